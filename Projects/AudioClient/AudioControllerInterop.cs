@@ -23,9 +23,81 @@ public enum AcEvent : byte
 {
     AcAttachedEvent = 0,
     AcDetachedEvent = 1,
-    AcVolumeChangedEvent = 2
+    AcVolumeChangedEvent = 2,
+    AcDefaultChangedEvent = 3,
+    AcPropertyChangedEvent = 4
 }
 
+public enum AcRole
+{
+    AcRoleConsole = 0,
+    AcRoleMultimedia = 1,
+    AcRoleCommunications = 2
+}
+
+public enum AcLatencyKind
+{
+    AcLatencyDeviceAdded = 0,
+    AcLatencyDeviceRemoved = 1,
+    AcLatencyDeviceStateChanged = 2,
+    AcLatencyVolumeChanged = 3,
+    AcLatencyResetContent = 4,
+    AcLatencyResetEnumeration = 5,
+    AcLatencyResetProbing = 6,
+    AcLatencyResetApplying = 7,
+    AcLatencyDefaultDeviceChanged = 8,
+    AcLatencyPropertyValueChanged = 9,
+    AcLatencyKindCount = 10
+}
+
+[StructLayout(LayoutKind.Sequential)]
+public struct AcLatency
+{
+    public ulong Count;
+    public ulong MeanNs;
+    public ulong P50Ns;
+    public ulong P90Ns;
+    public ulong P99Ns;
+    public ulong P999Ns;
+    public ulong MaxNs;
+};
+
+[StructLayout(LayoutKind.Sequential)]
+public struct AcLatencyStats
+{
+    [MarshalAs(UnmanagedType.ByValArray, SizeConst = (int)AcLatencyKind.AcLatencyKindCount)]
+    public AcLatency[] Kinds;
+};
+
+[StructLayout(LayoutKind.Sequential)]
+public struct AcStats
+{
+    public ulong DeviceAddedNotifications;
+    public ulong DeviceRemovedNotifications;
+    public ulong DeviceStateChangedNotifications;
+    public ulong VolumeNotifications;
+    public ulong DefaultDeviceChangedNotifications;
+    public ulong PropertyValueChangedNotifications;
+    public ulong EventsDelivered;
+    public ulong NotificationsSuppressed;
+    public ulong Enumerations;
+    public ulong PropertyStoreOpens;
+    public ulong EndpointActivations;
+    public ulong VolumeCallbacks;
+    public ulong Observers;
+    public ulong PendingNotifications;
+    public ulong NotificationsDeduplicated;
+};
+
+[StructLayout(LayoutKind.Sequential, CharSet = CharSet.Unicode)]
+public struct AcChange
+{
+    public int Event; // AcEvent, as a C enum
+
+    [MarshalAs(UnmanagedType.ByValTStr, SizeConst = 40)]
+    public string Guid;
+};
+
 [UnmanagedFunctionPointer(CallingConvention.StdCall)]
 public delegate void AcEventDelegate(
     byte hint
@@ -54,6 +126,54 @@ public static class AudioControllerInterop
         out AcDescription description
     );
 
+    [DllImport("AudioController.dll", CallingConvention = CallingConvention.StdCall)]
+    public static extern int AcIsStale(
+        ulong handle,
+        [MarshalAs(UnmanagedType.Bool)] out bool isStale
+    );
+
+    [DllImport("AudioController.dll", CallingConvention = CallingConvention.StdCall)]
+    public static extern int AcGetLatencyStats(
+        ulong handle,
+        out AcLatencyStats stats
+    );
+
+    [DllImport("AudioController.dll", CallingConvention = CallingConvention.StdCall)]
+    public static extern int AcGetStats(
+        ulong handle,
+        out AcStats stats
+    );
+
+    [DllImport("AudioController.dll", CallingConvention = CallingConvention.StdCall)]
+    public static extern int AcGetSequence(
+        ulong handle,
+        out ulong sequence
+    );
+
+    [DllImport("AudioController.dll", CallingConvention = CallingConvention.StdCall)]
+    public static extern int AcGetChangesSince(
+        ulong handle,
+        ulong sinceSequence,
+        [Out] AcChange[] changes,
+        uint capacity,
+        out uint count,
+        [MarshalAs(UnmanagedType.Bool)] out bool isComplete
+    );
+
+    [DllImport("AudioController.dll", CallingConvention = CallingConvention.StdCall)]
+    public static extern int AcSetFilter(
+        ulong handle,
+        [MarshalAs(UnmanagedType.LPWStr)] string deviceFilter
+    );
+
+    [DllImport("AudioController.dll", CallingConvention = CallingConvention.StdCall)]
+    public static extern int AcGetDefault(
+        ulong handle,
+        [MarshalAs(UnmanagedType.Bool)] bool isCapture,
+        AcRole role,
+        out AcDescription description
+    );
+
     [DllImport("AudioController.dll", CallingConvention = CallingConvention.StdCall)]
     public static extern int AcUnInitialize(
         ulong handle
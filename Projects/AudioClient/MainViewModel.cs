@@ -91,7 +91,8 @@ public class MainViewModel : INotifyPropertyChanged
             // ReSharper disable once InvertIf
             if (mainWindow?.DataContext is MainViewModel mainViewModel)
             {
-                var devicePresent = acEvent is (byte)AcEvent.AcAttachedEvent or (byte)AcEvent.AcVolumeChangedEvent;
+                var devicePresent = acEvent is (byte)AcEvent.AcAttachedEvent or (byte)AcEvent.AcVolumeChangedEvent or (byte)AcEvent.AcDefaultChangedEvent
+                    or (byte)AcEvent.AcPropertyChangedEvent;
                 mainViewModel.Device
                     = devicePresent
                         ? mainViewModel.AudioDeviceService.GetAudioDevice()
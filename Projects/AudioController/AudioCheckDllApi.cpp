@@ -4,6 +4,10 @@
 
 #include "AudioControlInterface.h"
 
+#include <future>
+
+#include "DeviceTableCache.h"
+
 class DllObserver final : public DeviceCollectionObserverInterface {
 public:
     explicit DllObserver(TAcEventCallback eventCallback, TAcLog logCallback)
@@ -25,25 +29,32 @@ private:
 
 DllObserver::~DllObserver() = default;
 
-void DllObserver::OnCollectionChanged(DeviceCollectionEvent event, const std::wstring& devicePnpId)
-{
-    if(eventCallback_ != nullptr)
+namespace  {
+    TAcEvent ToAcEvent(DeviceCollectionEvent event)
     {
-        TAcEvent acEvent;
         switch(event)
         {
         case DeviceCollectionEvent::Discovered:
-            acEvent = TAcAttachedEvent;
-            break;
+            return TAcAttachedEvent;
         case DeviceCollectionEvent::VolumeChanged:
-            acEvent = TAcVolumeChangedEvent;
-            break;
+            return TAcVolumeChangedEvent;
+        case DeviceCollectionEvent::DefaultChanged:
+            return TAcDefaultChangedEvent;
+        case DeviceCollectionEvent::PropertyChanged:
+            return TAcPropertyChangedEvent;
         case DeviceCollectionEvent::Detached:
         case DeviceCollectionEvent::None:
         default:  // NOLINT(clang-diagnostic-covered-switch-default)
-            acEvent = TAcDetachedEvent;
+            return TAcDetachedEvent;
         }
-        eventCallback_(acEvent);
+    }
+}
+
+void DllObserver::OnCollectionChanged(DeviceCollectionEvent event, const std::wstring& devicePnpId)
+{
+    if(eventCallback_ != nullptr)
+    {
+        eventCallback_(ToAcEvent(event));
     }
 }
 
@@ -65,49 +76,238 @@ void DllObserver::OnTraceDebug(const std::wstring & line)
 
 
 namespace  {
+    // No exception may cross the C boundary; E_FAIL instead
+    template <typename TFunction>
+    AcResult CatchAll(TFunction && function) noexcept
+    {
+        try
+        {
+            return function();
+        }
+        catch (...)
+        {
+            return E_FAIL;
+        }
+    }
+
     std::unique_ptr<DeviceCollectionInterface> device_collection;
     std::unique_ptr<DeviceCollectionObserverInterface> device_collection_observer;
+    std::future<void> device_collection_reconciliation;
 }
 
 AcResult AcInitialize(AcHandle* handle, PCWSTR deviceFilter, TAcEventCallback eventCallback, TAcLog logCallback)
 {
-    device_collection = AudioControl::CreateDeviceCollection(deviceFilter);
-    device_collection_observer = std::make_unique<DllObserver>(eventCallback, logCallback);
-    device_collection->Subscribe(*device_collection_observer);
+    return CatchAll([&]
+    {
+        device_collection = AudioControl::CreateDeviceCollection(deviceFilter);
+        device_collection_observer = std::make_unique<DllObserver>(eventCallback, logCallback);
+        device_collection->Subscribe(*device_collection_observer);
 
-    device_collection->ResetContent();
+        // Answer from the last persisted table at once (if any) and enumerate in the background:
+        // a stale table is reconciled, otherwise every device is announced as soon as it is probed
+        device_collection->LoadWarmStartCache(ed::audio::DeviceTableCache::GetDefaultFilePath());
+        device_collection_reconciliation = device_collection->ResetContentAsync(nullptr);
 
-    return 0;
+        return 0;
+    });
 }
 
 AcResult AcGetAttached(AcHandle handle, AcDescription* description)
 {
-    if(description == nullptr)
+    return CatchAll([&]
     {
+        if(description == nullptr)
+        {
+            return 0;
+        }
+
+        // Copied at once: the background enumeration may detach every device meanwhile
+        std::vector<std::unique_ptr<DeviceInterface>> devices;
+        if (device_collection != nullptr)
+        {
+            devices = device_collection->FindDevices({});
+        }
+        if (!devices.empty())
+        {
+            const auto & device = devices.front();
+            wcsncpy_s(description->Guid, _countof(description->Guid), device->GetPnpId().c_str(), _TRUNCATE);
+            wcsncpy_s(description->Name, _countof(description->Name), device->GetName().c_str(), _TRUNCATE);
+            description->Volume = device->GetCurrentRenderVolume();
+            return 0;
+        }
+        description->Guid[0] = '\0';
+        description->Name[0] = L'\0';
+        description->Volume = 0;
         return 0;
-    }
+    });
+}
 
-    if (device_collection != nullptr && device_collection->GetSize() > 0)
+AcResult AcIsStale(AcHandle handle, BOOL* isStale)
+{
+    return CatchAll([&]
     {
-        const auto device = device_collection->CreateItem(0);
-        wcsncpy_s(description->Guid, _countof(description->Guid), device->GetPnpId().c_str(), device->GetPnpId().size());
-        wcsncpy_s(description->Name, _countof(description->Name), device->GetName().c_str(), device->GetName().size());
-        description->Volume = device->GetCurrentRenderVolume();
+        if (isStale != nullptr)
+        {
+            *isStale = device_collection != nullptr && device_collection->IsStale() ? TRUE : FALSE;
+        }
         return 0;
-    }
-    description->Guid[0] = '\0';
-    description->Name[0] = L'\0';
-    description->Volume = 0;
-    return 0;
+    });
+}
+
+AcResult AcGetLatencyStats(AcHandle handle, AcLatencyStats* stats)
+{
+    return CatchAll([&]
+    {
+        if (stats == nullptr)
+        {
+            return 0;
+        }
+        *stats = {};
+        if (device_collection != nullptr)
+        {
+            const auto statistics = device_collection->GetLatencyStatistics();
+            static_assert(TAcLatencyKindCount == LatencyKindCount);
+            for (size_t i = 0; i < LatencyKindCount; ++i)
+            {
+                const auto & summary = statistics[i];
+                auto & latency = stats->Kinds[i];
+                latency.Count = summary.Count;
+                latency.MeanNs = static_cast<UINT64>(summary.Mean.count());
+                latency.P50Ns = static_cast<UINT64>(summary.P50.count());
+                latency.P90Ns = static_cast<UINT64>(summary.P90.count());
+                latency.P99Ns = static_cast<UINT64>(summary.P99.count());
+                latency.P999Ns = static_cast<UINT64>(summary.P999.count());
+                latency.MaxNs = static_cast<UINT64>(summary.Max.count());
+            }
+        }
+        return 0;
+    });
+}
+
+AcResult AcGetStats(AcHandle handle, AcStats* stats)
+{
+    return CatchAll([&]
+    {
+        if (stats == nullptr)
+        {
+            return 0;
+        }
+        *stats = {};
+        if (device_collection != nullptr)
+        {
+            const auto counters = device_collection->GetOperationalCounters();
+            stats->DeviceAddedNotifications = counters.DeviceAddedNotifications;
+            stats->DeviceRemovedNotifications = counters.DeviceRemovedNotifications;
+            stats->DeviceStateChangedNotifications = counters.DeviceStateChangedNotifications;
+            stats->VolumeNotifications = counters.VolumeNotifications;
+            stats->DefaultDeviceChangedNotifications = counters.DefaultDeviceChangedNotifications;
+            stats->PropertyValueChangedNotifications = counters.PropertyValueChangedNotifications;
+            stats->EventsDelivered = counters.EventsDelivered;
+            stats->NotificationsSuppressed = counters.NotificationsSuppressed;
+            stats->Enumerations = counters.Enumerations;
+            stats->PropertyStoreOpens = counters.PropertyStoreOpens;
+            stats->EndpointActivations = counters.EndpointActivations;
+            stats->VolumeCallbacks = counters.VolumeCallbacks;
+            stats->Observers = counters.Observers;
+            stats->PendingNotifications = counters.PendingNotifications;
+            stats->NotificationsDeduplicated = counters.NotificationsDeduplicated;
+        }
+        return 0;
+    });
+}
+
+AcResult AcGetSequence(AcHandle handle, UINT64* sequence)
+{
+    return CatchAll([&]
+    {
+        if (sequence != nullptr)
+        {
+            *sequence = device_collection != nullptr ? device_collection->GetSequence() : 0;
+        }
+        return 0;
+    });
+}
+
+AcResult AcGetChangesSince(AcHandle handle, UINT64 sinceSequence, AcChange* changes, UINT32 capacity, UINT32* count, BOOL* isComplete)
+{
+    return CatchAll([&]
+    {
+        if (count == nullptr || isComplete == nullptr || (changes == nullptr && capacity > 0))
+        {
+            return 0;
+        }
+        *count = 0;
+        *isComplete = FALSE;
+        if (device_collection == nullptr)
+        {
+            return 0;
+        }
+        const auto changesSince = device_collection->GetChangesSince(sinceSequence);
+        *isComplete = changesSince.IsComplete ? TRUE : FALSE;
+        for (const auto & [event, pnpId] : changesSince.Changes)
+        {
+            if (*count == capacity)
+            {
+                break;
+            }
+            auto & change = changes[(*count)++];
+            change.Event = ToAcEvent(event);
+            wcsncpy_s(change.Guid, _countof(change.Guid), pnpId.c_str(), _TRUNCATE);
+        }
+        return 0;
+    });
+}
+
+AcResult AcSetFilter(AcHandle handle, PCWSTR deviceFilter)
+{
+    return CatchAll([&]
+    {
+        if (device_collection != nullptr)
+        {
+            device_collection->SetFilter(deviceFilter != nullptr ? deviceFilter : L"");
+        }
+        return 0;
+    });
+}
+
+AcResult AcGetDefault(AcHandle handle, BOOL isCapture, TAcRole role, AcDescription* description)
+{
+    return CatchAll([&]
+    {
+        if (description == nullptr)
+        {
+            return 0;
+        }
+
+        const auto flow = isCapture != FALSE ? DeviceFlowEnum::Capture : DeviceFlowEnum::Render;
+        if (const auto device = device_collection != nullptr ? device_collection->GetDefaultDevice(flow, static_cast<DeviceRole>(role)) : nullptr)
+        {
+            wcsncpy_s(description->Guid, _countof(description->Guid), device->GetPnpId().c_str(), _TRUNCATE);
+            wcsncpy_s(description->Name, _countof(description->Name), device->GetName().c_str(), _TRUNCATE);
+            description->Volume = flow == DeviceFlowEnum::Capture ? device->GetCurrentCaptureVolume() : device->GetCurrentRenderVolume();
+            return 0;
+        }
+        description->Guid[0] = L'\0';
+        description->Name[0] = L'\0';
+        description->Volume = 0;
+        return 0;
+    });
 }
 
 AcResult AcUnInitialize(AcHandle handle)
 {
-    if(device_collection != nullptr)
+    return CatchAll([&]
     {
-        device_collection->Unsubscribe(*device_collection_observer);
-        device_collection_observer.reset();
-        device_collection.reset();
-    }
-    return 0;
+        if (device_collection_reconciliation.valid())
+        {
+            device_collection_reconciliation.wait();
+        }
+        if(device_collection != nullptr)
+        {
+            device_collection->Unsubscribe(*device_collection_observer);
+            device_collection_observer.reset();
+            device_collection.reset();
+        }
+        return 0;
+    });
 }
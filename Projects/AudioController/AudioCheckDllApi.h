@@ -62,9 +62,21 @@
     typedef enum {  // NOLINT(performance-enum-size)
         TAcAttachedEvent,
         TAcDetachedEvent,
-        TAcVolumeChangedEvent
+        TAcVolumeChangedEvent,
+        TAcDefaultChangedEvent,
+        TAcPropertyChangedEvent
     } TAcEvent;
 
+    /**
+     * @enum TAcRole
+     * @brief Roles of a default device, see AcGetDefault.
+     */
+    typedef enum {  // NOLINT(performance-enum-size)
+        TAcRoleConsole,
+        TAcRoleMultimedia,
+        TAcRoleCommunications
+    } TAcRole;
+
     /**
      * @typedef TAcEventCallback
      * @brief Callback type for device discovery events.
@@ -72,7 +84,9 @@
      * This callback function is invoked when an audio device is either attached
      * or detached.
      *
-     * @param hint Indicates whether the device is being attached (TAcAttachedEvent), detached (TAcDetachedEvent) or volume changed TAcVolumeChangedEvent
+     * @param hint Indicates whether the device is being attached (TAcAttachedEvent), detached (TAcDetachedEvent), volume changed (TAcVolumeChangedEvent),
+     *             has become or is no longer a default device (TAcDefaultChangedEvent)
+     *             or has been renamed or re-classified (TAcPropertyChangedEvent)
      */
     typedef void(__stdcall* TAcEventCallback)(
         _In_ UINT8 hint
@@ -93,6 +107,87 @@
         _In_  PCWSTR          infoLine
         );
 
+    /**
+     * @enum TAcLatencyKind
+     * @brief Kinds of latencies measured by the library; indexes AcLatencyStats::Kinds.
+     *
+     * Notification latencies run from the entry of the platform callback to the end of
+     * the event delivery. The ResetContent kinds time a whole enumeration and its
+     * enumeration, probing and applying phases.
+     */
+    typedef enum {  // NOLINT(performance-enum-size)
+        TAcLatencyDeviceAdded,
+        TAcLatencyDeviceRemoved,
+        TAcLatencyDeviceStateChanged,
+        TAcLatencyVolumeChanged,
+        TAcLatencyResetContent,
+        TAcLatencyResetEnumeration,
+        TAcLatencyResetProbing,
+        TAcLatencyResetApplying,
+        TAcLatencyDefaultDeviceChanged,
+        TAcLatencyPropertyValueChanged,
+        TAcLatencyKindCount
+    } TAcLatencyKind;
+
+    /**
+     * @struct AcLatency
+     * @brief Latency distribution of one kind, in nanoseconds.
+     *
+     * Percentiles are the highest value of their histogram bucket, precise to about 3%.
+     */
+    typedef struct {
+        UINT64 Count;
+        UINT64 MeanNs;
+        UINT64 P50Ns;
+        UINT64 P90Ns;
+        UINT64 P99Ns;
+        UINT64 P999Ns;
+        UINT64 MaxNs;
+    } AcLatency;
+
+    /**
+     * @struct AcLatencyStats
+     * @brief Latency distributions of all kinds, indexed by TAcLatencyKind.
+     */
+    typedef struct {
+        AcLatency Kinds[TAcLatencyKindCount];
+    } AcLatencyStats;
+
+    /**
+     * @struct AcStats
+     * @brief Operational counters of the session, for incident analysis.
+     *
+     * All members are totals since AcInitialize, except the gauges VolumeCallbacks,
+     * Observers and PendingNotifications, which are current values. The layout is
+     * fixed; new counters are only ever appended.
+     */
+    typedef struct {
+        UINT64 DeviceAddedNotifications;          ///< Platform notifications received, per kind
+        UINT64 DeviceRemovedNotifications;
+        UINT64 DeviceStateChangedNotifications;
+        UINT64 VolumeNotifications;
+        UINT64 DefaultDeviceChangedNotifications;
+        UINT64 PropertyValueChangedNotifications;
+        UINT64 EventsDelivered;                   ///< Events delivered, one per event and observer
+        UINT64 NotificationsSuppressed;           ///< Notifications that raised no event
+        UINT64 Enumerations;                      ///< Full enumerations of the active endpoints
+        UINT64 PropertyStoreOpens;                ///< Endpoint probes, each opens a property store
+        UINT64 EndpointActivations;               ///< Endpoint volume activations
+        UINT64 VolumeCallbacks;                   ///< Registered volume notification callbacks
+        UINT64 Observers;                         ///< Subscribed observers
+        UINT64 PendingNotifications;              ///< Notifications being processed right now
+        UINT64 NotificationsDeduplicated;         ///< Redundant notifications dropped before probing
+    } AcStats;
+
+    /**
+     * @struct AcChange
+     * @brief One logged change of the device list, see AcGetChangesSince.
+     */
+    typedef struct {
+        TAcEvent Event;                           ///< Attached, detached, volume changed or default changed
+        WCHAR Guid[40];                           ///< Plug-and-play id of the device
+    } AcChange;
+
     /**
      * @brief Initializes the audio check session.
      *
@@ -100,6 +195,9 @@
      * for subsequent operations. It also allows the user to set callbacks for
      * device discovery and logging.
      *
+     * The function returns without waiting for the device enumeration: each device
+     * is reported via eventCallback as soon as it is probed.
+     *
      * @param[out] handle Pointer to the handle that will be initialized.
      * @param[in] deviceFilter Filter string for selecting specific devices.
      * @param[in, optional] eventCallback Callback function for device events.
@@ -132,6 +230,142 @@
             _Out_  AcDescription* description
         );
 
+    /**
+     * @brief Tells whether the device list is still served from the warm-start cache.
+     *
+     * Right after AcInitialize the list may come from the table persisted by the
+     * previous session, while the real enumeration runs in the background. Once it
+     * is reconciled, the differences are reported via the event callback and the
+     * list is not stale any more.
+     *
+     * @param[in] handle The handle identifying the audio check session.
+     * @param[out] isStale Receives TRUE while the list is not yet reconciled.
+     *
+     * @return AcResult Result code indicating the success or failure of the operation.
+     */
+    AC_EXPORT_IMPORT_DECL
+        AcResult __stdcall AcIsStale(
+            _In_ AcHandle handle,
+            _Out_ BOOL* isStale
+        );
+
+    /**
+     * @brief Retrieves the latency distributions accumulated since AcInitialize.
+     *
+     * @param[in] handle The handle identifying the audio check session.
+     * @param[out] stats Pointer to the structure that receives the distributions.
+     *
+     * @return AcResult Result code indicating the success or failure of the operation.
+     */
+    AC_EXPORT_IMPORT_DECL
+        AcResult __stdcall AcGetLatencyStats(
+            _In_ AcHandle handle,
+            _Out_ AcLatencyStats* stats
+        );
+
+    /**
+     * @brief Retrieves the operational counters of the session.
+     *
+     * The counters are cheap and always on, so e.g. a runaway re-enumeration loop
+     * shows up without verbose logging.
+     *
+     * @param[in] handle The handle identifying the audio check session.
+     * @param[out] stats Pointer to the structure that receives the counters.
+     *
+     * @return AcResult Result code indicating the success or failure of the operation.
+     */
+    AC_EXPORT_IMPORT_DECL
+        AcResult __stdcall AcGetStats(
+            _In_ AcHandle handle,
+            _Out_ AcStats* stats
+        );
+
+    /**
+     * @brief Retrieves the sequence number of the device list.
+     *
+     * Every change of the list increments it; an unchanged sequence number means an
+     * unchanged list, so idle polling costs one atomic load.
+     *
+     * @param[in] handle The handle identifying the audio check session.
+     * @param[out] sequence Receives the current sequence number.
+     *
+     * @return AcResult Result code indicating the success or failure of the operation.
+     */
+    AC_EXPORT_IMPORT_DECL
+        AcResult __stdcall AcGetSequence(
+            _In_ AcHandle handle,
+            _Out_ UINT64* sequence
+        );
+
+    /**
+     * @brief Retrieves the changes of the device list after a sequence number.
+     *
+     * The changes come from a bounded log of the last changes, oldest first; the
+     * change i has the sequence number sinceSequence + 1 + i. If there are more than
+     * capacity, ask again with sinceSequence + *count. If the log does not reach back
+     * to sinceSequence, *isComplete is FALSE and no change is written: re-read the
+     * whole list and continue from the sequence number taken before it (AcGetSequence).
+     *
+     * @param[in] handle The handle identifying the audio check session.
+     * @param[in] sinceSequence The sequence number the caller is in sync with.
+     * @param[out] changes Array of capacity elements that receives the changes.
+     * @param[in] capacity Number of elements of changes.
+     * @param[out] count Receives the number of changes written.
+     * @param[out] isComplete Receives FALSE if the changes are not logged any more.
+     *
+     * @return AcResult Result code indicating the success or failure of the operation.
+     */
+    AC_EXPORT_IMPORT_DECL
+        AcResult __stdcall AcGetChangesSince(
+            _In_ AcHandle handle,
+            _In_ UINT64 sinceSequence,
+            _Out_writes_to_(capacity, *count) AcChange* changes,
+            _In_ UINT32 capacity,
+            _Out_ UINT32* count,
+            _Out_ BOOL* isComplete
+        );
+
+    /**
+     * @brief Changes the device filter of AcInitialize in place.
+     *
+     * The facts of every active device are kept in memory, so nothing is enumerated
+     * or probed again: the devices entering or leaving the filtered list are reported
+     * via the event callback at once.
+     *
+     * @param[in] handle The handle identifying the audio check session.
+     * @param[in] deviceFilter Filter string for selecting specific devices; NULL or empty for all.
+     *
+     * @return AcResult Result code indicating the success or failure of the operation.
+     */
+    AC_EXPORT_IMPORT_DECL
+        AcResult __stdcall AcSetFilter(
+            _In_ AcHandle handle,
+            _In_opt_ PCWSTR deviceFilter
+        );
+
+    /**
+     * @brief Retrieves the default device of a flow and role.
+     *
+     * The default devices are tracked in memory and kept up to date by the audio
+     * service's notifications, so no audio endpoint is asked. A change is reported
+     * via the event callback as TAcDefaultChangedEvent.
+     *
+     * @param[in] handle The handle identifying the audio check session.
+     * @param[in] isCapture TRUE for the default recording device, FALSE for the default playback device.
+     * @param[in] role The role of the default device.
+     * @param[out] description Pointer to the structure that will hold the device description, with the
+     *             volume of the flow; an empty Guid if there is no default device or the filter leaves it out.
+     *
+     * @return AcResult Result code indicating the success or failure of the operation.
+     */
+    AC_EXPORT_IMPORT_DECL
+        AcResult __stdcall AcGetDefault(
+            _In_ AcHandle handle,
+            _In_ BOOL isCapture,
+            _In_ TAcRole role,
+            _Out_ AcDescription* description
+        );
+
     /**
      * @brief Uninitializes the audio check session.
      *
@@ -5,10 +5,55 @@
 
 #include <stdexcept>
 
+#include "ComAudioBackend.h"
 #include "DeviceCollection.h"
+#include "DeviceTableCache.h"
+#include "RecordingAudioBackend.h"
+#include "SnapshotPublisher.h"
+#include "TimedDeviceCollection.h"
+#include "TimelineTrace.h"
+#include "TraceReplayer.h"
 
 
 std::unique_ptr<DeviceCollectionInterface> AudioControl::CreateDeviceCollection(const std::wstring& nameFilter, bool bothHeadsetAndMicro)
 {
     return std::make_unique<ed::audio::DeviceCollection>(nameFilter, bothHeadsetAndMicro);
 }
+
+std::unique_ptr<SnapshotPublisherInterface> AudioControl::CreateSnapshotPublisher(DeviceCollectionInterface & collection, const std::wstring & regionName)
+{
+    return std::make_unique<ed::audio::SnapshotPublisher>(collection, regionName);
+}
+
+std::unique_ptr<DeviceCollectionInterface> AudioControl::CreateRecordingDeviceCollection(const std::wstring & nameFilter, bool bothHeadsetAndMicro, const std::wstring & traceFilePath)
+{
+    return std::make_unique<ed::audio::DeviceCollection>(
+        nameFilter, bothHeadsetAndMicro,
+        std::make_unique<ed::audio::RecordingAudioBackend>(std::make_unique<ed::audio::ComAudioBackend>(), traceFilePath));
+}
+
+std::unique_ptr<TraceReplayerInterface> AudioControl::CreateTraceReplayer(const std::wstring & traceFilePath, const std::wstring & nameFilter, bool bothHeadsetAndMicro)
+{
+    return std::make_unique<ed::audio::TraceReplayer>(traceFilePath, nameFilter, bothHeadsetAndMicro);
+}
+
+std::unique_ptr<TimedDeviceCollectionInterface> AudioControl::CreateTimedDeviceCollection(const std::wstring & nameFilter, bool bothHeadsetAndMicro)
+{
+    return std::make_unique<ed::audio::TimedDeviceCollection>(nameFilter, bothHeadsetAndMicro, std::make_unique<ed::audio::ComAudioBackend>());
+}
+
+std::wstring AudioControl::GetDefaultWarmStartCachePath()
+{
+    return ed::audio::DeviceTableCache::GetDefaultFilePath();
+}
+
+void AudioControl::StartTimelineTrace(size_t zoneCapacity)
+{
+    ed::audio::TimelineTrace::Start(zoneCapacity);
+}
+
+bool AudioControl::StopTimelineTrace(const std::wstring & jsonFilePath)
+{
+    ed::audio::TimelineTrace::Stop();
+    return ed::audio::TimelineTrace::TryWriteChromeJson(jsonFilePath);
+}
@@ -7,7 +7,16 @@
 #define AC_EXPORT_IMPORT_DECL __declspec(dllimport)
 #endif
 
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
 
 #include "ClassDefHelper.h"
 
@@ -15,12 +24,19 @@ class DeviceCollectionInterface;
 class DeviceCollectionObserver;
 class DeviceInterface;
 class DeviceCollectionObserverInterface;
+class SnapshotPublisherInterface;
+class TraceReplayerInterface;
+class TimedDeviceCollectionInterface;
 
 enum class AC_EXPORT_IMPORT_DECL DeviceCollectionEvent : uint8_t {
     None = 0,
     Discovered,
     Detached,
-    VolumeChanged
+    VolumeChanged,
+    // The device has become, or is no longer, the default of a flow and role, see DeviceInterface::IsDefault
+    DefaultChanged,
+    // The name or the form factor of the device has changed, e.g. renamed in the Sound control panel
+    PropertyChanged
 };
 
 enum class AC_EXPORT_IMPORT_DECL DeviceFlowEnum : uint8_t {
@@ -30,10 +46,211 @@ enum class AC_EXPORT_IMPORT_DECL DeviceFlowEnum : uint8_t {
     RenderAndCapture
 };
 
+// The form factor of an endpoint as the system reports it (PKEY_AudioEndpoint_FormFactor), in the order of EndpointFormFactor.
+// Of a merged device, the form factor of the endpoint discovered first, unless that is Unknown.
+enum class AC_EXPORT_IMPORT_DECL DeviceFormFactor : uint8_t {
+    RemoteNetworkDevice = 0,
+    Speakers,
+    LineLevel,
+    Headphones,
+    Microphone,
+    Headset,
+    Handset,
+    UnknownDigitalPassthrough,
+    Spdif,
+    DigitalAudioDisplayDevice,
+    Unknown
+};
+
+// The connector type of the jack of an endpoint, in the order of EPcxConnectionType; Unknown if the driver tells none
+enum class AC_EXPORT_IMPORT_DECL DeviceJackConnection : uint8_t {
+    Unknown = 0,
+    Jack3Point5mm,
+    Quarter,
+    AtapiInternal,
+    Rca,
+    Optical,
+    OtherDigital,
+    OtherAnalog,
+    MultichannelAnalogDin,
+    XlrProfessional,
+    Rj11Modem,
+    Combination
+};
+
+// The role of a default endpoint, in the order of ERole
+enum class AC_EXPORT_IMPORT_DECL DeviceRole : uint8_t {
+    Console = 0,
+    Multimedia,
+    Communications
+};
+
+constexpr size_t DeviceRoleCount = 3;
+
+// Event kinds as bits, see DeviceCollectionSubscription
+enum class AC_EXPORT_IMPORT_DECL DeviceCollectionEventMask : uint8_t {
+    None = 0,
+    Discovered = 1 << 0,
+    Detached = 1 << 1,
+    VolumeChanged = 1 << 2,
+    DefaultChanged = 1 << 3,
+    PropertyChanged = 1 << 4,
+    All = Discovered | Detached | VolumeChanged | DefaultChanged | PropertyChanged
+};
+
+constexpr DeviceCollectionEventMask operator|(DeviceCollectionEventMask left, DeviceCollectionEventMask right)
+{
+    return static_cast<DeviceCollectionEventMask>(static_cast<uint8_t>(left) | static_cast<uint8_t>(right));
+}
+
+enum class AC_EXPORT_IMPORT_DECL TraceLevel : uint8_t {
+    None = 0,
+    // OnTrace only
+    Info,
+    // OnTrace and OnTraceDebug
+    Debug
+};
+
+// What an observer is called back for; the default is everything. An event is delivered if its kind is in
+// Events and its device matches all the device predicates, a batch contains the matching changes only.
+struct DeviceCollectionSubscription {
+    DeviceCollectionEventMask Events = DeviceCollectionEventMask::All;
+    // The plug-and-play (container) id of the one device, as in the events; empty for any device
+    std::wstring PnpId;
+    // Devices having the flow, e.g. Render matches RenderAndCapture, too; None for any flow
+    DeviceFlowEnum Flow = DeviceFlowEnum::None;
+    // A case-insensitive substring of the device name; empty for any name
+    std::wstring NameFilter;
+    // Matched exactly; unset for any. Unlike a name filter, independent of the localized names
+    std::optional<DeviceFormFactor> FormFactor;
+    std::optional<DeviceJackConnection> JackConnection;
+    TraceLevel Trace = TraceLevel::Debug;
+};
+
+// See DeviceCollectionInterface::FindDevices. The criteria are and-ed; the defaults match any device.
+struct DeviceQuery {
+    // The plug-and-play (container) id of the one device, as in the events; empty for any device
+    std::wstring PnpId;
+    // Devices having the flow, e.g. Render matches RenderAndCapture, too
+    DeviceFlowEnum Flow = DeviceFlowEnum::None;
+    // A case-insensitive prefix of the name or, of a merged device, of the name of one of its endpoints
+    std::wstring NamePrefix;
+    // The render volume or, if Flow is Capture, the capture volume; a device without that flow does not match.
+    // A muted device has the volume 0.
+    uint16_t MinVolume = 0;
+    uint16_t MaxVolume = UINT16_MAX;
+    // Matched exactly; unset for any
+    std::optional<DeviceFormFactor> FormFactor;
+    std::optional<DeviceJackConnection> JackConnection;
+};
+
+// One net change of a burst, see DeviceCollectionInterface::SetBurstWindow, or one entry of the change log
+struct DeviceCollectionChange {
+    DeviceCollectionEvent Event = DeviceCollectionEvent::None;
+    std::wstring PnpId;
+};
+
+// See DeviceCollectionInterface::GetChangesSince
+struct DeviceCollectionChangesSince {
+    // False if the change log does not reach back to the sequence number: re-read the whole collection
+    bool IsComplete = false;
+    // The current sequence number, to ask with next time
+    uint64_t Sequence = 0;
+    // Oldest first; the change i has the sequence number of the request + 1 + i
+    std::vector<DeviceCollectionChange> Changes;
+};
+
+// Latencies are measured from the entry of a platform callback to the end of the observer delivery;
+// the ResetContent kinds time a whole ResetContent() and its enumeration, probing and applying phases.
+enum class AC_EXPORT_IMPORT_DECL LatencyKind : uint8_t {
+    DeviceAdded = 0,
+    DeviceRemoved,
+    DeviceStateChanged,
+    VolumeChanged,
+    ResetContent,
+    ResetEnumeration,
+    ResetProbing,
+    ResetApplying,
+    DefaultDeviceChanged,
+    PropertyValueChanged
+};
+
+constexpr size_t LatencyKindCount = 10;
+
+// Percentiles are the highest value of their histogram bucket, precise to about 3%
+struct LatencySummary {
+    uint64_t Count = 0;
+    std::chrono::nanoseconds Mean{};
+    std::chrono::nanoseconds P50{};
+    std::chrono::nanoseconds P90{};
+    std::chrono::nanoseconds P99{};
+    std::chrono::nanoseconds P999{};
+    std::chrono::nanoseconds Max{};
+};
+
+// Indexed by LatencyKind
+using LatencyStatistics = std::array<LatencySummary, LatencyKindCount>;
+
+// Time spent inside platform (COM) calls, accumulated over the lifetime of a collection
+struct PlatformCallTimes {
+    std::chrono::nanoseconds Enumeration{};
+    std::chrono::nanoseconds Probing{};
+    uint64_t ProbeCount = 0;
+    std::chrono::nanoseconds VolumeRegistration{};
+};
+
+// Cheap, always-on counters for incident analysis. All are totals since the creation of the collection,
+// except the gauges VolumeCallbacks, Observers and PendingNotifications, which are current values.
+struct OperationalCounters {
+    // Platform notifications received, per kind
+    uint64_t DeviceAddedNotifications = 0;
+    uint64_t DeviceRemovedNotifications = 0;
+    uint64_t DeviceStateChangedNotifications = 0;
+    uint64_t VolumeNotifications = 0;
+    uint64_t DefaultDeviceChangedNotifications = 0;
+    uint64_t PropertyValueChangedNotifications = 0;
+    // Events delivered, one per event and observer; a batch counts each of its changes
+    uint64_t EventsDelivered = 0;
+    // Notifications that raised no event, e.g. of a filtered-out device or with an unchanged volume
+    uint64_t NotificationsSuppressed = 0;
+    // Full enumerations of the active endpoints; a volume notification of an unknown endpoint causes one, too
+    uint64_t Enumerations = 0;
+    // Endpoint probes and property reads, each opens a property store
+    uint64_t PropertyStoreOpens = 0;
+    // IAudioEndpointVolume activations, by probes and volume notification registrations
+    uint64_t EndpointActivations = 0;
+    // Registered IAudioEndpointVolumeCallback notifications
+    uint64_t VolumeCallbacks = 0;
+    uint64_t Observers = 0;
+    // Notifications being processed right now, i.e. the depth of the platform's callback queue seen by the collection
+    uint64_t PendingNotifications = 0;
+    // Redundant notifications dropped before probing, e.g. OnDeviceAdded of an endpoint already activated by OnDeviceStateChanged
+    uint64_t NotificationsDeduplicated = 0;
+};
+
 class AC_EXPORT_IMPORT_DECL AudioControl {
 public:
     static std::unique_ptr<DeviceCollectionInterface> CreateDeviceCollection(
         const std::wstring & nameFilter, bool bothHeadsetAndMicro = false);
+    static std::unique_ptr<SnapshotPublisherInterface> CreateSnapshotPublisher(
+        DeviceCollectionInterface & collection, const std::wstring & regionName);
+    // Like CreateDeviceCollection, additionally writes every low-level notification and probed fact into a trace file.
+    static std::unique_ptr<DeviceCollectionInterface> CreateRecordingDeviceCollection(
+        const std::wstring & nameFilter, bool bothHeadsetAndMicro, const std::wstring & traceFilePath);
+    static std::unique_ptr<TraceReplayerInterface> CreateTraceReplayer(
+        const std::wstring & traceFilePath, const std::wstring & nameFilter, bool bothHeadsetAndMicro = false);
+    // Like CreateDeviceCollection, additionally times every platform call, e.g. for benchmarks.
+    static std::unique_ptr<TimedDeviceCollectionInterface> CreateTimedDeviceCollection(
+        const std::wstring & nameFilter, bool bothHeadsetAndMicro = false);
+    // The per-user warm-start cache the DLL uses, see DeviceCollectionInterface::LoadWarmStartCache(); empty, i.e.
+    // no cache, if %LOCALAPPDATA% is not set.
+    static std::wstring GetDefaultWarmStartCachePath();
+
+    // Records the zones of enumerations, platform calls, merging and event delivery of every collection
+    // into an in-process buffer of zoneCapacity zones. Call it before the first collection is created.
+    static void StartTimelineTrace(size_t zoneCapacity = 1000000);
+    // Stops recording and writes the timeline as Chrome trace / Perfetto JSON (chrome://tracing, ui.perfetto.dev).
+    static bool StopTimelineTrace(const std::wstring & jsonFilePath);
 
     DISALLOW_COPY_MOVE(AudioControl);
     AudioControl() = delete;
@@ -44,11 +261,55 @@ class AC_EXPORT_IMPORT_DECL DeviceCollectionInterface {
 public:
     virtual size_t GetSize() const = 0;
     virtual std::unique_ptr<DeviceInterface> CreateItem(size_t deviceNumber) const = 0;
+    // Answered by indexes kept up to date with every change, without iterating the collection; in the order of CreateItem()
+    virtual std::vector<std::unique_ptr<DeviceInterface>> FindDevices(const DeviceQuery & query) const = 0;
+    // The device of the default endpoint of the flow, Render or Capture, and the role; nullptr if there is none or
+    // the filter leaves it out. Kept up to date by the default device notifications, so it is read from memory.
+    // A change raises DefaultChanged for the device losing the default and for the one gaining it, unless that one
+    // has yet to be discovered.
+    virtual std::unique_ptr<DeviceInterface> GetDefaultDevice(DeviceFlowEnum flow, DeviceRole role) const = 0;
 
     virtual void Subscribe(DeviceCollectionObserverInterface & observer) = 0;
+    // Observers not interested in an event or a trace line are not called at all. Subscribing an observer
+    // again replaces its subscription.
+    virtual void Subscribe(DeviceCollectionObserverInterface & observer, const DeviceCollectionSubscription & subscription) = 0;
+    // Returns once no callback to the observer is running or can start, so it may be destroyed then. Called from
+    // within a callback of this collection, it returns at once: the callbacks of that thread are still running.
     virtual void Unsubscribe(DeviceCollectionObserverInterface & observer) = 0;
 
     virtual void ResetContent() = 0;
+    // Returns at once; every probed endpoint is published (Discovered) as soon as it is known. Resets run one after
+    // another in the order asked for, from any thread, onCompleted, too. onCompleted, if any, is called on the
+    // enumeration thread before the future becomes ready, also if the reset has failed; the future holds the error.
+    virtual std::future<void> ResetContentAsync(std::function<void()> onCompleted) = 0;
+
+    // Serves the last persisted table immediately, flagged as stale, until the next ResetContent() reconciles it.
+    virtual bool LoadWarmStartCache(const std::wstring & cacheFilePath) = 0;
+    virtual bool IsStale() const = 0;
+
+    // Accumulated since the creation of the collection; cheap enough to stay always on.
+    virtual LatencyStatistics GetLatencyStatistics() const = 0;
+    virtual OperationalCounters GetOperationalCounters() const = 0;
+
+    // Hot-plug storms: with a non-zero quiet window, device additions, removals and state changes are queued
+    // until none has arrived for the window (at the latest, 20 windows after the first one), then applied as
+    // one transaction and delivered as their net changes by one OnCollectionChangedBatch() per observer.
+    // Zero, the default, applies and delivers every notification as it arrives. Volume changes are never queued.
+    virtual void SetBurstWindow(std::chrono::milliseconds quietWindow) = 0;
+
+    // Resynchronization without re-reading the collection: every event of the collection, whether delivered
+    // or not, gets the next sequence number and goes into a bounded log of the last changes. An unchanged
+    // sequence number means an unchanged collection; polling it is one atomic load.
+    [[nodiscard]] virtual uint64_t GetSequence() const = 0;
+    // The changes after the sequence number, or IsComplete false if they are not logged any more
+    [[nodiscard]] virtual DeviceCollectionChangesSince GetChangesSince(uint64_t sequence) const = 0;
+
+    // Change the filters of CreateDeviceCollection() in place, without enumerating or probing: the facts of every
+    // active endpoint are kept, whether filtered out or not. The devices entering or leaving the filtered view are
+    // delivered as one batch of Detached and Discovered events; a device whose merged flow or name changes is
+    // Discovered again. Before the first ResetContent() the filters only apply to its reconciliation.
+    virtual void SetFilter(const std::wstring & nameFilter) = 0;
+    virtual void SetFlowMode(bool bothHeadsetAndMicro) = 0;
 
     AS_INTERFACE(DeviceCollectionInterface);
     DISALLOW_COPY_MOVE(DeviceCollectionInterface);
@@ -57,6 +318,15 @@ public:
 class AC_EXPORT_IMPORT_DECL DeviceCollectionObserverInterface {
 public:
     virtual void OnCollectionChanged(DeviceCollectionEvent event, const std::wstring & devicePnpId) = 0;
+    // The net changes of a burst: a device added and removed again within it is left out.
+    // Unless overridden, they are passed on one by one.
+    virtual void OnCollectionChangedBatch(std::span<const DeviceCollectionChange> changes)
+    {
+        for (const auto & [event, pnpId] : changes)
+        {
+            OnCollectionChanged(event, pnpId);
+        }
+    }
     virtual void OnTrace(const std::wstring & line) = 0;
     virtual void OnTraceDebug(const std::wstring & line) = 0;
 
@@ -72,7 +342,42 @@ public:
     virtual DeviceFlowEnum GetFlow() const = 0;
     virtual uint16_t GetCurrentRenderVolume() const = 0;
     virtual uint16_t GetCurrentCaptureVolume() const = 0;
+    virtual DeviceFormFactor GetFormFactor() const = 0;
+    virtual DeviceJackConnection GetJackConnection() const = 0;
+    // Whether an endpoint of the device is the default one of the flow, Render or Capture, and the role
+    virtual bool IsDefault(DeviceFlowEnum flow, DeviceRole role) const = 0;
 
     AS_INTERFACE(DeviceInterface);
     DISALLOW_COPY_MOVE(DeviceInterface);
 };
+
+class AC_EXPORT_IMPORT_DECL SnapshotPublisherInterface {
+public:
+    virtual void Publish() = 0;
+
+    AS_INTERFACE(SnapshotPublisherInterface);
+    DISALLOW_COPY_MOVE(SnapshotPublisherInterface);
+};
+
+class AC_EXPORT_IMPORT_DECL TraceReplayerInterface {
+public:
+    // Fed by the trace instead of the audio system; ResetContent() sees the recorded enumeration.
+    virtual DeviceCollectionInterface & GetCollection() = 0;
+    // speedFactor 1 keeps the recorded pace, N plays N times faster, 0 plays flat-out.
+    // Returns the number of delivered notifications.
+    virtual size_t Replay(double speedFactor) = 0;
+    virtual size_t GetNotificationCount() const = 0;
+
+    AS_INTERFACE(TraceReplayerInterface);
+    DISALLOW_COPY_MOVE(TraceReplayerInterface);
+};
+
+class AC_EXPORT_IMPORT_DECL TimedDeviceCollectionInterface {
+public:
+    virtual DeviceCollectionInterface & GetCollection() = 0;
+    // The time of ResetContent() not spent here is the overhead of the library.
+    virtual PlatformCallTimes GetPlatformCallTimes() const = 0;
+
+    AS_INTERFACE(TimedDeviceCollectionInterface);
+    DISALLOW_COPY_MOVE(TimedDeviceCollectionInterface);
+};
@@ -0,0 +1,122 @@
+/**
+ * @file AudioSnapshotLayout.h
+ * @brief Binary layout of the shared-memory device snapshot, Version 2.
+ *
+ * A publisher process writes the current device table into a named
+ * file mapping. Any number of reader processes can map it read-only and
+ * copy a consistent snapshot without COM and without callbacks.
+ *
+ * @note The region is protected by a sequence lock: the writer makes
+ *       AcSnapshotRegion::Sequence odd before changing the table and even
+ *       after it. A reader that sees an odd value or a different value
+ *       before and after its copy has to retry.
+ */
+
+#ifndef AUDIO_SNAPSHOT_LAYOUT_H
+#define AUDIO_SNAPSHOT_LAYOUT_H
+
+#include <Windows.h>
+
+#ifdef __cplusplus
+    extern "C" {
+#endif
+
+    /** @brief Signature of a valid snapshot region, "ACSP". */
+#define AC_SNAPSHOT_MAGIC 0x50534341u
+
+    /** @brief Layout version, incremented on every incompatible change. */
+#define AC_SNAPSHOT_VERSION 2u
+
+    /** @brief Maximal number of devices the region holds. */
+#define AC_SNAPSHOT_MAX_DEVICES 256u
+
+    /** @brief Name of the file mapping used if no other name is given. */
+#define AC_SNAPSHOT_DEFAULT_NAME L"Local\\PnPAudioCheckSnapshot"
+
+    /**
+     * @struct AcSnapshotDevice
+     * @brief One device record of the snapshot.
+     *
+     * @var AcSnapshotDevice::Guid
+     *  Plug-and-play (container) id of the device.
+     *
+     * @var AcSnapshotDevice::Name
+     *  The name of the device.
+     *
+     * @var AcSnapshotDevice::Flow
+     *  Data flow as a DeviceFlowEnum value: 1 render, 2 capture, 3 both.
+     *
+     * @var AcSnapshotDevice::FormFactor
+     *  Form factor as a DeviceFormFactor value, e.g. 5 headset; 10 unknown. Since Version 2.
+     *
+     * @var AcSnapshotDevice::RenderVolume
+     *  Render volume, 0..1000.
+     *
+     * @var AcSnapshotDevice::CaptureVolume
+     *  Capture volume, 0..1000.
+     *
+     * @var AcSnapshotDevice::JackConnection
+     *  Connector type as a DeviceJackConnection value; 0 unknown. Since Version 2.
+     */
+    typedef struct {
+        WCHAR Guid[40];
+        WCHAR Name[128];
+        UINT8 Flow;
+        UINT8 FormFactor;
+        UINT16 RenderVolume;
+        UINT16 CaptureVolume;
+        UINT8 JackConnection;
+        UINT8 Reserved;
+    } AcSnapshotDevice;
+
+    /**
+     * @struct AcSnapshotRegion
+     * @brief The whole shared-memory region.
+     *
+     * @var AcSnapshotRegion::Magic
+     *  Always AC_SNAPSHOT_MAGIC.
+     *
+     * @var AcSnapshotRegion::Version
+     *  Always AC_SNAPSHOT_VERSION of the publisher.
+     *
+     * @var AcSnapshotRegion::HeaderSize
+     *  Offset of the Devices array, allows readers to check the layout.
+     *
+     * @var AcSnapshotRegion::DeviceRecordSize
+     *  Size of one AcSnapshotDevice record.
+     *
+     * @var AcSnapshotRegion::Capacity
+     *  Number of records in the Devices array.
+     *
+     * @var AcSnapshotRegion::Count
+     *  Number of valid records, guarded by Sequence.
+     *
+     * @var AcSnapshotRegion::Sequence
+     *  Sequence lock counter; odd while the publisher writes.
+     *
+     * @var AcSnapshotRegion::PublishedAt
+     *  UTC time of the last publication as FILETIME ticks, guarded by Sequence.
+     */
+    typedef struct {
+        UINT32 Magic;
+        UINT32 Version;
+        UINT32 HeaderSize;
+        UINT32 DeviceRecordSize;
+        UINT32 Capacity;
+        UINT32 Count;
+        INT64 Sequence;
+        INT64 PublishedAt;
+        AcSnapshotDevice Devices[AC_SNAPSHOT_MAX_DEVICES];
+    } AcSnapshotRegion;
+
+#ifdef __cplusplus
+}
+
+#include <cstddef>
+
+static_assert(sizeof(AcSnapshotDevice) == 344, "AcSnapshotDevice layout changed");
+static_assert(offsetof(AcSnapshotRegion, Sequence) == 24, "AcSnapshotRegion layout changed");
+static_assert(offsetof(AcSnapshotRegion, Devices) == 40, "AcSnapshotRegion layout changed");
+#endif
+
+#endif // AUDIO_SNAPSHOT_LAYOUT_H
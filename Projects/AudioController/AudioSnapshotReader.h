@@ -0,0 +1,110 @@
+// ReSharper disable CppClangTidyModernizeUseNodiscard
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "AudioSnapshotLayout.h"
+#include "ClassDefHelper.h"
+
+namespace ed::audio {
+// Header-only reader of the shared-memory device snapshot. Needs neither COM nor the AudioController DLL.
+class AudioSnapshotReader final {
+public:
+    DISALLOW_COPY_MOVE(AudioSnapshotReader);
+    AudioSnapshotReader() = default;
+
+    ~AudioSnapshotReader()
+    {
+        Close();
+    }
+
+    bool Open(const std::wstring & regionName = AC_SNAPSHOT_DEFAULT_NAME)
+    {
+        Close();
+        mapping_ = OpenFileMappingW(FILE_MAP_READ, FALSE, regionName.c_str());
+        if (mapping_ == nullptr)
+        {
+            return false;
+        }
+        region_ = static_cast<const AcSnapshotRegion*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, sizeof(AcSnapshotRegion)));
+        if (region_ == nullptr
+            || region_->Magic != AC_SNAPSHOT_MAGIC
+            || region_->Version != AC_SNAPSHOT_VERSION
+            || region_->HeaderSize != offsetof(AcSnapshotRegion, Devices)
+            || region_->DeviceRecordSize != sizeof(AcSnapshotDevice)
+            || region_->Capacity > AC_SNAPSHOT_MAX_DEVICES)
+        {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close()
+    {
+        if (region_ != nullptr)
+        {
+            UnmapViewOfFile(region_);
+            region_ = nullptr;
+        }
+        if (mapping_ != nullptr)
+        {
+            CloseHandle(mapping_);
+            mapping_ = nullptr;
+        }
+    }
+
+    bool IsOpen() const
+    {
+        return region_ != nullptr;
+    }
+
+    // Cheap check whether anything changed since the last snapshot: one atomic load.
+    INT64 GetSequence() const
+    {
+        return region_ == nullptr ? 0 : SequenceRef().load(std::memory_order_acquire);
+    }
+
+    // Copies a consistent snapshot. Returns false if the region is not open or the publisher
+    // kept writing during all attempts.
+    bool TryRead(std::vector<AcSnapshotDevice> & devices, INT64 & sequence, INT64 & publishedAt, unsigned attempts = 1000) const
+    {
+        if (region_ == nullptr)
+        {
+            return false;
+        }
+        for (unsigned i = 0; i < attempts; ++i)
+        {
+            const auto before = SequenceRef().load(std::memory_order_acquire);
+            if ((before & 1) != 0)
+            {
+                YieldProcessor();
+                continue;
+            }
+            const auto count = (std::min)(region_->Count, region_->Capacity);
+            devices.assign(region_->Devices, region_->Devices + count);
+            publishedAt = region_->PublishedAt;
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (SequenceRef().load(std::memory_order_relaxed) == before)
+            {
+                sequence = before;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    std::atomic_ref<INT64> SequenceRef() const
+    {
+        // The view is mapped read-only, the reference is never stored to.
+        return std::atomic_ref(const_cast<INT64&>(region_->Sequence));  // NOLINT(cppcoreguidelines-pro-type-const-cast)
+    }
+
+    HANDLE mapping_ = nullptr;
+    const AcSnapshotRegion * region_ = nullptr;
+};
+}
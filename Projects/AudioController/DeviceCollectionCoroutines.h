@@ -0,0 +1,202 @@
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "AudioControlInterface.h"
+
+
+// Awaitable access to a device collection for coroutine-based clients (C++20, header-only):
+//
+//     auto events = ed::audio::coro::Events(collection, executor);
+//     for (auto batch = co_await events->NextBatch(); !batch.empty(); batch = co_await events->NextBatch())
+//         for (const auto & ev : batch) ...
+//
+//     co_await ed::audio::coro::ResetContentAsync(collection, executor);
+//
+// C++20 has no "for co_await", hence the explicit loop. A suspended consumer is resumed by the thread that
+// delivers the event, through the executor; an executor that resumes inline avoids any context switch.
+// A reset resumes from a thread of its own once the reset thread is done, so the coroutine may reset again or
+// destroy the collection; a failed reset throws from the co_await.
+namespace ed::audio::coro {
+using Executor = std::function<void(std::coroutine_handle<>)>;
+
+inline Executor InlineExecutor()
+{
+    return [](std::coroutine_handle<> handle) { handle.resume(); };
+}
+
+struct CollectionEvent {
+    DeviceCollectionEvent Event;
+    std::wstring PnpId;
+};
+
+class EventStream final : DeviceCollectionObserverInterface {
+public:
+    DISALLOW_COPY_MOVE(EventStream);
+
+    EventStream(DeviceCollectionInterface & collection, Executor executor)
+        : collection_(collection)
+          , executor_(std::move(executor))
+    {
+        collection_.Subscribe(*this);
+    }
+
+    ~EventStream() override
+    {
+        collection_.Unsubscribe(*this);
+    }
+
+    class BatchAwaiter {
+    public:
+        explicit BatchAwaiter(EventStream & stream) : stream_(stream) {}
+
+        bool await_ready() const
+        {
+            std::lock_guard lock(stream_.mutex_);
+            return !stream_.pending_.empty() || stream_.closed_;
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            std::lock_guard lock(stream_.mutex_);
+            if (!stream_.pending_.empty() || stream_.closed_)
+            {
+                return false;
+            }
+            stream_.waiter_ = handle;
+            return true;
+        }
+
+        // All events available at resumption; empty once the stream is closed.
+        std::vector<CollectionEvent> await_resume()
+        {
+            std::lock_guard lock(stream_.mutex_);
+            return std::exchange(stream_.pending_, {});
+        }
+
+    private:
+        EventStream & stream_;
+    };
+
+    BatchAwaiter NextBatch()
+    {
+        return BatchAwaiter(*this);
+    }
+
+    // Ends the stream: a waiting consumer is resumed with an empty batch.
+    void Close()
+    {
+        std::coroutine_handle<> waiter;
+        {
+            std::lock_guard lock(mutex_);
+            closed_ = true;
+            waiter = std::exchange(waiter_, {});
+        }
+        if (waiter)
+        {
+            executor_(waiter);
+        }
+    }
+
+private:
+    void OnCollectionChanged(DeviceCollectionEvent event, const std::wstring & devicePnpId) override
+    {
+        const DeviceCollectionChange change{event, devicePnpId};
+        OnCollectionChangedBatch(std::span(&change, 1));
+    }
+
+    // A burst resumes the consumer once, with all its changes in one batch
+    void OnCollectionChangedBatch(std::span<const DeviceCollectionChange> changes) override
+    {
+        std::coroutine_handle<> waiter;
+        {
+            std::lock_guard lock(mutex_);
+            if (closed_)
+            {
+                return;
+            }
+            for (const auto & [event, pnpId] : changes)
+            {
+                pending_.push_back({event, pnpId});
+            }
+            waiter = std::exchange(waiter_, {});
+        }
+        if (waiter)
+        {
+            executor_(waiter);
+        }
+    }
+
+    void OnTrace(const std::wstring &) override {}
+    void OnTraceDebug(const std::wstring &) override {}
+
+private:
+    DeviceCollectionInterface & collection_;
+    Executor executor_;
+    std::mutex mutex_;
+    std::vector<CollectionEvent> pending_;
+    std::coroutine_handle<> waiter_;
+    bool closed_ = false;
+};
+
+inline std::unique_ptr<EventStream> Events(DeviceCollectionInterface & collection, Executor executor = InlineExecutor())
+{
+    return std::make_unique<EventStream>(collection, std::move(executor));
+}
+
+class ResetContentAwaiter {
+public:
+    ResetContentAwaiter(DeviceCollectionInterface & collection, Executor executor)
+        : collection_(collection)
+          , executor_(std::move(executor))
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        future_ = collection_.ResetContentAsync(nullptr);
+        // Done at once, e.g. by a fake collection: not suspended at all
+        if (future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            return false;
+        }
+        // Not resumed by onCompleted, which runs on the reset thread. The awaiter may be gone as soon as the
+        // coroutine is resumed, so the waiting thread touches nothing afterwards.
+        std::thread([this, executor = executor_, handle]
+        {
+            future_.wait();
+            executor(handle);
+        }).detach();
+        return true;
+    }
+
+    void await_resume()
+    {
+        future_.get();
+    }
+
+private:
+    DeviceCollectionInterface & collection_;
+    Executor executor_;
+    std::future<void> future_;
+};
+
+inline ResetContentAwaiter ResetContentAsync(DeviceCollectionInterface & collection, Executor executor = InlineExecutor())
+{
+    return {collection, std::move(executor)};
+}
+}
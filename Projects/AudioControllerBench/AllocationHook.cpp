@@ -0,0 +1,79 @@
+#include "stdafx.h"
+
+#include "BenchHarness.h"
+
+#include <cstdlib>
+#include <new>
+
+
+// Replaceable global allocation functions counting the allocations per thread, for BenchResult::AllocationsPerIteration
+
+namespace
+{
+    thread_local uint64_t allocationCount = 0;
+
+    void * Allocate(size_t size) noexcept
+    {
+        ++allocationCount;
+        return malloc(size == 0 ? 1 : size);
+    }
+}
+
+uint64_t ed::bench::GetThreadAllocationCount() noexcept
+{
+    return allocationCount;
+}
+
+void * operator new(size_t size)
+{
+    if (void * memory = Allocate(size); memory != nullptr)
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void * operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void * operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return Allocate(size);
+}
+
+void * operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return Allocate(size);
+}
+
+void operator delete(void * memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void * memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void * memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void * memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void * memory, const std::nothrow_t &) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void * memory, const std::nothrow_t &) noexcept
+{
+    free(memory);
+}
@@ -0,0 +1,80 @@
+#include "stdafx.h"
+
+#include <iostream>
+
+#include "BenchHarness.h"
+
+
+namespace
+{
+    struct CommandLine {
+        std::string filter;
+        double minSeconds = 0.5;
+        std::wstring jsonFilePath;
+    };
+
+    bool ParseCommandLine(int argc, wchar_t * argv[], CommandLine & commandLine)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::wstring arg(argv[i]);
+            const auto equalPos = arg.find(L'=');
+            const auto name = arg.substr(0, equalPos);
+            const auto value = equalPos == std::wstring::npos ? std::wstring() : arg.substr(equalPos + 1);
+            if (name == L"--filter")
+            {
+                // Benchmark names are ASCII
+                commandLine.filter.clear();
+                for (const auto ch : value)
+                {
+                    commandLine.filter += static_cast<char>(ch);
+                }
+            }
+            else if (name == L"--min-time")
+            {
+                commandLine.minSeconds = std::wcstod(value.c_str(), nullptr);
+                if (commandLine.minSeconds <= 0.0)
+                {
+                    return false;
+                }
+            }
+            else if (name == L"--json")
+            {
+                commandLine.jsonFilePath = value;
+                if (value.empty())
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+
+int wmain(int argc, wchar_t * argv[])
+{
+    CommandLine commandLine;
+    if (!ParseCommandLine(argc, argv, commandLine))
+    {
+        std::wcout << L"Wrong command line!\nUsage: \"" << argv[0]
+            << "\" [--filter=<name substring>] [--min-time=<seconds per benchmark>] [--json=<result file>]\n";
+        return -1;
+    }
+
+    ed::bench::BenchRegistry registry;
+    ed::bench::RegisterUtilityBenchmarks(registry);
+    ed::bench::RegisterDeviceCollectionBenchmarks(registry);
+
+    const auto results = registry.Run(commandLine.filter, commandLine.minSeconds);
+    if (!commandLine.jsonFilePath.empty() && !ed::bench::BenchRegistry::TryWriteJson(commandLine.jsonFilePath, results))
+    {
+        std::wcout << L"Can not write " << commandLine.jsonFilePath << L".\n";
+        return 1;
+    }
+    return 0;
+}
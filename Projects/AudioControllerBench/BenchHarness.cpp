@@ -0,0 +1,256 @@
+#include "stdafx.h"
+
+#include "BenchHarness.h"
+
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+
+namespace
+{
+    constexpr uint64_t MaxIterations = 1'000'000'000;
+
+    std::string EscapeJson(const std::string & value)
+    {
+        std::string result;
+        for (const auto ch : value)
+        {
+            if (ch == '"' || ch == '\\')
+            {
+                result += '\\';
+            }
+            result += ch;
+        }
+        return result;
+    }
+
+    std::string ComposeName(const std::string & name, const std::vector<int64_t> & arguments)
+    {
+        auto result = name;
+        for (const auto argument : arguments)
+        {
+            result += '/' + std::to_string(argument);
+        }
+        return result;
+    }
+}
+
+
+ed::bench::BenchState::BenchState(std::vector<int64_t> arguments, uint64_t iterations)
+    : arguments_(std::move(arguments))
+    , iterations_(iterations)
+    , remaining_(iterations)
+{
+}
+
+bool ed::bench::BenchState::KeepRunning()
+{
+    if (remaining_ == iterations_ && !isRunning_)
+    {
+        ResumeTiming();
+    }
+    if (remaining_ > 0)
+    {
+        --remaining_;
+        return true;
+    }
+    PauseTiming();
+    return false;
+}
+
+int64_t ed::bench::BenchState::GetArgument(size_t index) const
+{
+    return index < arguments_.size() ? arguments_[index] : 0;
+}
+
+uint64_t ed::bench::BenchState::GetIterations() const
+{
+    return iterations_;
+}
+
+void ed::bench::BenchState::PauseTiming()
+{
+    if (isRunning_)
+    {
+        realSeconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - startedAt_).count();
+        cpuSeconds_ += GetThreadCpuSeconds() - startedCpuAt_;
+        allocations_ += GetThreadAllocationCount() - startedAllocationsAt_;
+        isRunning_ = false;
+    }
+}
+
+void ed::bench::BenchState::ResumeTiming()
+{
+    if (!isRunning_)
+    {
+        startedCpuAt_ = GetThreadCpuSeconds();
+        startedAllocationsAt_ = GetThreadAllocationCount();
+        startedAt_ = std::chrono::steady_clock::now();
+        isRunning_ = true;
+    }
+}
+
+void ed::bench::BenchState::SetItemsProcessed(uint64_t items)
+{
+    itemsProcessed_ = items;
+}
+
+double ed::bench::BenchState::GetRealSeconds() const
+{
+    return realSeconds_;
+}
+
+double ed::bench::BenchState::GetCpuSeconds() const
+{
+    return cpuSeconds_;
+}
+
+uint64_t ed::bench::BenchState::GetItemsProcessed() const
+{
+    return itemsProcessed_;
+}
+
+uint64_t ed::bench::BenchState::GetAllocations() const
+{
+    return allocations_;
+}
+
+/*static*/
+double ed::bench::BenchState::GetThreadCpuSeconds()
+{
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime))
+    {
+        return 0.0;
+    }
+    const auto toHundredsOfNs = [](const FILETIME & time)
+    {
+        return static_cast<double>((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime);
+    };
+    return (toHundredsOfNs(kernelTime) + toHundredsOfNs(userTime)) * 1e-7;
+}
+
+void ed::bench::BenchRegistry::Add(std::string name, BenchFunctionT function, std::vector<std::vector<int64_t>> argumentSets)
+{
+    entries_.push_back({std::move(name), std::move(function), std::move(argumentSets)});
+}
+
+std::vector<ed::bench::BenchResult> ed::bench::BenchRegistry::Run(const std::string & filter, double minSeconds) const
+{
+    std::cout << std::left << std::setw(72) << "Benchmark" << std::right
+        << std::setw(17) << "Time" << std::setw(17) << "CPU" << std::setw(12) << "Iterations" << std::setw(12) << "Allocs" << '\n';
+
+    std::vector<BenchResult> results;
+    for (const auto & entry : entries_)
+    {
+        for (const auto & arguments : entry.ArgumentSets)
+        {
+            const auto name = ComposeName(entry.Name, arguments);
+            if (name.find(filter) == std::string::npos)
+            {
+                continue;
+            }
+
+            for (uint64_t iterations = 1;;)
+            {
+                BenchState state(arguments, iterations);
+                entry.Function(state);
+
+                const auto realSeconds = state.GetRealSeconds();
+                if (realSeconds >= minSeconds || iterations >= MaxIterations)
+                {
+                    BenchResult result;
+                    result.Name = name;
+                    result.Iterations = iterations;
+                    result.RealTimeNs = realSeconds * 1e9 / static_cast<double>(iterations);
+                    result.CpuTimeNs = state.GetCpuSeconds() * 1e9 / static_cast<double>(iterations);
+                    result.ItemsPerSecond = realSeconds > 0.0
+                        ? static_cast<double>(state.GetItemsProcessed()) / realSeconds
+                        : 0.0;
+                    result.AllocationsPerIteration = static_cast<double>(state.GetAllocations()) / static_cast<double>(iterations);
+                    PrintResult(result);
+                    results.push_back(std::move(result));
+                    break;
+                }
+                // Aim at 1.4 times the minimum time, but grow at most tenfold per attempt
+                const auto predicted = realSeconds > 0.0
+                    ? static_cast<double>(iterations) * minSeconds * 1.4 / realSeconds
+                    : static_cast<double>(iterations) * 10.0;
+                iterations = static_cast<uint64_t>(
+                    (std::min)((std::max)(predicted, static_cast<double>(iterations) + 1.0), static_cast<double>(iterations) * 10.0));
+                iterations = (std::min)(iterations, MaxIterations);
+            }
+        }
+    }
+    return results;
+}
+
+/*static*/
+void ed::bench::BenchRegistry::PrintResult(const BenchResult & result)
+{
+    std::cout << std::left << std::setw(72) << result.Name << std::right
+        << std::fixed << std::setprecision(0)
+        << std::setw(14) << result.RealTimeNs << " ns"
+        << std::setw(14) << result.CpuTimeNs << " ns"
+        << std::setw(12) << result.Iterations
+        << std::setprecision(1) << std::setw(12) << result.AllocationsPerIteration;
+    if (result.ItemsPerSecond > 0.0)
+    {
+        std::cout << std::setprecision(0) << std::setw(14) << result.ItemsPerSecond << " items/s";
+    }
+    std::cout << '\n';
+}
+
+/*static*/
+bool ed::bench::BenchRegistry::TryWriteJson(const std::wstring & filePath, const std::vector<BenchResult> & results)
+{
+    std::ofstream stream(std::filesystem::path(filePath), std::ios::trunc);
+    if (!stream)
+    {
+        return false;
+    }
+
+    const auto now = std::time(nullptr);
+    tm localTime{};
+    // ReSharper disable once CppFunctionResultShouldBeUsed
+    localtime_s(&localTime, &now);
+
+    stream << "{\n"
+        << "  \"context\": {\n"
+        << "    \"date\": \"" << std::put_time(&localTime, "%Y-%m-%dT%H:%M:%S") << "\",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef _DEBUG
+        << "    \"library_build_type\": \"debug\"\n"
+#else
+        << "    \"library_build_type\": \"release\"\n"
+#endif
+        << "  },\n"
+        << "  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const auto & result = results[i];
+        const auto name = EscapeJson(result.Name);
+        stream << (i == 0 ? "\n" : ",\n")
+            << "    {\n"
+            << "      \"name\": \"" << name << "\",\n"
+            << "      \"run_name\": \"" << name << "\",\n"
+            << "      \"run_type\": \"iteration\",\n"
+            << "      \"iterations\": " << result.Iterations << ",\n"
+            << std::setprecision(3) << std::fixed
+            << "      \"real_time\": " << result.RealTimeNs << ",\n"
+            << "      \"cpu_time\": " << result.CpuTimeNs << ",\n"
+            << "      \"time_unit\": \"ns\",\n"
+            << "      \"allocs_per_iter\": " << result.AllocationsPerIteration;
+        if (result.ItemsPerSecond > 0.0)
+        {
+            stream << ",\n      \"items_per_second\": " << result.ItemsPerSecond;
+        }
+        stream << "\n    }";
+    }
+    stream << "\n  ]\n}\n";
+    return static_cast<bool>(stream);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+namespace ed::bench {
+// Passed to a benchmark body, which repeats its measured work while KeepRunning() returns true.
+// Set-up before the first KeepRunning() call is not measured.
+class BenchState final {
+public:
+    BenchState(std::vector<int64_t> arguments, uint64_t iterations);
+
+    [[nodiscard]] bool KeepRunning();
+    [[nodiscard]] int64_t GetArgument(size_t index) const;
+    [[nodiscard]] uint64_t GetIterations() const;
+
+    // Excludes per-iteration preparation from the measurement.
+    void PauseTiming();
+    void ResumeTiming();
+    // Items are reported per second, e.g. notifications delivered.
+    void SetItemsProcessed(uint64_t items);
+
+    [[nodiscard]] double GetRealSeconds() const;
+    [[nodiscard]] double GetCpuSeconds() const;
+    [[nodiscard]] uint64_t GetItemsProcessed() const;
+    [[nodiscard]] uint64_t GetAllocations() const;
+
+private:
+    static double GetThreadCpuSeconds();
+
+private:
+    const std::vector<int64_t> arguments_;
+    const uint64_t iterations_;
+    uint64_t remaining_;
+    bool isRunning_ = false;
+    std::chrono::steady_clock::time_point startedAt_;
+    double startedCpuAt_ = 0.0;
+    uint64_t startedAllocationsAt_ = 0;
+    double realSeconds_ = 0.0;
+    double cpuSeconds_ = 0.0;
+    uint64_t allocations_ = 0;
+    uint64_t itemsProcessed_ = 0;
+};
+
+using BenchFunctionT = std::function<void(BenchState &)>;
+
+struct BenchResult {
+    std::string Name;
+    uint64_t Iterations = 0;
+    double RealTimeNs = 0.0; // Per iteration
+    double CpuTimeNs = 0.0; // Per iteration, of the calling thread
+    double ItemsPerSecond = 0.0;
+    double AllocationsPerIteration = 0.0; // Heap allocations of the calling thread
+};
+
+// Minimal harness in the spirit of Google Benchmark: every benchmark runs with a doubling
+// iteration count until it lasts the minimum time; results go to the console and, on request,
+// to a JSON file in the Google Benchmark format, so the usual comparison tooling applies.
+class BenchRegistry final {
+public:
+    void Add(std::string name, BenchFunctionT function, std::vector<std::vector<int64_t>> argumentSets = {{}});
+    // Runs benchmarks whose name contains the filter.
+    std::vector<BenchResult> Run(const std::string & filter, double minSeconds) const;
+
+    static void PrintResult(const BenchResult & result);
+    static bool TryWriteJson(const std::wstring & filePath, const std::vector<BenchResult> & results);
+
+private:
+    struct Entry {
+        std::string Name;
+        BenchFunctionT Function;
+        std::vector<std::vector<int64_t>> ArgumentSets;
+    };
+
+    std::vector<Entry> entries_;
+};
+
+// Keeps the compiler from discarding a computed value.
+template <class T>
+void DoNotOptimize(const T & value)
+{
+    static const void * volatile sink;
+    sink = &value;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+// Heap allocations of the calling thread so far, counted by the replaced global operator new (AllocationHook.cpp)
+[[nodiscard]] uint64_t GetThreadAllocationCount() noexcept;
+
+void RegisterUtilityBenchmarks(BenchRegistry & registry);
+void RegisterDeviceCollectionBenchmarks(BenchRegistry & registry);
+}
@@ -0,0 +1,448 @@
+#include "stdafx.h"
+
+#include "BenchHarness.h"
+
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+#include "../AudioController/AudioControlInterface.h"
+#include "DeviceCollection.h"
+#include "RecordingAudioBackend.h"
+#include "SimulatedAudioBackend.h"
+#include "TraceReplayer.h"
+
+
+using namespace std::literals::string_literals;
+using namespace std::literals::chrono_literals;
+
+
+namespace ed::audio {
+// Reaches the private helpers of DeviceCollection; it is its friend.
+class DeviceCollectionBenchAccess final {
+public:
+    using TPnPIdToDeviceMap = DeviceCollection::TPnPIdToDeviceMap;
+
+    static Device MergeDeviceWithExistingOneBasedOnPnpIdAndFlow(const TPnPIdToDeviceMap & devices, const Device & device)
+    {
+        return DeviceCollection::MergeDeviceWithExistingOneBasedOnPnpIdAndFlow(devices, device);
+    }
+
+    static bool CheckRemovalAndUnmergeDeviceFromExistingOneBasedOnPnpIdAndFlow(
+        const DeviceCollection & collection, const Device & device, Device & unmergedDev)
+    {
+        return collection.CheckRemovalAndUnmergeDeviceFromExistingOneBasedOnPnpIdAndFlow(device, unmergedDev);
+    }
+
+    static std::vector<std::wstring> GetDevicePnPIdsWithChangedVolume(const TPnPIdToDeviceMap & old,
+                                                                      const TPnPIdToDeviceMap & updated)
+    {
+        return DeviceCollection::GetDevicePnPIdsWithChangedVolume(old, updated);
+    }
+};
+}
+
+
+namespace
+{
+    using ed::audio::Device;
+    using ed::audio::DeviceCollection;
+    using ed::audio::DeviceCollectionBenchAccess;
+    using ed::audio::SimulatedAudioBackend;
+    using ed::bench::BenchState;
+
+    const std::vector<std::vector<int64_t>> DeviceCounts = {{10}, {100}, {1000}, {10000}};
+
+    // Counts deliveries; stands for the one observer a real client has.
+    class CountingObserver final : public DeviceCollectionObserverInterface {
+    public:
+        void OnCollectionChanged(DeviceCollectionEvent, const std::wstring &) override
+        {
+            ++count_;
+        }
+        void OnTrace(const std::wstring &) override {}
+        void OnTraceDebug(const std::wstring &) override {}
+
+        [[nodiscard]] uint64_t GetCount() const
+        {
+            return count_;
+        }
+
+    private:
+        std::atomic<uint64_t> count_ = 0;
+    };
+
+    // A collection of render-and-capture containers, served by the simulated backend.
+    class SimulatedCollection final {
+    public:
+        explicit SimulatedCollection(size_t containerCount)
+        {
+            auto backend = std::make_unique<SimulatedAudioBackend>();
+            backend_ = backend.get();
+            backend_->Populate(containerCount, true);
+            collection_ = std::make_unique<DeviceCollection>(L""s, true, std::move(backend));
+            collection_->ResetContent();
+            collection_->Subscribe(observer_);
+        }
+
+        ~SimulatedCollection()
+        {
+            collection_->Unsubscribe(observer_);
+        }
+
+        SimulatedAudioBackend & GetBackend() const
+        {
+            return *backend_;
+        }
+
+        DeviceCollection & GetCollection() const
+        {
+            return *collection_;
+        }
+
+        [[nodiscard]] uint64_t GetDeliveredCount() const
+        {
+            return observer_.GetCount();
+        }
+
+    private:
+        CountingObserver observer_;
+        SimulatedAudioBackend * backend_;
+        std::unique_ptr<DeviceCollection> collection_;
+    };
+
+    // Reads the whole collection on every callback, as the CLI does when it reprints the list.
+    class ListingObserver final : public DeviceCollectionObserverInterface {
+    public:
+        explicit ListingObserver(const DeviceCollectionInterface & collection)
+            : collection_(collection)
+        {
+        }
+
+        void OnCollectionChanged(DeviceCollectionEvent, const std::wstring &) override
+        {
+            ListCollection();
+        }
+        void OnCollectionChangedBatch(std::span<const DeviceCollectionChange>) override
+        {
+            ListCollection();
+        }
+        void OnTrace(const std::wstring &) override {}
+        void OnTraceDebug(const std::wstring &) override {}
+
+    private:
+        void ListCollection() const
+        {
+            for (size_t i = 0; i < collection_.GetSize(); ++i)
+            {
+                ed::bench::DoNotOptimize(collection_.CreateItem(i));
+            }
+        }
+
+    private:
+        const DeviceCollectionInterface & collection_;
+    };
+
+    Device MakeDevice(size_t containerNumber, DeviceFlowEnum flow)
+    {
+        const auto endpoint = SimulatedAudioBackend::MakeEndpoint(containerNumber, flow);
+        return {
+            endpoint.ContainerId, endpoint.Name, flow,
+            flow == DeviceFlowEnum::Render ? endpoint.Volume : uint16_t{0},
+            flow == DeviceFlowEnum::Capture ? endpoint.Volume : uint16_t{0}
+        };
+    }
+
+    DeviceCollectionBenchAccess::TPnPIdToDeviceMap MakeDeviceMap(size_t containerCount, DeviceFlowEnum flow)
+    {
+        DeviceCollectionBenchAccess::TPnPIdToDeviceMap devices;
+        for (size_t i = 0; i < containerCount; ++i)
+        {
+            auto device = MakeDevice(i, flow);
+            devices.emplace(device.GetPnpId(), std::move(device));
+        }
+        return devices;
+    }
+
+    void MergeDeviceBench(BenchState & state)
+    {
+        const auto containerCount = static_cast<size_t>(state.GetArgument(0));
+        const auto devices = MakeDeviceMap(containerCount, DeviceFlowEnum::Render);
+        const auto capture = MakeDevice(containerCount / 2, DeviceFlowEnum::Capture);
+        while (state.KeepRunning())
+        {
+            ed::bench::DoNotOptimize(DeviceCollectionBenchAccess::MergeDeviceWithExistingOneBasedOnPnpIdAndFlow(devices, capture));
+        }
+    }
+
+    void CheckRemovalAndUnmergeBench(BenchState & state)
+    {
+        const auto containerCount = static_cast<size_t>(state.GetArgument(0));
+        const SimulatedCollection simulated(containerCount);
+        const auto capture = MakeDevice(containerCount / 2, DeviceFlowEnum::Capture);
+        while (state.KeepRunning())
+        {
+            Device unmerged;
+            ed::bench::DoNotOptimize(DeviceCollectionBenchAccess::CheckRemovalAndUnmergeDeviceFromExistingOneBasedOnPnpIdAndFlow(
+                simulated.GetCollection(), capture, unmerged));
+            ed::bench::DoNotOptimize(unmerged);
+        }
+    }
+
+    void GetDevicePnPIdsWithChangedVolumeBench(BenchState & state)
+    {
+        const auto containerCount = static_cast<size_t>(state.GetArgument(0));
+        const auto old = MakeDeviceMap(containerCount, DeviceFlowEnum::Render);
+        auto updated = old;
+        updated.begin()->second.SetCurrentRenderVolume(100);
+        while (state.KeepRunning())
+        {
+            ed::bench::DoNotOptimize(DeviceCollectionBenchAccess::GetDevicePnPIdsWithChangedVolume(old, updated));
+        }
+        state.SetItemsProcessed(state.GetIterations() * containerCount);
+    }
+
+    void CreateItemIterationBench(BenchState & state)
+    {
+        const SimulatedCollection simulated(static_cast<size_t>(state.GetArgument(0)));
+        const auto & collection = simulated.GetCollection();
+        const auto size = collection.GetSize();
+        while (state.KeepRunning())
+        {
+            for (size_t i = 0; i < size; ++i)
+            {
+                ed::bench::DoNotOptimize(collection.CreateItem(i));
+            }
+        }
+        state.SetItemsProcessed(state.GetIterations() * size);
+    }
+
+    // "All muted microphones whose name starts with ...", to compare with a client-side scan by CreateItemIteration
+    void FindDevicesBench(BenchState & state)
+    {
+        const SimulatedCollection simulated(static_cast<size_t>(state.GetArgument(0)));
+        simulated.GetBackend().SetVolume(SimulatedAudioBackend::MakeEndpoint(7, DeviceFlowEnum::Capture).EndpointId, 0, true);
+        const auto & collection = simulated.GetCollection();
+        const DeviceQuery query{.Flow = DeviceFlowEnum::Capture, .NamePrefix = L"Microphone (Simulated Device 7", .MaxVolume = 0};
+        while (state.KeepRunning())
+        {
+            ed::bench::DoNotOptimize(collection.FindDevices(query));
+        }
+        state.SetItemsProcessed(state.GetIterations());
+    }
+
+    // One iteration moves the default render device to another container and back, delivering DefaultChanged,
+    // and asks for it; the query is answered from memory without asking the backend
+    void DefaultDeviceChangeBench(BenchState & state)
+    {
+        const auto containerCount = static_cast<size_t>(state.GetArgument(0));
+        const SimulatedCollection simulated(containerCount);
+        const auto & collection = simulated.GetCollection();
+        const auto first = SimulatedAudioBackend::MakeEndpoint(0, DeviceFlowEnum::Render);
+        const auto middle = SimulatedAudioBackend::MakeEndpoint(containerCount / 2, DeviceFlowEnum::Render);
+        auto & backend = simulated.GetBackend();
+        while (state.KeepRunning())
+        {
+            backend.SetDefaultEndpoint(DeviceFlowEnum::Render, DeviceRole::Console, middle.EndpointId);
+            ed::bench::DoNotOptimize(collection.GetDefaultDevice(DeviceFlowEnum::Render, DeviceRole::Console));
+            backend.SetDefaultEndpoint(DeviceFlowEnum::Render, DeviceRole::Console, first.EndpointId);
+            ed::bench::DoNotOptimize(collection.GetDefaultDevice(DeviceFlowEnum::Render, DeviceRole::Console));
+        }
+        state.SetItemsProcessed(state.GetIterations() * 2);
+    }
+
+    // One iteration renames an endpoint of the middle device and back, delivering PropertyChanged; each reads
+    // the one property of the one endpoint instead of enumerating
+    void PropertyChangeBench(BenchState & state)
+    {
+        const auto containerCount = static_cast<size_t>(state.GetArgument(0));
+        const SimulatedCollection simulated(containerCount);
+        const auto middle = SimulatedAudioBackend::MakeEndpoint(containerCount / 2, DeviceFlowEnum::Render);
+        auto & backend = simulated.GetBackend();
+        while (state.KeepRunning())
+        {
+            backend.SetEndpointName(middle.EndpointId, L"Speakers (Renamed)"s);
+            backend.SetEndpointName(middle.EndpointId, middle.Name);
+        }
+        state.SetItemsProcessed(state.GetIterations() * 2);
+    }
+
+    // One iteration narrows the view to one device and widens it again, from the endpoint facts in memory
+    void SetFilterBench(BenchState & state)
+    {
+        const SimulatedCollection simulated(static_cast<size_t>(state.GetArgument(0)));
+        auto & collection = simulated.GetCollection();
+        while (state.KeepRunning())
+        {
+            collection.SetFilter(L"(Simulated Device 7)"s);
+            collection.SetFilter(L""s);
+        }
+        state.SetItemsProcessed(state.GetIterations() * 2);
+    }
+
+    void ResetContentBench(BenchState & state)
+    {
+        const SimulatedCollection simulated(static_cast<size_t>(state.GetArgument(0)));
+        while (state.KeepRunning())
+        {
+            simulated.GetCollection().ResetContent();
+        }
+    }
+
+    // One iteration plugs a capture endpoint into an existing render container and unplugs it again.
+    void DeviceAddRemoveBench(BenchState & state)
+    {
+        const auto containerCount = static_cast<size_t>(state.GetArgument(0));
+        const SimulatedCollection simulated(containerCount);
+        const auto endpoint = SimulatedAudioBackend::MakeEndpoint(containerCount / 2, DeviceFlowEnum::Capture);
+        auto & backend = simulated.GetBackend();
+        backend.RemoveEndpoint(endpoint.EndpointId);
+        while (state.KeepRunning())
+        {
+            backend.SetEndpointState(endpoint.EndpointId, DEVICE_STATE_ACTIVE);
+            backend.SetEndpointState(endpoint.EndpointId, DEVICE_STATE_NOTPRESENT);
+        }
+        state.SetItemsProcessed(state.GetIterations() * 2);
+    }
+
+    void VolumeChangeBench(BenchState & state)
+    {
+        const auto containerCount = static_cast<size_t>(state.GetArgument(0));
+        const SimulatedCollection simulated(containerCount);
+        const auto endpoint = SimulatedAudioBackend::MakeEndpoint(containerCount / 2, DeviceFlowEnum::Render);
+        auto & backend = simulated.GetBackend();
+        uint16_t volume = 0;
+        while (state.KeepRunning())
+        {
+            volume = static_cast<uint16_t>((volume + 1) % 1000);
+            backend.SetVolume(endpoint.EndpointId, volume);
+        }
+        state.SetItemsProcessed(state.GetIterations());
+    }
+
+    // Several threads raise notifications at once, as the audio service does when a dock is plugged:
+    // each thread changes the volume of its own render endpoint three times and re-plugs its own
+    // capture endpoint once per round. Items are notifications delivered to the observer.
+    void NotificationStormBench(BenchState & state)
+    {
+        constexpr size_t ContainerCount = 1000;
+        constexpr unsigned RoundsPerThread = 5;
+        const auto threadCount = static_cast<unsigned>(state.GetArgument(0));
+        const SimulatedCollection simulated(ContainerCount);
+        auto & backend = simulated.GetBackend();
+
+        const auto deliveredBefore = simulated.GetDeliveredCount();
+        while (state.KeepRunning())
+        {
+            std::vector<std::thread> threads;
+            threads.reserve(threadCount);
+            for (unsigned t = 0; t < threadCount; ++t)
+            {
+                threads.emplace_back([&backend, t]
+                {
+                    const auto render = SimulatedAudioBackend::MakeEndpoint(t, DeviceFlowEnum::Render);
+                    const auto capture = SimulatedAudioBackend::MakeEndpoint(t, DeviceFlowEnum::Capture);
+                    for (unsigned round = 0; round < RoundsPerThread; ++round)
+                    {
+                        backend.SetVolume(render.EndpointId, static_cast<uint16_t>(100 + round));
+                        backend.SetVolume(render.EndpointId, static_cast<uint16_t>(200 + round));
+                        backend.RemoveEndpoint(capture.EndpointId);
+                        backend.SetVolume(render.EndpointId, static_cast<uint16_t>(300 + round));
+                        backend.SetEndpointState(capture.EndpointId, DEVICE_STATE_ACTIVE);
+                    }
+                });
+            }
+            for (auto & thread : threads)
+            {
+                thread.join();
+            }
+        }
+        state.SetItemsProcessed(simulated.GetDeliveredCount() - deliveredBefore);
+    }
+
+    // A dock of 8 headsets reconnected: each endpoint is removed, re-added and flaps its state once.
+    // Recorded once per process; the replay serves the recorded answers.
+    const std::wstring & GetHotPlugStormTrace()
+    {
+        static const auto traceFile = []
+        {
+            constexpr size_t ContainerCount = 100;
+            constexpr size_t DockedCount = 8;
+            auto file = (std::filesystem::temp_directory_path() / L"AudioControllerBenchHotPlugStorm.actrace").wstring();
+            auto simulated = std::make_unique<SimulatedAudioBackend>();
+            auto & simulation = *simulated;
+            simulation.Populate(ContainerCount, true);
+            DeviceCollection collection(L""s, true, std::make_unique<ed::audio::RecordingAudioBackend>(std::move(simulated), file));
+            collection.ResetContent();
+            for (const auto flow : {DeviceFlowEnum::Render, DeviceFlowEnum::Capture})
+            {
+                for (size_t i = 0; i < DockedCount; ++i)
+                {
+                    simulation.RemoveEndpoint(SimulatedAudioBackend::MakeEndpoint(i, flow).EndpointId);
+                }
+            }
+            for (const auto flow : {DeviceFlowEnum::Render, DeviceFlowEnum::Capture})
+            {
+                for (size_t i = 0; i < DockedCount; ++i)
+                {
+                    const auto endpoint = SimulatedAudioBackend::MakeEndpoint(i, flow);
+                    simulation.AddEndpoint(endpoint);
+                    simulation.SetEndpointState(endpoint.EndpointId, DEVICE_STATE_UNPLUGGED);
+                    simulation.SetEndpointState(endpoint.EndpointId, DEVICE_STATE_ACTIVE);
+                }
+            }
+            return file;
+        }();
+        return traceFile;
+    }
+
+    // The argument is the burst window in ms, 0 for none. Items are replayed notifications; an
+    // iteration lasts until the last of them is delivered, and the observer lists the collection per callback.
+    void HotPlugStormReplayBench(BenchState & state)
+    {
+        const auto burstWindow = std::chrono::milliseconds(state.GetArgument(0));
+        const auto & traceFile = GetHotPlugStormTrace();
+        uint64_t notificationCount = 0;
+        while (state.KeepRunning())
+        {
+            state.PauseTiming();
+            ed::audio::TraceReplayer replayer(traceFile, L""s, true);
+            auto & collection = replayer.GetCollection();
+            collection.ResetContent();
+            ListingObserver observer(collection);
+            collection.Subscribe(observer);
+            collection.SetBurstWindow(burstWindow);
+            state.ResumeTiming();
+
+            notificationCount += replayer.Replay(0.0);
+            while (collection.GetOperationalCounters().PendingNotifications != 0)
+            {
+                std::this_thread::sleep_for(100us);
+            }
+
+            state.PauseTiming();
+            collection.SetBurstWindow(0ms);
+            collection.Unsubscribe(observer);
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(notificationCount);
+    }
+}
+
+
+void ed::bench::RegisterDeviceCollectionBenchmarks(BenchRegistry & registry)
+{
+    registry.Add("MergeDeviceWithExistingOneBasedOnPnpIdAndFlow", MergeDeviceBench, DeviceCounts);
+    registry.Add("CheckRemovalAndUnmergeDeviceFromExistingOneBasedOnPnpIdAndFlow", CheckRemovalAndUnmergeBench, DeviceCounts);
+    registry.Add("GetDevicePnPIdsWithChangedVolume", GetDevicePnPIdsWithChangedVolumeBench, DeviceCounts);
+    registry.Add("CreateItemIteration", CreateItemIterationBench, DeviceCounts);
+    registry.Add("FindDevices", FindDevicesBench, DeviceCounts);
+    registry.Add("SetFilter", SetFilterBench, DeviceCounts);
+    registry.Add("DefaultDeviceChange", DefaultDeviceChangeBench, DeviceCounts);
+    registry.Add("PropertyChange", PropertyChangeBench, DeviceCounts);
+    registry.Add("ResetContent", ResetContentBench, DeviceCounts);
+    registry.Add("DeviceAddRemove", DeviceAddRemoveBench, DeviceCounts);
+    registry.Add("VolumeChange", VolumeChangeBench, DeviceCounts);
+    registry.Add("NotificationStorm", NotificationStormBench, {{1}, {2}, {4}, {8}});
+    registry.Add("HotPlugStormReplay", HotPlugStormReplayBench, {{0}, {2}, {10}});
+}
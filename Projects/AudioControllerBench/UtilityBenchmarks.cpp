@@ -0,0 +1,51 @@
+#include "stdafx.h"
+
+#include "BenchHarness.h"
+
+#include "CaseInsensitiveSubstr.h"
+#include "Utilities.h"
+
+
+namespace
+{
+    // Typical endpoint name, and a merged one of a render-and-capture container
+    const std::wstring ShortName = L"Speakers (Realtek High Definition Audio)";
+    const std::wstring MergedName =
+        L"Headset Microphone (Jabra Evolve2 85)/Headset Earphone (Jabra Evolve2 85)/Speakers (Jabra Evolve2 85)";
+
+    void FindSubstrCaseInsensitiveBench(ed::bench::BenchState & state)
+    {
+        const auto & haystack = state.GetArgument(0) == 0 ? ShortName : MergedName;
+        // Absent needle: the whole haystack is scanned, as for most devices when a filter is set
+        const std::wstring needle = L"bluetooth";
+        while (state.KeepRunning())
+        {
+            ed::bench::DoNotOptimize(FindSubstrCaseInsensitive(haystack, needle));
+        }
+    }
+
+    void SplitBench(ed::bench::BenchState & state)
+    {
+        while (state.KeepRunning())
+        {
+            ed::bench::DoNotOptimize(Split(MergedName, L'/'));
+        }
+    }
+
+    void MergeBench(ed::bench::BenchState & state)
+    {
+        const auto parts = Split(MergedName, L'/');
+        while (state.KeepRunning())
+        {
+            ed::bench::DoNotOptimize(Merge(parts, L'/'));
+        }
+    }
+}
+
+
+void ed::bench::RegisterUtilityBenchmarks(BenchRegistry & registry)
+{
+    registry.Add("FindSubstrCaseInsensitive", FindSubstrCaseInsensitiveBench, {{0}, {1}});
+    registry.Add("Split", SplitBench);
+    registry.Add("Merge", MergeBench);
+}
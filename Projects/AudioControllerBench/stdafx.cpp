@@ -0,0 +1,2 @@
+#include "stdafx.h"
+
@@ -2,14 +2,20 @@
 
 #include <SpdLogger.h>
 
+#include <array>
 #include <filesystem>
 #include <iomanip>
 #include <memory>
+#include <optional>
 #include <tchar.h>
 
 #include "../AudioControllerLib/CoInitRaiiHelper.h"
 #include "../AudioController/AudioControlInterface.h"
+#include "../AudioController/AudioSnapshotLayout.h"
 #include "../AudioControllerLib/DefToString.h"
+#include "BenchMode.h"
+#include "ReplayMode.h"
+#include "ServeMode.h"
 #include "TimeUtils.h" // Include the header for TimeUtils
 
 namespace
@@ -54,9 +60,14 @@ public:
         std::wcout << CurrentLocalTimeWithoutDate << L"[" << i << L"]: " << idAsWideString
             << L", \"" << device->GetName()
             << L"\", " << ed::GetFlowAsString(device->GetFlow())
+            << L", " << ed::GetFormFactorAsString(device->GetFormFactor())
             << L", Volume " << device->GetCurrentRenderVolume()
-			<< L" / " << device->GetCurrentCaptureVolume()
-            << '\n';
+			<< L" / " << device->GetCurrentCaptureVolume();
+        if (const auto defaultRoles = ed::GetDefaultRolesAsString(*device); !defaultRoles.empty())
+        {
+            std::wcout << L", default " << defaultRoles;
+        }
+        std::wcout << '\n';
     }
 
     void PrintCollection() const
@@ -76,11 +87,38 @@ public:
         PrintCollection();
     }
 
+    // Devices are printed via OnCollectionChanged as they are probed; reports the time to the first one.
+    void ResetCollectionContentAsyncAndWait()
+    {
+        std::wcout << CurrentLocalTimeWithoutDate << L"Regenerating device list asynchronously.\n";
+        firstDiscoveredAt_.reset();
+        const auto start = std::chrono::steady_clock::now();
+        collection_.ResetContentAsync(nullptr).get();
+        const auto finished = std::chrono::steady_clock::now();
+
+        if (firstDiscoveredAt_.has_value())
+        {
+            std::wcout << CurrentLocalTimeWithoutDate << L"First device after "
+                << std::chrono::duration<double, std::milli>(*firstDiscoveredAt_ - start).count() << L" ms, ";
+        }
+        std::wcout << L"enumeration completed after " << std::chrono::duration<double, std::milli>(finished - start).count() << L" ms.\n";
+        PrintCollection();
+    }
+
     void OnCollectionChanged(DeviceCollectionEvent event, const std::wstring& devicePnpId) override
     {
-        std::wcout << '\n' << CurrentLocalTimeWithoutDate << L"Event caught: " << ed::GetDeviceCollectionEventAsString(event) << L"."
-            <<  L" Device PnP id: " << devicePnpId << L'\n';
+        PrintEvent(event, devicePnpId);
+        PrintCollection();
+    }
 
+    // A burst: all its events, then the collection once
+    void OnCollectionChangedBatch(std::span<const DeviceCollectionChange> changes) override
+    {
+        std::wcout << '\n' << CurrentLocalTimeWithoutDate << L"Burst of " << changes.size() << L" change(s) caught.";
+        for (const auto & [event, pnpId] : changes)
+        {
+            PrintEvent(event, pnpId);
+        }
         PrintCollection();
     }
 
@@ -100,8 +138,20 @@ public:
         OnTrace(line);
     }
 
+private:
+    void PrintEvent(DeviceCollectionEvent event, const std::wstring& devicePnpId)
+    {
+        if (event == DeviceCollectionEvent::Discovered && !firstDiscoveredAt_.has_value())
+        {
+            firstDiscoveredAt_ = std::chrono::steady_clock::now();
+        }
+        std::wcout << '\n' << CurrentLocalTimeWithoutDate << L"Event caught: " << ed::GetDeviceCollectionEventAsString(event) << L"."
+            <<  L" Device PnP id: " << devicePnpId << L'\n';
+    }
+
 private:
     DeviceCollectionInterface & collection_;
+    std::optional<std::chrono::steady_clock::time_point> firstDiscoveredAt_;
 };
 
 bool StopAndWaitForInput()
@@ -123,6 +173,242 @@ bool StopAndWaitForInput()
     }
 }
 
+double ElapsedMilliseconds(std::chrono::steady_clock::time_point since)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+void PrintLatencyStatistics(const DeviceCollectionInterface & collection)
+{
+    constexpr std::array<const wchar_t *, LatencyKindCount> kindNames = {
+        L"DeviceAdded", L"DeviceRemoved", L"DeviceStateChanged", L"VolumeChanged",
+        L"ResetContent", L"  Enumeration", L"  Probing", L"  Applying", L"DefaultDeviceChanged", L"PropertyValueChanged"
+    };
+    const auto statistics = collection.GetLatencyStatistics();
+    const auto toMicroseconds = [](std::chrono::nanoseconds duration)
+    {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    };
+
+    std::wcout << std::left << std::setw(22) << L"Latency [us]" << std::right << std::setw(10) << L"count"
+        << std::setw(12) << L"mean" << std::setw(12) << L"p50" << std::setw(12) << L"p90"
+        << std::setw(12) << L"p99" << std::setw(12) << L"p99.9" << std::setw(12) << L"max" << L'\n';
+    for (size_t i = 0; i < LatencyKindCount; ++i)
+    {
+        const auto & summary = statistics[i];
+        std::wcout << std::left << std::setw(22) << kindNames[i] << std::right << std::setw(10) << summary.Count
+            << std::fixed << std::setprecision(1)
+            << std::setw(12) << toMicroseconds(summary.Mean) << std::setw(12) << toMicroseconds(summary.P50)
+            << std::setw(12) << toMicroseconds(summary.P90) << std::setw(12) << toMicroseconds(summary.P99)
+            << std::setw(12) << toMicroseconds(summary.P999) << std::setw(12) << toMicroseconds(summary.Max) << L'\n';
+    }
+}
+
+void PrintOperationalCounters(const DeviceCollectionInterface & collection)
+{
+    const auto counters = collection.GetOperationalCounters();
+    const std::array<std::pair<const wchar_t *, uint64_t>, 15> rows = {{
+        {L"DeviceAdded notifications", counters.DeviceAddedNotifications},
+        {L"DeviceRemoved notifications", counters.DeviceRemovedNotifications},
+        {L"DeviceStateChanged notifications", counters.DeviceStateChangedNotifications},
+        {L"Volume notifications", counters.VolumeNotifications},
+        {L"DefaultDeviceChanged notifications", counters.DefaultDeviceChangedNotifications},
+        {L"PropertyValueChanged notifications", counters.PropertyValueChangedNotifications},
+        {L"Events delivered", counters.EventsDelivered},
+        {L"Notifications suppressed", counters.NotificationsSuppressed},
+        {L"Notifications deduplicated", counters.NotificationsDeduplicated},
+        {L"Full enumerations", counters.Enumerations},
+        {L"Property store opens", counters.PropertyStoreOpens},
+        {L"Endpoint activations", counters.EndpointActivations},
+        {L"Volume callbacks (now)", counters.VolumeCallbacks},
+        {L"Observers (now)", counters.Observers},
+        {L"Pending notifications (now)", counters.PendingNotifications}
+    }};
+    for (const auto & [name, value] : rows)
+    {
+        std::wcout << std::left << std::setw(38) << name << std::right << std::setw(10) << value << L'\n';
+    }
+}
+
+struct CommandLine {
+    std::wstring filter;
+    bool bothHeadsetAndMicro = false;
+    bool publishSnapshot = false;
+    std::wstring snapshotRegionName = AC_SNAPSHOT_DEFAULT_NAME;
+    bool serve = false;
+    std::wstring pipeName = ed::audio::DefaultEventPipeName;
+    size_t serveBenchSubscribers = 0;
+    size_t serveBenchEvents = 100000;
+    bool asyncReset = false;
+    bool warmStart = false;
+    std::wstring cacheFilePath;
+    std::wstring recordFilePath;
+    std::wstring replayFilePath;
+    double replaySpeedFactor = 1.0;
+    size_t benchCycles = 0;
+    bool printStatistics = false;
+    std::wstring timelineFilePath;
+    std::chrono::milliseconds burstWindow{0};
+};
+
+// Records a timeline, if requested, and writes it whichever mode the process ran in
+class TimelineTraceScope final {
+public:
+    DISALLOW_COPY_MOVE(TimelineTraceScope);
+    explicit TimelineTraceScope(std::wstring filePath)
+        : filePath_(std::move(filePath))
+    {
+        if (!filePath_.empty())
+        {
+            AudioControl::StartTimelineTrace();
+        }
+    }
+    ~TimelineTraceScope()
+    {
+        if (filePath_.empty())
+        {
+            return;
+        }
+        if (AudioControl::StopTimelineTrace(filePath_))
+        {
+            std::wcout << CurrentLocalTimeWithoutDate << L"Timeline written to \"" << filePath_ << L"\".\n";
+        }
+        else
+        {
+            std::wcout << CurrentLocalTimeWithoutDate << L"Can not write the timeline \"" << filePath_ << L"\".\n";
+        }
+    }
+
+private:
+    const std::wstring filePath_;
+};
+
+bool ParseCommandLine(int argc, _TCHAR * argv[], CommandLine & commandLine)
+{
+    std::vector<std::wstring> positional;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::wstring arg(argv[i]);
+        if (!arg.starts_with(L"--"))
+        {
+            positional.push_back(arg);
+            continue;
+        }
+        const auto equalPos = arg.find(L'=');
+        const auto name = arg.substr(0, equalPos);
+        const auto value = equalPos == std::wstring::npos ? std::wstring() : arg.substr(equalPos + 1);
+        if (name == L"--publish")
+        {
+            commandLine.publishSnapshot = true;
+            if (!value.empty())
+            {
+                commandLine.snapshotRegionName = value;
+            }
+        }
+        else if (name == L"--serve")
+        {
+            commandLine.serve = true;
+            if (!value.empty())
+            {
+                commandLine.pipeName = value;
+            }
+        }
+        else if (name == L"--async")
+        {
+            commandLine.asyncReset = true;
+        }
+        else if (name == L"--warm-start")
+        {
+            commandLine.warmStart = true;
+            commandLine.cacheFilePath = value;
+        }
+        else if (name == L"--record")
+        {
+            commandLine.recordFilePath = value;
+            if (value.empty())
+            {
+                return false;
+            }
+        }
+        else if (name == L"--replay")
+        {
+            // --replay=<trace file>[,<speed factor, 0 flat-out>]
+            const auto commaPos = value.find(L',');
+            commandLine.replayFilePath = value.substr(0, commaPos);
+            if (commaPos != std::wstring::npos)
+            {
+                commandLine.replaySpeedFactor = std::wcstod(value.substr(commaPos + 1).c_str(), nullptr);
+            }
+            if (commandLine.replayFilePath.empty() || commandLine.replaySpeedFactor < 0.0)
+            {
+                return false;
+            }
+        }
+        else if (name == L"--stats")
+        {
+            commandLine.printStatistics = true;
+        }
+        else if (name == L"--burst")
+        {
+            // --burst[=<quiet window in ms>]
+            commandLine.burstWindow = std::chrono::milliseconds(value.empty() ? 50 : std::wcstol(value.c_str(), nullptr, 10));
+            if (commandLine.burstWindow <= std::chrono::milliseconds::zero())
+            {
+                return false;
+            }
+        }
+        else if (name == L"--timeline")
+        {
+            commandLine.timelineFilePath = value;
+            if (value.empty())
+            {
+                return false;
+            }
+        }
+        else if (name == L"--bench")
+        {
+            // --bench[=<ResetContent cycles>]
+            commandLine.benchCycles = value.empty() ? 100 : std::wcstoul(value.c_str(), nullptr, 10);
+            if (commandLine.benchCycles == 0)
+            {
+                return false;
+            }
+        }
+        else if (name == L"--serve-bench")
+        {
+            // --serve-bench=<subscribers>[,<events>]
+            const auto commaPos = value.find(L',');
+            commandLine.serveBenchSubscribers = std::wcstoul(value.substr(0, commaPos).c_str(), nullptr, 10);
+            if (commaPos != std::wstring::npos)
+            {
+                commandLine.serveBenchEvents = std::wcstoul(value.substr(commaPos + 1).c_str(), nullptr, 10);
+            }
+            if (commandLine.serveBenchSubscribers == 0)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    if (positional.size() > 2)
+    {
+        return false;
+    }
+    if (!positional.empty())
+    {
+        commandLine.filter = positional[0];
+    }
+    if (positional.size() > 1)
+    {
+        commandLine.bothHeadsetAndMicro = positional[1][0] != L'0';
+    }
+    return true;
+}
+
 int _tmain(int argc, _TCHAR * argv[])
 {
     _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
@@ -131,38 +417,134 @@ int _tmain(int argc, _TCHAR * argv[])
     _CrtSetReportFile(_CRT_WARN, _CRTDBG_FILE_STDOUT);
     _CrtSetReportFile(_CRT_ERROR, _CRTDBG_FILE_STDERR);
 
-    bool bothHeadsetAndMicro = false;
-    std::wstring filter;
-    if (argc > 1)
+    CommandLine commandLine;
+    if (!ParseCommandLine(argc, argv, commandLine))
     {
-        filter = std::wstring(argv[1]);
+        std::wcout << L"Wrong command line!\nUsage: \"" << argv[0]
+            << "\" [--publish[=<region name>]] [--serve[=<pipe name>]] [--serve-bench=<subscribers>[,<events>]]"
+            " [--warm-start[=<cache file>]] [--async] [--record=<trace file>] [--replay=<trace file>[,<speed factor>]]"
+            " [--bench[=<cycles>]] [--stats] [--timeline=<json file>] [--burst[=<quiet window ms>]]"
+            " <filter substring> [<both headset and micro, 0 or 1>]\n";
+        return -1;
     }
 
-    if (argc > 2)
+    // Created before any collection, so it outlives them all
+    const TimelineTraceScope timelineTrace(commandLine.timelineFilePath);
+
+    if (commandLine.serveBenchSubscribers > 0)
     {
-        bothHeadsetAndMicro = argv[2][0] != L'0';
+        return ed::audio::RunServeBenchmark(commandLine.serveBenchSubscribers, commandLine.serveBenchEvents);
     }
 
-    if (argc > 3)
+    if (!commandLine.replayFilePath.empty())
     {
-        std::wcout << L"Wrong command line!\nUsage: \"" << argv[0] << "\" <filter substring>\n";
-        return -1;
+        return ed::audio::RunReplay(commandLine.replayFilePath, commandLine.replaySpeedFactor, commandLine.filter, commandLine.bothHeadsetAndMicro);
     }
 
     ed::CoInitRaiiHelper coInitHelper;
-    const auto coll(AudioControl::CreateDeviceCollection(filter, bothHeadsetAndMicro));
+    if (commandLine.benchCycles > 0)
+    {
+        return ed::audio::RunBench(commandLine.benchCycles, commandLine.filter, commandLine.bothHeadsetAndMicro);
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto coll(commandLine.recordFilePath.empty()
+        ? AudioControl::CreateDeviceCollection(commandLine.filter, commandLine.bothHeadsetAndMicro)
+        : AudioControl::CreateRecordingDeviceCollection(commandLine.filter, commandLine.bothHeadsetAndMicro, commandLine.recordFilePath));
     Observer o(*coll);
     coll->Subscribe(o);
+    if (commandLine.burstWindow > std::chrono::milliseconds::zero())
+    {
+        coll->SetBurstWindow(commandLine.burstWindow);
+        std::wcout << CurrentLocalTimeWithoutDate << L"Coalescing notification bursts, quiet window " << commandLine.burstWindow.count() << L" ms.\n";
+    }
+
+    if (commandLine.warmStart)
+    {
+        if (commandLine.cacheFilePath.empty())
+        {
+            commandLine.cacheFilePath = AudioControl::GetDefaultWarmStartCachePath();
+        }
+        if (coll->LoadWarmStartCache(commandLine.cacheFilePath))
+        {
+            std::wcout << CurrentLocalTimeWithoutDate << L"Stale device list from \"" << commandLine.cacheFilePath
+                << L"\", first answer after " << ElapsedMilliseconds(startTime) << L" ms:\n";
+            o.PrintCollection();
+        }
+    }
+
+    std::unique_ptr<SnapshotPublisherInterface> publisher;
+    if (commandLine.publishSnapshot)
+    {
+        publisher = AudioControl::CreateSnapshotPublisher(*coll, commandLine.snapshotRegionName);
+        std::wcout << CurrentLocalTimeWithoutDate << L"Publishing device snapshot to \"" << commandLine.snapshotRegionName << L"\".\n";
+    }
+
+    // Service mode: one collection, any number of pipe clients receiving JSON-lines events
+    std::unique_ptr<ed::audio::EventBroadcaster> broadcaster;
+    std::unique_ptr<ed::audio::BroadcastObserver> broadcastObserver;
+    if (commandLine.serve)
+    {
+        constexpr size_t clientQueueLimit = 1024;
+        broadcaster = std::make_unique<ed::audio::EventBroadcaster>(
+            commandLine.pipeName, clientQueueLimit, [&broadcastObserver] { return broadcastObserver->CreateSnapshotLines(); });
+        broadcastObserver = std::make_unique<ed::audio::BroadcastObserver>(*coll, *broadcaster);
+        coll->Subscribe(*broadcastObserver);
+        broadcaster->Start();
+        std::wcout << CurrentLocalTimeWithoutDate << L"Serving device events on \"" << commandLine.pipeName << L"\".\n";
+    }
 
     bool continueLoop = true;
+    bool firstPass = true;
 
     while (continueLoop)
     {
-        o.ResetCollectionContentAndPrintIt();
+        if (commandLine.asyncReset)
+        {
+            o.ResetCollectionContentAsyncAndWait();
+        }
+        else
+        {
+            o.ResetCollectionContentAndPrintIt();
+        }
+        if (firstPass)
+        {
+            std::wcout << CurrentLocalTimeWithoutDate << L"Enumerated after " << ElapsedMilliseconds(startTime) << L" ms.\n";
+            firstPass = false;
+        }
+        if (publisher != nullptr)
+        {
+            publisher->Publish();
+        }
+        if (broadcaster != nullptr)
+        {
+            for (const auto & line : broadcastObserver->CreateSnapshotLines())
+            {
+                broadcaster->Broadcast(line);
+            }
+        }
+
+        if (commandLine.printStatistics)
+        {
+            PrintLatencyStatistics(*coll);
+            PrintOperationalCounters(*coll);
+        }
 
         continueLoop = StopAndWaitForInput();
     }
 
+    if (commandLine.printStatistics)
+    {
+        PrintLatencyStatistics(*coll);
+        PrintOperationalCounters(*coll);
+    }
+
+    if (broadcaster != nullptr)
+    {
+        coll->Unsubscribe(*broadcastObserver);
+        broadcaster->Stop();
+    }
+    publisher.reset();
     coll->Unsubscribe(o);
 
     return 0;
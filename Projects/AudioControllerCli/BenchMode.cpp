@@ -0,0 +1,186 @@
+#include "stdafx.h"
+
+#include "BenchMode.h"
+
+#include <algorithm>
+#include <atlbase.h>
+#include <condition_variable>
+#include <endpointvolume.h>
+#include <iomanip>
+#include <mmdeviceapi.h>
+#include <mutex>
+
+#include "../AudioController/AudioControlInterface.h"
+
+
+namespace
+{
+    constexpr size_t VolumeProbeCount = 20;
+    constexpr auto VolumeDeliveryTimeout = std::chrono::seconds(2);
+
+    // Waits for the VolumeChanged event following a volume change triggered by the benchmark.
+    class VolumeProbeObserver final : public DeviceCollectionObserverInterface {
+    public:
+        void OnCollectionChanged(DeviceCollectionEvent event, const std::wstring &) override
+        {
+            if (event != DeviceCollectionEvent::VolumeChanged)
+            {
+                return;
+            }
+            {
+                std::lock_guard lock(mutex_);
+                deliveredAt_ = std::chrono::steady_clock::now();
+                isDelivered_ = true;
+            }
+            delivered_.notify_one();
+        }
+
+        void OnTrace(const std::wstring &) override {}
+        void OnTraceDebug(const std::wstring &) override {}
+
+        void Arm()
+        {
+            std::lock_guard lock(mutex_);
+            isDelivered_ = false;
+        }
+
+        bool WaitForDelivery(std::chrono::steady_clock::time_point & deliveredAt)
+        {
+            std::unique_lock lock(mutex_);
+            if (!delivered_.wait_for(lock, VolumeDeliveryTimeout, [this] { return isDelivered_; }))
+            {
+                return false;
+            }
+            deliveredAt = deliveredAt_;
+            return true;
+        }
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable delivered_;
+        bool isDelivered_ = false;
+        std::chrono::steady_clock::time_point deliveredAt_;
+    };
+
+    double ToMilliseconds(std::chrono::nanoseconds duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    // Prints min / p50 / p99 / max of the samples, in milliseconds
+    void PrintDistribution(const std::wstring & title, std::vector<double> samples)
+    {
+        std::wcout << std::left << std::setw(28) << title << std::right;
+        if (samples.empty())
+        {
+            std::wcout << L"no samples\n";
+            return;
+        }
+        std::ranges::sort(samples);
+        const auto percentile = [&samples](double fraction)
+        {
+            const auto rank = static_cast<size_t>(fraction * static_cast<double>(samples.size()) + 0.999999);
+            return samples[(std::max)(rank, size_t{1}) - 1];
+        };
+        std::wcout << std::fixed << std::setprecision(3)
+            << std::setw(12) << samples.front()
+            << std::setw(12) << percentile(0.50)
+            << std::setw(12) << percentile(0.99)
+            << std::setw(12) << samples.back() << L'\n';
+    }
+
+    bool TryGetDefaultRenderVolume(CComPtr<IAudioEndpointVolume> & endpointVolume)
+    {
+        CComPtr<IMMDeviceEnumerator> enumerator;
+        CComPtr<IMMDevice> device;
+        return SUCCEEDED(enumerator.CoCreateInstance(__uuidof(MMDeviceEnumerator)))
+            && SUCCEEDED(enumerator->GetDefaultAudioEndpoint(eRender, eConsole, &device))
+            && SUCCEEDED(device->Activate(__uuidof(IAudioEndpointVolume), CLSCTX_INPROC_SERVER, nullptr,
+                                          reinterpret_cast<void**>(&endpointVolume)));
+    }
+
+    // Nudges the default render volume back and forth and returns the delivery delays in milliseconds.
+    // The original volume is restored.
+    std::vector<double> MeasureVolumeDelivery(DeviceCollectionInterface & collection, size_t & timeouts)
+    {
+        std::vector<double> delays;
+        timeouts = 0;
+        CComPtr<IAudioEndpointVolume> endpointVolume;
+        float originalLevel = 0.0f;
+        if (!TryGetDefaultRenderVolume(endpointVolume) || FAILED(endpointVolume->GetMasterVolumeLevelScalar(&originalLevel)))
+        {
+            return delays;
+        }
+        const auto nudgedLevel = originalLevel < 0.5f ? originalLevel + 0.02f : originalLevel - 0.02f;
+
+        VolumeProbeObserver observer;
+        collection.Subscribe(observer);
+        for (size_t i = 0; i < VolumeProbeCount; ++i)
+        {
+            observer.Arm();
+            const auto triggeredAt = std::chrono::steady_clock::now();
+            if (FAILED(endpointVolume->SetMasterVolumeLevelScalar(i % 2 == 0 ? nudgedLevel : originalLevel, nullptr)))
+            {
+                break;
+            }
+            if (std::chrono::steady_clock::time_point deliveredAt; observer.WaitForDelivery(deliveredAt))
+            {
+                delays.push_back(ToMilliseconds(deliveredAt - triggeredAt));
+            }
+            else
+            {
+                ++timeouts;
+            }
+        }
+        collection.Unsubscribe(observer);
+        // ReSharper disable once CppFunctionResultShouldBeUsed
+        endpointVolume->SetMasterVolumeLevelScalar(originalLevel, nullptr);
+        return delays;
+    }
+}
+
+int ed::audio::RunBench(size_t cycles, const std::wstring & nameFilter, bool bothHeadsetAndMicro)
+{
+    const auto timed = AudioControl::CreateTimedDeviceCollection(nameFilter, bothHeadsetAndMicro);
+    auto & collection = timed->GetCollection();
+
+    std::vector<double> totals, enumerations, probings, registrations, overheads;
+    uint64_t probes = 0;
+    for (size_t i = 0; i < cycles; ++i)
+    {
+        const auto before = timed->GetPlatformCallTimes();
+        const auto startedAt = std::chrono::steady_clock::now();
+        collection.ResetContent();
+        const auto total = std::chrono::steady_clock::now() - startedAt;
+        const auto after = timed->GetPlatformCallTimes();
+
+        const auto enumeration = after.Enumeration - before.Enumeration;
+        const auto probing = after.Probing - before.Probing;
+        const auto registration = after.VolumeRegistration - before.VolumeRegistration;
+        totals.push_back(ToMilliseconds(total));
+        enumerations.push_back(ToMilliseconds(enumeration));
+        probings.push_back(ToMilliseconds(probing));
+        registrations.push_back(ToMilliseconds(registration));
+        overheads.push_back(ToMilliseconds(total - enumeration - probing - registration));
+        probes = after.ProbeCount - before.ProbeCount;
+    }
+
+    std::wcout << L"ResetContent: " << cycles << L" cycles, " << collection.GetSize() << L" devices, "
+        << probes << L" endpoints probed per cycle\n"
+        << std::left << std::setw(28) << L"[ms]" << std::right
+        << std::setw(12) << L"min" << std::setw(12) << L"p50" << std::setw(12) << L"p99" << std::setw(12) << L"max" << L'\n';
+    PrintDistribution(L"Total", totals);
+    PrintDistribution(L"  COM enumeration", enumerations);
+    PrintDistribution(L"  COM probing", probings);
+    PrintDistribution(L"  COM volume registration", registrations);
+    PrintDistribution(L"  Library overhead", overheads);
+
+    size_t timeouts = 0;
+    PrintDistribution(L"Volume change to delivery", MeasureVolumeDelivery(collection, timeouts));
+    if (timeouts > 0)
+    {
+        std::wcout << timeouts << L" of " << VolumeProbeCount
+            << L" volume changes not delivered; is the default render device filtered out?\n";
+    }
+    return 0;
+}
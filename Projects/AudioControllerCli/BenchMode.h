@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+
+
+namespace ed::audio {
+// Non-interactive benchmark on the real audio system: times ResetContent() cycles, split into
+// platform (COM) calls and library overhead, and the delay from a volume change of the default
+// render endpoint, triggered here, to its VolumeChanged delivery. Expects COM to be initialized.
+int RunBench(size_t cycles, const std::wstring & nameFilter, bool bothHeadsetAndMicro);
+}
@@ -0,0 +1,222 @@
+#include "stdafx.h"
+
+#include "EventBroadcaster.h"
+
+
+const std::string ed::audio::EventBroadcaster::OverflowLine = R"({"event":"Overflow"})""\n";
+
+ed::audio::EventBroadcaster::~EventBroadcaster()
+{
+    Stop();
+}
+
+ed::audio::EventBroadcaster::EventBroadcaster(std::wstring pipeName, size_t clientQueueLimit, GreetingFunctionT greeting)
+    : pipeName_(std::move(pipeName))
+      , clientQueueLimit_(clientQueueLimit)
+      , greeting_(std::move(greeting))
+{
+}
+
+void ed::audio::EventBroadcaster::Start()
+{
+    stopping_ = false;
+    acceptFinished_ = false;
+    acceptThread_ = std::thread([this]
+    {
+        AcceptLoop();
+        acceptFinished_ = true;
+    });
+}
+
+void ed::audio::EventBroadcaster::Stop()
+{
+    if (!acceptThread_.joinable())
+    {
+        return;
+    }
+    stopping_ = true;
+    // Unblock ConnectNamedPipe by connecting to ourselves. Between two pipe instances there is nothing to connect to,
+    // and the next one may block again, so until the accept loop has ended.
+    for (;;)
+    {
+        if (const HANDLE self = CreateFileW(pipeName_.c_str(), GENERIC_READ, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+            self != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(self);
+        }
+        if (acceptFinished_)
+        {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    acceptThread_.join();
+
+    std::vector<std::unique_ptr<Client>> clients;
+    {
+        std::lock_guard lock(clientsMutex_);
+        clients.swap(clients_);
+    }
+    for (const auto & client : clients)
+    {
+        {
+            std::lock_guard lock(client->Mutex);
+            client->Closing = true;
+        }
+        client->Wakeup.notify_one();
+        // A writer blocked on a client that does not read any more has to be kicked out of WriteFile
+        while (!client->Finished)
+        {
+            CancelSynchronousIo(client->Writer.native_handle());
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        client->Writer.join();
+    }
+}
+
+void ed::audio::EventBroadcaster::Broadcast(const std::string & line)
+{
+    Broadcast([&line] { return line; });
+}
+
+void ed::audio::EventBroadcaster::Broadcast(const FormatFunctionT & format)
+{
+    ++broadcast_;
+
+    ReapFinishedClients();
+    std::lock_guard lock(clientsMutex_);
+    const auto shared = std::make_shared<const std::string>(format());
+    for (const auto & client : clients_)
+    {
+        Enqueue(*client, shared);
+    }
+}
+
+ed::audio::BroadcastStatistics ed::audio::EventBroadcaster::GetStatistics() const
+{
+    BroadcastStatistics statistics;
+    statistics.Broadcast = broadcast_;
+    statistics.Delivered = delivered_;
+    statistics.Dropped = dropped_;
+    statistics.Overflows = overflows_;
+    {
+        std::lock_guard lock(clientsMutex_);
+        statistics.Clients = clients_.size();
+    }
+    return statistics;
+}
+
+const std::wstring & ed::audio::EventBroadcaster::GetPipeName() const
+{
+    return pipeName_;
+}
+
+void ed::audio::EventBroadcaster::AcceptLoop()
+{
+    constexpr DWORD pipeBufferSize = 64 * 1024;
+    while (!stopping_)
+    {
+        const HANDLE pipe = CreateNamedPipeW(
+            pipeName_.c_str(),
+            PIPE_ACCESS_OUTBOUND,
+            PIPE_TYPE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+            PIPE_UNLIMITED_INSTANCES,
+            pipeBufferSize,
+            0,
+            0,
+            nullptr);
+        if (pipe == INVALID_HANDLE_VALUE)
+        {
+            return;
+        }
+        if (const bool connected = ConnectNamedPipe(pipe, nullptr) != FALSE || GetLastError() == ERROR_PIPE_CONNECTED;
+            !connected || stopping_)
+        {
+            CloseHandle(pipe);
+            continue;
+        }
+
+        auto client = std::make_unique<Client>();
+        client->Pipe = pipe;
+        // Greeted and joined at once: a line broadcast meanwhile would be lost, or repeated with the sequence of the greeting
+        std::lock_guard lock(clientsMutex_);
+        if (greeting_)
+        {
+            for (const auto & line : greeting_())
+            {
+                client->Queue.push_back(std::make_shared<const std::string>(line));
+            }
+        }
+        client->Writer = std::thread(&EventBroadcaster::WriterLoop, this, std::ref(*client));
+        clients_.push_back(std::move(client));
+    }
+}
+
+void ed::audio::EventBroadcaster::WriterLoop(Client & client)
+{
+    for (;;)
+    {
+        LineT line;
+        {
+            std::unique_lock lock(client.Mutex);
+            client.Wakeup.wait(lock, [&client] { return client.Closing || !client.Queue.empty(); });
+            if (client.Closing)
+            {
+                break;
+            }
+            line = std::move(client.Queue.front());
+            client.Queue.pop_front();
+        }
+
+        DWORD written = 0;
+        if (!WriteFile(client.Pipe, line->data(), static_cast<DWORD>(line->size()), &written, nullptr)
+            || written != line->size())
+        {
+            break;
+        }
+        ++delivered_;
+    }
+
+    FlushFileBuffers(client.Pipe);
+    DisconnectNamedPipe(client.Pipe);
+    CloseHandle(client.Pipe);
+    client.Pipe = INVALID_HANDLE_VALUE;
+    client.Finished = true;
+}
+
+void ed::audio::EventBroadcaster::Enqueue(Client & client, const LineT & line)
+{
+    {
+        std::lock_guard lock(client.Mutex);
+        if (client.Closing || client.Finished)
+        {
+            return;
+        }
+        if (client.Queue.size() >= clientQueueLimit_)
+        {
+            dropped_ += client.Queue.size();
+            ++overflows_;
+            client.Queue.clear();
+            static const auto overflowLine = std::make_shared<const std::string>(OverflowLine);
+            client.Queue.push_back(overflowLine);
+        }
+        client.Queue.push_back(line);
+    }
+    client.Wakeup.notify_one();
+}
+
+void ed::audio::EventBroadcaster::ReapFinishedClients()
+{
+    std::vector<std::unique_ptr<Client>> finished;
+    {
+        std::lock_guard lock(clientsMutex_);
+        const auto firstFinished = std::stable_partition(clients_.begin(), clients_.end(),
+                                                         [](const auto & client) { return !client->Finished; });
+        std::move(firstFinished, clients_.end(), std::back_inserter(finished));
+        clients_.erase(firstFinished, clients_.end());
+    }
+    for (const auto & client : finished)
+    {
+        client->Writer.join();
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../AudioController/ClassDefHelper.h"
+
+
+namespace ed::audio {
+struct BroadcastStatistics {
+    uint64_t Broadcast = 0;
+    uint64_t Delivered = 0;
+    uint64_t Dropped = 0;
+    uint64_t Overflows = 0;
+    size_t Clients = 0;
+};
+
+// Streams text lines (JSON-lines) to any number of local named-pipe clients.
+// Every client has its own bounded queue and writer thread, so a slow client never blocks the producer:
+// when its queue is full, the queue is dropped and replaced by an overflow marker telling the client to resync.
+// A new client gets the greeting lines first; they are taken under the lock of Broadcast(), so the client receives
+// every line broadcast after them and none before.
+class EventBroadcaster final {
+public:
+    using GreetingFunctionT = std::function<std::vector<std::string>()>;
+    using FormatFunctionT = std::function<std::string()>;
+
+    DISALLOW_COPY_MOVE(EventBroadcaster);
+    ~EventBroadcaster();
+
+public:
+    EventBroadcaster(std::wstring pipeName, size_t clientQueueLimit, GreetingFunctionT greeting = {});
+
+    void Start();
+    void Stop();
+    void Broadcast(const std::string & line);
+    // Formats the line under the lock of the greeting, e.g. to number it in step with the greeting lines
+    void Broadcast(const FormatFunctionT & format);
+
+    [[nodiscard]] BroadcastStatistics GetStatistics() const;
+    [[nodiscard]] const std::wstring & GetPipeName() const;
+
+    static const std::string OverflowLine;
+
+private:
+    using LineT = std::shared_ptr<const std::string>;
+
+    struct Client {
+        HANDLE Pipe = INVALID_HANDLE_VALUE;
+        std::mutex Mutex;
+        std::condition_variable Wakeup;
+        std::deque<LineT> Queue;
+        bool Closing = false;
+        std::atomic_bool Finished = false;
+        std::thread Writer;
+    };
+
+    void AcceptLoop();
+    void WriterLoop(Client & client);
+    void Enqueue(Client & client, const LineT & line);
+    void ReapFinishedClients();
+
+private:
+    std::wstring pipeName_;
+    size_t clientQueueLimit_;
+    GreetingFunctionT greeting_;
+
+    std::atomic_bool stopping_ = false;
+    std::atomic_bool acceptFinished_ = false;
+    std::thread acceptThread_;
+
+    mutable std::mutex clientsMutex_;
+    std::vector<std::unique_ptr<Client>> clients_;
+
+    std::atomic_uint64_t broadcast_ = 0;
+    std::atomic_uint64_t delivered_ = 0;
+    std::atomic_uint64_t dropped_ = 0;
+    std::atomic_uint64_t overflows_ = 0;
+};
+}
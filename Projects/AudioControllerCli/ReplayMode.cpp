@@ -0,0 +1,68 @@
+#include "stdafx.h"
+
+#include "ReplayMode.h"
+
+#include <atomic>
+#include <stdexcept>
+
+#include "../AudioController/AudioControlInterface.h"
+
+
+namespace
+{
+    class CountingObserver final : public DeviceCollectionObserverInterface {
+    public:
+        void OnCollectionChanged(DeviceCollectionEvent, const std::wstring &) override
+        {
+            ++events_;
+        }
+
+        void OnTrace(const std::wstring &) override {}
+        void OnTraceDebug(const std::wstring &) override {}
+
+        [[nodiscard]] uint64_t GetEvents() const
+        {
+            return events_;
+        }
+
+    private:
+        std::atomic_uint64_t events_ = 0;
+    };
+}
+
+int ed::audio::RunReplay(const std::wstring & traceFilePath, double speedFactor, const std::wstring & nameFilter, bool bothHeadsetAndMicro)
+{
+    std::unique_ptr<TraceReplayerInterface> replayer;
+    try
+    {
+        replayer = AudioControl::CreateTraceReplayer(traceFilePath, nameFilter, bothHeadsetAndMicro);
+    }
+    catch (const std::runtime_error & e)
+    {
+        std::wcout << L"\"" << traceFilePath << L"\": " << e.what() << L'\n';
+        return -1;
+    }
+
+    auto & collection = replayer->GetCollection();
+    collection.ResetContent();
+    const auto initialDevices = collection.GetSize();
+    CountingObserver observer;
+    collection.Subscribe(observer);
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto notifications = replayer->Replay(speedFactor);
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    collection.Unsubscribe(observer);
+
+    std::wcout << L"Trace: \"" << traceFilePath << L"\", speed factor " << speedFactor << L'\n'
+        << L"Devices: " << initialDevices << L" initially, " << collection.GetSize() << L" finally\n"
+        << L"Notifications: " << notifications << L", collection events: " << observer.GetEvents() << L'\n'
+        << L"Replay: " << seconds * 1000.0 << L" ms";
+    if (notifications > 0 && seconds > 0.0)
+    {
+        std::wcout << L", " << static_cast<double>(notifications) / seconds << L" notifications/s, "
+            << seconds * 1e6 / static_cast<double>(notifications) << L" us per notification";
+    }
+    std::wcout << L'\n';
+    return 0;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+
+
+namespace ed::audio {
+// Feeds a recorded notification trace (--record) into a collection and reports throughput and
+// per-notification handling time. speedFactor 1 keeps the recorded pace, 0 plays flat-out.
+int RunReplay(const std::wstring & traceFilePath, double speedFactor, const std::wstring & nameFilter, bool bothHeadsetAndMicro);
+}
@@ -0,0 +1,225 @@
+#include "stdafx.h"
+
+#include "ServeMode.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "../AudioControllerLib/DefToString.h"
+#include "../AudioControllerLib/generate-uuid.h"
+
+
+namespace
+{
+    std::string ToUtf8(const std::wstring & wide)
+    {
+        if (wide.empty())
+        {
+            return {};
+        }
+        const auto size = WideCharToMultiByte(CP_UTF8, 0, wide.data(), static_cast<int>(wide.size()), nullptr, 0, nullptr, nullptr);
+        std::string result(size, '\0');
+        WideCharToMultiByte(CP_UTF8, 0, wide.data(), static_cast<int>(wide.size()), result.data(), size, nullptr, nullptr);
+        return result;
+    }
+
+    std::string JsonEscaped(const std::wstring & wide)
+    {
+        std::ostringstream os;
+        for (const auto ch : ToUtf8(wide))
+        {
+            switch (ch)
+            {
+            case '"': os << "\\\""; break;
+            case '\\': os << "\\\\"; break;
+            default:
+                if (static_cast<unsigned char>(ch) < 0x20)
+                {
+                    os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(ch) << std::dec;
+                }
+                else
+                {
+                    os << ch;
+                }
+            }
+        }
+        return os.str();
+    }
+
+    std::unique_ptr<DeviceInterface> FindDevice(const DeviceCollectionInterface & collection, const std::wstring & pnpId)
+    {
+        auto devices = collection.FindDevices({.PnpId = pnpId});
+        return devices.empty() ? nullptr : std::move(devices.front());
+    }
+}
+
+std::string ed::audio::FormatEventLine(uint64_t sequence, DeviceCollectionEvent event, const std::wstring & pnpId,
+                                       const DeviceInterface * device)
+{
+    std::ostringstream os;
+    os << R"({"seq":)" << sequence
+        << R"(,"event":")" << JsonEscaped(GetDeviceCollectionEventAsString(event))
+        << R"(","pnpId":")" << JsonEscaped(pnpId) << '"';
+    if (device != nullptr)
+    {
+        os << R"(,"name":")" << JsonEscaped(device->GetName())
+            << R"(","flow":")" << JsonEscaped(GetFlowAsString(device->GetFlow()))
+            << R"(","renderVolume":)" << device->GetCurrentRenderVolume()
+            << R"(,"captureVolume":)" << device->GetCurrentCaptureVolume()
+            << R"(,"formFactor":")" << JsonEscaped(GetFormFactorAsString(device->GetFormFactor()))
+            << R"(","jackConnection":")" << JsonEscaped(GetJackConnectionAsString(device->GetJackConnection()))
+            << R"(","defaultRoles":")" << JsonEscaped(GetDefaultRolesAsString(*device)) << '"';
+    }
+    os << "}\n";
+    return os.str();
+}
+
+ed::audio::BroadcastObserver::BroadcastObserver(DeviceCollectionInterface & collection, EventBroadcaster & broadcaster)
+    : collection_(collection)
+      , broadcaster_(broadcaster)
+{
+}
+
+std::vector<std::string> ed::audio::BroadcastObserver::CreateSnapshotLines()
+{
+    std::vector<std::string> lines;
+    for (const auto & device : collection_.FindDevices({}))
+    {
+        lines.push_back(FormatEventLine(sequence_, DeviceCollectionEvent::Discovered, device->GetPnpId(), device.get()));
+    }
+    return lines;
+}
+
+void ed::audio::BroadcastObserver::OnCollectionChanged(DeviceCollectionEvent event, const std::wstring & devicePnpId)
+{
+    const auto device = event == DeviceCollectionEvent::Detached ? nullptr : FindDevice(collection_, devicePnpId);
+    // Numbered under the lock of the greeting, so a new client sees the lines after its snapshot continue its sequence
+    broadcaster_.Broadcast([this, event, &devicePnpId, &device]
+    {
+        return FormatEventLine(++sequence_, event, devicePnpId, device.get());
+    });
+}
+
+void ed::audio::BroadcastObserver::OnTrace(const std::wstring &)
+{
+}
+
+void ed::audio::BroadcastObserver::OnTraceDebug(const std::wstring &)
+{
+}
+
+namespace
+{
+    // Subscriber side of the benchmark: reads lines until the end marker arrives.
+    struct BenchSubscriber {
+        std::thread Reader;
+        uint64_t Lines = 0;
+        uint64_t Overflows = 0;
+    };
+
+    void ReadUntilEnd(const std::wstring & pipeName, const std::string & endLine, BenchSubscriber & subscriber)
+    {
+        HANDLE pipe = INVALID_HANDLE_VALUE;
+        while (pipe == INVALID_HANDLE_VALUE)
+        {
+            if (!WaitNamedPipeW(pipeName.c_str(), NMPWAIT_WAIT_FOREVER))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            pipe = CreateFileW(pipeName.c_str(), GENERIC_READ, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+        }
+        std::string pending;
+        char buffer[16 * 1024];
+        DWORD read = 0;
+        bool done = false;
+        while (!done && ReadFile(pipe, buffer, sizeof buffer, &read, nullptr) && read > 0)
+        {
+            pending.append(buffer, read);
+            size_t begin = 0;
+            for (auto end = pending.find('\n', begin); end != std::string::npos; end = pending.find('\n', begin))
+            {
+                const auto line = std::string_view(pending).substr(begin, end - begin + 1);
+                ++subscriber.Lines;
+                if (line == ed::audio::EventBroadcaster::OverflowLine)
+                {
+                    ++subscriber.Overflows;
+                }
+                if (line == endLine)
+                {
+                    done = true;
+                }
+                begin = end + 1;
+            }
+            pending.erase(0, begin);
+        }
+        CloseHandle(pipe);
+    }
+}
+
+int ed::audio::RunServeBenchmark(size_t subscribers, size_t events)
+{
+    const auto pipeName = DefaultEventPipeName + L"-bench-" + generate_w_uuid();
+    const std::string endLine = R"({"event":"End"})""\n";
+    constexpr size_t clientQueueLimit = 4096;
+
+    EventBroadcaster broadcaster(pipeName, clientQueueLimit);
+    broadcaster.Start();
+
+    std::vector<std::unique_ptr<BenchSubscriber>> readers;
+    for (size_t i = 0; i < subscribers; ++i)
+    {
+        auto subscriber = std::make_unique<BenchSubscriber>();
+        subscriber->Reader = std::thread(ReadUntilEnd, pipeName, endLine, std::ref(*subscriber));
+        readers.push_back(std::move(subscriber));
+    }
+    while (broadcaster.GetStatistics().Clients < subscribers)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Simulated device source: a fixed set of devices cycling through attach, volume changes and detach
+    constexpr size_t simulatedDevices = 64;
+    std::vector<std::wstring> pnpIds;
+    for (size_t i = 0; i < simulatedDevices; ++i)
+    {
+        pnpIds.push_back(L"{" + generate_w_uuid() + L"}");
+    }
+    constexpr DeviceCollectionEvent cycle[] = {
+        DeviceCollectionEvent::Discovered, DeviceCollectionEvent::VolumeChanged, DeviceCollectionEvent::VolumeChanged,
+        DeviceCollectionEvent::Detached
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < events; ++i)
+    {
+        broadcaster.Broadcast(FormatEventLine(i + 1, cycle[(i / simulatedDevices) % std::size(cycle)], pnpIds[i % simulatedDevices], nullptr));
+    }
+    const auto produced = std::chrono::steady_clock::now();
+    broadcaster.Broadcast(endLine);
+    for (const auto & reader : readers)
+    {
+        reader->Reader.join();
+    }
+    const auto finished = std::chrono::steady_clock::now();
+
+    const auto statistics = broadcaster.GetStatistics();
+    broadcaster.Stop();
+
+    const auto produceSeconds = std::chrono::duration<double>(produced - start).count();
+    const auto totalSeconds = std::chrono::duration<double>(finished - start).count();
+    uint64_t minLines = UINT64_MAX;
+    uint64_t overflows = 0;
+    for (const auto & reader : readers)
+    {
+        minLines = (std::min)(minLines, reader->Lines);
+        overflows += reader->Overflows;
+    }
+    std::wcout << L"Subscribers: " << subscribers << L", events: " << events << L'\n'
+        << L"Producer: " << produceSeconds * 1000.0 << L" ms, " << static_cast<double>(events) / produceSeconds << L" events/s\n"
+        << L"Fan-out: " << totalSeconds * 1000.0 << L" ms, " << static_cast<double>(statistics.Delivered) / totalSeconds << L" lines/s delivered\n"
+        << L"Delivered: " << statistics.Delivered << L", dropped: " << statistics.Dropped
+        << L", overflows: " << overflows << L", fewest lines per subscriber: " << (readers.empty() ? 0 : minLines) << L'\n';
+    return 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "../AudioController/AudioControlInterface.h"
+
+#include "EventBroadcaster.h"
+
+
+namespace ed::audio {
+// Default pipe of the service mode (--serve).
+inline const std::wstring DefaultEventPipeName = L"\\\\.\\pipe\\PnPAudioCheckEvents";
+
+std::string FormatEventLine(uint64_t sequence, DeviceCollectionEvent event, const std::wstring & pnpId,
+                            const DeviceInterface * device);
+
+// Owns nothing but the sequence number: turns collection events into JSON lines for the broadcaster.
+class BroadcastObserver final : public DeviceCollectionObserverInterface {
+public:
+    DISALLOW_COPY_MOVE(BroadcastObserver);
+    ~BroadcastObserver() override = default;
+
+public:
+    BroadcastObserver(DeviceCollectionInterface & collection, EventBroadcaster & broadcaster);
+
+    // Current collection as a sequence of "Discovered" lines, sent to every new client first; they carry the sequence
+    // number of the last event line broadcast.
+    [[nodiscard]] std::vector<std::string> CreateSnapshotLines();
+
+    void OnCollectionChanged(DeviceCollectionEvent event, const std::wstring & devicePnpId) override;
+    void OnTrace(const std::wstring & line) override;
+    void OnTraceDebug(const std::wstring & line) override;
+
+private:
+    DeviceCollectionInterface & collection_;
+    EventBroadcaster & broadcaster_;
+    std::atomic_uint64_t sequence_ = 0;
+};
+
+// Throughput of the broadcaster with many pipe subscribers, fed by a simulated device source.
+int RunServeBenchmark(size_t subscribers, size_t events);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../AudioController/ClassDefHelper.h"
+
+#include "Device.h"
+#include "EndpointProperty.h"
+#include "MultipleNotificationClient.h"
+
+
+namespace ed::audio {
+// What a probe has activated of an endpoint anyway, so registering its volume notification activates nothing again.
+// Opaque to the client; the backend that has made it knows its type.
+class VolumeNotificationToken {
+    AS_INTERFACE(VolumeNotificationToken);
+    DISALLOW_COPY_MOVE(VolumeNotificationToken);
+};
+using TVolumeNotificationToken = std::unique_ptr<VolumeNotificationToken>;
+
+// The platform side of a DeviceCollection: enumerates and probes audio endpoints and
+// delivers endpoint and volume notifications to the started client.
+// ComAudioBackend talks to the Windows Core Audio API, SimulatedAudioBackend to an in-memory model.
+class AudioBackendInterface {
+public:
+    using TraceFunctionT = std::function<void(const std::wstring &)>;
+    using TraceOnFunctionT = std::function<bool()>;
+
+    // From now on the client gets IMMNotificationClient and IAudioEndpointVolumeCallback calls. A trace line is
+    // formatted and passed to traceFunction only while isTraceOn tells that somebody listens.
+    virtual void Start(MultipleNotificationClient & client, TraceFunctionT traceFunction, TraceOnFunctionT isTraceOn) = 0;
+    // Unregisters every notification; no client call follows the return.
+    virtual void Stop() = 0;
+
+    virtual bool TryEnumerateActiveEndpoints(bool bothHeadsetAndMicro, std::vector<std::wstring> & endpointIds) = 0;
+    // Reads flow, friendly name, container (plug-and-play) id and volume of an endpoint, active or not. Given a
+    // volumeToken, keeps there what it has activated for RegisterVolumeNotification(); a backend may leave it empty.
+    virtual bool TryProbeEndpoint(const std::wstring & endpointId, Device & device, TVolumeNotificationToken * volumeToken) = 0;
+    // The default endpoint of the flow, Render or Capture, and the role; false if there is none.
+    virtual bool TryGetDefaultEndpoint(DeviceFlowEnum flow, DeviceRole role, std::wstring & endpointId) = 0;
+    // Reads the one property of an endpoint into device, its facts as probed, leaving the others as they are
+    virtual bool TryReadEndpointProperty(const std::wstring & endpointId, EndpointProperty property, Device & device) = 0;
+
+    // With the token of a probe of the endpoint, if any; without one the backend activates the endpoint itself
+    virtual void RegisterVolumeNotification(const std::wstring & endpointId, TVolumeNotificationToken volumeToken) = 0;
+    virtual void UnregisterVolumeNotification(const std::wstring & endpointId) = 0;
+    virtual void UnregisterAllVolumeNotifications() = 0;
+    // Number of currently registered volume notifications; the client serializes it with the registration calls.
+    [[nodiscard]] virtual size_t GetVolumeNotificationCount() const = 0;
+
+    AS_INTERFACE(AudioBackendInterface);
+    DISALLOW_COPY_MOVE(AudioBackendInterface);
+};
+}
@@ -0,0 +1,533 @@
+// ReSharper disable CppClangTidyClangDiagnosticLanguageExtensionToken
+#include "stdafx.h"
+
+#include "ComAudioBackend.h"
+
+#include <Functiondiscoverykeys_devpkey.h>
+#include <sstream>
+
+#include "DefToString.h"
+#include "TimelineTrace.h"
+
+
+namespace {
+DeviceFlowEnum ConvertFromLowLevelFlow(const EDataFlow flow)
+{
+    switch (flow)
+    {
+    case eRender:
+        return DeviceFlowEnum::Render;
+    case eCapture:
+        return DeviceFlowEnum::Capture;
+    case eAll:
+        return DeviceFlowEnum::RenderAndCapture;
+    case EDataFlow_enum_count:
+    default: // NOLINT(clang-diagnostic-covered-switch-default)
+        return DeviceFlowEnum::None;
+    }
+}
+
+// Forwards the volume notifications of one endpoint to the client, naming the endpoint
+class EndpointVolumeCallback final : public IAudioEndpointVolumeCallback {
+public:
+    DISALLOW_COPY_MOVE(EndpointVolumeCallback);
+    virtual ~EndpointVolumeCallback() = default;
+
+public:
+    EndpointVolumeCallback(ed::audio::MultipleNotificationClient & client, std::wstring endpointId)
+        : client_(client)
+        , endpointId_(std::move(endpointId))
+    {
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return InterlockedIncrement(&ref_);
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        const ULONG ulRef = InterlockedDecrement(&ref_);
+        if (0 == ulRef)
+        {
+            delete this;
+        }
+        return ulRef;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID refIId, VOID ** ppvInterface) override
+    {
+        if (IID_IUnknown == refIId || __uuidof(IAudioEndpointVolumeCallback) == refIId)
+        {
+            AddRef();
+            *ppvInterface = static_cast<IAudioEndpointVolumeCallback*>(this);
+            return S_OK;
+        }
+        *ppvInterface = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    HRESULT STDMETHODCALLTYPE OnNotify(PAUDIO_VOLUME_NOTIFICATION_DATA pNotify) override
+    {
+        return client_.OnEndpointVolumeNotify(endpointId_.c_str(), pNotify);
+    }
+
+private:
+    LONG ref_ = 1;
+    ed::audio::MultipleNotificationClient & client_;
+    const std::wstring endpointId_;
+};
+}
+
+
+ed::audio::ComAudioBackend::VolumeRegistration::VolumeRegistration(
+    EndPointVolumeSmartPtr endpointVolume, CComPtr<IAudioEndpointVolumeCallback> callback)
+    : endpointVolume_(std::move(endpointVolume))
+    , callback_(std::move(callback))
+{
+}
+
+ed::audio::ComAudioBackend::VolumeRegistration::~VolumeRegistration()
+{
+    AC_TIMELINE_ZONE("IAudioEndpointVolume::UnregisterControlChangeNotify");
+    // ReSharper disable once CppFunctionResultShouldBeUsed
+    endpointVolume_->UnregisterControlChangeNotify(callback_);
+}
+
+ed::audio::ComAudioBackend::~ComAudioBackend()
+{
+    Stop();
+    SAFE_RELEASE(enumerator_)
+}
+
+ed::audio::ComAudioBackend::ComAudioBackend()
+{
+    const auto hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL, IID_PPV_ARGS(&enumerator_));
+    assert(SUCCEEDED(hr));
+}
+
+void ed::audio::ComAudioBackend::Start(MultipleNotificationClient & client, TraceFunctionT traceFunction,
+                                       TraceOnFunctionT isTraceOn)
+{
+    client_ = &client;
+    traceFunction_ = std::move(traceFunction);
+    isTraceOn_ = std::move(isTraceOn);
+    // ReSharper disable once CppFunctionResultShouldBeUsed
+    enumerator_->RegisterEndpointNotificationCallback(client_);
+}
+
+void ed::audio::ComAudioBackend::Stop()
+{
+    if (client_ == nullptr)
+    {
+        return;
+    }
+    UnregisterAllVolumeNotifications();
+    // ReSharper disable once CppFunctionResultShouldBeUsed
+    enumerator_->UnregisterEndpointNotificationCallback(client_);
+    client_ = nullptr;
+}
+
+bool ed::audio::ComAudioBackend::TryEnumerateActiveEndpoints(bool bothHeadsetAndMicro, std::vector<std::wstring> & endpointIds)
+{
+    AC_TIMELINE_ZONE("ComAudioBackend::TryEnumerateActiveEndpoints");
+    CComPtr<IMMDeviceCollection> deviceCollectionSmartPtr;
+    {
+        AC_TIMELINE_ZONE("IMMDeviceEnumerator::EnumAudioEndpoints");
+        IMMDeviceCollection * deviceCollection = nullptr;
+        if (FAILED(enumerator_->EnumAudioEndpoints(bothHeadsetAndMicro ? eAll : eRender, DEVICE_STATE_ACTIVE, &deviceCollection)))
+        {
+            return false;
+        }
+        deviceCollectionSmartPtr.Attach(deviceCollection);
+    }
+    UINT count = 0;
+    auto hr = deviceCollectionSmartPtr->GetCount(&count);
+    assert(SUCCEEDED(hr));
+
+    endpointIds.clear();
+    endpointIds.reserve(count);
+    for (ULONG i = 0; i < count; i++)
+    {
+        CComPtr<IMMDevice> endpointDeviceSmartPtr;
+        {
+            IMMDevice * pEndpointDevice = nullptr;
+            hr = deviceCollectionSmartPtr->Item(i, &pEndpointDevice);
+            if (FAILED(hr))
+            {
+                LOG_INFO("Collection::Item failed")
+                continue;
+            }
+            endpointDeviceSmartPtr.Attach(pEndpointDevice);
+        }
+        LPWSTR deviceIdPtr = nullptr;
+        if (FAILED(endpointDeviceSmartPtr->GetId(&deviceIdPtr)))
+        {
+            continue;
+        }
+        endpointIds.emplace_back(deviceIdPtr);
+        LOG_INFO(L"Id of the current point device " << i << L" is \"" << endpointIds.back() << L"\".");
+        CoTaskMemFree(deviceIdPtr);
+    }
+    return true;
+}
+
+bool ed::audio::ComAudioBackend::TryProbeEndpoint(const std::wstring & endpointId, Device & device, TVolumeNotificationToken * volumeToken)
+{
+    AC_TIMELINE_ZONE("ComAudioBackend::TryProbeEndpoint");
+    CComPtr<IMMDevice> deviceEndpointSmartPtr;
+    if (!TryGetDevice(endpointId, deviceEndpointSmartPtr))
+    {
+        return false;
+    }
+    HRESULT hr;
+    // Get flow direction via IMMEndpoint
+    auto flow = DeviceFlowEnum::None;
+    {
+        AC_TIMELINE_ZONE("IMMEndpoint::GetDataFlow");
+        EDataFlow lowLevelFlow;
+        IMMEndpoint * pEndpoint = nullptr;
+        hr = deviceEndpointSmartPtr->QueryInterface(__uuidof(IMMEndpoint), reinterpret_cast<void**>(&pEndpoint));
+        if (FAILED(hr)) {
+            return false;
+        }
+        hr = pEndpoint->GetDataFlow(&lowLevelFlow);
+        SAFE_RELEASE(pEndpoint);
+        if (FAILED(hr)) {
+            return false;
+        }
+        flow = ConvertFromLowLevelFlow(lowLevelFlow);
+        LOG_INFO(L"The end point device, id \"" << endpointId << L"\", has a data flow \"" << GetFlowAsString(flow) << L"\".");
+    }
+    // Read device PnP Class id property
+    std::wstring pnpGuid;
+    std::wstring name;
+    auto formFactor = DeviceFormFactor::Unknown;
+    {
+        IPropertyStore* pProps = nullptr;
+        {
+            AC_TIMELINE_ZONE("IMMDevice::OpenPropertyStore");
+            hr = deviceEndpointSmartPtr->OpenPropertyStore(STGM_READ, &pProps);
+        }
+        if (FAILED(hr)) {
+            return false;
+        }
+        {
+            PROPVARIANT propVarForName;
+
+            PropVariantInit(&propVarForName);
+
+            {
+                AC_TIMELINE_ZONE("IPropertyStore::GetValue(FriendlyName)");
+                hr = pProps->GetValue(
+                    PKEY_Device_FriendlyName, &propVarForName);
+            }
+            assert(SUCCEEDED(hr));
+            if (propVarForName.vt == VT_EMPTY)
+            {
+                std::wstringstream wos;
+                wos << "UnknownDeviceName" << endpointId;
+                name = wos.str();
+                LOG_INFO(L"End point device, id \"" << endpointId << L"\", has no name, assigning: \"" << name << L"\".")
+            }
+            else
+            {
+                name = propVarForName.pwszVal;
+                LOG_INFO(
+                    L"The end point device, id \"" << endpointId << L"\", has a name \"" << name << L"\".")
+            }
+            // ReSharper disable once CppFunctionResultShouldBeUsed
+            PropVariantClear(&propVarForName);
+        }
+
+        {
+            PROPVARIANT propVarForGuid;
+            PropVariantInit(&propVarForGuid);
+
+            {
+                AC_TIMELINE_ZONE("IPropertyStore::GetValue(ContainerId)");
+                hr = pProps->GetValue(
+                    PKEY_Device_ContainerId, &propVarForGuid);
+            }
+
+            assert(SUCCEEDED(hr));
+            assert(propVarForGuid.vt == VT_CLSID);
+            {
+                WCHAR buff[80];
+                // ReSharper disable once CppTooWideScopeInitStatement
+                const auto len = StringFromGUID2(
+                    *propVarForGuid.puuid,
+                    buff,
+                    std::size(buff)
+                );
+                if (len == 0)
+                {
+                    buff[0] = L'\0';
+                }
+                pnpGuid = std::wstring(buff);
+            }
+            LOG_INFO(
+                L"The end point device, id \"" << endpointId << L"\", has a PnP id \"" << pnpGuid << L"\".")
+
+                // ReSharper disable once CppFunctionResultShouldBeUsed
+            PropVariantClear(&propVarForGuid);
+        }
+
+        {
+            PROPVARIANT propVarForFormFactor;
+            PropVariantInit(&propVarForFormFactor);
+            {
+                AC_TIMELINE_ZONE("IPropertyStore::GetValue(FormFactor)");
+                hr = pProps->GetValue(AudioEndpointFormFactorKey, &propVarForFormFactor);
+            }
+            // Missing with some virtual endpoints
+            if (SUCCEEDED(hr) && propVarForFormFactor.vt == VT_UI4 && propVarForFormFactor.ulVal < EndpointFormFactor_enum_count)
+            {
+                formFactor = static_cast<DeviceFormFactor>(propVarForFormFactor.ulVal);
+            }
+            LOG_INFO(
+                L"The end point device, id \"" << endpointId << L"\", has a form factor \"" << GetFormFactorAsString(formFactor) << L"\".")
+            // ReSharper disable once CppFunctionResultShouldBeUsed
+            PropVariantClear(&propVarForFormFactor);
+        }
+        SAFE_RELEASE(pProps);
+    }
+    // Check mute and possibly correct volume
+    EndPointVolumeSmartPtr outVolumeEndpoint;
+    if (!TryActivateEndpointVolume(deviceEndpointSmartPtr, outVolumeEndpoint)) {
+        LOG_INFO(L"The end point device, id \"" << endpointId << L"\", has no volume property.");
+        return false;
+    }
+    uint16_t volume = 0;
+    BOOL mute;
+    {
+        AC_TIMELINE_ZONE("IAudioEndpointVolume::GetMute");
+        hr = outVolumeEndpoint->GetMute(&mute);
+    }
+    if (FAILED(hr)) {
+        return false;
+    }
+    if (mute == FALSE) {
+        float currVolume = 0.0f;
+        {
+            AC_TIMELINE_ZONE("IAudioEndpointVolume::GetMasterVolumeLevelScalar");
+            hr = outVolumeEndpoint->GetMasterVolumeLevelScalar(&currVolume);
+        }
+        if (FAILED(hr)) {
+            return false;
+        }
+        volume = static_cast<uint16_t>(lround(currVolume * 1000.0f));
+        LOG_INFO(L"The end point device, id \"" << endpointId << L"\", has a volume \"" << volume << L"\".");
+    }
+    uint16_t renderVolume = 0;
+    uint16_t captureVolume = 0;
+
+    switch (flow)
+    {
+    case DeviceFlowEnum::Capture:
+        captureVolume = volume;
+        break;
+    case DeviceFlowEnum::Render:
+        renderVolume = volume;
+        break;
+    default:
+        break;
+    }
+    device = Device(pnpGuid, name, flow, renderVolume, captureVolume, formFactor, GetJackConnection(deviceEndpointSmartPtr));
+    if (volumeToken != nullptr)
+    {
+        *volumeToken = std::make_unique<EndpointVolumeToken>(std::move(outVolumeEndpoint));
+    }
+    return true;
+}
+
+bool ed::audio::ComAudioBackend::TryGetDefaultEndpoint(DeviceFlowEnum flow, DeviceRole role, std::wstring & endpointId)
+{
+    AC_TIMELINE_ZONE("IMMDeviceEnumerator::GetDefaultAudioEndpoint");
+    CComPtr<IMMDevice> deviceSmartPtr;
+    {
+        IMMDevice * devicePtr = nullptr;
+        // Fails with E_NOTFOUND if there is no endpoint of the flow
+        if (FAILED(enumerator_->GetDefaultAudioEndpoint(flow == DeviceFlowEnum::Capture ? eCapture : eRender,
+                                                        static_cast<ERole>(role), &devicePtr)))
+        {
+            return false;
+        }
+        deviceSmartPtr.Attach(devicePtr);
+    }
+    LPWSTR deviceIdPtr = nullptr;
+    if (FAILED(deviceSmartPtr->GetId(&deviceIdPtr)))
+    {
+        return false;
+    }
+    endpointId = deviceIdPtr;
+    CoTaskMemFree(deviceIdPtr);
+    return true;
+}
+
+bool ed::audio::ComAudioBackend::TryReadEndpointProperty(const std::wstring & endpointId, EndpointProperty property, Device & device)
+{
+    AC_TIMELINE_ZONE("ComAudioBackend::TryReadEndpointProperty");
+    CComPtr<IMMDevice> deviceEndpointSmartPtr;
+    if (property == EndpointProperty::None || !TryGetDevice(endpointId, deviceEndpointSmartPtr))
+    {
+        return false;
+    }
+    CComPtr<IPropertyStore> propsSmartPtr;
+    {
+        AC_TIMELINE_ZONE("IMMDevice::OpenPropertyStore");
+        if (FAILED(deviceEndpointSmartPtr->OpenPropertyStore(STGM_READ, &propsSmartPtr)))
+        {
+            return false;
+        }
+    }
+    PROPVARIANT propVar;
+    PropVariantInit(&propVar);
+    HRESULT hr;
+    {
+        AC_TIMELINE_ZONE("IPropertyStore::GetValue");
+        hr = propsSmartPtr->GetValue(GetPropertyKey(property), &propVar);
+    }
+    auto isRead = false;
+    if (SUCCEEDED(hr))
+    {
+        switch (property)
+        {
+        case EndpointProperty::FriendlyName:
+            if (propVar.vt == VT_LPWSTR)
+            {
+                device.SetName(propVar.pwszVal);
+                isRead = true;
+                LOG_INFO(L"The end point device, id \"" << endpointId << L"\", has a new name \"" << device.GetName() << L"\".")
+            }
+            break;
+        case EndpointProperty::FormFactor:
+            device.SetFormFactor(propVar.vt == VT_UI4 && propVar.ulVal < EndpointFormFactor_enum_count
+                                     ? static_cast<DeviceFormFactor>(propVar.ulVal)
+                                     : DeviceFormFactor::Unknown);
+            isRead = true;
+            LOG_INFO(L"The end point device, id \"" << endpointId << L"\", has a new form factor \""
+                << GetFormFactorAsString(device.GetFormFactor()) << L"\".")
+            break;
+        case EndpointProperty::None:
+        default: // NOLINT(clang-diagnostic-covered-switch-default)
+            break;
+        }
+    }
+    // ReSharper disable once CppFunctionResultShouldBeUsed
+    PropVariantClear(&propVar);
+    return isRead;
+}
+
+void ed::audio::ComAudioBackend::RegisterVolumeNotification(const std::wstring & endpointId, TVolumeNotificationToken volumeToken)
+{
+    EndPointVolumeSmartPtr endpointVolume;
+    if (volumeToken != nullptr)
+    {
+        endpointVolume = std::move(static_cast<EndpointVolumeToken&>(*volumeToken).EndpointVolume);
+    }
+    if (CComPtr<IMMDevice> deviceSmartPtr;
+        client_ != nullptr
+        && (endpointVolume != nullptr
+            || (TryGetDevice(endpointId, deviceSmartPtr) && TryActivateEndpointVolume(deviceSmartPtr, endpointVolume))))
+    {
+        UnregisterVolumeNotification(endpointId);
+        CComPtr<IAudioEndpointVolumeCallback> callback;
+        callback.Attach(new EndpointVolumeCallback(*client_, endpointId));
+        HRESULT hr;
+        {
+            AC_TIMELINE_ZONE("IAudioEndpointVolume::RegisterControlChangeNotify");
+            hr = endpointVolume->RegisterControlChangeNotify(callback);
+        }
+        if (SUCCEEDED(hr))
+        {
+            devIdToEndpointVolumes_.try_emplace(endpointId, std::move(endpointVolume), std::move(callback));
+        }
+    }
+}
+
+void ed::audio::ComAudioBackend::UnregisterVolumeNotification(const std::wstring & endpointId)
+{
+    // The registration unregisters its callback and releases the endpoint volume
+    devIdToEndpointVolumes_.erase(endpointId);
+}
+
+void ed::audio::ComAudioBackend::UnregisterAllVolumeNotifications()
+{
+    devIdToEndpointVolumes_.clear();
+}
+
+size_t ed::audio::ComAudioBackend::GetVolumeNotificationCount() const
+{
+    return devIdToEndpointVolumes_.size();
+}
+
+bool ed::audio::ComAudioBackend::TryGetDevice(const std::wstring & endpointId, CComPtr<IMMDevice> & deviceSmartPtr) const
+{
+    AC_TIMELINE_ZONE("IMMDeviceEnumerator::GetDevice");
+    IMMDevice * devicePtr = nullptr;
+    if (FAILED(enumerator_->GetDevice(endpointId.c_str(), &devicePtr)))
+    {
+        return false;
+    }
+    deviceSmartPtr.Attach(devicePtr);
+    return true;
+}
+
+// ReSharper disable once CppPassValueParameterByConstReference
+bool ed::audio::ComAudioBackend::TryActivateEndpointVolume(CComPtr<IMMDevice> deviceSmartPtr, EndPointVolumeSmartPtr & outVolumeEndpoint)
+{
+    AC_TIMELINE_ZONE("IMMDevice::Activate(IAudioEndpointVolume)");
+    IAudioEndpointVolume * pEndpointVolume = nullptr;
+    if (FAILED(deviceSmartPtr->Activate(
+        __uuidof(IAudioEndpointVolume),
+        CLSCTX_INPROC_SERVER,
+        nullptr,
+        reinterpret_cast<void**>(&pEndpointVolume)
+    )))
+    {
+        return false;
+    }
+    outVolumeEndpoint.Attach(pEndpointVolume);
+    return true;
+}
+
+DeviceJackConnection ed::audio::ComAudioBackend::GetJackConnection(CComPtr<IMMDevice> deviceSmartPtr)
+{
+    AC_TIMELINE_ZONE("IKsJackDescription::GetJackDescription");
+    // The endpoint's connector is connected to the adapter part (the bridge pin) describing the jack
+    CComPtr<IDeviceTopology> topology;
+    CComPtr<IConnector> endpointConnector;
+    CComPtr<IConnector> adapterConnector;
+    CComPtr<IPart> adapterPart;
+    CComPtr<IKsJackDescription> jackDescription;
+    UINT jackCount = 0;
+    KSJACK_DESCRIPTION description{};
+    if (FAILED(deviceSmartPtr->Activate(__uuidof(IDeviceTopology), CLSCTX_INPROC_SERVER, nullptr, reinterpret_cast<void**>(&topology)))
+        || FAILED(topology->GetConnector(0, &endpointConnector))
+        || FAILED(endpointConnector->GetConnectedTo(&adapterConnector))
+        || FAILED(adapterConnector.QueryInterface(&adapterPart))
+        || FAILED(adapterPart->Activate(CLSCTX_INPROC_SERVER, __uuidof(IKsJackDescription), reinterpret_cast<void**>(&jackDescription)))
+        || FAILED(jackDescription->GetJackCount(&jackCount)) || jackCount == 0
+        || FAILED(jackDescription->GetJackDescription(0, &description)))
+    {
+        return DeviceJackConnection::Unknown;
+    }
+    // eConnTypeUnknown is 0, as DeviceJackConnection::Unknown
+    return description.ConnectionType <= eConnTypeCombination
+               ? static_cast<DeviceJackConnection>(description.ConnectionType)
+               : DeviceJackConnection::Unknown;
+}
+
+bool ed::audio::ComAudioBackend::IsTraceOn() const
+{
+    return traceFunction_ && isTraceOn_ && isTraceOn_();
+}
+
+void ed::audio::ComAudioBackend::TraceIt(const std::wstring & line) const
+{
+    if (traceFunction_)
+    {
+        traceFunction_(line);
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atlbase.h>
+#include <devicetopology.h>
+#include <endpointvolume.h>
+#include <map>
+#include <mmdeviceapi.h>
+
+#include "AudioBackendInterface.h"
+
+
+namespace ed::audio {
+using EndPointVolumeSmartPtr = CComPtr<IAudioEndpointVolume>;
+
+// Backend on top of IMMDeviceEnumerator, IMMDevice, IPropertyStore, IAudioEndpointVolume and IDeviceTopology.
+class ComAudioBackend final : public AudioBackendInterface {
+public:
+    DISALLOW_COPY_MOVE(ComAudioBackend);
+    ~ComAudioBackend() override;
+
+public:
+    ComAudioBackend();
+
+    void Start(MultipleNotificationClient & client, TraceFunctionT traceFunction, TraceOnFunctionT isTraceOn) override;
+    void Stop() override;
+
+    bool TryEnumerateActiveEndpoints(bool bothHeadsetAndMicro, std::vector<std::wstring> & endpointIds) override;
+    bool TryProbeEndpoint(const std::wstring & endpointId, Device & device, TVolumeNotificationToken * volumeToken) override;
+    bool TryGetDefaultEndpoint(DeviceFlowEnum flow, DeviceRole role, std::wstring & endpointId) override;
+    bool TryReadEndpointProperty(const std::wstring & endpointId, EndpointProperty property, Device & device) override;
+
+    void RegisterVolumeNotification(const std::wstring & endpointId, TVolumeNotificationToken volumeToken) override;
+    void UnregisterVolumeNotification(const std::wstring & endpointId) override;
+    void UnregisterAllVolumeNotifications() override;
+    [[nodiscard]] size_t GetVolumeNotificationCount() const override;
+
+private:
+    bool TryGetDevice(const std::wstring & endpointId, CComPtr<IMMDevice> & deviceSmartPtr) const;
+    static bool TryActivateEndpointVolume(CComPtr<IMMDevice> deviceSmartPtr, EndPointVolumeSmartPtr & outVolumeEndpoint);
+    // The connector type of the jack the endpoint is connected to, Unknown if its driver describes no jack
+    static DeviceJackConnection GetJackConnection(CComPtr<IMMDevice> deviceSmartPtr);
+    [[nodiscard]] bool IsTraceOn() const;
+    void TraceIt(const std::wstring & line) const;
+
+private:
+    // The endpoint volume a probe has activated
+    class EndpointVolumeToken final : public VolumeNotificationToken {
+    public:
+        DISALLOW_COPY_MOVE(EndpointVolumeToken);
+        ~EndpointVolumeToken() override = default;
+        explicit EndpointVolumeToken(EndPointVolumeSmartPtr endpointVolume) : EndpointVolume(std::move(endpointVolume)) {}
+
+        EndPointVolumeSmartPtr EndpointVolume;
+    };
+
+    // Owns the registration of one endpoint's own callback (so a volume notification names its endpoint):
+    // holds a reference to the endpoint volume and to the callback and unregisters the callback when destroyed,
+    // so erasing the registration from the registry releases both.
+    class VolumeRegistration final {
+    public:
+        DISALLOW_COPY_MOVE(VolumeRegistration);
+        VolumeRegistration(EndPointVolumeSmartPtr endpointVolume, CComPtr<IAudioEndpointVolumeCallback> callback);
+        ~VolumeRegistration();
+
+    private:
+        EndPointVolumeSmartPtr endpointVolume_;
+        CComPtr<IAudioEndpointVolumeCallback> callback_;
+    };
+
+private:
+    IMMDeviceEnumerator * enumerator_ = nullptr;
+    MultipleNotificationClient * client_ = nullptr;
+    TraceFunctionT traceFunction_;
+    TraceOnFunctionT isTraceOn_;
+    std::map<std::wstring, VolumeRegistration> devIdToEndpointVolumes_;
+};
+}
@@ -49,9 +49,81 @@ inline std::wstring GetDeviceCollectionEventAsString(DeviceCollectionEvent v)
     COMMAND_CASE2(DeviceCollectionEvent, Discovered)
     COMMAND_CASE2(DeviceCollectionEvent, Detached)
     COMMAND_CASE2(DeviceCollectionEvent, VolumeChanged)
+    COMMAND_CASE2(DeviceCollectionEvent, DefaultChanged)
+    COMMAND_CASE2(DeviceCollectionEvent, PropertyChanged)
     case DeviceCollectionEvent::None:
     default: // NOLINT(clang-diagnostic-covered-switch-default)
         return L"Unknown event";
     }
 }
+
+inline std::wstring GetFormFactorAsString(DeviceFormFactor v)
+{
+    switch (v)
+    {
+    COMMAND_CASE2(DeviceFormFactor, RemoteNetworkDevice)
+    COMMAND_CASE2(DeviceFormFactor, Speakers)
+    COMMAND_CASE2(DeviceFormFactor, LineLevel)
+    COMMAND_CASE2(DeviceFormFactor, Headphones)
+    COMMAND_CASE2(DeviceFormFactor, Microphone)
+    COMMAND_CASE2(DeviceFormFactor, Headset)
+    COMMAND_CASE2(DeviceFormFactor, Handset)
+    COMMAND_CASE2(DeviceFormFactor, UnknownDigitalPassthrough)
+    COMMAND_CASE2(DeviceFormFactor, Spdif)
+    COMMAND_CASE2(DeviceFormFactor, DigitalAudioDisplayDevice)
+    case DeviceFormFactor::Unknown:
+    default: // NOLINT(clang-diagnostic-covered-switch-default)
+        return L"Unknown form factor";
+    }
+}
+
+inline std::wstring GetJackConnectionAsString(DeviceJackConnection v)
+{
+    switch (v)
+    {
+    COMMAND_CASE2(DeviceJackConnection, Jack3Point5mm)
+    COMMAND_CASE2(DeviceJackConnection, Quarter)
+    COMMAND_CASE2(DeviceJackConnection, AtapiInternal)
+    COMMAND_CASE2(DeviceJackConnection, Rca)
+    COMMAND_CASE2(DeviceJackConnection, Optical)
+    COMMAND_CASE2(DeviceJackConnection, OtherDigital)
+    COMMAND_CASE2(DeviceJackConnection, OtherAnalog)
+    COMMAND_CASE2(DeviceJackConnection, MultichannelAnalogDin)
+    COMMAND_CASE2(DeviceJackConnection, XlrProfessional)
+    COMMAND_CASE2(DeviceJackConnection, Rj11Modem)
+    COMMAND_CASE2(DeviceJackConnection, Combination)
+    case DeviceJackConnection::Unknown:
+    default: // NOLINT(clang-diagnostic-covered-switch-default)
+        return L"Unknown jack connection";
+    }
+}
+
+inline std::wstring GetRoleAsString(DeviceRole v)
+{
+    switch (v)
+    {
+    COMMAND_CASE2(DeviceRole, Console)
+    COMMAND_CASE2(DeviceRole, Multimedia)
+    COMMAND_CASE2(DeviceRole, Communications)
+    default: // NOLINT(clang-diagnostic-covered-switch-default)
+        return L"Unknown role";
+    }
+}
+
+// E.g. "Render Console, Capture Communications"; empty if the device is no default
+inline std::wstring GetDefaultRolesAsString(const DeviceInterface & device)
+{
+    std::wstring defaultRoles;
+    for (const auto flow : {DeviceFlowEnum::Render, DeviceFlowEnum::Capture})
+    {
+        for (const auto role : {DeviceRole::Console, DeviceRole::Multimedia, DeviceRole::Communications})
+        {
+            if (device.IsDefault(flow, role))
+            {
+                defaultRoles += (defaultRoles.empty() ? L"" : L", ") + GetFlowAsString(flow) + L' ' + GetRoleAsString(role);
+            }
+        }
+    }
+    return defaultRoles;
+}
 }
@@ -11,12 +11,15 @@ ed::audio::Device::Device()
 
 // ReSharper disable once CppParameterMayBeConst
 ed::audio::Device::Device(std::wstring pnpGuid, std::wstring name, DeviceFlowEnum flow, uint16_t renderVolume,
-                          uint16_t captureVolume)
+                          uint16_t captureVolume, DeviceFormFactor formFactor, DeviceJackConnection jackConnection)
     : pnpGuid_(std::move(pnpGuid))
       , name_(std::move(name))
       , flow_(flow)
       , renderVolume_(renderVolume)
       , captureVolume_(captureVolume)
+      , formFactor_(formFactor)
+      , jackConnection_(jackConnection)
+      , defaultRoles_(0)
 {
 }
 
@@ -26,6 +29,9 @@ ed::audio::Device::Device(const Device & toCopy)
       , flow_(toCopy.flow_)
       , renderVolume_(toCopy.renderVolume_)
       , captureVolume_(toCopy.captureVolume_)
+      , formFactor_(toCopy.formFactor_)
+      , jackConnection_(toCopy.jackConnection_)
+      , defaultRoles_(toCopy.defaultRoles_)
 {
 }
 
@@ -35,6 +41,9 @@ ed::audio::Device::Device(Device && toMove) noexcept
       , flow_(toMove.flow_)
       , renderVolume_(toMove.renderVolume_)
       , captureVolume_(toMove.captureVolume_)
+      , formFactor_(toMove.formFactor_)
+      , jackConnection_(toMove.jackConnection_)
+      , defaultRoles_(toMove.defaultRoles_)
 {
 }
 
@@ -47,6 +56,9 @@ ed::audio::Device & ed::audio::Device::operator=(const Device & toCopy)
         flow_ = toCopy.flow_;
         renderVolume_ = toCopy.renderVolume_;
         captureVolume_ = toCopy.captureVolume_;
+        formFactor_ = toCopy.formFactor_;
+        jackConnection_ = toCopy.jackConnection_;
+        defaultRoles_ = toCopy.defaultRoles_;
     }
     return *this;
 }
@@ -60,6 +72,9 @@ ed::audio::Device & ed::audio::Device::operator=(Device && toMove) noexcept
         flow_ = toMove.flow_;
         renderVolume_ = toMove.renderVolume_;
         captureVolume_ = toMove.captureVolume_;
+        formFactor_ = toMove.formFactor_;
+        jackConnection_ = toMove.jackConnection_;
+        defaultRoles_ = toMove.defaultRoles_;
     }
     return *this;
 }
@@ -89,6 +104,21 @@ uint16_t ed::audio::Device::GetCurrentCaptureVolume() const
     return captureVolume_;
 }
 
+DeviceFormFactor ed::audio::Device::GetFormFactor() const
+{
+    return formFactor_;
+}
+
+DeviceJackConnection ed::audio::Device::GetJackConnection() const
+{
+    return jackConnection_;
+}
+
+bool ed::audio::Device::IsDefault(DeviceFlowEnum flow, DeviceRole role) const
+{
+    return (defaultRoles_ & GetDefaultRoleBit(flow, role)) != 0;
+}
+
 void ed::audio::Device::SetCurrentRenderVolume(uint16_t volume)
 {
     renderVolume_ = volume;
@@ -99,3 +129,34 @@ void ed::audio::Device::SetCurrentCaptureVolume(uint16_t volume)
     captureVolume_ = volume;
 }
 
+void ed::audio::Device::SetName(std::wstring name)
+{
+    name_ = std::move(name);
+}
+
+void ed::audio::Device::SetFormFactor(DeviceFormFactor formFactor)
+{
+    formFactor_ = formFactor;
+}
+
+uint8_t ed::audio::Device::GetDefaultRoles() const
+{
+    return defaultRoles_;
+}
+
+void ed::audio::Device::SetDefaultRoles(uint8_t defaultRoles)
+{
+    defaultRoles_ = defaultRoles;
+}
+
+/*static*/
+uint8_t ed::audio::Device::GetDefaultRoleBit(DeviceFlowEnum flow, DeviceRole role)
+{
+    // The render roles, then the capture roles
+    if ((flow != DeviceFlowEnum::Render && flow != DeviceFlowEnum::Capture) || static_cast<size_t>(role) >= DeviceRoleCount)
+    {
+        return 0;
+    }
+    const auto position = (flow == DeviceFlowEnum::Capture ? DeviceRoleCount : 0) + static_cast<size_t>(role);
+    return static_cast<uint8_t>(1u << position);
+}
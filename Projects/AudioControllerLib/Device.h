@@ -11,7 +11,8 @@ public:
 
 public:
     Device();
-    Device(std::wstring pnpGuid, std::wstring name, DeviceFlowEnum flow, uint16_t renderVolume, uint16_t captureVolume);
+    Device(std::wstring pnpGuid, std::wstring name, DeviceFlowEnum flow, uint16_t renderVolume, uint16_t captureVolume,
+           DeviceFormFactor formFactor = DeviceFormFactor::Unknown, DeviceJackConnection jackConnection = DeviceJackConnection::Unknown);
     Device(const Device & toCopy);
     Device(Device && toMove) noexcept;
     Device & operator=(const Device & toCopy);
@@ -23,8 +24,20 @@ public:
     [[nodiscard]] DeviceFlowEnum GetFlow() const override;
     [[nodiscard]] uint16_t GetCurrentRenderVolume() const override;
     [[nodiscard]] uint16_t GetCurrentCaptureVolume() const override;
+    [[nodiscard]] DeviceFormFactor GetFormFactor() const override;
+    [[nodiscard]] DeviceJackConnection GetJackConnection() const override;
+    [[nodiscard]] bool IsDefault(DeviceFlowEnum flow, DeviceRole role) const override;
     void SetCurrentRenderVolume(uint16_t volume);
     void SetCurrentCaptureVolume(uint16_t volume);
+    // Of the facts of one endpoint, refreshed by a property change; a merged device is merged anew instead
+    void SetName(std::wstring name);
+    void SetFormFactor(DeviceFormFactor formFactor);
+    // Bits of GetDefaultRoleBit(), set by the collection from the default endpoints it tracks
+    [[nodiscard]] uint8_t GetDefaultRoles() const;
+    void SetDefaultRoles(uint8_t defaultRoles);
+
+    // The bit of the flow, Render or Capture, and the role; zero for any other flow or an unknown role
+    [[nodiscard]] static uint8_t GetDefaultRoleBit(DeviceFlowEnum flow, DeviceRole role);
 
 private:
     std::wstring pnpGuid_;
@@ -32,5 +45,8 @@ private:
     DeviceFlowEnum flow_;
     uint16_t renderVolume_;
     uint16_t captureVolume_;
+    DeviceFormFactor formFactor_;
+    DeviceJackConnection jackConnection_;
+    uint8_t defaultRoles_;
 };
 }
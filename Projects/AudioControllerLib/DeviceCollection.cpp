@@ -4,12 +4,14 @@
 #include "DeviceCollection.h"
 #include "Device.h"
 
+#include <algorithm>
+#include <bit>
 #include <iostream>
 #include <cstddef>
-#include <mmdeviceapi.h>
-#include <endpointvolume.h>
-#include <Functiondiscoverykeys_devpkey.h>
+#include <exception>
+#include <iterator>
 #include <ranges>
+#include <set>
 #include <sstream>
 #include <string>
 #include <valarray>
@@ -19,42 +21,49 @@
 #include "generate-uuid.h"
 #include "Utilities.h"
 #include "CaseInsensitiveSubstr.h"
+#include "CoInitRaiiHelper.h"
+#include "ComAudioBackend.h"
+#include "DeviceTableCache.h"
+#include "NotificationArena.h"
+#include "TimelineTrace.h"
 
 using namespace std::literals::string_literals;
 
-inline DeviceFlowEnum ConvertFromLowLevelFlow(const EDataFlow flow)
+ed::audio::DeviceCollection::~DeviceCollection()
 {
-    switch (flow)
+    SetBurstWindow(std::chrono::milliseconds::zero());
+    std::thread resetThread;
+    {
+        std::lock_guard lock(resetThreadMutex_);
+        resetThread = std::move(resetThread_);
+    }
+    // Joins the earlier ones, too
+    if (resetThread.joinable())
     {
-    case eRender:
-        return DeviceFlowEnum::Render;
-    case eCapture:
-        return DeviceFlowEnum::Capture;
-    case eAll:
-        return DeviceFlowEnum::RenderAndCapture;
-    case EDataFlow_enum_count:
-    default: // NOLINT(clang-diagnostic-covered-switch-default)
-        return DeviceFlowEnum::None;
+        resetThread.join();
     }
+    SaveWarmStartCache();
+    backend_->Stop();
 }
 
-
-ed::audio::DeviceCollection::~DeviceCollection()
+ed::audio::DeviceCollection::DeviceCollection(std::wstring nameFilter, bool bothHeadsetAndMicro)
+    : DeviceCollection(std::move(nameFilter), bothHeadsetAndMicro, std::make_unique<ComAudioBackend>())
 {
-    UnregisterAllEndpointsVolumes();
-    SAFE_RELEASE(enumerator_)
 }
 
-// ReSharper disable once CppParameterNeverUsed
-ed::audio::DeviceCollection::DeviceCollection(std::wstring nameFilter, bool bothHeadsetAndMicro)
+ed::audio::DeviceCollection::DeviceCollection(std::wstring nameFilter, bool bothHeadsetAndMicro, std::unique_ptr<AudioBackendInterface> backend)
     : MultipleNotificationClient()
+      , backend_(std::move(backend))
       , nameFilter_(std::move(nameFilter))
       , bothHeadsetAndMicro_(bothHeadsetAndMicro)
+      , changeLog_(ChangeLogCapacity)
 {
-    auto hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL, IID_PPV_ARGS(&enumerator_));
-    assert(SUCCEEDED(hr));
-
-    ResetNotification(enumerator_);
+    // Room for a GUID, so that logging a change does not allocate
+    for (auto & loggedChange : changeLog_)
+    {
+        loggedChange.PnpId.reserve(noPlugAndPlayGuid_.size());
+    }
+    backend_->Start(*this, [this](const std::wstring & line) { TraceIt(line); }, [this] { return IsTraceOn(); });
 }
 
 void ed::audio::DeviceCollection::ResetContent()
@@ -62,13 +71,111 @@ void ed::audio::DeviceCollection::ResetContent()
     RecreateActiveDeviceList();
 }
 
+std::future<void> ed::audio::DeviceCollection::ResetContentAsync(std::function<void()> onCompleted)
+{
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    std::lock_guard lock(resetThreadMutex_);
+    // Every reset thread joins the previous one first, so resets run in the order they were asked for. The caller
+    // never joins: it may be the previous reset thread itself, calling again from its onCompleted.
+    resetThread_ = std::thread(
+        [this, previous = std::move(resetThread_), onCompleted = std::move(onCompleted), promise = std::move(promise)]() mutable
+        {
+            if (previous.joinable())
+            {
+                previous.join();
+            }
+            std::exception_ptr error;
+            try
+            {
+                const CoInitRaiiHelper coInitHelper;
+                // A stale (warm-start) table is reconciled as a whole, otherwise devices show up one by one
+                if (stale_)
+                {
+                    RecreateActiveDeviceList();
+                }
+                else
+                {
+                    RecreateActiveDeviceListProgressively();
+                }
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            // Failed or not; the future tells
+            if (onCompleted)
+            {
+                try
+                {
+                    onCompleted();
+                }
+                catch (...)
+                {
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                }
+            }
+            if (error)
+            {
+                promise.set_exception(error);
+            }
+            else
+            {
+                promise.set_value();
+            }
+        });
+    return future;
+}
+
 size_t ed::audio::DeviceCollection::GetSize() const
 {
+    TableLock lock(*this);
     return pnpToDeviceMap_.size();
 }
 
+std::vector<std::unique_ptr<DeviceInterface>> ed::audio::DeviceCollection::FindDevices(const DeviceQuery & query) const
+{
+    TableLock lock(*this);
+    std::vector<std::unique_ptr<DeviceInterface>> devices;
+    if (!query.PnpId.empty())
+    {
+        if (const auto foundPair = pnpToDeviceMap_.find(query.PnpId);
+            foundPair != pnpToDeviceMap_.end() && DeviceQueryIndex::IsMatching(*foundPair, query))
+        {
+            devices.push_back(std::make_unique<Device>(foundPair->second));
+        }
+        return devices;
+    }
+    for (const auto * entry : queryIndex_.Find(query))
+    {
+        devices.push_back(std::make_unique<Device>(entry->second));
+    }
+    return devices;
+}
+
+std::unique_ptr<DeviceInterface> ed::audio::DeviceCollection::GetDefaultDevice(DeviceFlowEnum flow, DeviceRole role) const
+{
+    const auto bit = Device::GetDefaultRoleBit(flow, role);
+    if (bit == 0)
+    {
+        return nullptr;
+    }
+    TableLock lock(*this);
+    const auto foundEndpoint = endpointToDevice_.find(defaultEndpoints_[std::countr_zero(bit)]);
+    if (foundEndpoint == endpointToDevice_.end())
+    {
+        return nullptr;
+    }
+    const auto foundPair = pnpToDeviceMap_.find(foundEndpoint->second.PnpId);
+    return foundPair != pnpToDeviceMap_.end() ? std::make_unique<Device>(foundPair->second) : nullptr;
+}
+
 std::unique_ptr<DeviceInterface> ed::audio::DeviceCollection::CreateItem(size_t deviceNumber) const
 {
+    TableLock lock(*this);
     if (deviceNumber >= pnpToDeviceMap_.size())
     {
         throw std::runtime_error("Device number is too big");
@@ -86,171 +193,271 @@ std::unique_ptr<DeviceInterface> ed::audio::DeviceCollection::CreateItem(size_t
 
 void ed::audio::DeviceCollection::Subscribe(DeviceCollectionObserverInterface & observer)
 {
-    observers_.insert(&observer);
+    Subscribe(observer, DeviceCollectionSubscription{});
 }
 
-void ed::audio::DeviceCollection::Unsubscribe(DeviceCollectionObserverInterface & observer)
+void ed::audio::DeviceCollection::Subscribe(DeviceCollectionObserverInterface & observer, const DeviceCollectionSubscription & subscription)
 {
-    observers_.erase(&observer);
+    std::lock_guard lock(observersMutex_);
+    auto changed = std::make_shared<const ObserverIndex>(observers_.load()->With(observer, subscription));
+    traceObserverCount_ = changed->GetTraceObservers(TraceLevel::Info).size();
+    observers_.store(std::move(changed));
 }
 
-
-bool ed::audio::DeviceCollection::TryCreateDeviceAndGetVolumeEndpoint(
-    ULONG i,
-    CComPtr<IMMDevice> deviceEndpointSmartPtr,
-    Device & device,
-    std::wstring & deviceId,
-    EndPointVolumeSmartPtr & outVolumeEndpoint
-) const {
-    HRESULT hr;
-    // Get device id
+void ed::audio::DeviceCollection::Unsubscribe(DeviceCollectionObserverInterface & observer)
+{
     {
-        LPWSTR deviceIdPtr = nullptr;
-        hr = deviceEndpointSmartPtr->GetId(&deviceIdPtr);
-        if (FAILED(hr)) {
-            return false;
+        std::lock_guard lock(observersMutex_);
+        const auto current = observers_.load();
+        if (!current->Contains(observer))
+        {
+            return;
         }
-        deviceId = deviceIdPtr;
-        LOG_INFO(L"Id of the current point device " << i << L" is \"" << deviceId << L"\".");
-        CoTaskMemFree(deviceIdPtr);
+        auto changed = std::make_shared<const ObserverIndex>(current->Without(observer));
+        traceObserverCount_ = changed->GetTraceObservers(TraceLevel::Info).size();
+        observers_.store(std::move(changed));
     }
-    // Get flow direction via IMMEndpoint
-    auto flow = DeviceFlowEnum::None;
+    // A dispatch that has loaded the index before may still call the observer back; not waited for with
+    // observersMutex_ held, as its callbacks may (un)subscribe
+    WaitForDispatches();
+}
+
+std::shared_ptr<const ed::audio::ObserverIndex> ed::audio::DeviceCollection::GetObserversSnapshot() const
+{
+    return observers_.load(std::memory_order_acquire);
+}
+
+void ed::audio::DeviceCollection::WaitForDispatches()
+{
+    // The dispatch of this thread would never end; the dispatches of other threads may still call back until they end
+    if (ScopedDispatch::IsDispatching(*this))
     {
-        EDataFlow lowLevelFlow;
-        IMMEndpoint * pEndpoint = nullptr;
-        hr = deviceEndpointSmartPtr->QueryInterface(__uuidof(IMMEndpoint), reinterpret_cast<void**>(&pEndpoint));
-        if (FAILED(hr)) {
-            return false;
-        }
-        hr = pEndpoint->GetDataFlow(&lowLevelFlow);
-        SAFE_RELEASE(pEndpoint);
-        if (FAILED(hr)) {
-            return false;
-        }
-        flow = ConvertFromLowLevelFlow(lowLevelFlow);
-        LOG_INFO(L"The end point device " << i << L", id \"" << deviceId << L"\", has a data flow \"" << GetFlowAsString(flow) << L"\".");
+        return;
     }
-    // Read device PnP Class id property
-    std::wstring pnpGuid;
-    std::wstring name;
+    // A dispatch started in an earlier epoch of the same parity has ended, as the waiter that advanced that epoch
+    // has waited for it
+    std::lock_guard lock(dispatchWaitMutex_);
+    const auto parity = static_cast<size_t>(dispatchEpoch_.fetch_add(1) & 1);
+    while (dispatchesInFlight_[parity].load() != 0)
     {
-        IPropertyStore* pProps = nullptr;
-        hr = deviceEndpointSmartPtr->OpenPropertyStore(STGM_READ, &pProps);
-        if (FAILED(hr)) {
-            return false;
-        }
-        {
-            PROPVARIANT propVarForName;
+        std::this_thread::yield();
+    }
+}
 
-            PropVariantInit(&propVarForName);
+thread_local ed::audio::DeviceCollection::ScopedDispatch * ed::audio::DeviceCollection::ScopedDispatch::innermost_ = nullptr;
 
-            hr = pProps->GetValue(
-                PKEY_Device_FriendlyName, &propVarForName);
-            assert(SUCCEEDED(hr));
-            if (propVarForName.vt == VT_EMPTY)
-            {
-                std::wstringstream wos;
-                wos << "UnknownDeviceName" << i;
-                name = wos.str();
-                LOG_INFO(L"End point device " << i << L", id \"" << deviceId << L"\", has no name, assigning: \"" << name << L"\".")
-            }
-            else
-            {
-                name = propVarForName.pwszVal;
-                LOG_INFO(
-                    L"The end point device " << i << L", id \"" << deviceId << L"\", has a name \"" << name << L"\".")
-            }
-            // ReSharper disable once CppFunctionResultShouldBeUsed
-            PropVariantClear(&propVarForName);
+ed::audio::DeviceCollection::ScopedDispatch::ScopedDispatch(const DeviceCollection & collection)
+    : collection_(collection)
+    , outer_(innermost_)
+{
+    // Counted under an epoch still current once counted, so a waiter advancing it meanwhile is not missed
+    for (;;)
+    {
+        const auto epoch = collection_.dispatchEpoch_.load();
+        parity_ = static_cast<size_t>(epoch & 1);
+        collection_.dispatchesInFlight_[parity_].fetch_add(1);
+        if (collection_.dispatchEpoch_.load() == epoch)
+        {
+            break;
         }
+        collection_.dispatchesInFlight_[parity_].fetch_sub(1);
+    }
+    observers_ = collection_.GetObserversSnapshot();
+    innermost_ = this;
+}
+
+ed::audio::DeviceCollection::ScopedDispatch::~ScopedDispatch()
+{
+    innermost_ = outer_;
+    observers_.reset();
+    collection_.dispatchesInFlight_[parity_].fetch_sub(1);
+}
 
+/*static*/
+bool ed::audio::DeviceCollection::ScopedDispatch::IsDispatching(const DeviceCollection & collection)
+{
+    for (const auto * dispatch = innermost_; dispatch != nullptr; dispatch = dispatch->outer_)
+    {
+        if (&dispatch->collection_ == &collection)
         {
-            PROPVARIANT propVarForGuid;
-            PropVariantInit(&propVarForGuid);
+            return true;
+        }
+    }
+    return false;
+}
 
-            hr = pProps->GetValue(
-                PKEY_Device_ContainerId, &propVarForGuid);
+thread_local ed::audio::DeviceCollection::TableLock * ed::audio::DeviceCollection::TableLock::held_ = nullptr;
 
-            assert(SUCCEEDED(hr));
-            assert(propVarForGuid.vt == VT_CLSID);
-            {
-                WCHAR buff[80];
-                // ReSharper disable once CppTooWideScopeInitStatement
-                const auto len = StringFromGUID2(
-                    *propVarForGuid.puuid,
-                    buff,
-                    std::size(buff)
-                );
-                if (len == 0)
-                {
-                    buff[0] = L'\0';
-                }
-                pnpGuid = std::wstring(buff);
-            }
-            LOG_INFO(
-                L"The end point device " << i << L", id \"" << deviceId << L"\", has a PnP id \"" << pnpGuid << L"\".")
+ed::audio::DeviceCollection::TableLock::TableLock(const DeviceCollection & collection)
+    : collection_(collection)
+    , lock_(collection.mutex_)
+    , keptLines_(NotificationArena::GetCurrentResource())
+    , uncaughtExceptions_(std::uncaught_exceptions())
+{
+    held_ = this;
+}
 
-                // ReSharper disable once CppFunctionResultShouldBeUsed
-            PropVariantClear(&propVarForGuid);
-        }
-        SAFE_RELEASE(pProps);
+ed::audio::DeviceCollection::TableLock::~TableLock() noexcept(false)
+{
+    held_ = nullptr;
+    lock_.unlock();
+    if (std::uncaught_exceptions() > uncaughtExceptions_)
+    {
+        return;
     }
-    // Get IAudioEndpointVolume and volume
-    outVolumeEndpoint = nullptr;
-    uint16_t volume = 0;
+    for (const auto & [level, line] : keptLines_)
     {
-        IAudioEndpointVolume* pEndpointVolume;
-        hr = deviceEndpointSmartPtr->Activate(
-            __uuidof(IAudioEndpointVolume),
-            CLSCTX_INPROC_SERVER,
-            nullptr,
-            reinterpret_cast<void**>(&pEndpointVolume)
-        );
-        if (SUCCEEDED(hr)) {
-            outVolumeEndpoint.Attach(pEndpointVolume);
+        const std::wstring text(line);
+        if (level == TraceLevel::Debug)
+        {
+            collection_.TraceItDebug(text);
+        }
+        else
+        {
+            collection_.TraceIt(text);
         }
     }
-    // Check mute and possibly correct volume
-    if (outVolumeEndpoint == nullptr) {
-        LOG_INFO(L"The end point device " << i << L", id \"" << deviceId << L"\", has no volume property.");
+}
+
+/*static*/
+bool ed::audio::DeviceCollection::TableLock::TryKeepTrace(const DeviceCollection & collection, TraceLevel level,
+                                                          std::wstring_view line)
+{
+    if (held_ == nullptr || &held_->collection_ != &collection)
+    {
         return false;
     }
-    BOOL mute;
-    hr = outVolumeEndpoint->GetMute(&mute);
-    if (FAILED(hr)) {
+    held_->keptLines_.emplace_back(level, line);
+    return true;
+}
+
+bool ed::audio::DeviceCollection::LoadWarmStartCache(const std::wstring & cacheFilePath)
+{
+    std::vector<Device> devices;
+    const auto loaded = DeviceTableCache(cacheFilePath).Load(devices);
+
+    TableLock lock(*this);
+    cacheFilePath_ = cacheFilePath;
+    if (!loaded)
+    {
+        LOG_INFO(L"No valid warm-start cache in \"" << cacheFilePath << L"\".")
         return false;
     }
-    if (mute == FALSE) {
-        float currVolume = 0.0f;
-        hr = outVolumeEndpoint->GetMasterVolumeLevelScalar(&currVolume);
-        if (FAILED(hr)) {
-            return false;
-        }
-        volume = static_cast<uint16_t>(lround(currVolume * 1000.0f));
-        LOG_INFO(L"The end point device " << i << L", id \"" << deviceId << L"\", has a volume \"" << volume << L"\".");
+    TPnPIdToDeviceMap cachedDevices;
+    for (auto & device : devices)
+    {
+        auto pnpId = device.GetPnpId();
+        cachedDevices.emplace(std::move(pnpId), std::move(device));
+    }
+    ReplaceDevices(std::move(cachedDevices));
+    stale_ = true;
+    LOG_INFO(L"Warm-start cache \"" << cacheFilePath << L"\" served " << pnpToDeviceMap_.size() << L" stale device(s).")
+    return true;
+}
+
+bool ed::audio::DeviceCollection::IsStale() const
+{
+    return stale_;
+}
+
+LatencyStatistics ed::audio::DeviceCollection::GetLatencyStatistics() const
+{
+    LatencyStatistics statistics;
+    for (size_t i = 0; i < LatencyKindCount; ++i)
+    {
+        statistics[i] = latencies_[i].GetSummary();
     }
-	uint16_t renderVolume = 0;
-	uint16_t captureVolume = 0;
+    return statistics;
+}
 
-    switch (flow)
+OperationalCounters ed::audio::DeviceCollection::GetOperationalCounters() const
+{
+    constexpr auto relaxed = std::memory_order_relaxed;
+    OperationalCounters counters;
+    counters.DeviceAddedNotifications = counters_.DeviceAddedNotifications.load(relaxed);
+    counters.DeviceRemovedNotifications = counters_.DeviceRemovedNotifications.load(relaxed);
+    counters.DeviceStateChangedNotifications = counters_.DeviceStateChangedNotifications.load(relaxed);
+    counters.VolumeNotifications = counters_.VolumeNotifications.load(relaxed);
+    counters.DefaultDeviceChangedNotifications = counters_.DefaultDeviceChangedNotifications.load(relaxed);
+    counters.PropertyValueChangedNotifications = counters_.PropertyValueChangedNotifications.load(relaxed);
+    counters.EventsDelivered = counters_.EventsDelivered.load(relaxed);
+    counters.NotificationsSuppressed = counters_.NotificationsSuppressed.load(relaxed);
+    counters.NotificationsDeduplicated = counters_.NotificationsDeduplicated.load(relaxed);
+    counters.Enumerations = counters_.Enumerations.load(relaxed);
+    counters.PropertyStoreOpens = counters_.PropertyStoreOpens.load(relaxed);
+    counters.EndpointActivations = counters_.EndpointActivations.load(relaxed);
+    counters.PendingNotifications = counters_.PendingNotifications.load(relaxed);
     {
-    case DeviceFlowEnum::Capture:
-        captureVolume = volume;
-        break;
-    case DeviceFlowEnum::Render:
-        renderVolume = volume;
-        break;
-    default:
-        break;
+        std::lock_guard lock(volumeMutex_);
+        counters.VolumeCallbacks = backend_->GetVolumeNotificationCount();
     }
-	device = Device(pnpGuid, name, flow, renderVolume, captureVolume);
-    return true;
+    counters.Observers = GetObserversSnapshot()->GetSize();
+    return counters;
+}
+
+/*static*/
+void ed::audio::DeviceCollection::Count(std::atomic<uint64_t> & counter, uint64_t increment) noexcept
+{
+    counter.fetch_add(increment, std::memory_order_relaxed);
+}
+
+ed::audio::DeviceCollection::ScopedNotification::ScopedNotification(AtomicCounters & counters, std::atomic<uint64_t> & kindCounter)
+    : counters_(counters)
+{
+    Count(kindCounter);
+    Count(counters_.PendingNotifications);
+}
+
+ed::audio::DeviceCollection::ScopedNotification::~ScopedNotification()
+{
+    counters_.PendingNotifications.fetch_sub(1, std::memory_order_relaxed);
+}
+
+ed::audio::LatencyHistogram & ed::audio::DeviceCollection::GetLatencyHistogram(LatencyKind kind)
+{
+    return latencies_[static_cast<size_t>(kind)];
+}
+
+void ed::audio::DeviceCollection::SaveWarmStartCache() const
+{
+    // Saves in turn, each the table as it is once its turn has come
+    std::lock_guard saveLock(cacheSaveMutex_);
+    std::wstring cacheFilePath;
+    std::vector<Device> devices;
+    {
+        TableLock lock(*this);
+        if (cacheFilePath_.empty() || stale_)
+        {
+            return;
+        }
+        cacheFilePath = cacheFilePath_;
+        devices.reserve(pnpToDeviceMap_.size());
+        for (const auto & device : pnpToDeviceMap_ | std::views::values)
+        {
+            devices.push_back(device);
+        }
+    }
+    // Written without the lock, so no notification or reader waits for the disk
+    if (!DeviceTableCache(cacheFilePath).Save(devices))
+    {
+        LOG_INFO(L"Could not save the warm-start cache \"" << cacheFilePath << L"\".")
+    }
+}
+
+
+bool ed::audio::DeviceCollection::IsTraceOn() const
+{
+    return traceObserverCount_ != 0;
 }
 
 void ed::audio::DeviceCollection::TraceIt(const std::wstring & line) const
 {
-    for (auto * obs : observers_)
+    if (TableLock::TryKeepTrace(*this, TraceLevel::Info, line))
+    {
+        return;
+    }
+    const ScopedDispatch dispatch(*this);
+    for (auto * obs : dispatch.GetObservers().GetTraceObservers(TraceLevel::Info))
     {
         obs->OnTrace(line);
     }
@@ -258,207 +465,1016 @@ void ed::audio::DeviceCollection::TraceIt(const std::wstring & line) const
 
 void ed::audio::DeviceCollection::TraceItDebug(const std::wstring & line) const
 {
-    for (auto * obs : observers_)
+    if (TableLock::TryKeepTrace(*this, TraceLevel::Debug, line))
+    {
+        return;
+    }
+    const ScopedDispatch dispatch(*this);
+    for (auto * obs : dispatch.GetObservers().GetTraceObservers(TraceLevel::Debug))
+    {
+        obs->OnTraceDebug(line);
+    }
+}
+
+/*static*/
+ed::audio::Device ed::audio::DeviceCollection::MergeDeviceWithExistingOneBasedOnPnpIdAndFlow(
+    const TPnPIdToDeviceMap & devices, const ed::audio::Device & device)
+{
+    AC_TIMELINE_ZONE("MergeDevice");
+    if
+    (
+        const auto foundPair = devices.find(device.GetPnpId())
+        ; foundPair != devices.end()
+    )
+    {
+        auto volume = device.GetCurrentRenderVolume();
+        auto flow = device.GetFlow();
+        uint16_t renderVolume = device.GetCurrentRenderVolume();
+		uint16_t captureVolume = device.GetCurrentCaptureVolume();
+
+        const auto & foundDev = foundPair->second;
+        if (foundDev.GetFlow() != device.GetFlow())
+        {
+
+            switch (flow)
+            {
+            case DeviceFlowEnum::Capture:
+                renderVolume = foundDev.GetCurrentRenderVolume();
+                break;
+            case DeviceFlowEnum::Render:
+                captureVolume = foundDev.GetCurrentCaptureVolume();
+            default:
+                break;
+            }
+
+            flow = DeviceFlowEnum::RenderAndCapture;
+        }
+        auto foundDevNameAsSet = Split(foundDev.GetName(), L'/', NotificationArena::GetCurrentResource());
+
+        foundDevNameAsSet.emplace(device.GetName());
+        // The endpoints of one container mostly share their form factor and jack, e.g. of a headset
+        const auto formFactor = foundDev.GetFormFactor() != DeviceFormFactor::Unknown ? foundDev.GetFormFactor() : device.GetFormFactor();
+        const auto jackConnection = foundDev.GetJackConnection() != DeviceJackConnection::Unknown
+                                        ? foundDev.GetJackConnection()
+                                        : device.GetJackConnection();
+        return {
+			device.GetPnpId(), Merge(foundDevNameAsSet, L'/'), flow, renderVolume, captureVolume, formFactor, jackConnection
+        };
+    }
+    return device;
+}
+
+uint64_t ed::audio::DeviceCollection::ProcessActiveDeviceList(ProcessDeviceFunctionT processDeviceFunc, bool isReset)
+{
+    AC_TIMELINE_ZONE("ProcessActiveDeviceList");
+    std::vector<std::wstring> endpointIds;
+    const auto enumerationStartedAt = std::chrono::steady_clock::now();
+    Count(counters_.Enumerations);
+    // Both flows whatever the flow mode, so SetFlowMode() finds the facts of every endpoint in memory
+    if (!backend_->TryEnumerateActiveEndpoints(true, endpointIds))
+    {
+        LOG_INFO("EnumAudioEndpoints failed")
+        return 0;
+    }
+    TDefaultEndpoints defaultEndpoints;
+    TDefaultChanges defaultChanges{};
+    if (isReset)
+    {
+        {
+            TableLock lock(*this);
+            defaultChanges = defaultChanges_;
+        }
+        defaultEndpoints = QueryDefaultEndpoints();
+    }
+    const auto probingStartedAt = std::chrono::steady_clock::now();
+    uint64_t generation = 0;
+    if (isReset)
+    {
+        GetLatencyHistogram(LatencyKind::ResetEnumeration).Record(probingStartedAt - enumerationStartedAt);
+        TableLock lock(*this);
+        generation = RestartEndpointStates(endpointIds);
+        for (size_t i = 0; i < defaultEndpoints_.size(); ++i)
+        {
+            if (defaultChanges_[i] == defaultChanges[i])
+            {
+                defaultEndpoints_[i] = std::move(defaultEndpoints[i]);
+            }
+        }
+    }
+    LOG_INFO(L"Audio devices enumerated.\n")
+    for (size_t i = 0; i < endpointIds.size(); i++)
+    {
+        const auto & deviceId = endpointIds[i];
+        // A reset registers the volume notifications of the probed endpoints, a refresh of the volumes does not
+        TVolumeNotificationToken volumeToken;
+        if (Device device; TryProbeEndpoint(deviceId, device, isReset ? &volumeToken : nullptr))
+        {
+            processDeviceFunc(this, deviceId, device, generation, std::move(volumeToken));
+            LOG_INFO(L"End point " << i << L" with plug-and-play id " << device.GetPnpId() << L" processed.\n")
+        }
+    }
+    if (isReset)
+    {
+        GetLatencyHistogram(LatencyKind::ResetProbing).Record(std::chrono::steady_clock::now() - probingStartedAt);
+    }
+    return generation;
+}
+
+
+void ed::audio::DeviceCollection::RecreateActiveDeviceList()
+{
+    LOG_INFO("Recreating audio device info list..")
+    AC_TIMELINE_ZONE("ResetContent");
+    const ScopedLatency resetLatency(GetLatencyHistogram(LatencyKind::ResetContent));
+
+    // Enumerate without holding the lock, so a (stale) table stays readable meanwhile
+    TEndpointFactsMap freshFacts;
+    std::map<std::wstring, TVolumeNotificationToken> volumeTokens;
+    const auto generation = ProcessActiveDeviceList(
+        [&freshFacts, &volumeTokens](DeviceCollection*, const std::wstring & deviceId, const Device & device, uint64_t,
+                                     TVolumeNotificationToken volumeToken)
+        {
+            freshFacts.insert_or_assign(deviceId, device);
+            volumeTokens.insert_or_assign(deviceId, std::move(volumeToken));
+        }, true);
+
+    const ScopedLatency applyingLatency(GetLatencyHistogram(LatencyKind::ResetApplying));
+    TEventList events;
+    std::vector<Device> eventDevices;
+    bool wasStale;
+    std::vector<std::wstring> goneEndpointIds;
+    {
+        TableLock lock(*this);
+        ReconcileSupersededProbes(generation, freshFacts);
+        // Of every endpoint, so its facts stay current while the filter leaves it out: the ones gone are unregistered,
+        // the probed ones registered, both below, without the lock
+        for (const auto & deviceId : endpointFacts_ | std::views::keys)
+        {
+            if (!freshFacts.contains(deviceId))
+            {
+                goneEndpointIds.push_back(deviceId);
+            }
+        }
+        TPnPIdToDeviceMap freshDevices;
+        TEndpointMap freshEndpoints;
+        for (const auto & [deviceId, device] : freshFacts)
+        {
+            if (IsDeviceApplicable(device))
+            {
+                freshEndpoints[deviceId] = {device.GetPnpId(), device.GetFlow()};
+                freshDevices[device.GetPnpId()] = MergeDeviceWithExistingOneBasedOnPnpIdAndFlow(freshDevices, device);
+            }
+        }
+        ReplaceEndpointFacts(std::move(freshFacts));
+        endpointToDevice_ = std::move(freshEndpoints);
+
+        events = GetDifferences(pnpToDeviceMap_, freshDevices);
+        wasStale = stale_.exchange(false);
+        if (wasStale)
+        {
+            LOG_INFO(L"Stale device list reconciled, " << events.size() << L" difference(s).")
+            eventDevices = GetEventDevices(events, pnpToDeviceMap_, freshDevices);
+        }
+        ReplaceDevices(std::move(freshDevices));
+    }
+    // An endpoint notified since the enumeration has been (un)registered by its notification, which this drops
+    for (const auto & deviceId : goneEndpointIds)
+    {
+        UnregisterVolumeNotification(deviceId, generation);
+    }
+    for (auto & [deviceId, volumeToken] : volumeTokens)
+    {
+        RegisterVolumeNotification(deviceId, generation, std::move(volumeToken));
+    }
+    SaveWarmStartCache();
+    // Only a stale list is reconciled by events; otherwise the caller re-reads it, but the change log must tell
+    if (wasStale)
+    {
+        NotifyObservers(events, eventDevices);
+    }
+    else
+    {
+        for (const auto & [action, devicePNpId] : events)
+        {
+            LogChange(action, devicePNpId);
+        }
+    }
+}
+
+void ed::audio::DeviceCollection::RecreateActiveDeviceListProgressively()
+{
+    LOG_INFO("Recreating audio device info list progressively..")
+    AC_TIMELINE_ZONE("ResetContent");
+    const ScopedLatency resetLatency(GetLatencyHistogram(LatencyKind::ResetContent));
+
+    // Devices are applied one by one while probing; applying times the clearing and the saving only
+    const auto clearingStartedAt = std::chrono::steady_clock::now();
+    TEventList events;
+    std::vector<Device> eventDevices;
+    {
+        TableLock lock(*this);
+        queryIndex_.Clear();
+        for (auto & [pnpId, device] : pnpToDeviceMap_)
+        {
+            events.emplace_back(DeviceCollectionEvent::Detached, pnpId);
+            eventDevices.push_back(std::move(device));
+        }
+        pnpToDeviceMap_.clear();
+        endpointToDevice_.clear();
+        ReplaceEndpointFacts({});
+    }
+    // An endpoint added meanwhile is enumerated below, which registers it anew
+    UnregisterAllVolumeNotifications();
+    NotifyObservers(events, eventDevices);
+    const auto clearing = std::chrono::steady_clock::now() - clearingStartedAt;
+
+    ProcessActiveDeviceList([](DeviceCollection* self, const std::wstring & deviceId, const Device & device, uint64_t generation,
+                               TVolumeNotificationToken volumeToken)
+    {
+        // ReSharper disable once CppFunctionResultShouldBeUsed
+        self->ApplyAddedDevice(deviceId, device, generation, std::move(volumeToken));
+    }, true);
+
+    const auto savingStartedAt = std::chrono::steady_clock::now();
+    SaveWarmStartCache();
+    GetLatencyHistogram(LatencyKind::ResetApplying).Record(clearing + (std::chrono::steady_clock::now() - savingStartedAt));
+}
+
+bool ed::audio::DeviceCollection::ApplyAddedDevice(const std::wstring & deviceId, const Device & device, uint64_t generation,
+                                                  TVolumeNotificationToken volumeToken)
+{
+    Device possiblyMergedDevice;
+    bool isApplicable = false;
+    {
+        TableLock lock(*this);
+        if (!TryPutAddedEndpoint(deviceId, device, generation, possiblyMergedDevice, isApplicable))
+        {
+            return true;
+        }
+    }
+    RegisterVolumeNotification(deviceId, generation, std::move(volumeToken));
+    if (!isApplicable)
+    {
+        return false;
+    }
+
+    NotifyObservers(DeviceCollectionEvent::Discovered, device.GetPnpId(), possiblyMergedDevice);
+    return true;
+}
+
+bool ed::audio::DeviceCollection::TryPutAddedEndpoint(const std::wstring & deviceId, const Device & device, uint64_t generation,
+                                                     Device & possiblyMergedDevice, bool & isApplicable)
+{
+    using magic_enum::iostream_operators::operator<<; // out-of-the-box stream operators for enums
+
+    if (!IsCurrentGeneration(deviceId, generation))
+    {
+        LOG_INFO(L"ADDED SUPERSEDED: device id \"" << deviceId << L"\" has transitioned while probed.")
+        Count(counters_.NotificationsSuppressed);
+        return false;
+    }
+    PutEndpointFacts(deviceId, device);
+    isApplicable = IsDeviceApplicable(device);
+    if (isApplicable)
+    {
+        possiblyMergedDevice = MergeDeviceWithExistingOneBasedOnPnpIdAndFlow(pnpToDeviceMap_, device);
+        LOG_INFO(
+            L"ADDED MERGED: device name: \"" << possiblyMergedDevice.GetName() << L"\", flow: " <<
+            possiblyMergedDevice.GetFlow() << L".")
+
+        endpointToDevice_.insert_or_assign(deviceId, EndpointEntry{device.GetPnpId(), device.GetFlow()});
+        PutDevice(possiblyMergedDevice);
+    }
+    return true;
+}
+
+void ed::audio::DeviceCollection::ReconcileSupersededProbes(uint64_t generation, TEndpointFactsMap & freshFacts) const
+{
+    if (generation == 0)
+    {
+        return;
+    }
+    // Added or removed while the enumeration was probed: as its notification has left it, so neither a removed
+    // endpoint comes back nor an added one is lost. A notification still probing applies itself afterwards.
+    for (const auto & [endpointId, state] : endpointStates_)
+    {
+        if (state.Generation <= generation)
+        {
+            continue;
+        }
+        LOG_INFO(L"RESET SUPERSEDED: device id \"" << endpointId << L"\" has transitioned while probed.")
+        if (const auto foundFacts = endpointFacts_.find(endpointId); foundFacts != endpointFacts_.end())
+        {
+            freshFacts.insert_or_assign(endpointId, foundFacts->second);
+        }
+        else if (const auto foundFresh = freshFacts.find(endpointId); foundFresh != freshFacts.end())
+        {
+            freshFacts.erase(foundFresh);
+        }
+    }
+}
+
+uint64_t ed::audio::DeviceCollection::RestartEndpointStates(const std::vector<std::wstring> & activeEndpointIds)
+{
+    // One transition of all endpoints; the ones not enumerated are unknown until notified
+    const auto generation = ++lastGeneration_;
+    endpointStates_.clear();
+    for (const auto & endpointId : activeEndpointIds)
+    {
+        endpointStates_.try_emplace(endpointId, EndpointState{EndpointPresence::Present, generation});
+    }
+    return generation;
+}
+
+bool ed::audio::DeviceCollection::TryTransitEndpoint(LPCWSTR endpointId, EndpointPresence presence, uint64_t & generation)
+{
+    TableLock lock(*this);
+    auto foundState = endpointStates_.find(std::wstring_view(endpointId));
+    if (foundState == endpointStates_.end())
+    {
+        foundState = endpointStates_.try_emplace(endpointId).first;
+    }
+    else if (foundState->second.Presence == presence)
+    {
+        Count(counters_.NotificationsDeduplicated);
+        return false;
+    }
+    foundState->second = {presence, ++lastGeneration_};
+    generation = foundState->second.Generation;
+    return true;
+}
+
+void ed::audio::DeviceCollection::ForgetEndpointState(std::wstring_view endpointId, uint64_t generation)
+{
+    // Not added after all: unknown again, so that a repeated notification probes again
+    if (const auto foundState = endpointStates_.find(endpointId)
+        ; foundState != endpointStates_.end() && foundState->second.Generation == generation)
+    {
+        endpointStates_.erase(foundState);
+    }
+}
+
+bool ed::audio::DeviceCollection::IsCurrentGeneration(std::wstring_view endpointId, uint64_t generation) const
+{
+    // Zero: not tracked, e.g. probed by a non-progressive ResetContent()
+    if (generation == 0)
+    {
+        return true;
+    }
+    const auto foundState = endpointStates_.find(endpointId);
+    return foundState != endpointStates_.end() && foundState->second.Generation == generation;
+}
+
+void ed::audio::DeviceCollection::RefreshVolumes()
+{
+    LOG_INFO("Refreshing volumes of audio devices..")
+
+    ProcessActiveDeviceList(&DeviceCollection::UpdateDeviceVolume);
+}
+
+
+bool ed::audio::DeviceCollection::TryProbeEndpoint(const std::wstring & endpointId, Device & device, TVolumeNotificationToken * volumeToken)
+{
+    // A probe reads the property store and activates the endpoint volume
+    Count(counters_.PropertyStoreOpens);
+    Count(counters_.EndpointActivations);
+    return backend_->TryProbeEndpoint(endpointId, device, volumeToken);
+}
+
+ed::audio::DeviceCollection::TDefaultEndpoints ed::audio::DeviceCollection::QueryDefaultEndpoints() const
+{
+    TDefaultEndpoints defaultEndpoints;
+    for (const auto flow : {DeviceFlowEnum::Render, DeviceFlowEnum::Capture})
+    {
+        for (size_t role = 0; role < DeviceRoleCount; ++role)
+        {
+            const auto bit = Device::GetDefaultRoleBit(flow, static_cast<DeviceRole>(role));
+            // ReSharper disable once CppFunctionResultShouldBeUsed
+            backend_->TryGetDefaultEndpoint(flow, static_cast<DeviceRole>(role), defaultEndpoints[std::countr_zero(bit)]);
+        }
+    }
+    return defaultEndpoints;
+}
+
+uint8_t ed::audio::DeviceCollection::GetDefaultRoles(std::wstring_view pnpId) const
+{
+    uint8_t defaultRoles = 0;
+    for (size_t i = 0; i < defaultEndpoints_.size(); ++i)
+    {
+        if (const auto foundEndpoint = endpointToDevice_.find(defaultEndpoints_[i]);
+            foundEndpoint != endpointToDevice_.end() && foundEndpoint->second.PnpId == pnpId)
+        {
+            defaultRoles |= static_cast<uint8_t>(1u << i);
+        }
+    }
+    return defaultRoles;
+}
+
+bool ed::audio::DeviceCollection::TryReadEndpointProperty(const std::wstring & endpointId, EndpointProperty property, Device & device)
+{
+    // A read opens the property store only
+    Count(counters_.PropertyStoreOpens);
+    return backend_->TryReadEndpointProperty(endpointId, property, device);
+}
+
+void ed::audio::DeviceCollection::RegisterVolumeNotification(const std::wstring & endpointId, uint64_t generation,
+                                                             TVolumeNotificationToken volumeToken)
+{
+    std::lock_guard lock(volumeMutex_);
+    if (!TryAdvanceVolumeGeneration(endpointId, generation))
+    {
+        return;
+    }
+    // Without a token the backend activates the endpoint once more
+    if (volumeToken == nullptr)
+    {
+        Count(counters_.EndpointActivations);
+    }
+    backend_->RegisterVolumeNotification(endpointId, std::move(volumeToken));
+}
+
+void ed::audio::DeviceCollection::UnregisterVolumeNotification(const std::wstring & endpointId, uint64_t generation)
+{
+    std::lock_guard lock(volumeMutex_);
+    if (TryAdvanceVolumeGeneration(endpointId, generation))
+    {
+        backend_->UnregisterVolumeNotification(endpointId);
+    }
+}
+
+bool ed::audio::DeviceCollection::TryAdvanceVolumeGeneration(const std::wstring & endpointId, uint64_t generation)
+{
+    if (generation == 0)
+    {
+        return true;
+    }
+    auto & lastGeneration = volumeGenerations_[endpointId];
+    if (generation < lastGeneration)
+    {
+        return false;
+    }
+    lastGeneration = generation;
+    return true;
+}
+
+void ed::audio::DeviceCollection::UnregisterAllVolumeNotifications()
+{
+    std::lock_guard lock(volumeMutex_);
+    backend_->UnregisterAllVolumeNotifications();
+}
+
+void ed::audio::DeviceCollection::UpdateDeviceVolume(DeviceCollection* self, const std::wstring& deviceId, const Device& device, uint64_t,
+                                                     TVolumeNotificationToken)
+{
+    const auto pnpGuid = device.GetPnpId();
+    TableLock lock(*self);
+    if (self->endpointFacts_.contains(deviceId))
+    {
+        self->PutEndpointFacts(deviceId, device);
+    }
+    if (!self->IsDeviceApplicable(device))
+    {
+        return;
+    }
+    if
+    (
+        auto foundPair = self->pnpToDeviceMap_.find(pnpGuid)
+        ; foundPair != self->pnpToDeviceMap_.end()
+    )
+    {
+        if (device.GetFlow() == DeviceFlowEnum::Render)
+        {
+            self->SetDeviceVolume(*foundPair, DeviceFlowEnum::Render, device.GetCurrentRenderVolume());
+        }
+        else
+        {
+            self->SetDeviceVolume(*foundPair, DeviceFlowEnum::Capture, device.GetCurrentCaptureVolume());
+        }
+    }
+}
+
+void ed::audio::DeviceCollection::PutDevice(const Device & device)
+{
+    auto [foundPair, isInserted] = pnpToDeviceMap_.try_emplace(device.GetPnpId());
+    if (!isInserted)
+    {
+        queryIndex_.Erase(*foundPair);
+    }
+    foundPair->second = device;
+    foundPair->second.SetDefaultRoles(GetDefaultRoles(foundPair->first));
+    queryIndex_.Insert(*foundPair);
+}
+
+void ed::audio::DeviceCollection::EraseDevice(const std::wstring & pnpId)
+{
+    if (const auto foundPair = pnpToDeviceMap_.find(pnpId); foundPair != pnpToDeviceMap_.end())
+    {
+        queryIndex_.Erase(*foundPair);
+        pnpToDeviceMap_.erase(foundPair);
+    }
+}
+
+void ed::audio::DeviceCollection::ReplaceDevices(TPnPIdToDeviceMap devices)
+{
+    queryIndex_.Clear();
+    pnpToDeviceMap_ = std::move(devices);
+    for (auto & entry : pnpToDeviceMap_)
+    {
+        entry.second.SetDefaultRoles(GetDefaultRoles(entry.first));
+        queryIndex_.Insert(entry);
+    }
+}
+
+void ed::audio::DeviceCollection::PutEndpointFacts(const std::wstring & endpointId, const Device & device)
+{
+    if (const auto foundFacts = endpointFacts_.find(endpointId); foundFacts != endpointFacts_.end())
+    {
+        if (foundFacts->second.GetPnpId() == device.GetPnpId())
+        {
+            foundFacts->second = device;
+            return;
+        }
+        EraseEndpointFacts(endpointId);
+    }
+    endpointFacts_.emplace(endpointId, device);
+    containerEndpoints_[device.GetPnpId()].insert(endpointId);
+}
+
+void ed::audio::DeviceCollection::EraseEndpointFacts(std::wstring_view endpointId)
+{
+    const auto foundFacts = endpointFacts_.find(endpointId);
+    if (foundFacts == endpointFacts_.end())
+    {
+        return;
+    }
+    if (const auto foundContainer = containerEndpoints_.find(foundFacts->second.GetPnpId()); foundContainer != containerEndpoints_.end())
+    {
+        foundContainer->second.erase(foundFacts->first);
+        if (foundContainer->second.empty())
+        {
+            containerEndpoints_.erase(foundContainer);
+        }
+    }
+    endpointFacts_.erase(foundFacts);
+}
+
+void ed::audio::DeviceCollection::ReplaceEndpointFacts(TEndpointFactsMap facts)
+{
+    containerEndpoints_.clear();
+    endpointFacts_ = std::move(facts);
+    for (const auto & [endpointId, device] : endpointFacts_)
+    {
+        containerEndpoints_[device.GetPnpId()].insert(endpointId);
+    }
+}
+
+bool ed::audio::DeviceCollection::SetDeviceVolume(TPnPIdToDeviceMap::value_type & entry, DeviceFlowEnum flow, uint16_t volume)
+{
+    auto & device = entry.second;
+    const auto oldVolume = flow == DeviceFlowEnum::Capture ? device.GetCurrentCaptureVolume() : device.GetCurrentRenderVolume();
+    if (oldVolume == volume)
+    {
+        return false;
+    }
+    if (flow == DeviceFlowEnum::Capture)
+    {
+        device.SetCurrentCaptureVolume(volume);
+    }
+    else
+    {
+        device.SetCurrentRenderVolume(volume);
+    }
+    queryIndex_.UpdateVolume(entry, flow, oldVolume);
+    return true;
+}
+
+
+void ed::audio::DeviceCollection::NotifyObservers(DeviceCollectionEvent action, const std::wstring & devicePNpId, const Device & device) const
+{
+    AC_TIMELINE_ZONE("NotifyObservers");
+    LogChange(action, devicePNpId);
+    uint64_t deliveredCount = 0;
+    const ScopedDispatch dispatch(*this);
+    dispatch.GetObservers().ForEachInterested(action, devicePNpId, device,
+        [action, &devicePNpId, &deliveredCount](DeviceCollectionObserverInterface & observer)
+        {
+            observer.OnCollectionChanged(action, devicePNpId);
+            ++deliveredCount;
+        });
+    Count(counters_.EventsDelivered, deliveredCount);
+}
+
+void ed::audio::DeviceCollection::NotifyObservers(const TEventList & events, const std::vector<Device> & devices) const
+{
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        NotifyObservers(events[i].first, events[i].second, devices[i]);
+    }
+}
+
+void ed::audio::DeviceCollection::NotifyObserversOfBatch(const TEventList & events, const std::vector<Device> & devices) const
+{
+    if (events.empty())
+    {
+        return;
+    }
+    AC_TIMELINE_ZONE("NotifyObserversOfBatch");
+    // Every observer gets the changes it is interested in, if any, as one batch
+    using TObserverBatch = std::pair<DeviceCollectionObserverInterface*, std::vector<DeviceCollectionChange>>;
+    std::vector<TObserverBatch> batches;
+    const ScopedDispatch dispatch(*this);
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        const auto & [action, devicePNpId] = events[i];
+        LogChange(action, devicePNpId);
+        dispatch.GetObservers().ForEachInterested(action, devicePNpId, devices[i],
+            [&batches, action, &devicePNpId](DeviceCollectionObserverInterface & observer)
+            {
+                auto foundBatch = std::ranges::find(batches, &observer, &TObserverBatch::first);
+                if (foundBatch == batches.end())
+                {
+                    foundBatch = batches.insert(foundBatch, TObserverBatch{&observer, {}});
+                }
+                foundBatch->second.push_back({action, devicePNpId});
+            });
+    }
+    uint64_t deliveredCount = 0;
+    for (const auto & [observer, changes] : batches)
+    {
+        observer->OnCollectionChangedBatch(changes);
+        deliveredCount += changes.size();
+    }
+    Count(counters_.EventsDelivered, deliveredCount);
+}
+
+void ed::audio::DeviceCollection::LogChange(DeviceCollectionEvent event, std::wstring_view pnpId) const
+{
+    std::lock_guard lock(changeLogMutex_);
+    const auto sequence = sequence_.load(std::memory_order_relaxed) + 1;
+    auto & [loggedEvent, loggedPnpId] = changeLog_[(sequence - 1) % ChangeLogCapacity];
+    loggedEvent = event;
+    loggedPnpId.assign(pnpId);
+    sequence_.store(sequence, std::memory_order_release);
+}
+
+uint64_t ed::audio::DeviceCollection::GetSequence() const
+{
+    return sequence_.load(std::memory_order_acquire);
+}
+
+DeviceCollectionChangesSince ed::audio::DeviceCollection::GetChangesSince(uint64_t sequence) const
+{
+    std::lock_guard lock(changeLogMutex_);
+    DeviceCollectionChangesSince changesSince;
+    changesSince.Sequence = sequence_.load(std::memory_order_relaxed);
+    // A sequence number from the future, e.g. of another collection, is as useless as an overwritten one
+    if (sequence > changesSince.Sequence || changesSince.Sequence - sequence > ChangeLogCapacity)
+    {
+        return changesSince;
+    }
+    changesSince.IsComplete = true;
+    changesSince.Changes.reserve(changesSince.Sequence - sequence);
+    for (auto loggedSequence = sequence + 1; loggedSequence <= changesSince.Sequence; ++loggedSequence)
+    {
+        const auto & [event, pnpId] = changeLog_[(loggedSequence - 1) % ChangeLogCapacity];
+        changesSince.Changes.push_back({event, pnpId});
+    }
+    return changesSince;
+}
+
+void ed::audio::DeviceCollection::SetFilter(const std::wstring & nameFilter)
+{
+    TEventList events;
+    std::vector<Device> eventDevices;
+    {
+        TableLock lock(*this);
+        if (nameFilter == nameFilter_)
+        {
+            return;
+        }
+        LOG_INFO(L"The substring filter changes from \"" << nameFilter_ << L"\" to \"" << nameFilter << L"\".")
+        nameFilter_ = nameFilter;
+        ReapplyFilter(events, eventDevices);
+    }
+    NotifyObserversOfBatch(events, eventDevices);
+}
+
+void ed::audio::DeviceCollection::SetFlowMode(bool bothHeadsetAndMicro)
+{
+    TEventList events;
+    std::vector<Device> eventDevices;
+    {
+        TableLock lock(*this);
+        if (bothHeadsetAndMicro == bothHeadsetAndMicro_)
+        {
+            return;
+        }
+        LOG_INFO(L"The flow mode changes to " << (bothHeadsetAndMicro ? L"render and capture." : L"render only."))
+        bothHeadsetAndMicro_ = bothHeadsetAndMicro;
+        ReapplyFilter(events, eventDevices);
+    }
+    NotifyObserversOfBatch(events, eventDevices);
+}
+
+void ed::audio::DeviceCollection::ReapplyFilter(TEventList & events, std::vector<Device> & eventDevices)
+{
+    AC_TIMELINE_ZONE("ReapplyFilter");
+    // No facts yet: the next ResetContent() reconciles the table with the filter
+    if (stale_)
+    {
+        return;
+    }
+    // The containers of the endpoints entering or leaving the view
+    std::set<std::wstring, std::less<>> changedPnpIds;
+    for (const auto & [deviceId, device] : endpointFacts_)
+    {
+        if (IsPassingFilter(device) != endpointToDevice_.contains(deviceId))
+        {
+            changedPnpIds.insert(device.GetPnpId());
+        }
+    }
+    if (changedPnpIds.empty())
+    {
+        return;
+    }
+
+    TPnPIdToDeviceMap old;
+    TPnPIdToDeviceMap updated;
+    RemergeDevices(changedPnpIds, old, updated);
+    events = GetDifferences(old, updated);
+    eventDevices = GetEventDevices(events, old, updated);
+    LOG_INFO(L"Filter reapplied to " << changedPnpIds.size() << L" device(s), " << events.size() << L" difference(s).")
+}
+
+void ed::audio::DeviceCollection::RemergeDevices(
+    const std::set<std::wstring, std::less<>> & pnpIds, TPnPIdToDeviceMap & old, TPnPIdToDeviceMap & updated)
+{
+    for (const auto & pnpId : pnpIds)
+    {
+        if (const auto foundPair = pnpToDeviceMap_.find(pnpId); foundPair != pnpToDeviceMap_.end())
+        {
+            old.insert(*foundPair);
+        }
+    }
+    for (const auto & pnpId : pnpIds)
+    {
+        const auto foundContainer = containerEndpoints_.find(pnpId);
+        if (foundContainer == containerEndpoints_.end())
+        {
+            continue;
+        }
+        for (const auto & deviceId : foundContainer->second)
+        {
+            const auto & device = endpointFacts_.find(deviceId)->second;
+            if (IsPassingFilter(device))
+            {
+                endpointToDevice_.insert_or_assign(deviceId, EndpointEntry{device.GetPnpId(), device.GetFlow()});
+                updated[device.GetPnpId()] = MergeDeviceWithExistingOneBasedOnPnpIdAndFlow(updated, device);
+            }
+            else if (const auto foundEndpoint = endpointToDevice_.find(deviceId); foundEndpoint != endpointToDevice_.end())
+            {
+                endpointToDevice_.erase(foundEndpoint);
+            }
+        }
+    }
+
+    for (const auto & pnpId : old | std::views::keys)
+    {
+        if (!updated.contains(pnpId))
+        {
+            EraseDevice(pnpId);
+        }
+    }
+    for (const auto & device : updated | std::views::values)
+    {
+        PutDevice(device);
+    }
+}
+
+void ed::audio::DeviceCollection::SetBurstWindow(std::chrono::milliseconds quietWindow)
+{
+    std::unique_lock lock(burstMutex_);
+    burstWindow_ = quietWindow;
+    if (quietWindow > std::chrono::milliseconds::zero())
+    {
+        if (!burstThread_.joinable())
+        {
+            burstStopping_ = false;
+            burstThread_ = std::thread([this] { RunBurstWorker(); });
+        }
+        burstCondition_.notify_one();
+        return;
+    }
+    if (burstThread_.joinable())
     {
-        obs->OnTraceDebug(line);
+        // The worker applies the queued notifications before it ends
+        burstStopping_ = true;
+        burstCondition_.notify_one();
+        auto worker = std::move(burstThread_);
+        lock.unlock();
+        worker.join();
     }
 }
 
-void ed::audio::DeviceCollection::UnregisterAllEndpointsVolumes()
+void ed::audio::DeviceCollection::FlushBurst()
 {
-    for (const auto & endpointVolume : devIdToEndpointVolumes_ | std::views::values)
-    {
-        // ReSharper disable once CppFunctionResultShouldBeUsed
-        endpointVolume->UnregisterControlChangeNotify(this);
-    }
+    ApplyBurst();
 }
 
-// template<class INTERFACE>
-// ULONG CountRef(INTERFACE* pInterface) noexcept
-// {
-//     if (pInterface)
-//     {
-//         pInterface->AddRef();
-//         return pInterface->Release();
-//     }
-//
-//     return 0;
-// }
-
-void ed::audio::DeviceCollection::UnregisterAndRemoveEndpointsVolumes(const std::wstring & deviceId)
+bool ed::audio::DeviceCollection::TryQueueForBurst(LatencyKind kind, LPCWSTR deviceId, DWORD state)
 {
-    if
-    (
-        const auto foundPair = devIdToEndpointVolumes_.find(deviceId)
-        ; foundPair != devIdToEndpointVolumes_.end()
-    )
     {
-        auto audioEndpointVolume = foundPair->second;
-        // ReSharper disable once CppFunctionResultShouldBeUsed
-        audioEndpointVolume->UnregisterControlChangeNotify(this);
-        //        const auto ii = CountRef(static_cast<IAudioEndpointVolume*>(audioEndpointVolume));
-        audioEndpointVolume.Detach();
-        devIdToEndpointVolumes_.erase(foundPair);
+        std::lock_guard lock(burstMutex_);
+        if (!burstThread_.joinable() || burstStopping_)
+        {
+            return false;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        burstQueue_.push_back({kind, deviceId, state, now});
+        burstLastArrivalAt_ = now;
+        // Pending until the burst is applied
+        Count(counters_.PendingNotifications);
     }
+    burstCondition_.notify_one();
+    return true;
 }
 
-ed::audio::Device ed::audio::DeviceCollection::MergeDeviceWithExistingOneBasedOnPnpIdAndFlow(
-    const ed::audio::Device & device) const
+void ed::audio::DeviceCollection::RunBurstWorker()
 {
-    if
-    (
-        const auto foundPair = pnpToDeviceMap_.find(device.GetPnpId())
-        ; foundPair != pnpToDeviceMap_.end()
-    )
+    std::unique_lock lock(burstMutex_);
+    for (;;)
     {
-        auto volume = device.GetCurrentRenderVolume();
-        auto flow = device.GetFlow();
-        uint16_t renderVolume = device.GetCurrentRenderVolume();
-		uint16_t captureVolume = device.GetCurrentCaptureVolume();
-
-        const auto & foundDev = foundPair->second;
-        if (foundDev.GetFlow() != device.GetFlow())
+        burstCondition_.wait(lock, [this] { return burstStopping_ || !burstQueue_.empty(); });
+        if (burstQueue_.empty())
         {
-
-            switch (flow)
+            return;
+        }
+        // Until quiet for a window, but at the latest MaxBurstWindows windows after the first notification
+        while (!burstStopping_ && !burstQueue_.empty())
+        {
+            const auto applyAt = (std::min)(burstLastArrivalAt_ + burstWindow_,
+                                            burstQueue_.front().ArrivedAt + burstWindow_ * MaxBurstWindows);
+            if (std::chrono::steady_clock::now() >= applyAt)
             {
-            case DeviceFlowEnum::Capture:
-                renderVolume = foundDev.GetCurrentRenderVolume();
-                break;
-            case DeviceFlowEnum::Render:
-                captureVolume = foundDev.GetCurrentCaptureVolume();
-            default:
                 break;
             }
-
-            flow = DeviceFlowEnum::RenderAndCapture;
+            burstCondition_.wait_until(lock, applyAt);
         }
-        auto foundDevNameAsSet = Split(foundDev.GetName(), L'/');
-
-        foundDevNameAsSet.insert(device.GetName());
-        return {
-			device.GetPnpId(), Merge(foundDevNameAsSet, L'/'), flow, renderVolume, captureVolume
-        };
+        lock.unlock();
+        ApplyBurst();
+        lock.lock();
     }
-    return device;
-}
-
-void ed::audio::DeviceCollection::ProcessActiveDeviceList(ProcessDeviceFunctionT processDeviceFunc)
-{
-	HRESULT hr;
-	CComPtr<IMMDeviceCollection> deviceCollectionSmartPtr;
-	{
-		IMMDeviceCollection* deviceCollection = nullptr;
-		hr = enumerator_->EnumAudioEndpoints(
-			bothHeadsetAndMicro_ ? eAll : eRender, DEVICE_STATE_ACTIVE,
-			&deviceCollection);
-		if (FAILED(hr))
-		{
-			LOG_INFO("EnumAudioEndpoints failed")
-				return;
-		}
-		LOG_INFO(L"Audio devices enumerated.\n")
-			deviceCollectionSmartPtr.Attach(deviceCollection);
-	}
-	UINT count = 0;
-	hr = deviceCollectionSmartPtr->GetCount(&count);
-	assert(SUCCEEDED(hr));
-	for (ULONG i = 0; i < count; i++)
-	{
-		Device device;
-		EndPointVolumeSmartPtr endPointVolumeSmartPtr;
-		bool isDeviceCreated = false;
-		std::wstring deviceId;
-		{
-			CComPtr<IMMDevice> endpointDeviceSmartPtr;
-			{
-				IMMDevice* pEndpointDevice = nullptr;
-				hr = deviceCollectionSmartPtr->Item(i, &pEndpointDevice);
-				if (FAILED(hr))
-				{
-					LOG_INFO("Collection::Item failed")
-						continue;
-				}
-				endpointDeviceSmartPtr.Attach(pEndpointDevice);
-			}
-			isDeviceCreated = TryCreateDeviceAndGetVolumeEndpoint(i, endpointDeviceSmartPtr, device, deviceId, endPointVolumeSmartPtr);
-		}
-		if (!isDeviceCreated)
-		{
-			continue;
-		}
-		if (!IsDeviceApplicable(device))
-		{
-			continue;
-		}
-		processDeviceFunc(this, deviceId, device, endPointVolumeSmartPtr);
-		LOG_INFO(L"End point " << i << L" with plug-and-play id " << device.GetPnpId() << L" processed.\n")
-	}
-}
-
-
-void ed::audio::DeviceCollection::RecreateActiveDeviceList()
-{
-    LOG_INFO("Recreating audio device info list..")
-    pnpToDeviceMap_.clear();
-
-    UnregisterAllEndpointsVolumes();
-    devIdToEndpointVolumes_.clear();
-
-    ProcessActiveDeviceList(&DeviceCollection::RegisterDevice);
 }
 
-void ed::audio::DeviceCollection::RefreshVolumes()
+void ed::audio::DeviceCollection::ApplyBurst()
 {
-    LOG_INFO("Refreshing volumes of audio devices..")
-
-    ProcessActiveDeviceList(&DeviceCollection::UpdateDeviceVolume);
-}
+    std::lock_guard applyLock(burstApplyMutex_);
+    std::vector<QueuedNotification> notifications;
+    {
+        std::lock_guard lock(burstMutex_);
+        notifications.swap(burstQueue_);
+    }
+    if (notifications.empty())
+    {
+        return;
+    }
 
+    AC_TIMELINE_ZONE("ApplyBurst");
+    const NotificationArena arena;
+    // Transited in order, then probed once at the presence notified last, all without the lock
+    std::map<std::wstring, BurstEndpoint, std::less<>> endpoints;
+    for (const auto & [kind, endpointId, state, arrivedAt] : notifications)
+    {
+        auto presence = EndpointPresence::Present;
+        if (kind == LatencyKind::DeviceRemoved)
+        {
+            presence = EndpointPresence::Absent;
+        }
+        else if (kind == LatencyKind::DeviceStateChanged && state != DEVICE_STATE_ACTIVE)
+        {
+            // As HandleDeviceStateChanged() tells them apart
+            if (state != DEVICE_STATE_DISABLED && state != DEVICE_STATE_NOTPRESENT && state != DEVICE_STATE_UNPLUGGED)
+            {
+                Count(counters_.NotificationsSuppressed);
+                continue;
+            }
+            presence = EndpointPresence::Absent;
+        }
+        if (uint64_t generation = 0; TryTransitEndpoint(endpointId.c_str(), presence, generation))
+        {
+            auto & endpoint = endpoints[endpointId];
+            endpoint.Presence = presence;
+            endpoint.Generation = generation;
+            endpoint.WasRemoved = endpoint.WasRemoved || presence == EndpointPresence::Absent;
+        }
+    }
+    for (auto & [endpointId, endpoint] : endpoints)
+    {
+        // A removed endpoint is unmerged by its kept facts, so only the present ones are probed
+        if (endpoint.Presence == EndpointPresence::Present)
+        {
+            endpoint.IsProbed = TryProbeEndpoint(endpointId, endpoint.Facts, &endpoint.VolumeToken);
+        }
+    }
 
-// ReSharper disable CppPassValueParameterByConstReference
-/*static*/
-void ed::audio::DeviceCollection::RegisterDevice(ed::audio::DeviceCollection* self, const std::wstring& deviceId, const Device& device, EndPointVolumeSmartPtr endpointVolume)
-{
-    if (endpointVolume != nullptr)
+    TEventList changes;
+    std::vector<Device> changedDevices;
     {
-        // ReSharper disable once CppFunctionResultShouldBeUsed
-        endpointVolume->RegisterControlChangeNotify(self);
-        self->devIdToEndpointVolumes_[deviceId] = endpointVolume;
+        // One transaction of the net changes: nobody sees the collection in between
+        TableLock lock(*this);
+        const auto before = pnpToDeviceMap_;
+        for (auto & [endpointId, endpoint] : endpoints)
+        {
+            Device device;
+            // Removed in between, too: unmerged first, so that it is merged anew with its current facts
+            const bool isRemoved = endpoint.WasRemoved && TryEraseRemovedEndpoint(endpointId.c_str(), endpoint.Generation, device);
+            if (endpoint.Presence == EndpointPresence::Absent)
+            {
+                if (!isRemoved)
+                {
+                    Count(counters_.NotificationsSuppressed);
+                }
+            }
+            else if (!endpoint.IsProbed)
+            {
+                ForgetEndpointState(endpointId, endpoint.Generation);
+                Count(counters_.NotificationsSuppressed);
+            }
+            else if (bool isApplicable = false; TryPutAddedEndpoint(endpointId, endpoint.Facts, endpoint.Generation, device, isApplicable))
+            {
+                endpoint.IsPut = true;
+                if (!isApplicable)
+                {
+                    Count(counters_.NotificationsSuppressed);
+                }
+            }
+        }
+        changes = GetDifferences(before, pnpToDeviceMap_);
+        changedDevices = GetEventDevices(changes, before, pnpToDeviceMap_);
+    }
+    for (auto & [endpointId, endpoint] : endpoints)
+    {
+        if (endpoint.WasRemoved)
+        {
+            UnregisterVolumeNotification(endpointId, endpoint.Generation);
+        }
+        if (endpoint.IsPut)
+        {
+            RegisterVolumeNotification(endpointId, endpoint.Generation, std::move(endpoint.VolumeToken));
+        }
     }
+    NotifyObserversOfBatch(changes, changedDevices);
 
-    self->pnpToDeviceMap_[device.GetPnpId()] = self->MergeDeviceWithExistingOneBasedOnPnpIdAndFlow(device);
+    const auto deliveredAt = std::chrono::steady_clock::now();
+    for (const auto & notification : notifications)
+    {
+        GetLatencyHistogram(notification.Kind).Record(deliveredAt - notification.ArrivedAt);
+    }
+    counters_.PendingNotifications.fetch_sub(notifications.size(), std::memory_order_relaxed);
 }
 
-void ed::audio::DeviceCollection::UpdateDeviceVolume(DeviceCollection* self, const std::wstring& deviceId, const Device& device, EndPointVolumeSmartPtr)
+/*static*/
+ed::audio::DeviceCollection::TEventList ed::audio::DeviceCollection::GetDifferences(
+    const TPnPIdToDeviceMap & old, const TPnPIdToDeviceMap & updated)
 {
-    // ReSharper restore CppPassValueParameterByConstReference
-    const auto pnpGuid = device.GetPnpId();
-    if
-    (
-        auto foundPair = self->pnpToDeviceMap_.find(pnpGuid)
-        ; foundPair != self->pnpToDeviceMap_.end()
-    )
+    TEventList events;
+    for (const auto & pnpId : old | std::views::keys)
     {
-        auto& foundDev = foundPair->second;
-        if (device.GetFlow() == DeviceFlowEnum::Render)
+        if (!updated.contains(pnpId))
         {
-            foundDev.SetCurrentRenderVolume(device.GetCurrentRenderVolume());
+            events.emplace_back(DeviceCollectionEvent::Detached, pnpId);
         }
-        else
+    }
+    for (const auto & [pnpId, device] : updated)
+    {
+        const auto foundPair = old.find(pnpId);
+        if (foundPair == old.end()
+            || foundPair->second.GetFlow() != device.GetFlow()
+            || foundPair->second.GetName() != device.GetName())
         {
-            foundDev.SetCurrentCaptureVolume(device.GetCurrentCaptureVolume());
+            events.emplace_back(DeviceCollectionEvent::Discovered, pnpId);
         }
     }
+    for (auto & pnpId : GetDevicePnPIdsWithChangedVolume(old, updated))
+    {
+        events.emplace_back(DeviceCollectionEvent::VolumeChanged, std::move(pnpId));
+    }
+    return events;
 }
 
-
-void ed::audio::DeviceCollection::NotifyObservers(DeviceCollectionEvent action, const std::wstring & devicePNpId) const
+/*static*/
+std::vector<ed::audio::Device> ed::audio::DeviceCollection::GetEventDevices(
+    const TEventList & events, const TPnPIdToDeviceMap & old, const TPnPIdToDeviceMap & updated)
 {
-    for (auto * observer : observers_)
+    std::vector<Device> devices;
+    devices.reserve(events.size());
+    for (const auto & [action, pnpId] : events)
     {
-        observer->OnCollectionChanged(action, devicePNpId);
+        const auto & devicesOfEvent = action == DeviceCollectionEvent::Detached ? old : updated;
+        const auto foundPair = devicesOfEvent.find(pnpId);
+        devices.push_back(foundPair != devicesOfEvent.end() ? foundPair->second : Device());
     }
+    return devices;
 }
 
 bool ed::audio::DeviceCollection::IsDeviceApplicable(const Device & device) const
@@ -506,41 +1522,54 @@ bool ed::audio::DeviceCollection::IsDeviceApplicable(const Device & device) cons
     return true;
 }
 
+bool ed::audio::DeviceCollection::IsPassingFilter(const Device & device) const
+{
+    return (bothHeadsetAndMicro_ || device.GetFlow() == DeviceFlowEnum::Render)
+        && FindSubstrCaseInsensitive(device.GetName(), nameFilter_)
+        && device.GetPnpId() != noPlugAndPlayGuid_;
+}
+
 HRESULT ed::audio::DeviceCollection::OnDeviceAdded(LPCWSTR deviceId)
+{
+    const NotificationArena arena;
+    const ScopedNotification notification(counters_, counters_.DeviceAddedNotifications);
+    if (TryQueueForBurst(LatencyKind::DeviceAdded, deviceId))
+    {
+        return S_OK;
+    }
+    AC_TIMELINE_ZONE("OnDeviceAdded");
+    const ScopedLatency latency(GetLatencyHistogram(LatencyKind::DeviceAdded));
+    return HandleDeviceAdded(deviceId);
+}
+
+HRESULT ed::audio::DeviceCollection::HandleDeviceAdded(LPCWSTR deviceId)
 {
     using magic_enum::iostream_operators::operator<<; // out-of-the-box stream operators for enums
 
     const HRESULT onDeviceAdded = MultipleNotificationClient::OnDeviceAdded(deviceId);
-    if (onDeviceAdded == S_OK)
+    if (uint64_t generation = 0; onDeviceAdded == S_OK && TryTransitEndpoint(deviceId, EndpointPresence::Present, generation))
     {
         LOG_INFO(L"ADDED INFO: device id \"" << deviceId << L".")
 
-        Device device;
-        if
-        (
-            EndPointVolumeSmartPtr endPointVolumeSmartPtr;
-            TryCreateDeviceOnId(deviceId, device, endPointVolumeSmartPtr) && IsDeviceApplicable(device)
-        )
+        TVolumeNotificationToken volumeToken;
+        if (Device device; TryProbeEndpoint(deviceId, device, &volumeToken))
         {
             LOG_INFO(
                 L"ADDED MORE INFO: device name: \"" << device.GetName() << L"\", flow: " << device.GetFlow()
                 << L", plug-and-play id " << device.GetPnpId() << L".")
 
-            const auto possiblyMergedDevice = MergeDeviceWithExistingOneBasedOnPnpIdAndFlow(device);
-            LOG_INFO(
-                L"ADDED MERGED: device name: \"" << possiblyMergedDevice.GetName() << L"\", flow: " <<
-                possiblyMergedDevice.GetFlow() << L".")
-
-            pnpToDeviceMap_[device.GetPnpId()] = possiblyMergedDevice;
-
-            // ReSharper disable once CppFunctionResultShouldBeUsed
-            if (endPointVolumeSmartPtr != nullptr)
+            if (!ApplyAddedDevice(deviceId, device, generation, std::move(volumeToken)))
             {
-                endPointVolumeSmartPtr->RegisterControlChangeNotify(this);
-                devIdToEndpointVolumes_[deviceId] = endPointVolumeSmartPtr;
+                Count(counters_.NotificationsSuppressed);
             }
-
-            NotifyObservers(DeviceCollectionEvent::Discovered, device.GetPnpId());
+        }
+        else
+        {
+            {
+                TableLock lock(*this);
+                ForgetEndpointState(deviceId, generation);
+            }
+            Count(counters_.NotificationsSuppressed);
         }
         LOG_INFO(L"ADDED FINISHED: device id \"" << deviceId << L".\n")
     }
@@ -550,8 +1579,10 @@ HRESULT ed::audio::DeviceCollection::OnDeviceAdded(LPCWSTR deviceId)
 bool ed::audio::DeviceCollection::CheckRemovalAndUnmergeDeviceFromExistingOneBasedOnPnpIdAndFlow(
     const Device & device, Device & unmergedDev) const
 {
+    AC_TIMELINE_ZONE("UnmergeDevice");
     unmergedDev = {
-		device.GetPnpId(), device.GetName(), DeviceFlowEnum::None, device.GetCurrentRenderVolume(), device.GetCurrentCaptureVolume()
+		device.GetPnpId(), device.GetName(), DeviceFlowEnum::None, device.GetCurrentRenderVolume(), device.GetCurrentCaptureVolume(),
+        device.GetFormFactor(), device.GetJackConnection()
     };
 
     if
@@ -596,16 +1627,18 @@ bool ed::audio::DeviceCollection::CheckRemovalAndUnmergeDeviceFromExistingOneBas
             }
 
             // ReSharper disable once CppTooWideScopeInitStatement
-            const auto foundDevNameAsSet = Split(foundDev.GetName(), L'/');
+            const auto foundDevNameAsSet = Split(foundDev.GetName(), L'/', NotificationArena::GetCurrentResource());
             for (const auto & elem : foundDevNameAsSet)
             {
-                if (elem != name)
+                if (std::wstring_view(elem) != name)
                 {
                     name = elem;
                     break;
                 }
             }
-			unmergedDev = { device.GetPnpId(), name, flow, renderVolume, captureVolume };
+			unmergedDev = {
+                device.GetPnpId(), name, flow, renderVolume, captureVolume, foundDev.GetFormFactor(), foundDev.GetJackConnection()
+            };
             return true;
         }
     }
@@ -614,67 +1647,91 @@ bool ed::audio::DeviceCollection::CheckRemovalAndUnmergeDeviceFromExistingOneBas
 
 
 HRESULT ed::audio::DeviceCollection::OnDeviceRemoved(LPCWSTR deviceId)
+{
+    const NotificationArena arena;
+    const ScopedNotification notification(counters_, counters_.DeviceRemovedNotifications);
+    if (TryQueueForBurst(LatencyKind::DeviceRemoved, deviceId))
+    {
+        return S_OK;
+    }
+    AC_TIMELINE_ZONE("OnDeviceRemoved");
+    const ScopedLatency latency(GetLatencyHistogram(LatencyKind::DeviceRemoved));
+    return HandleDeviceRemoved(deviceId);
+}
+
+HRESULT ed::audio::DeviceCollection::HandleDeviceRemoved(LPCWSTR deviceId)
 {
     using magic_enum::iostream_operators::operator<<; // out-of-the-box stream operators for enums
 
     const HRESULT hr = MultipleNotificationClient::OnDeviceRemoved(deviceId);
-    if (hr == S_OK)
+    if (uint64_t generation = 0; hr == S_OK && TryTransitEndpoint(deviceId, EndpointPresence::Absent, generation))
     {
         LOG_INFO(L"REMOVED INFO: device id \"" << deviceId << L".")
-        Device removedDeviceToUnmerge;
-        if
-        (   EndPointVolumeSmartPtr volumeEndpointSmartPtr;
-            TryCreateDeviceOnId(deviceId, removedDeviceToUnmerge, volumeEndpointSmartPtr)
-            && IsDeviceApplicable(removedDeviceToUnmerge)
-        )
+        bool isRemoved;
+        // As it was before the removal, to match the subscriptions against
+        Device detachedDevice;
         {
-            LOG_INFO(
-                L"REMOVED MORE INFO: device name \"" << removedDeviceToUnmerge.GetName() << L"\", flow: " <<
-                removedDeviceToUnmerge.GetFlow() << L", plug-and-play id: " << removedDeviceToUnmerge.GetPnpId() <<
-                L".")
-
-            
-            if (Device possiblyUnmergedDevice; 
-                CheckRemovalAndUnmergeDeviceFromExistingOneBasedOnPnpIdAndFlow(removedDeviceToUnmerge, possiblyUnmergedDevice))
-            {
-                if (possiblyUnmergedDevice.GetFlow() == DeviceFlowEnum::None)
-                {
-                    LOG_INFO(L"REMOVED UNMERGED: nothing.")
-                    pnpToDeviceMap_.erase(possiblyUnmergedDevice.GetPnpId());
-                }
-                else
-                {
-                    LOG_INFO(
-                        L"REMOVED UNMERGED: device name \"" << possiblyUnmergedDevice.GetName() << L"\", flow: " <<
-                        possiblyUnmergedDevice.GetFlow() << L".")
-                    pnpToDeviceMap_[possiblyUnmergedDevice.GetPnpId()] = possiblyUnmergedDevice;
-                }
-                UnregisterAndRemoveEndpointsVolumes(deviceId);
-                NotifyObservers(DeviceCollectionEvent::Detached, removedDeviceToUnmerge.GetPnpId());
-            }
+            TableLock lock(*this);
+            isRemoved = TryEraseRemovedEndpoint(deviceId, generation, detachedDevice);
+        }
+        UnregisterVolumeNotification(deviceId, generation);
+        if (isRemoved)
+        {
+            NotifyObservers(DeviceCollectionEvent::Detached, detachedDevice.GetPnpId(), detachedDevice);
+        }
+        else
+        {
+            Count(counters_.NotificationsSuppressed);
         }
         LOG_INFO(L"REMOVED FINISHED: device id \"" << deviceId << L".\n")
     }
     return hr;
 }
 
-bool ed::audio::DeviceCollection::TryCreateDeviceOnId(
-    LPCWSTR deviceId,
-    Device& device,
-    EndPointVolumeSmartPtr& outVolumeEndpoint
-) const {
-    CComPtr<IMMDevice> deviceSmartPtr;
-    // Retrieve the device using the device ID
+bool ed::audio::DeviceCollection::TryEraseRemovedEndpoint(LPCWSTR deviceId, uint64_t generation, Device & detachedDevice)
+{
+    using magic_enum::iostream_operators::operator<<; // out-of-the-box stream operators for enums
+
+    if (!IsCurrentGeneration(deviceId, generation))
     {
-        IMMDevice* devicePtr = nullptr;
-        const auto hr = enumerator_->GetDevice(deviceId, &devicePtr);
-        if (FAILED(hr)) {
-            return false; // Return false on failure
-        }
-        deviceSmartPtr.Attach(devicePtr);
+        return false;
+    }
+    // The facts it has been merged with, kept for every active endpoint: a gone endpoint may fail to probe
+    const auto foundFacts = endpointFacts_.find(std::wstring_view(deviceId));
+    if (foundFacts == endpointFacts_.end())
+    {
+        return false;
+    }
+    const Device removedDevice = foundFacts->second;
+    LOG_INFO(
+        L"REMOVED MORE INFO: device name \"" << removedDevice.GetName() << L"\", flow: " << removedDevice.GetFlow() <<
+        L", plug-and-play id: " << removedDevice.GetPnpId() << L".")
+    EraseEndpointFacts(deviceId);
+    Device possiblyUnmergedDevice;
+    if (!IsDeviceApplicable(removedDevice)
+        || !CheckRemovalAndUnmergeDeviceFromExistingOneBasedOnPnpIdAndFlow(removedDevice, possiblyUnmergedDevice))
+    {
+        return false;
+    }
+    const auto foundPair = pnpToDeviceMap_.find(removedDevice.GetPnpId());
+    detachedDevice = foundPair != pnpToDeviceMap_.end() ? foundPair->second : removedDevice;
+    if (const auto foundEndpoint = endpointToDevice_.find(std::wstring_view(deviceId)); foundEndpoint != endpointToDevice_.end())
+    {
+        endpointToDevice_.erase(foundEndpoint);
+    }
+    if (possiblyUnmergedDevice.GetFlow() == DeviceFlowEnum::None)
+    {
+        LOG_INFO(L"REMOVED UNMERGED: nothing.")
+        EraseDevice(possiblyUnmergedDevice.GetPnpId());
+    }
+    else
+    {
+        LOG_INFO(
+            L"REMOVED UNMERGED: device name \"" << possiblyUnmergedDevice.GetName() << L"\", flow: " <<
+            possiblyUnmergedDevice.GetFlow() << L".")
+        PutDevice(possiblyUnmergedDevice);
     }
-    std::wstring devId;
-    return TryCreateDeviceAndGetVolumeEndpoint(0, deviceSmartPtr, device, devId, outVolumeEndpoint);
+    return true;
 }
 
 std::vector<std::wstring> ed::audio::DeviceCollection::GetDevicePnPIdsWithChangedVolume(
@@ -705,6 +1762,19 @@ std::vector<std::wstring> ed::audio::DeviceCollection::GetDevicePnPIdsWithChange
 }
 
 HRESULT ed::audio::DeviceCollection::OnDeviceStateChanged(LPCWSTR deviceId, DWORD dwNewState)
+{
+    const NotificationArena arena;
+    const ScopedNotification notification(counters_, counters_.DeviceStateChangedNotifications);
+    if (TryQueueForBurst(LatencyKind::DeviceStateChanged, deviceId, dwNewState))
+    {
+        return S_OK;
+    }
+    AC_TIMELINE_ZONE("OnDeviceStateChanged");
+    const ScopedLatency latency(GetLatencyHistogram(LatencyKind::DeviceStateChanged));
+    return HandleDeviceStateChanged(deviceId, dwNewState);
+}
+
+HRESULT ed::audio::DeviceCollection::HandleDeviceStateChanged(LPCWSTR deviceId, DWORD dwNewState)
 {
     HRESULT hr = MultipleNotificationClient::OnDeviceStateChanged(deviceId, dwNewState);
     assert(SUCCEEDED(hr));
@@ -712,14 +1782,15 @@ HRESULT ed::audio::DeviceCollection::OnDeviceStateChanged(LPCWSTR deviceId, DWOR
     switch (dwNewState)
     {
     case DEVICE_STATE_ACTIVE:
-        hr = OnDeviceAdded(deviceId);
+        hr = HandleDeviceAdded(deviceId);
         break;
     case DEVICE_STATE_DISABLED:
     case DEVICE_STATE_NOTPRESENT:
     case DEVICE_STATE_UNPLUGGED:
-        hr = OnDeviceRemoved(deviceId);
+        hr = HandleDeviceRemoved(deviceId);
         break;
-    default: ;
+    default:
+        Count(counters_.NotificationsSuppressed);
     }
 
     return hr;
@@ -727,17 +1798,221 @@ HRESULT ed::audio::DeviceCollection::OnDeviceStateChanged(LPCWSTR deviceId, DWOR
 
 HRESULT ed::audio::DeviceCollection::OnNotify(PAUDIO_VOLUME_NOTIFICATION_DATA pNotify)
 {
+    const NotificationArena arena;
+    const ScopedNotification notification(counters_, counters_.VolumeNotifications);
+    AC_TIMELINE_ZONE("OnNotify");
+    const ScopedLatency latency(GetLatencyHistogram(LatencyKind::VolumeChanged));
     const HRESULT hResult = MultipleNotificationClient::OnNotify(pNotify);
-    const auto copy = pnpToDeviceMap_;
+    TPnPIdToDeviceMap copy;
+    {
+        TableLock lock(*this);
+        copy = pnpToDeviceMap_;
+    }
 
     RefreshVolumes();
 
-    for (
-        const auto diff = GetDevicePnPIdsWithChangedVolume(copy, pnpToDeviceMap_);
-        const auto & currPnPId : diff)
+    std::vector<std::wstring> diff;
+    std::vector<Device> changedDevices;
+    {
+        TableLock lock(*this);
+        diff = GetDevicePnPIdsWithChangedVolume(copy, pnpToDeviceMap_);
+        for (const auto & currPnPId : diff)
+        {
+            const auto foundPair = pnpToDeviceMap_.find(currPnPId);
+            changedDevices.push_back(foundPair != pnpToDeviceMap_.end() ? foundPair->second : Device());
+        }
+    }
+    if (diff.empty())
+    {
+        Count(counters_.NotificationsSuppressed);
+    }
+    for (size_t i = 0; i < diff.size(); ++i)
     {
-        NotifyObservers(DeviceCollectionEvent::VolumeChanged, currPnPId);
+        NotifyObservers(DeviceCollectionEvent::VolumeChanged, diff[i], changedDevices[i]);
     }
 
     return hResult;
 }
+
+HRESULT ed::audio::DeviceCollection::OnEndpointVolumeNotify(LPCWSTR endpointId, PAUDIO_VOLUME_NOTIFICATION_DATA pNotify)
+{
+    const NotificationArena arena;
+    const ScopedNotification notification(counters_, counters_.VolumeNotifications);
+    AC_TIMELINE_ZONE("OnEndpointVolumeNotify");
+    const ScopedLatency latency(GetLatencyHistogram(LatencyKind::VolumeChanged));
+    // As probed: a muted endpoint has the volume 0
+    const auto volume = static_cast<uint16_t>(pNotify->bMuted != FALSE ? 0 : lround(pNotify->fMasterVolume * 1000.0f));
+
+    bool isChanged = false;
+    // Copied only if some observer is interested
+    std::wstring changedPnpId;
+    Device changedDevice;
+    {
+        TableLock lock(*this);
+        const auto foundFacts = endpointFacts_.find(std::wstring_view(endpointId));
+        if (foundFacts == endpointFacts_.end())
+        {
+            LOG_INFO(L"Volume notification of the unknown end point device, id \"" << endpointId << L"\". Ignoring it.")
+            Count(counters_.NotificationsSuppressed);
+            return S_OK;
+        }
+        // Kept current while the filter leaves the endpoint out, too
+        if (auto & facts = foundFacts->second; facts.GetFlow() == DeviceFlowEnum::Capture)
+        {
+            facts.SetCurrentCaptureVolume(volume);
+        }
+        else
+        {
+            facts.SetCurrentRenderVolume(volume);
+        }
+        const auto foundEndpoint = endpointToDevice_.find(std::wstring_view(endpointId));
+        if (foundEndpoint == endpointToDevice_.end())
+        {
+            Count(counters_.NotificationsSuppressed);
+            return S_OK;
+        }
+        const auto & [pnpId, flow] = foundEndpoint->second;
+        if (const auto foundPair = pnpToDeviceMap_.find(pnpId); foundPair != pnpToDeviceMap_.end())
+        {
+            const auto & device = foundPair->second;
+            isChanged = SetDeviceVolume(*foundPair, flow == DeviceFlowEnum::Capture ? DeviceFlowEnum::Capture : DeviceFlowEnum::Render, volume);
+            if (isChanged && GetObserversSnapshot()->IsInterested(DeviceCollectionEvent::VolumeChanged, pnpId, device))
+            {
+                changedPnpId = pnpId;
+                changedDevice = device;
+            }
+            else if (isChanged)
+            {
+                // Nobody to notify: logged only, without copying the id
+                LogChange(DeviceCollectionEvent::VolumeChanged, pnpId);
+            }
+        }
+    }
+
+    if (!isChanged)
+    {
+        Count(counters_.NotificationsSuppressed);
+    }
+    else if (!changedPnpId.empty())
+    {
+        NotifyObservers(DeviceCollectionEvent::VolumeChanged, changedPnpId, changedDevice);
+    }
+    return S_OK;
+}
+
+HRESULT ed::audio::DeviceCollection::OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR defaultDeviceId)
+{
+    using magic_enum::iostream_operators::operator<<; // out-of-the-box stream operators for enums
+
+    const NotificationArena arena;
+    const ScopedNotification notification(counters_, counters_.DefaultDeviceChangedNotifications);
+    AC_TIMELINE_ZONE("OnDefaultDeviceChanged");
+    const ScopedLatency latency(GetLatencyHistogram(LatencyKind::DefaultDeviceChanged));
+    const auto deviceFlow = flow == eRender ? DeviceFlowEnum::Render : flow == eCapture ? DeviceFlowEnum::Capture : DeviceFlowEnum::None;
+    const auto deviceRole = static_cast<DeviceRole>(role);
+    const std::wstring_view endpointId = defaultDeviceId != nullptr ? defaultDeviceId : L"";
+    TEventList events;
+    std::vector<Device> eventDevices;
+    if (const auto bit = Device::GetDefaultRoleBit(deviceFlow, deviceRole); bit != 0)
+    {
+        TableLock lock(*this);
+        ++defaultChanges_[std::countr_zero(bit)];
+        if (auto & defaultEndpoint = defaultEndpoints_[std::countr_zero(bit)]; defaultEndpoint != endpointId)
+        {
+            LOG_INFO(L"DEFAULT CHANGED: flow: " << deviceFlow << L", role: " << deviceRole << L", device id \"" << endpointId << L"\".")
+            // The devices of the previous and of the new default endpoint, if in the view
+            std::vector<std::wstring> pnpIds;
+            for (const auto & changedEndpointId : {std::wstring_view(defaultEndpoint), endpointId})
+            {
+                if (const auto foundEndpoint = endpointToDevice_.find(changedEndpointId); foundEndpoint != endpointToDevice_.end())
+                {
+                    pnpIds.push_back(foundEndpoint->second.PnpId);
+                }
+            }
+            defaultEndpoint = endpointId;
+            for (const auto & pnpId : pnpIds)
+            {
+                // The roles are not indexed, so they change in place
+                if (const auto foundPair = pnpToDeviceMap_.find(pnpId); foundPair != pnpToDeviceMap_.end()
+                    && foundPair->second.GetDefaultRoles() != GetDefaultRoles(pnpId))
+                {
+                    foundPair->second.SetDefaultRoles(GetDefaultRoles(pnpId));
+                    events.emplace_back(DeviceCollectionEvent::DefaultChanged, pnpId);
+                    eventDevices.push_back(foundPair->second);
+                }
+            }
+        }
+    }
+    if (events.empty())
+    {
+        Count(counters_.NotificationsSuppressed);
+        return S_OK;
+    }
+    NotifyObservers(events, eventDevices);
+    return S_OK;
+}
+
+HRESULT ed::audio::DeviceCollection::OnPropertyValueChanged(LPCWSTR deviceId, const PROPERTYKEY key)
+{
+    using magic_enum::iostream_operators::operator<<; // out-of-the-box stream operators for enums
+
+    const NotificationArena arena;
+    const ScopedNotification notification(counters_, counters_.PropertyValueChangedNotifications);
+    AC_TIMELINE_ZONE("OnPropertyValueChanged");
+    const ScopedLatency latency(GetLatencyHistogram(LatencyKind::PropertyValueChanged));
+    // Of the many properties a driver may change, only the kept ones are read; only of the active endpoints,
+    // a probe reads the others anew when they become active
+    const auto property = GetEndpointProperty(key);
+    Device facts;
+    bool isKnown = false;
+    if (property != EndpointProperty::None)
+    {
+        TableLock lock(*this);
+        if (const auto foundFacts = endpointFacts_.find(std::wstring_view(deviceId)); foundFacts != endpointFacts_.end())
+        {
+            facts = foundFacts->second;
+            isKnown = true;
+        }
+    }
+    TEventList events;
+    std::vector<Device> eventDevices;
+    // Read without the lock, as a probe is
+    if (auto refreshed = facts; isKnown && TryReadEndpointProperty(deviceId, property, refreshed)
+        && (refreshed.GetName() != facts.GetName() || refreshed.GetFormFactor() != facts.GetFormFactor()))
+    {
+        TableLock lock(*this);
+        // Only the one property, the endpoint's volume may have changed meanwhile; the endpoint may have gone, too
+        if (const auto foundFacts = endpointFacts_.find(std::wstring_view(deviceId)); foundFacts != endpointFacts_.end())
+        {
+            LOG_INFO(L"PROPERTY CHANGED: device id \"" << deviceId << L"\", property: " << property << L".")
+            foundFacts->second.SetName(refreshed.GetName());
+            foundFacts->second.SetFormFactor(refreshed.GetFormFactor());
+
+            const auto pnpId = foundFacts->second.GetPnpId();
+            TPnPIdToDeviceMap old;
+            TPnPIdToDeviceMap updated;
+            RemergeDevices({pnpId}, old, updated);
+            const auto foundOld = old.find(pnpId);
+            const auto foundUpdated = updated.find(pnpId);
+            if (foundOld == old.end() || foundUpdated == updated.end() || foundOld->second.GetFlow() != foundUpdated->second.GetFlow())
+            {
+                // Renamed into or out of the filter, as a whole or by one of its endpoints
+                events = GetDifferences(old, updated);
+                eventDevices = GetEventDevices(events, old, updated);
+            }
+            else if (foundOld->second.GetName() != foundUpdated->second.GetName()
+                || foundOld->second.GetFormFactor() != foundUpdated->second.GetFormFactor())
+            {
+                events.emplace_back(DeviceCollectionEvent::PropertyChanged, pnpId);
+                eventDevices.push_back(foundUpdated->second);
+            }
+        }
+    }
+    if (events.empty())
+    {
+        Count(counters_.NotificationsSuppressed);
+        return S_OK;
+    }
+    NotifyObservers(events, eventDevices);
+    return S_OK;
+}
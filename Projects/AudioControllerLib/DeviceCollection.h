@@ -1,26 +1,62 @@
 ﻿#pragma once
 
-#include <endpointvolume.h>
-#include <set>
-#include <atlbase.h>
 #include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <set>
+#include <thread>
+#include <unordered_map>
 
 #include "../AudioController/AudioControlInterface.h"
 
+#include "AudioBackendInterface.h"
 #include "Device.h"
+#include "DeviceQueryIndex.h"
+#include "LatencyHistogram.h"
+#include "ObserverIndex.h"
 
 #include "MultipleNotificationClient.h"
 
 
 namespace ed::audio {
-using EndPointVolumeSmartPtr = CComPtr<IAudioEndpointVolume>;
-
-
 class DeviceCollection final : public DeviceCollectionInterface, protected MultipleNotificationClient {
 protected:
     using TPnPIdToDeviceMap = std::map<std::wstring, Device>;
+    // The generation of the endpoint at the enumeration, zero if not a ResetContent(), and the volume token of the
+    // probe, empty if not a ResetContent()
     using ProcessDeviceFunctionT =
-        std::function<void(ed::audio::DeviceCollection*, const std::wstring&, const Device&, EndPointVolumeSmartPtr)>;
+        std::function<void(ed::audio::DeviceCollection*, const std::wstring&, const Device&, uint64_t, TVolumeNotificationToken)>;
+    using TEventList = std::vector<std::pair<DeviceCollectionEvent, std::wstring>>;
+    // The device an active endpoint belongs to; lets a volume notification update it in place
+    struct EndpointEntry {
+        std::wstring PnpId;
+        DeviceFlowEnum Flow = DeviceFlowEnum::None;
+    };
+    using TEndpointMap = std::map<std::wstring, EndpointEntry, std::less<>>;
+    // Every active endpoint as probed, whether the filter lets it through or not; volumes kept current
+    using TEndpointFactsMap = std::map<std::wstring, Device, std::less<>>;
+    // The endpoints of every container among the endpoint facts, ordered as there
+    using TContainerEndpointsMap = std::map<std::wstring, std::set<std::wstring, std::less<>>, std::less<>>;
+    // Presence of an endpoint as last notified, to drop redundant notifications before probing. The generation
+    // is renewed by every transition, so a probe can tell whether its endpoint has transitioned again meanwhile.
+    enum class EndpointPresence : uint8_t { Present, Absent };
+    struct EndpointState {
+        EndpointPresence Presence = EndpointPresence::Absent;
+        uint64_t Generation = 0;
+    };
+    // Hashes strings and views alike, so a lookup by LPCWSTR allocates nothing
+    struct WideStringHash {
+        using is_transparent = void;
+        size_t operator()(std::wstring_view text) const noexcept { return std::hash<std::wstring_view>{}(text); }
+    };
+    using TEndpointStateMap = std::unordered_map<std::wstring, EndpointState, WideStringHash, std::equal_to<>>;
+    // Endpoint ids by flow and role, as Device::GetDefaultRoleBit() orders them; empty if there is none
+    using TDefaultEndpoints = std::array<std::wstring, 2 * DeviceRoleCount>;
+    // How often each of the defaults has been notified, in the same order
+    using TDefaultChanges = std::array<uint64_t, 2 * DeviceRoleCount>;
 
 public:
     DISALLOW_COPY_MOVE(DeviceCollection);
@@ -28,63 +64,311 @@ public:
 
 public:
     explicit DeviceCollection(std::wstring nameFilter, bool bothHeadsetAndMicro);
+    DeviceCollection(std::wstring nameFilter, bool bothHeadsetAndMicro, std::unique_ptr<AudioBackendInterface> backend);
 
     [[nodiscard]] size_t GetSize() const override;
     [[nodiscard]] std::unique_ptr<DeviceInterface> CreateItem(size_t deviceNumber) const override;
+    [[nodiscard]] std::vector<std::unique_ptr<DeviceInterface>> FindDevices(const DeviceQuery & query) const override;
+    [[nodiscard]] std::unique_ptr<DeviceInterface> GetDefaultDevice(DeviceFlowEnum flow, DeviceRole role) const override;
     void Subscribe(DeviceCollectionObserverInterface & observer) override;
+    void Subscribe(DeviceCollectionObserverInterface & observer, const DeviceCollectionSubscription & subscription) override;
     void Unsubscribe(DeviceCollectionObserverInterface & observer) override;
+    bool LoadWarmStartCache(const std::wstring & cacheFilePath) override;
+    [[nodiscard]] bool IsStale() const override;
+    [[nodiscard]] LatencyStatistics GetLatencyStatistics() const override;
+    [[nodiscard]] OperationalCounters GetOperationalCounters() const override;
+    void SetBurstWindow(std::chrono::milliseconds quietWindow) override;
+    // Applies the queued notifications of the running burst at once, on the calling thread
+    void FlushBurst();
+    [[nodiscard]] uint64_t GetSequence() const override;
+    [[nodiscard]] DeviceCollectionChangesSince GetChangesSince(uint64_t sequence) const override;
+    void SetFilter(const std::wstring & nameFilter) override;
+    void SetFlowMode(bool bothHeadsetAndMicro) override;
 
 public:
     HRESULT OnDeviceAdded(LPCWSTR deviceId) override;
     HRESULT OnDeviceRemoved(LPCWSTR deviceId) override;
     HRESULT OnDeviceStateChanged(LPCWSTR deviceId, DWORD dwNewState) override;
     HRESULT OnNotify(PAUDIO_VOLUME_NOTIFICATION_DATA pNotify) override;
+    // Updates the volume of the one device in place, without enumerating; allocates nothing if nobody is subscribed
+    HRESULT OnEndpointVolumeNotify(LPCWSTR endpointId, PAUDIO_VOLUME_NOTIFICATION_DATA pNotify) override;
+    // Moves the default of the flow and role to the device of the endpoint in place, without probing
+    HRESULT OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR defaultDeviceId) override;
+    // Reads the one changed property of the endpoint and updates its device in place, without enumerating or probing
+    HRESULT OnPropertyValueChanged(LPCWSTR deviceId, PROPERTYKEY key) override;
 
 private:
-    void ProcessActiveDeviceList(ProcessDeviceFunctionT processDeviceFunc);
+    // isReset: a ResetContent(); records the enumeration and probing latencies and restarts the endpoint states.
+    // Returns the generation of the enumeration, zero if not a reset or if enumerating has failed.
+    uint64_t ProcessActiveDeviceList(ProcessDeviceFunctionT processDeviceFunc, bool isReset = false);
     void RecreateActiveDeviceList();
+    void RecreateActiveDeviceListProgressively();
+    // Dropped, and counted, if the endpoint has transitioned since the generation. Returns false if the filter
+    // leaves the device out, which keeps the facts of the endpoint only. Registers its volume notification with
+    // the token of the probe, after releasing mutex_.
+    bool ApplyAddedDevice(const std::wstring & deviceId, const Device & device, uint64_t generation,
+                          TVolumeNotificationToken volumeToken);
+    // The endpoint states, see EndpointState. Returns the generation of the enumeration; called with mutex_ held.
+    uint64_t RestartEndpointStates(const std::vector<std::wstring> & activeEndpointIds);
+    // The facts probed by a ResetContent() of the generation, less the ones of endpoints notified since, which keep
+    // their current facts; called with mutex_ held
+    void ReconcileSupersededProbes(uint64_t generation, TEndpointFactsMap & freshFacts) const;
+    // False, and counted as deduplicated, if the endpoint is in the presence already
+    [[nodiscard]] bool TryTransitEndpoint(LPCWSTR endpointId, EndpointPresence presence, uint64_t & generation);
+    // Called with mutex_ held
+    [[nodiscard]] bool IsCurrentGeneration(std::wstring_view endpointId, uint64_t generation) const;
+    // An endpoint whose addition has failed to probe, unless it has transitioned since; called with mutex_ held
+    void ForgetEndpointState(std::wstring_view endpointId, uint64_t generation);
+    // The locked parts of ApplyAddedDevice() and HandleDeviceRemoved(), shared with ApplyBurst(); called with mutex_
+    // held. False if the endpoint has transitioned since the generation, or, for a removal, if no device is detached
+    // or unmerged. The device is the merged one for an addition, the one as before the removal for a removal. The
+    // caller (un)registers the volume notification after releasing mutex_.
+    bool TryPutAddedEndpoint(const std::wstring & deviceId, const Device & device, uint64_t generation,
+                             Device & possiblyMergedDevice, bool & isApplicable);
+    bool TryEraseRemovedEndpoint(LPCWSTR deviceId, uint64_t generation, Device & detachedDevice);
+    // Shared by the notification entry points; OnDeviceStateChanged must not time them twice
+    HRESULT HandleDeviceAdded(LPCWSTR deviceId);
+    HRESULT HandleDeviceRemoved(LPCWSTR deviceId);
+    HRESULT HandleDeviceStateChanged(LPCWSTR deviceId, DWORD dwNewState);
+    // Queues the notification if a burst window is set; kind is DeviceAdded, DeviceRemoved or DeviceStateChanged
+    bool TryQueueForBurst(LatencyKind kind, LPCWSTR deviceId, DWORD state = 0);
+    void RunBurstWorker();
+    // Probes every endpoint of the burst once, without the lock, and applies the net changes with it
+    void ApplyBurst();
     void RefreshVolumes();
-    static void RegisterDevice(DeviceCollection* self, const std::wstring& deviceId, const Device& device, EndPointVolumeSmartPtr endpointVolume);
-    static void UpdateDeviceVolume(DeviceCollection* self, const std::wstring& deviceId, const Device& device, EndPointVolumeSmartPtr);
+    // The device map changes with its query indexes only; called with mutex_ held. A put device gets its default
+    // roles from the endpoints in endpointToDevice_, so an endpoint is entered there before its device is put.
+    void PutDevice(const Device & device);
+    void EraseDevice(const std::wstring & pnpId);
+    void ReplaceDevices(TPnPIdToDeviceMap devices);
+    // The endpoint facts change with their container index only; called with mutex_ held
+    void PutEndpointFacts(const std::wstring & endpointId, const Device & device);
+    void EraseEndpointFacts(std::wstring_view endpointId);
+    void ReplaceEndpointFacts(TEndpointFactsMap facts);
+    // Sets the volume of the flow, Render or Capture, in place; returns whether it has changed
+    bool SetDeviceVolume(TPnPIdToDeviceMap::value_type & entry, DeviceFlowEnum flow, uint16_t volume);
+    // Backend calls, counted
+    bool TryProbeEndpoint(const std::wstring & endpointId, Device & device, TVolumeNotificationToken * volumeToken = nullptr);
+    [[nodiscard]] TDefaultEndpoints QueryDefaultEndpoints() const;
+    bool TryReadEndpointProperty(const std::wstring & endpointId, EndpointProperty property, Device & device);
+    // Called without mutex_ held: a volume callback in flight takes mutex_, and the backend waits for it to return
+    // when unregistering. Dropped if the endpoint has been (un)registered as of a later generation meanwhile; a
+    // generation of zero is never dropped.
+    void RegisterVolumeNotification(const std::wstring & endpointId, uint64_t generation, TVolumeNotificationToken volumeToken);
+    void UnregisterVolumeNotification(const std::wstring & endpointId, uint64_t generation);
+    void UnregisterAllVolumeNotifications();
+    // Called with volumeMutex_ held
+    bool TryAdvanceVolumeGeneration(const std::wstring & endpointId, uint64_t generation);
+    static void UpdateDeviceVolume(DeviceCollection* self, const std::wstring& deviceId, const Device& device, uint64_t,
+                                   TVolumeNotificationToken);
 
 
-    void NotifyObservers(DeviceCollectionEvent action, const std::wstring & devicePNpId) const;
+    // The device is the one the subscriptions are matched against, see GetEventDevices()
+    void NotifyObservers(DeviceCollectionEvent action, const std::wstring & devicePNpId, const Device & device) const;
+    void NotifyObservers(const TEventList & events, const std::vector<Device> & devices) const;
+    void NotifyObserversOfBatch(const TEventList & events, const std::vector<Device> & devices) const;
+    // Logs an event with the next sequence number; allocates nothing once the log is warm
+    void LogChange(DeviceCollectionEvent event, std::wstring_view pnpId) const;
+    // The current observers; they stay valid and unchanged while held, whatever (un)subscribes meanwhile. To call
+    // them back, see ScopedDispatch.
+    [[nodiscard]] std::shared_ptr<const ObserverIndex> GetObserversSnapshot() const;
+    // Until every dispatch that may have loaded an index before has ended; at once within a dispatch of this thread
+    void WaitForDispatches();
+    static TEventList GetDifferences(const TPnPIdToDeviceMap & old, const TPnPIdToDeviceMap & updated);
+    // The device of every event: a detached one as it was before, the others as they are after
+    static std::vector<Device> GetEventDevices(const TEventList & events, const TPnPIdToDeviceMap & old, const TPnPIdToDeviceMap & updated);
+    void SaveWarmStartCache() const;
+    // The bits of the default endpoints among the endpoints of the device, see Device::GetDefaultRoles(); called with mutex_ held
+    [[nodiscard]] uint8_t GetDefaultRoles(std::wstring_view pnpId) const;
+    // Called with mutex_ held, as the filter may change meanwhile
     [[nodiscard]] bool IsDeviceApplicable(const Device & device) const;
-    bool TryCreateDeviceAndGetVolumeEndpoint(ULONG i,
-                                             CComPtr<IMMDevice> deviceEndpointSmartPtr,
-                                             Device & device,
-                                             std::wstring & deviceId,
-                                             EndPointVolumeSmartPtr & outVolumeEndpoint
-    ) const;
+    // As IsDeviceApplicable(), without tracing every endpoint, for re-filtering them all
+    [[nodiscard]] bool IsPassingFilter(const Device & device) const;
+    // The devices of the endpoints entering or leaving the view by a changed filter, from the endpoint facts,
+    // as their events; called with mutex_ held
+    void ReapplyFilter(TEventList & events, std::vector<Device> & eventDevices);
+    // The devices of the containers merged anew from the facts of their endpoints the filter lets through, and put
+    // in place of the old ones; old and updated get them before and after. Called with mutex_ held.
+    void RemergeDevices(const std::set<std::wstring, std::less<>> & pnpIds, TPnPIdToDeviceMap & old, TPnPIdToDeviceMap & updated);
 
+    [[nodiscard]] LatencyHistogram & GetLatencyHistogram(LatencyKind kind);
+    static void Count(std::atomic<uint64_t> & counter, uint64_t increment = 1) noexcept;
+    // Whether any observer takes trace lines, see LOG_INFO
+    [[nodiscard]] bool IsTraceOn() const;
     void TraceIt(const std::wstring & line) const;
     void TraceItDebug(const std::wstring & line) const;
-    void UnregisterAllEndpointsVolumes();
-    void UnregisterAndRemoveEndpointsVolumes(const std::wstring & deviceId);
 
-    [[nodiscard]] Device MergeDeviceWithExistingOneBasedOnPnpIdAndFlow(const Device & device) const;
+    [[nodiscard]] static Device MergeDeviceWithExistingOneBasedOnPnpIdAndFlow(const TPnPIdToDeviceMap & devices, const Device & device);
     [[nodiscard]] bool CheckRemovalAndUnmergeDeviceFromExistingOneBasedOnPnpIdAndFlow(const Device & device, Device & unmergedDev) const;
 
-    bool TryCreateDeviceOnId(LPCWSTR deviceId,
-                                               Device & device,
-                                               EndPointVolumeSmartPtr & outVolumeEndpoint
-    ) const;
-
     static std::vector<std::wstring> GetDevicePnPIdsWithChangedVolume(const TPnPIdToDeviceMap & old,
                                                                       const TPnPIdToDeviceMap & updated);
 
+    // The helpers above are measured in isolation by AudioControllerBench
+    friend class DeviceCollectionBenchAccess;
+
 public:
     void ResetContent() override;
+    std::future<void> ResetContentAsync(std::function<void()> onCompleted) override;
+
+private:
+    // Relaxed atomics behind GetOperationalCounters(); they are read for diagnostics only and order nothing
+    struct AtomicCounters {
+        std::atomic<uint64_t> DeviceAddedNotifications = 0;
+        std::atomic<uint64_t> DeviceRemovedNotifications = 0;
+        std::atomic<uint64_t> DeviceStateChangedNotifications = 0;
+        std::atomic<uint64_t> VolumeNotifications = 0;
+        std::atomic<uint64_t> DefaultDeviceChangedNotifications = 0;
+        std::atomic<uint64_t> PropertyValueChangedNotifications = 0;
+        std::atomic<uint64_t> EventsDelivered = 0;
+        std::atomic<uint64_t> NotificationsSuppressed = 0;
+        std::atomic<uint64_t> Enumerations = 0;
+        std::atomic<uint64_t> PropertyStoreOpens = 0;
+        std::atomic<uint64_t> EndpointActivations = 0;
+        std::atomic<uint64_t> PendingNotifications = 0;
+        std::atomic<uint64_t> NotificationsDeduplicated = 0;
+    };
+
+    struct LoggedChange {
+        DeviceCollectionEvent Event = DeviceCollectionEvent::None;
+        std::wstring PnpId;
+    };
+
+    struct QueuedNotification {
+        LatencyKind Kind = LatencyKind::DeviceAdded;
+        std::wstring EndpointId;
+        DWORD State = 0;
+        std::chrono::steady_clock::time_point ArrivedAt;
+    };
 
+    // An endpoint of a burst, at the presence notified last
+    struct BurstEndpoint {
+        EndpointPresence Presence = EndpointPresence::Absent;
+        uint64_t Generation = 0;
+        // Removed within the burst, possibly present again
+        bool WasRemoved = false;
+        bool IsProbed = false;
+        // Added to the tables, so its volume notification is registered
+        bool IsPut = false;
+        Device Facts;
+        TVolumeNotificationToken VolumeToken;
+    };
+
+    // Counts a received notification of one kind and keeps it pending during its lifetime
+    class ScopedNotification final {
+    public:
+        DISALLOW_COPY_MOVE(ScopedNotification);
+        ScopedNotification(AtomicCounters & counters, std::atomic<uint64_t> & kindCounter);
+        ~ScopedNotification();
+
+    private:
+        AtomicCounters & counters_;
+    };
+
+    // A dispatch in flight, counted under the dispatch epoch it has started in, so Unsubscribe() can wait for the
+    // ones that may still call an observer back. The dispatches of a thread are chained, innermost first, so a
+    // callback that unsubscribes does not wait for the dispatch it is called from.
+    class ScopedDispatch final {
+    public:
+        DISALLOW_COPY_MOVE(ScopedDispatch);
+        explicit ScopedDispatch(const DeviceCollection & collection);
+        ~ScopedDispatch();
+
+        [[nodiscard]] const ObserverIndex & GetObservers() const { return *observers_; }
+        [[nodiscard]] static bool IsDispatching(const DeviceCollection & collection);
+
+    private:
+        const DeviceCollection & collection_;
+        size_t parity_ = 0;
+        std::shared_ptr<const ObserverIndex> observers_;
+        ScopedDispatch * outer_;
+        static thread_local ScopedDispatch * innermost_;
+    };
+
+    // Holds mutex_. The trace lines of the thread are kept in the current arena meanwhile and handed to the trace
+    // observers once it is released, so no observer is called back with mutex_ held.
+    class TableLock final {
+    public:
+        DISALLOW_COPY_MOVE(TableLock);
+        explicit TableLock(const DeviceCollection & collection);
+        // Throws what a trace observer throws, unless unwinding from an exception, which drops the kept lines
+        ~TableLock() noexcept(false);
+
+        // False if the thread does not hold the lock of the collection
+        [[nodiscard]] static bool TryKeepTrace(const DeviceCollection & collection, TraceLevel level, std::wstring_view line);
+
+    private:
+        const DeviceCollection & collection_;
+        std::unique_lock<std::mutex> lock_;
+        std::pmr::vector<std::pair<TraceLevel, std::pmr::wstring>> keptLines_;
+        int uncaughtExceptions_;
+        static thread_local TableLock * held_;
+    };
 
 private:
     std::map<std::wstring, Device> pnpToDeviceMap_;
-    std::set<DeviceCollectionObserverInterface*> observers_;
-    IMMDeviceEnumerator * enumerator_ = nullptr;
+    DeviceQueryIndex queryIndex_;
+    // The endpoints of the devices in the map, i.e. the ones the filter lets through
+    TEndpointMap endpointToDevice_;
+    TEndpointFactsMap endpointFacts_;
+    TContainerEndpointsMap containerEndpoints_;
+    TEndpointStateMap endpointStates_;
+    uint64_t lastGeneration_ = 0;
+    // Asked with every ResetContent(), then kept up to date by OnDefaultDeviceChanged(). A reset takes only the
+    // defaults not notified since it has asked, the others are as current as its answers.
+    TDefaultEndpoints defaultEndpoints_;
+    TDefaultChanges defaultChanges_{};
+    // Copy-on-write: Subscribe() and Unsubscribe() swap in a changed copy, a dispatch loads the index once and holds
+    // no lock while calling back. So observers may (un)subscribe from any thread, inside their callbacks, too. The load
+    // is not lock-free: MSVC guards std::atomic<std::shared_ptr> with a spin lock of its own, held for the load only.
+    std::atomic<std::shared_ptr<const ObserverIndex>> observers_{std::make_shared<const ObserverIndex>()};
+    // Dispatches in flight by the parity of the dispatch epoch they have started in; Unsubscribe() advances the epoch
+    // and waits for the ones of the previous parity, serialized by dispatchWaitMutex_. See ScopedDispatch.
+    mutable std::atomic<uint64_t> dispatchEpoch_ = 0;
+    mutable std::array<std::atomic<size_t>, 2> dispatchesInFlight_{};
+    std::mutex dispatchWaitMutex_;
+    std::atomic<size_t> traceObserverCount_ = 0;
+    std::unique_ptr<AudioBackendInterface> backend_;
+    // The filter, see SetFilter() and SetFlowMode(); guarded by mutex_
     std::wstring nameFilter_;
     bool bothHeadsetAndMicro_;
     const std::wstring noPlugAndPlayGuid_ = L"{00000000-0000-0000-FFFF-FFFFFFFFFFFF}";
 
-    std::map<std::wstring, CComPtr<IAudioEndpointVolume>> devIdToEndpointVolumes_;
+    // Guards the device map and its indexes, the endpoint facts, states and defaults and the filter. Taken through
+    // TableLock only, so it is never held while observers are called back, trace observers included; hence a plain
+    // mutex, as no callback can re-enter the collection with it held.
+    mutable std::mutex mutex_;
+    // Serializes the volume notification calls of the backend, so (un)registering waits for no table; never taken
+    // with mutex_ held. The generation each endpoint has been (un)registered as of last, see RegisterVolumeNotification().
+    mutable std::mutex volumeMutex_;
+    std::map<std::wstring, uint64_t, std::less<>> volumeGenerations_;
+    // Serializes the writers of observers_
+    std::mutex observersMutex_;
+    std::atomic_bool stale_ = false;
+    std::wstring cacheFilePath_;
+    // Taken before mutex_, see SaveWarmStartCache()
+    mutable std::mutex cacheSaveMutex_;
+    // The last thread of ResetContentAsync(), which joins the one before; guarded by resetThreadMutex_
+    std::mutex resetThreadMutex_;
+    std::thread resetThread_;
+    std::array<LatencyHistogram, LatencyKindCount> latencies_;
+    mutable AtomicCounters counters_;
+
+    // Change log, a ring: the change with the sequence number s is at (s - 1) % ChangeLogCapacity
+    static constexpr size_t ChangeLogCapacity = 256;
+    mutable std::mutex changeLogMutex_;
+    mutable std::vector<LoggedChange> changeLog_;
+    mutable std::atomic<uint64_t> sequence_ = 0;
+
+    // Burst batching, see SetBurstWindow(). burstApplyMutex_ keeps the bursts in order and is taken before burstMutex_.
+    static constexpr int MaxBurstWindows = 20;
+    std::mutex burstApplyMutex_;
+    std::mutex burstMutex_;
+    std::condition_variable burstCondition_;
+    std::chrono::milliseconds burstWindow_{0};
+    std::vector<QueuedNotification> burstQueue_;
+    std::chrono::steady_clock::time_point burstLastArrivalAt_;
+    bool burstStopping_ = false;
+    std::thread burstThread_;
 };
 }
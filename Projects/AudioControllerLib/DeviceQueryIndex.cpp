@@ -0,0 +1,267 @@
+#include "stdafx.h"
+
+#include "DeviceQueryIndex.h"
+
+#include <algorithm>
+#include <cwctype>
+
+
+namespace
+{
+bool HasFlow(DeviceFlowEnum deviceFlow, DeviceFlowEnum flow)
+{
+    // Render and Capture are bits of RenderAndCapture
+    return (static_cast<uint8_t>(deviceFlow) & static_cast<uint8_t>(flow)) == static_cast<uint8_t>(flow);
+}
+
+template <typename TIterator>
+size_t CountUpTo(TIterator begin, TIterator end, size_t limit)
+{
+    size_t count = 0;
+    for (; begin != end && count < limit; ++begin)
+    {
+        ++count;
+    }
+    return count;
+}
+}
+
+void ed::audio::DeviceQueryIndex::Insert(const TEntry & entry)
+{
+    const auto & device = entry.second;
+    byFlow_.emplace(device.GetFlow(), &entry);
+    byFormFactor_.emplace(device.GetFormFactor(), &entry);
+    for (auto & foldedName : GetFoldedNames(device))
+    {
+        byFoldedName_.emplace(std::move(foldedName), &entry);
+    }
+    if (HasFlow(device.GetFlow(), DeviceFlowEnum::Render))
+    {
+        byRenderVolume_.emplace(device.GetCurrentRenderVolume(), &entry);
+    }
+    if (HasFlow(device.GetFlow(), DeviceFlowEnum::Capture))
+    {
+        byCaptureVolume_.emplace(device.GetCurrentCaptureVolume(), &entry);
+    }
+}
+
+void ed::audio::DeviceQueryIndex::Erase(const TEntry & entry)
+{
+    const auto & device = entry.second;
+    byFlow_.erase({device.GetFlow(), &entry});
+    byFormFactor_.erase({device.GetFormFactor(), &entry});
+    for (auto & foldedName : GetFoldedNames(device))
+    {
+        byFoldedName_.erase({std::move(foldedName), &entry});
+    }
+    byRenderVolume_.erase({device.GetCurrentRenderVolume(), &entry});
+    byCaptureVolume_.erase({device.GetCurrentCaptureVolume(), &entry});
+}
+
+void ed::audio::DeviceQueryIndex::Clear()
+{
+    byFlow_.clear();
+    byFormFactor_.clear();
+    byFoldedName_.clear();
+    byRenderVolume_.clear();
+    byCaptureVolume_.clear();
+}
+
+void ed::audio::DeviceQueryIndex::UpdateVolume(const TEntry & entry, DeviceFlowEnum flow, uint16_t oldVolume)
+{
+    const auto isCapture = flow == DeviceFlowEnum::Capture;
+    auto & index = isCapture ? byCaptureVolume_ : byRenderVolume_;
+    const auto found = index.find({oldVolume, &entry});
+    if (found == index.end())
+    {
+        return;
+    }
+    // Re-keyed in its node
+    auto node = index.extract(found);
+    node.value().first = isCapture ? entry.second.GetCurrentCaptureVolume() : entry.second.GetCurrentRenderVolume();
+    index.insert(std::move(node));
+}
+
+std::vector<const ed::audio::DeviceQueryIndex::TEntry*> ed::audio::DeviceQueryIndex::Find(const DeviceQuery & query) const
+{
+    const auto foldedPrefix = FoldCase(query.NamePrefix);
+    const auto isVolumeQueried = query.MinVolume != 0 || query.MaxVolume != UINT16_MAX;
+    if (query.MinVolume > query.MaxVolume)
+    {
+        return {};
+    }
+
+    // The ranges of every queried criterion; all devices if none
+    std::vector<std::pair<TIndex<DeviceFlowEnum>::const_iterator, TIndex<DeviceFlowEnum>::const_iterator>> flowRanges;
+    for (const auto flow : {DeviceFlowEnum::None, DeviceFlowEnum::Render, DeviceFlowEnum::Capture, DeviceFlowEnum::RenderAndCapture})
+    {
+        if (query.Flow == DeviceFlowEnum::None || (flow != DeviceFlowEnum::None && HasFlow(flow, query.Flow)))
+        {
+            flowRanges.emplace_back(byFlow_.lower_bound({flow, nullptr}),
+                                    byFlow_.lower_bound({static_cast<DeviceFlowEnum>(static_cast<uint8_t>(flow) + 1), nullptr}));
+        }
+    }
+    auto formFactorBegin = byFormFactor_.end();
+    auto formFactorEnd = byFormFactor_.end();
+    if (query.FormFactor)
+    {
+        formFactorBegin = byFormFactor_.lower_bound({*query.FormFactor, nullptr});
+        formFactorEnd = byFormFactor_.lower_bound({static_cast<DeviceFormFactor>(static_cast<uint8_t>(*query.FormFactor) + 1), nullptr});
+    }
+    auto nameBegin = byFoldedName_.end();
+    auto nameEnd = byFoldedName_.end();
+    if (!foldedPrefix.empty())
+    {
+        nameBegin = byFoldedName_.lower_bound({foldedPrefix, nullptr});
+        // The first name not starting with the prefix any more
+        if (auto successor = foldedPrefix; successor.back() != WCHAR_MAX)
+        {
+            ++successor.back();
+            nameEnd = byFoldedName_.lower_bound({successor, nullptr});
+        }
+    }
+    const auto & volumes = query.Flow == DeviceFlowEnum::Capture ? byCaptureVolume_ : byRenderVolume_;
+    auto volumeBegin = volumes.end();
+    auto volumeEnd = volumes.end();
+    if (isVolumeQueried)
+    {
+        volumeBegin = volumes.lower_bound({query.MinVolume, nullptr});
+        if (query.MaxVolume != UINT16_MAX)
+        {
+            volumeEnd = volumes.lower_bound({static_cast<uint16_t>(query.MaxVolume + 1), nullptr});
+        }
+    }
+
+    // Walks the shortest range of the queried criteria; counting stops at the shortest one so far
+    enum class Walked : uint8_t { Flow, FormFactor, Name, Volume };
+    auto walked = Walked::Flow;
+    auto shortest = SIZE_MAX;
+    if (query.FormFactor)
+    {
+        walked = Walked::FormFactor;
+        shortest = CountUpTo(formFactorBegin, formFactorEnd, shortest);
+    }
+    if (!foldedPrefix.empty())
+    {
+        if (const auto count = CountUpTo(nameBegin, nameEnd, shortest); count < shortest)
+        {
+            walked = Walked::Name;
+            shortest = count;
+        }
+    }
+    if (isVolumeQueried)
+    {
+        if (const auto count = CountUpTo(volumeBegin, volumeEnd, shortest); count < shortest)
+        {
+            walked = Walked::Volume;
+            shortest = count;
+        }
+    }
+    if (query.Flow != DeviceFlowEnum::None && walked != Walked::Flow)
+    {
+        size_t count = 0;
+        for (const auto & [begin, end] : flowRanges)
+        {
+            count += CountUpTo(begin, end, shortest - count);
+        }
+        if (count < shortest)
+        {
+            walked = Walked::Flow;
+        }
+    }
+
+    std::vector<const TEntry*> found;
+    const auto collect = [&found, &query](auto begin, auto end, const std::wstring & uncheckedPrefix)
+    {
+        for (; begin != end; ++begin)
+        {
+            if (IsMatching(*begin->second, query, uncheckedPrefix))
+            {
+                found.push_back(begin->second);
+            }
+        }
+    };
+    switch (walked)
+    {
+    case Walked::FormFactor:
+        collect(formFactorBegin, formFactorEnd, foldedPrefix);
+        break;
+    case Walked::Name:
+        // Their names start with the prefix
+        collect(nameBegin, nameEnd, std::wstring());
+        break;
+    case Walked::Volume:
+        collect(volumeBegin, volumeEnd, foldedPrefix);
+        break;
+    default:
+        for (const auto & [begin, end] : flowRanges)
+        {
+            collect(begin, end, foldedPrefix);
+        }
+        break;
+    }
+
+    // A merged device may be found by the names of both its endpoints
+    std::ranges::sort(found, [](const TEntry * left, const TEntry * right) { return left->first < right->first; });
+    found.erase(std::ranges::unique(found).begin(), found.end());
+    return found;
+}
+
+/*static*/
+bool ed::audio::DeviceQueryIndex::IsMatching(const TEntry & entry, const DeviceQuery & query)
+{
+    return IsMatching(entry, query, FoldCase(query.NamePrefix));
+}
+
+/*static*/
+bool ed::audio::DeviceQueryIndex::IsMatching(const TEntry & entry, const DeviceQuery & query, const std::wstring & foldedPrefix)
+{
+    const auto & device = entry.second;
+    if (!query.PnpId.empty() && entry.first != query.PnpId)
+    {
+        return false;
+    }
+    if (query.Flow != DeviceFlowEnum::None && !HasFlow(device.GetFlow(), query.Flow))
+    {
+        return false;
+    }
+    if (query.MinVolume != 0 || query.MaxVolume != UINT16_MAX)
+    {
+        const auto isCapture = query.Flow == DeviceFlowEnum::Capture;
+        if (!HasFlow(device.GetFlow(), isCapture ? DeviceFlowEnum::Capture : DeviceFlowEnum::Render))
+        {
+            return false;
+        }
+        const auto volume = isCapture ? device.GetCurrentCaptureVolume() : device.GetCurrentRenderVolume();
+        if (volume < query.MinVolume || volume > query.MaxVolume)
+        {
+            return false;
+        }
+    }
+    if ((query.FormFactor && device.GetFormFactor() != *query.FormFactor)
+        || (query.JackConnection && device.GetJackConnection() != *query.JackConnection))
+    {
+        return false;
+    }
+    return foldedPrefix.empty() || std::ranges::any_of(GetFoldedNames(device),
+        [&foldedPrefix](const std::wstring & foldedName) { return foldedName.starts_with(foldedPrefix); });
+}
+
+/*static*/
+std::wstring ed::audio::DeviceQueryIndex::FoldCase(std::wstring_view text)
+{
+    std::wstring folded(text);
+    std::ranges::transform(folded, folded.begin(), [](wchar_t ch) { return static_cast<wchar_t>(std::towupper(ch)); });
+    return folded;
+}
+
+/*static*/
+std::set<std::wstring> ed::audio::DeviceQueryIndex::GetFoldedNames(const Device & device)
+{
+    std::set<std::wstring> foldedNames;
+    for (const auto & name : Split(device.GetName(), L'/'))
+    {
+        foldedNames.insert(FoldCase(name));
+    }
+    return foldedNames;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../AudioController/AudioControlInterface.h"
+#include "Device.h"
+
+
+namespace ed::audio {
+// Secondary indexes of the device map of a collection, see DeviceCollectionInterface::FindDevices.
+// They refer to the map entries, which std::map keeps in place, and are kept up to date by the
+// collection with every change of its map: Erase() before an entry changes, Insert() after, or
+// UpdateVolume() after a volume has changed in place, which allocates nothing.
+class DeviceQueryIndex final {
+public:
+    using TEntry = std::pair<const std::wstring, Device>;
+
+    DISALLOW_COPY_MOVE(DeviceQueryIndex);
+    DeviceQueryIndex() = default;
+    ~DeviceQueryIndex() = default;
+
+public:
+    void Insert(const TEntry & entry);
+    void Erase(const TEntry & entry);
+    void Clear();
+    // flow is Render or Capture, the volume that has changed from oldVolume
+    void UpdateVolume(const TEntry & entry, DeviceFlowEnum flow, uint16_t oldVolume);
+
+    // Ordered by plug-and-play id. Walks the range of the most selective criterion only, checking the others per entry.
+    // The plug-and-play id is not indexed here, the device map is: look the entry up there and check it by IsMatching().
+    [[nodiscard]] std::vector<const TEntry*> Find(const DeviceQuery & query) const;
+    [[nodiscard]] static bool IsMatching(const TEntry & entry, const DeviceQuery & query);
+
+    // Upper case, as compared by FindSubstrCaseInsensitive
+    [[nodiscard]] static std::wstring FoldCase(std::wstring_view text);
+
+private:
+    // Ordered by the key, then by the plug-and-play id, so an entry is found and erased in logarithmic time
+    template <typename TKey>
+    struct KeyLess {
+        bool operator()(const std::pair<TKey, const TEntry*> & left, const std::pair<TKey, const TEntry*> & right) const
+        {
+            if (left.first != right.first)
+            {
+                return left.first < right.first;
+            }
+            return right.second != nullptr && (left.second == nullptr || left.second->first < right.second->first);
+        }
+    };
+    template <typename TKey>
+    using TIndex = std::set<std::pair<TKey, const TEntry*>, KeyLess<TKey>>;
+
+    [[nodiscard]] static bool IsMatching(const TEntry & entry, const DeviceQuery & query, const std::wstring & foldedPrefix);
+    // The case-folded names of the endpoints of a possibly merged device
+    [[nodiscard]] static std::set<std::wstring> GetFoldedNames(const Device & device);
+
+private:
+    TIndex<DeviceFlowEnum> byFlow_;
+    TIndex<DeviceFormFactor> byFormFactor_;
+    TIndex<std::wstring> byFoldedName_;
+    // Of the devices having the flow only
+    TIndex<uint16_t> byRenderVolume_;
+    TIndex<uint16_t> byCaptureVolume_;
+};
+}
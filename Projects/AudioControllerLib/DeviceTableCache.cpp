@@ -0,0 +1,199 @@
+#include "stdafx.h"
+
+#include "DeviceTableCache.h"
+
+#include <array>
+#include <filesystem>
+
+#include "../AudioController/AudioSnapshotLayout.h"
+
+
+namespace
+{
+    struct CacheHeader {
+        UINT32 Magic;
+        UINT32 Version;
+        UINT32 RecordSize;
+        UINT32 Count;
+        UINT32 Checksum;
+        UINT32 Reserved;
+    };
+
+    using CacheRecord = AcSnapshotDevice;
+
+    UINT32 Crc32(const void * data, size_t size)
+    {
+        static const auto table = []
+        {
+            std::array<UINT32, 256> t{};
+            for (UINT32 i = 0; i < t.size(); ++i)
+            {
+                UINT32 c = i;
+                for (int k = 0; k < 8; ++k)
+                {
+                    c = (c & 1) != 0 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                t[i] = c;
+            }
+            return t;
+        }();
+
+        UINT32 crc = 0xFFFFFFFFu;
+        const auto * bytes = static_cast<const BYTE*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            crc = table[(crc ^ bytes[i]) & 0xFFu] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    class MappedFile {
+    public:
+        DISALLOW_COPY_MOVE(MappedFile);
+        MappedFile() = default;
+
+        ~MappedFile()
+        {
+            if (view_ != nullptr)
+            {
+                UnmapViewOfFile(view_);
+            }
+            if (mapping_ != nullptr)
+            {
+                CloseHandle(mapping_);
+            }
+            if (file_ != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(file_);
+            }
+        }
+
+        bool Open(const std::wstring & path, bool write, DWORD size)
+        {
+            file_ = CreateFileW(path.c_str(), write ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                                write ? 0 : FILE_SHARE_READ, nullptr, write ? CREATE_ALWAYS : OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file_ == INVALID_HANDLE_VALUE)
+            {
+                return false;
+            }
+            if (!write)
+            {
+                LARGE_INTEGER fileSize;
+                if (!GetFileSizeEx(file_, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(CacheHeader))
+                    || fileSize.HighPart != 0)
+                {
+                    return false;
+                }
+                size = fileSize.LowPart;
+            }
+            mapping_ = CreateFileMappingW(file_, nullptr, write ? PAGE_READWRITE : PAGE_READONLY, 0, size, nullptr);
+            if (mapping_ == nullptr)
+            {
+                return false;
+            }
+            view_ = MapViewOfFile(mapping_, write ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+            size_ = size;
+            return view_ != nullptr;
+        }
+
+        [[nodiscard]] void * View() const { return view_; }
+        [[nodiscard]] DWORD Size() const { return size_; }
+
+    private:
+        HANDLE file_ = INVALID_HANDLE_VALUE;
+        HANDLE mapping_ = nullptr;
+        void * view_ = nullptr;
+        DWORD size_ = 0;
+    };
+}
+
+ed::audio::DeviceTableCache::DeviceTableCache(std::wstring filePath)
+    : filePath_(std::move(filePath))
+{
+}
+
+bool ed::audio::DeviceTableCache::Load(std::vector<Device> & devices) const
+{
+    devices.clear();
+    MappedFile file;
+    if (!file.Open(filePath_, false, 0))
+    {
+        return false;
+    }
+    const auto * header = static_cast<const CacheHeader*>(file.View());
+    if (header->Magic != Magic || header->Version != Version || header->RecordSize != sizeof(CacheRecord)
+        || sizeof(CacheHeader) + static_cast<size_t>(header->Count) * sizeof(CacheRecord) != file.Size())
+    {
+        return false;
+    }
+    const auto * records = reinterpret_cast<const CacheRecord*>(header + 1);
+    if (Crc32(records, header->Count * sizeof(CacheRecord)) != header->Checksum)
+    {
+        return false;
+    }
+
+    devices.reserve(header->Count);
+    for (UINT32 i = 0; i < header->Count; ++i)
+    {
+        const auto & record = records[i];
+        devices.emplace_back(
+            std::wstring(record.Guid, wcsnlen(record.Guid, _countof(record.Guid))),
+            std::wstring(record.Name, wcsnlen(record.Name, _countof(record.Name))),
+            static_cast<DeviceFlowEnum>(record.Flow),
+            record.RenderVolume,
+            record.CaptureVolume,
+            static_cast<DeviceFormFactor>(record.FormFactor),
+            static_cast<DeviceJackConnection>(record.JackConnection));
+    }
+    return true;
+}
+
+bool ed::audio::DeviceTableCache::Save(const std::vector<Device> & devices) const
+{
+    std::error_code errorCode;
+    std::filesystem::create_directories(std::filesystem::path(filePath_).parent_path(), errorCode);
+
+    const auto size = static_cast<DWORD>(sizeof(CacheHeader) + devices.size() * sizeof(CacheRecord));
+    MappedFile file;
+    if (!file.Open(filePath_, true, size))
+    {
+        return false;
+    }
+    auto * header = static_cast<CacheHeader*>(file.View());
+    auto * records = reinterpret_cast<CacheRecord*>(header + 1);
+    for (size_t i = 0; i < devices.size(); ++i)
+    {
+        auto & record = records[i];
+        record = {};
+        wcsncpy_s(record.Guid, _countof(record.Guid), devices[i].GetPnpId().c_str(), _TRUNCATE);
+        wcsncpy_s(record.Name, _countof(record.Name), devices[i].GetName().c_str(), _TRUNCATE);
+        record.Flow = static_cast<UINT8>(devices[i].GetFlow());
+        record.RenderVolume = devices[i].GetCurrentRenderVolume();
+        record.CaptureVolume = devices[i].GetCurrentCaptureVolume();
+        record.FormFactor = static_cast<UINT8>(devices[i].GetFormFactor());
+        record.JackConnection = static_cast<UINT8>(devices[i].GetJackConnection());
+    }
+    *header = {};
+    header->Magic = Magic;
+    header->Version = Version;
+    header->RecordSize = sizeof(CacheRecord);
+    header->Count = static_cast<UINT32>(devices.size());
+    header->Checksum = Crc32(records, devices.size() * sizeof(CacheRecord));
+    return FlushViewOfFile(file.View(), size) != FALSE;
+}
+
+const std::wstring & ed::audio::DeviceTableCache::GetFilePath() const
+{
+    return filePath_;
+}
+
+std::wstring ed::audio::DeviceTableCache::GetDefaultFilePath()
+{
+    wchar_t buffer[MAX_PATH];
+    if (const auto len = GetEnvironmentVariableW(L"LOCALAPPDATA", buffer, MAX_PATH); len == 0 || len >= MAX_PATH)
+    {
+        return {};
+    }
+    return (std::filesystem::path(buffer) / L"PnPAudioCheck" / L"DeviceTable.cache").wstring();
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Device.h"
+
+
+namespace ed::audio {
+// Persists the last reconciled device table in a small memory-mapped file.
+// The file is versioned and CRC32-checksummed; anything unexpected is treated as "no cache".
+class DeviceTableCache final {
+public:
+    static constexpr UINT32 Magic = 0x43444341u; // "ACDC"
+    static constexpr UINT32 Version = 2u;
+
+    explicit DeviceTableCache(std::wstring filePath);
+
+    [[nodiscard]] bool Load(std::vector<Device> & devices) const;
+    [[nodiscard]] bool Save(const std::vector<Device> & devices) const;
+    [[nodiscard]] const std::wstring & GetFilePath() const;
+
+    // %LOCALAPPDATA%\PnPAudioCheck\DeviceTable.cache
+    [[nodiscard]] static std::wstring GetDefaultFilePath();
+
+private:
+    std::wstring filePath_;
+};
+}
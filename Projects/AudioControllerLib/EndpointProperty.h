@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+
+#include <mmdeviceapi.h>
+
+
+namespace ed::audio {
+// The properties of an endpoint a Device keeps that may change while the endpoint is active; OnPropertyValueChanged
+// refreshes just the one changed. The container id is left out: an endpoint does not move to another container.
+enum class EndpointProperty : uint8_t {
+    None = 0,
+    FriendlyName,
+    FormFactor
+};
+
+// PKEY_Device_FriendlyName and PKEY_AudioEndpoint_FormFactor, repeated here as the SDK headers define them
+// only together with INITGUID
+constexpr PROPERTYKEY FriendlyNameKey = {
+    {0xa45c254e, 0xdf1c, 0x4efd, {0x80, 0x20, 0x67, 0xd1, 0x46, 0xa8, 0x50, 0xe0}}, 14
+};
+constexpr PROPERTYKEY AudioEndpointFormFactorKey = {
+    {0x1da5d803, 0xd492, 0x4edd, {0x8c, 0x23, 0xe0, 0xc0, 0xff, 0xee, 0x7f, 0x0e}}, 0
+};
+
+// None for a property a Device does not keep
+inline EndpointProperty GetEndpointProperty(const PROPERTYKEY & key)
+{
+    if (key.fmtid == FriendlyNameKey.fmtid && key.pid == FriendlyNameKey.pid)
+    {
+        return EndpointProperty::FriendlyName;
+    }
+    if (key.fmtid == AudioEndpointFormFactorKey.fmtid && key.pid == AudioEndpointFormFactorKey.pid)
+    {
+        return EndpointProperty::FormFactor;
+    }
+    return EndpointProperty::None;
+}
+
+inline PROPERTYKEY GetPropertyKey(EndpointProperty property)
+{
+    switch (property)
+    {
+    case EndpointProperty::FriendlyName:
+        return FriendlyNameKey;
+    case EndpointProperty::FormFactor:
+        return AudioEndpointFormFactorKey;
+    case EndpointProperty::None:
+    default: // NOLINT(clang-diagnostic-covered-switch-default)
+        return {};
+    }
+}
+}
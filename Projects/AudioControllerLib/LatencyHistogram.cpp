@@ -0,0 +1,73 @@
+#include "stdafx.h"
+
+#include "LatencyHistogram.h"
+
+#include <bit>
+
+
+void ed::audio::LatencyHistogram::Record(std::chrono::nanoseconds latency)
+{
+    const auto value = static_cast<uint64_t>((std::max)(latency.count(), std::chrono::nanoseconds::rep{0}));
+    buckets_[GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    for (auto max = max_.load(std::memory_order_relaxed);
+         value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed);)
+    {
+    }
+}
+
+LatencySummary ed::audio::LatencyHistogram::GetSummary() const
+{
+    // Counts are read one by one while recording goes on; the summary is consistent in itself
+    std::array<uint64_t, BucketCount> counts;
+    uint64_t total = 0;
+    for (size_t i = 0; i < BucketCount; ++i)
+    {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    LatencySummary summary;
+    summary.Count = total;
+    if (total == 0)
+    {
+        return summary;
+    }
+    summary.Mean = std::chrono::nanoseconds(sum_.load(std::memory_order_relaxed) / (std::max)(count_.load(std::memory_order_relaxed), uint64_t{1}));
+    summary.Max = std::chrono::nanoseconds(max_.load(std::memory_order_relaxed));
+
+    const std::array<std::pair<double, std::chrono::nanoseconds*>, 4> percentiles = {{
+        {0.50, &summary.P50}, {0.90, &summary.P90}, {0.99, &summary.P99}, {0.999, &summary.P999}
+    }};
+    size_t next = 0;
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < BucketCount && next < percentiles.size(); ++i)
+    {
+        cumulative += counts[i];
+        while (next < percentiles.size()
+            && static_cast<double>(cumulative) >= percentiles[next].first * static_cast<double>(total))
+        {
+            // Never above the exact maximum
+            *percentiles[next].second = (std::min)(std::chrono::nanoseconds(GetBucketUpperBound(i)), summary.Max);
+            ++next;
+        }
+    }
+    return summary;
+}
+
+/*static*/
+size_t ed::audio::LatencyHistogram::GetBucketIndex(uint64_t value)
+{
+    const auto magnitude = static_cast<unsigned>(std::bit_width(value));
+    const auto shift = magnitude > SubBucketBits + 1 ? magnitude - SubBucketBits - 1 : 0u;
+    return static_cast<size_t>(shift) * SubBucketCount + static_cast<size_t>(value >> shift);
+}
+
+/*static*/
+uint64_t ed::audio::LatencyHistogram::GetBucketUpperBound(size_t index)
+{
+    const auto shift = index >= 2 * SubBucketCount ? index / SubBucketCount - 1 : size_t{0};
+    const auto mantissa = static_cast<uint64_t>(index - shift * SubBucketCount);
+    return ((mantissa + 1) << shift) - 1;
+}
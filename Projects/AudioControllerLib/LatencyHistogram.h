@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+#include "../AudioController/AudioControlInterface.h"
+
+
+namespace ed::audio {
+// Log-linear (HDR-style) histogram of nanosecond latencies: 32 sub-buckets per power of two,
+// i.e. about 3% relative precision over the whole range. Recording is lock-free, a bit scan
+// and a few relaxed atomic increments, so it can stay on in production.
+class LatencyHistogram final {
+public:
+    DISALLOW_COPY_MOVE(LatencyHistogram);
+    LatencyHistogram() = default;
+    ~LatencyHistogram() = default;
+
+public:
+    void Record(std::chrono::nanoseconds latency);
+    [[nodiscard]] LatencySummary GetSummary() const;
+
+    [[nodiscard]] static size_t GetBucketIndex(uint64_t value);
+    // The highest value falling into the bucket
+    [[nodiscard]] static uint64_t GetBucketUpperBound(size_t index);
+
+private:
+    static constexpr unsigned SubBucketBits = 5;
+    static constexpr size_t SubBucketCount = size_t{1} << SubBucketBits;
+    // Values below 2 * SubBucketCount get a bucket each, every higher power of two SubBucketCount buckets
+    static constexpr size_t BucketCount = 2 * SubBucketCount + (64 - SubBucketBits - 1) * SubBucketCount;
+
+    std::array<std::atomic<uint64_t>, BucketCount> buckets_{};
+    std::atomic<uint64_t> count_ = 0;
+    std::atomic<uint64_t> sum_ = 0;
+    std::atomic<uint64_t> max_ = 0;
+};
+
+// Records the time from its construction to its destruction.
+class ScopedLatency final {
+public:
+    DISALLOW_COPY_MOVE(ScopedLatency);
+    explicit ScopedLatency(LatencyHistogram & histogram)
+        : histogram_(histogram)
+        , startedAt_(std::chrono::steady_clock::now())
+    {
+    }
+    ~ScopedLatency()
+    {
+        histogram_.Record(std::chrono::steady_clock::now() - startedAt_);
+    }
+
+private:
+    LatencyHistogram & histogram_;
+    const std::chrono::steady_clock::time_point startedAt_;
+};
+}
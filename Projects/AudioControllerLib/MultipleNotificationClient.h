@@ -111,5 +111,11 @@ public:
     {
         return S_OK;
     }
+
+    // Volume notification of a known endpoint, from backends registering one callback per endpoint
+    virtual HRESULT OnEndpointVolumeNotify(LPCWSTR endpointId, PAUDIO_VOLUME_NOTIFICATION_DATA pNotify)
+    {
+        return OnNotify(pNotify);
+    }
 };
 }
@@ -0,0 +1,35 @@
+#include "stdafx.h"
+
+#include "NotificationArena.h"
+
+
+ed::audio::NotificationArena::NotificationArena() noexcept
+{
+    ++GetThreadArena().Depth;
+}
+
+ed::audio::NotificationArena::~NotificationArena()
+{
+    if (auto & arena = GetThreadArena(); --arena.Depth == 0)
+    {
+        // Hands the heap blocks back and starts over at the beginning of the buffer
+        arena.Resource.release();
+    }
+}
+
+/*static*/
+std::pmr::memory_resource * ed::audio::NotificationArena::GetCurrentResource() noexcept
+{
+    if (auto & arena = GetThreadArena(); arena.Depth > 0)
+    {
+        return &arena.Resource;
+    }
+    return std::pmr::get_default_resource();
+}
+
+/*static*/
+ed::audio::NotificationArena::ThreadArena & ed::audio::NotificationArena::GetThreadArena() noexcept
+{
+    thread_local ThreadArena arena;
+    return arena;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <sstream>
+
+#include "../AudioController/ClassDefHelper.h"
+
+
+namespace ed::audio {
+// Monotonic arena for the transient state of one notification-handling pass, e.g. split device names
+// and trace lines. Each thread has a fixed buffer; beyond it the arena grows from the heap. Everything
+// is released at once when the outermost pass on the thread ends, so the objects allocated from the arena
+// must not outlive it. Nested passes, e.g. a state change handled as an addition, share the arena.
+class NotificationArena final {
+public:
+    DISALLOW_COPY_MOVE(NotificationArena);
+    NotificationArena() noexcept;
+    ~NotificationArena();
+
+    // The arena of the pass running on this thread; outside of a pass, the default resource
+    [[nodiscard]] static std::pmr::memory_resource * GetCurrentResource() noexcept;
+
+private:
+    static constexpr size_t BufferSize = 16 * 1024;
+
+    struct ThreadArena {
+        alignas(std::max_align_t) std::byte Buffer[BufferSize];
+        std::pmr::monotonic_buffer_resource Resource{Buffer, BufferSize, std::pmr::new_delete_resource()};
+        unsigned Depth = 0;
+    };
+
+    static ThreadArena & GetThreadArena() noexcept;
+};
+
+// Formats a trace line in the current arena
+using ArenaWideStringStream = std::basic_ostringstream<wchar_t, std::char_traits<wchar_t>, std::pmr::polymorphic_allocator<wchar_t>>;
+}
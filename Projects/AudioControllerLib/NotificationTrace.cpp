@@ -0,0 +1,259 @@
+#include "stdafx.h"
+
+#include "NotificationTrace.h"
+
+#include <filesystem>
+#include <stdexcept>
+
+
+namespace
+{
+    constexpr uint8_t SucceededFlag = 0x01;
+    constexpr uint8_t MutedFlag = 0x02;
+
+    template <class T>
+    void Put(std::vector<char> & buffer, const T & value)
+    {
+        const auto * bytes = reinterpret_cast<const char*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    void PutString(std::vector<char> & buffer, const std::wstring & value)
+    {
+        const auto length = static_cast<UINT16>((std::min)(value.size(), size_t{UINT16_MAX}));
+        Put(buffer, length);
+        for (size_t i = 0; i < length; ++i)
+        {
+            Put(buffer, static_cast<UINT16>(value[i]));
+        }
+    }
+
+    void PutFacts(std::vector<char> & buffer, const ed::audio::Device & facts)
+    {
+        PutString(buffer, facts.GetPnpId());
+        PutString(buffer, facts.GetName());
+        Put(buffer, static_cast<uint8_t>(facts.GetFlow()));
+        Put(buffer, facts.GetCurrentRenderVolume());
+        Put(buffer, facts.GetCurrentCaptureVolume());
+        Put(buffer, static_cast<uint8_t>(facts.GetFormFactor()));
+        Put(buffer, static_cast<uint8_t>(facts.GetJackConnection()));
+    }
+
+    class TraceInput {
+    public:
+        explicit TraceInput(std::ifstream & stream) : stream_(stream) {}
+
+        template <class T>
+        bool Get(T & value)
+        {
+            return static_cast<bool>(stream_.read(reinterpret_cast<char*>(&value), sizeof(T)));
+        }
+
+        bool GetString(std::wstring & value)
+        {
+            UINT16 length = 0;
+            if (!Get(length))
+            {
+                return false;
+            }
+            value.resize(length);
+            for (auto & ch : value)
+            {
+                UINT16 codeUnit = 0;
+                if (!Get(codeUnit))
+                {
+                    return false;
+                }
+                ch = static_cast<wchar_t>(codeUnit);
+            }
+            return true;
+        }
+
+        bool GetFacts(UINT32 version, ed::audio::Device & facts)
+        {
+            std::wstring pnpId;
+            std::wstring name;
+            uint8_t flow = 0;
+            uint16_t renderVolume = 0;
+            uint16_t captureVolume = 0;
+            auto formFactor = static_cast<uint8_t>(DeviceFormFactor::Unknown);
+            auto jackConnection = static_cast<uint8_t>(DeviceJackConnection::Unknown);
+            const auto complete = GetString(pnpId) && GetString(name) && Get(flow) && Get(renderVolume) && Get(captureVolume)
+                && (version < 3u || (Get(formFactor) && Get(jackConnection)));
+            facts = ed::audio::Device(std::move(pnpId), std::move(name), static_cast<DeviceFlowEnum>(flow), renderVolume, captureVolume,
+                                      static_cast<DeviceFormFactor>(formFactor), static_cast<DeviceJackConnection>(jackConnection));
+            return complete;
+        }
+
+    private:
+        std::ifstream & stream_;
+    };
+}
+
+
+ed::audio::NotificationTraceWriter::~NotificationTraceWriter()
+{
+    std::lock_guard lock(mutex_);
+    stream_.flush();
+}
+
+ed::audio::NotificationTraceWriter::NotificationTraceWriter(const std::wstring & filePath)
+    : stream_(std::filesystem::path(filePath), std::ios::binary | std::ios::trunc)
+    , startedAt_(std::chrono::steady_clock::now())
+{
+    if (!stream_)
+    {
+        std::ostringstream os; os << "Can not create the notification trace file, error " << GetLastError() << ".";
+        throw std::runtime_error(os.str());
+    }
+    Put(buffer_, Magic);
+    Put(buffer_, Version);
+    stream_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+}
+
+void ed::audio::NotificationTraceWriter::Write(TraceRecord record)
+{
+    std::lock_guard lock(mutex_);
+    record.Timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startedAt_).count();
+
+    buffer_.clear();
+    Put(buffer_, static_cast<INT64>(record.Timestamp));
+    Put(buffer_, static_cast<uint8_t>(record.Kind));
+    Put(buffer_, static_cast<uint8_t>((record.Succeeded ? SucceededFlag : 0) | (record.Muted ? MutedFlag : 0)));
+    switch (record.Kind)
+    {
+    case TraceRecordKind::DeviceAdded:
+    case TraceRecordKind::DeviceRemoved:
+        PutString(buffer_, record.EndpointId);
+        break;
+    case TraceRecordKind::DeviceStateChanged:
+        PutString(buffer_, record.EndpointId);
+        Put(buffer_, static_cast<UINT32>(record.State));
+        break;
+    case TraceRecordKind::VolumeNotify:
+        Put(buffer_, record.MasterVolume);
+        PutString(buffer_, record.EndpointId);
+        break;
+    case TraceRecordKind::Enumerated:
+        Put(buffer_, static_cast<UINT32>(record.EndpointIds.size()));
+        for (const auto & endpointId : record.EndpointIds)
+        {
+            PutString(buffer_, endpointId);
+        }
+        break;
+    case TraceRecordKind::Probed:
+        PutString(buffer_, record.EndpointId);
+        PutFacts(buffer_, record.Facts);
+        break;
+    case TraceRecordKind::DefaultDeviceChanged:
+    case TraceRecordKind::DefaultQueried:
+        Put(buffer_, static_cast<uint8_t>(record.Flow));
+        Put(buffer_, static_cast<uint8_t>(record.Role));
+        PutString(buffer_, record.EndpointId);
+        break;
+    case TraceRecordKind::PropertyValueChanged:
+        PutString(buffer_, record.EndpointId);
+        Put(buffer_, static_cast<uint8_t>(record.Property));
+        break;
+    case TraceRecordKind::PropertyRead:
+        PutString(buffer_, record.EndpointId);
+        Put(buffer_, static_cast<uint8_t>(record.Property));
+        PutFacts(buffer_, record.Facts);
+        break;
+    case TraceRecordKind::None:
+    default: // NOLINT(clang-diagnostic-covered-switch-default)
+        return;
+    }
+    stream_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+}
+
+/*static*/
+bool ed::audio::NotificationTraceReader::TryLoad(const std::wstring & filePath, std::vector<TraceRecord> & records)
+{
+    std::ifstream stream(std::filesystem::path(filePath), std::ios::binary);
+    TraceInput input(stream);
+    UINT32 magic = 0;
+    UINT32 version = 0;
+    if (!input.Get(magic) || !input.Get(version)
+        || magic != NotificationTraceWriter::Magic || version < 1u || version > NotificationTraceWriter::Version)
+    {
+        return false;
+    }
+
+    records.clear();
+    for (INT64 timestamp = 0; input.Get(timestamp);)
+    {
+        TraceRecord record;
+        record.Timestamp = timestamp;
+        uint8_t kind = 0;
+        uint8_t flags = 0;
+        if (!input.Get(kind) || !input.Get(flags))
+        {
+            return false;
+        }
+        record.Kind = static_cast<TraceRecordKind>(kind);
+        record.Succeeded = (flags & SucceededFlag) != 0;
+        record.Muted = (flags & MutedFlag) != 0;
+
+        bool complete;
+        switch (record.Kind)
+        {
+        case TraceRecordKind::DeviceAdded:
+        case TraceRecordKind::DeviceRemoved:
+            complete = input.GetString(record.EndpointId);
+            break;
+        case TraceRecordKind::DeviceStateChanged:
+        {
+            UINT32 state = 0;
+            complete = input.GetString(record.EndpointId) && input.Get(state);
+            record.State = state;
+            break;
+        }
+        case TraceRecordKind::VolumeNotify:
+            complete = input.Get(record.MasterVolume) && (version < 2u || input.GetString(record.EndpointId));
+            break;
+        case TraceRecordKind::Enumerated:
+        {
+            UINT32 count = 0;
+            complete = input.Get(count);
+            for (UINT32 i = 0; complete && i < count; ++i)
+            {
+                complete = input.GetString(record.EndpointIds.emplace_back());
+            }
+            break;
+        }
+        case TraceRecordKind::Probed:
+            complete = input.GetString(record.EndpointId) && input.GetFacts(version, record.Facts);
+            break;
+        case TraceRecordKind::DefaultDeviceChanged:
+        case TraceRecordKind::DefaultQueried:
+        {
+            uint8_t flow = 0;
+            uint8_t role = 0;
+            complete = version >= 4u && input.Get(flow) && input.Get(role) && input.GetString(record.EndpointId);
+            record.Flow = static_cast<DeviceFlowEnum>(flow);
+            record.Role = static_cast<DeviceRole>(role);
+            break;
+        }
+        case TraceRecordKind::PropertyValueChanged:
+        case TraceRecordKind::PropertyRead:
+        {
+            uint8_t property = 0;
+            complete = version >= 5u && input.GetString(record.EndpointId) && input.Get(property)
+                && (record.Kind != TraceRecordKind::PropertyRead || input.GetFacts(version, record.Facts));
+            record.Property = static_cast<EndpointProperty>(property);
+            break;
+        }
+        case TraceRecordKind::None:
+        default: // NOLINT(clang-diagnostic-covered-switch-default)
+            complete = false;
+            break;
+        }
+        if (!complete)
+        {
+            return false;
+        }
+        records.push_back(std::move(record));
+    }
+    return true;
+}
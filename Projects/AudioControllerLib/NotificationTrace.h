@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Device.h"
+#include "EndpointProperty.h"
+
+
+namespace ed::audio {
+enum class TraceRecordKind : uint8_t {
+    None = 0,
+    DeviceAdded,
+    DeviceRemoved,
+    DeviceStateChanged,
+    VolumeNotify,
+    // Facts the collection asked the backend for, recorded with their answers
+    Enumerated,
+    Probed,
+    DefaultDeviceChanged,
+    DefaultQueried,
+    PropertyValueChanged,
+    PropertyRead
+};
+
+struct TraceRecord {
+    int64_t Timestamp = 0; // Nanoseconds since the start of the recording
+    TraceRecordKind Kind = TraceRecordKind::None;
+    bool Succeeded = true;
+    std::wstring EndpointId;
+    DWORD State = 0;
+    bool Muted = false;
+    float MasterVolume = 0.0f;
+    std::vector<std::wstring> EndpointIds;
+    Device Facts;
+    // Of the default endpoint, EndpointId, empty if there is none. Flow is RenderAndCapture for eAll.
+    DeviceFlowEnum Flow = DeviceFlowEnum::None;
+    DeviceRole Role = DeviceRole::Console;
+    // Of a property notification and read; None for a property the collection does not keep
+    EndpointProperty Property = EndpointProperty::None;
+
+    [[nodiscard]] bool IsNotification() const
+    {
+        return (Kind >= TraceRecordKind::DeviceAdded && Kind <= TraceRecordKind::VolumeNotify)
+            || Kind == TraceRecordKind::DefaultDeviceChanged || Kind == TraceRecordKind::PropertyValueChanged;
+    }
+};
+
+// Binary notification trace: an 8-byte header ("ACNT", version) followed by records
+// {INT64 timestamp, UINT8 kind, UINT8 flags, kind-specific payload}.
+// Strings are stored as a UINT16 length followed by UTF-16 code units.
+class NotificationTraceWriter final {
+public:
+    static constexpr UINT32 Magic = 0x544E4341u; // "ACNT"
+    // Version 2 adds the endpoint id (empty if unknown) to volume notifications
+    // Version 3 adds the form factor and the jack connection to probe results
+    // Version 4 adds default device notifications and queries
+    // Version 5 adds property notifications and reads
+    static constexpr UINT32 Version = 5u;
+
+    DISALLOW_COPY_MOVE(NotificationTraceWriter);
+    ~NotificationTraceWriter();
+
+public:
+    explicit NotificationTraceWriter(const std::wstring & filePath);
+
+    // Thread-safe; the timestamp is assigned here.
+    void Write(TraceRecord record);
+
+private:
+    std::mutex mutex_;
+    std::ofstream stream_;
+    std::vector<char> buffer_;
+    const std::chrono::steady_clock::time_point startedAt_;
+};
+
+class NotificationTraceReader final {
+public:
+    // False if the file is missing, of an unknown version or truncated.
+    [[nodiscard]] static bool TryLoad(const std::wstring & filePath, std::vector<TraceRecord> & records);
+};
+}
@@ -0,0 +1,100 @@
+#include "stdafx.h"
+
+#include "ObserverIndex.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "CaseInsensitiveSubstr.h"
+
+
+ed::audio::ObserverIndex::ObserverIndex(std::vector<Entry> entries)
+    : entries_(std::move(entries))
+{
+    for (size_t position = 0; position < entries_.size(); ++position)
+    {
+        const auto & [observer, subscription] = entries_[position];
+        auto & lists = subscription.PnpId.empty() ? anyDevice_ : byPnpId_[subscription.PnpId];
+        for (size_t kind = 0; kind < EventKindCount; ++kind)
+        {
+            if ((static_cast<uint8_t>(subscription.Events) & (1u << kind)) != 0)
+            {
+                lists[kind].push_back(position);
+            }
+        }
+        if (subscription.Trace >= TraceLevel::Info)
+        {
+            traceObservers_.push_back(observer);
+        }
+        if (subscription.Trace >= TraceLevel::Debug)
+        {
+            traceDebugObservers_.push_back(observer);
+        }
+    }
+}
+
+ed::audio::ObserverIndex ed::audio::ObserverIndex::With(
+    DeviceCollectionObserverInterface & observer, const DeviceCollectionSubscription & subscription) const
+{
+    auto entries = entries_;
+    if (const auto found = std::ranges::find(entries, &observer, &Entry::Observer); found != entries.end())
+    {
+        found->Subscription = subscription;
+    }
+    else
+    {
+        entries.push_back({&observer, subscription});
+    }
+    return ObserverIndex(std::move(entries));
+}
+
+ed::audio::ObserverIndex ed::audio::ObserverIndex::Without(const DeviceCollectionObserverInterface & observer) const
+{
+    std::vector<Entry> entries;
+    entries.reserve(entries_.size());
+    std::ranges::copy_if(entries_, std::back_inserter(entries), [&observer](const Entry & entry) { return entry.Observer != &observer; });
+    return ObserverIndex(std::move(entries));
+}
+
+bool ed::audio::ObserverIndex::Contains(const DeviceCollectionObserverInterface & observer) const
+{
+    return std::ranges::find(entries_, &observer, &Entry::Observer) != entries_.end();
+}
+
+bool ed::audio::ObserverIndex::IsInterested(DeviceCollectionEvent event, std::wstring_view pnpId, const DeviceInterface & device) const
+{
+    bool isInterested = false;
+    ForEachInterested(event, pnpId, device, [&isInterested](DeviceCollectionObserverInterface &) { isInterested = true; });
+    return isInterested;
+}
+
+const std::vector<DeviceCollectionObserverInterface*> & ed::audio::ObserverIndex::GetTraceObservers(TraceLevel level) const
+{
+    static const std::vector<DeviceCollectionObserverInterface*> none;
+    switch (level)
+    {
+    case TraceLevel::Info:
+        return traceObservers_;
+    case TraceLevel::Debug:
+        return traceDebugObservers_;
+    default:
+        return none;
+    }
+}
+
+/*static*/
+bool ed::audio::ObserverIndex::IsMatching(const DeviceCollectionSubscription & subscription, const DeviceInterface & device)
+{
+    // Render and Capture are bits of RenderAndCapture
+    if (const auto flow = static_cast<uint8_t>(subscription.Flow);
+        flow != 0 && (static_cast<uint8_t>(device.GetFlow()) & flow) != flow)
+    {
+        return false;
+    }
+    if ((subscription.FormFactor && device.GetFormFactor() != *subscription.FormFactor)
+        || (subscription.JackConnection && device.GetJackConnection() != *subscription.JackConnection))
+    {
+        return false;
+    }
+    return subscription.NameFilter.empty() || FindSubstrCaseInsensitive(device.GetName(), subscription.NameFilter);
+}
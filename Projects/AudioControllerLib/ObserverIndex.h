@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../AudioController/AudioControlInterface.h"
+
+
+namespace ed::audio {
+// The observers of a collection with their subscriptions, indexed by event kind and device, so that
+// a dispatch visits the interested observers only. Immutable once built: the collection publishes a
+// changed copy per (un)subscription and dispatches without locking.
+class ObserverIndex final {
+public:
+    ObserverIndex() = default;
+
+public:
+    // A copy with the observer added, or with its subscription replaced
+    [[nodiscard]] ObserverIndex With(DeviceCollectionObserverInterface & observer, const DeviceCollectionSubscription & subscription) const;
+    [[nodiscard]] ObserverIndex Without(const DeviceCollectionObserverInterface & observer) const;
+    [[nodiscard]] bool Contains(const DeviceCollectionObserverInterface & observer) const;
+    [[nodiscard]] size_t GetSize() const { return entries_.size(); }
+
+    // Calls the function with every observer interested in the event of the device, in subscription order
+    template <typename TFunction>
+    void ForEachInterested(DeviceCollectionEvent event, std::wstring_view pnpId, const DeviceInterface & device, TFunction && function) const;
+    [[nodiscard]] bool IsInterested(DeviceCollectionEvent event, std::wstring_view pnpId, const DeviceInterface & device) const;
+    // The observers taking trace lines of the level, Info for OnTrace and Debug for OnTraceDebug
+    [[nodiscard]] const std::vector<DeviceCollectionObserverInterface*> & GetTraceObservers(TraceLevel level) const;
+
+private:
+    static constexpr size_t EventKindCount = 5;
+    // Positions in entries_, ascending, per event kind
+    using TEntryLists = std::array<std::vector<size_t>, EventKindCount>;
+
+    struct Entry {
+        DeviceCollectionObserverInterface * Observer = nullptr;
+        DeviceCollectionSubscription Subscription;
+    };
+
+    explicit ObserverIndex(std::vector<Entry> entries);
+    [[nodiscard]] static bool IsMatching(const DeviceCollectionSubscription & subscription, const DeviceInterface & device);
+
+private:
+    std::vector<Entry> entries_;
+    // Subscriptions of any device, and of one device by its plug-and-play id
+    TEntryLists anyDevice_;
+    std::map<std::wstring, TEntryLists, std::less<>> byPnpId_;
+    std::vector<DeviceCollectionObserverInterface*> traceObservers_;
+    std::vector<DeviceCollectionObserverInterface*> traceDebugObservers_;
+};
+
+template <typename TFunction>
+void ObserverIndex::ForEachInterested(DeviceCollectionEvent event, std::wstring_view pnpId, const DeviceInterface & device, TFunction && function) const
+{
+    if (event == DeviceCollectionEvent::None)
+    {
+        return;
+    }
+    const auto kind = static_cast<size_t>(event) - 1;
+    static const std::vector<size_t> none;
+    const auto & anyDevice = anyDevice_[kind];
+    const auto foundDevice = byPnpId_.find(pnpId);
+    const auto & oneDevice = foundDevice != byPnpId_.end() ? foundDevice->second[kind] : none;
+
+    // Both lists are ascending: merged, they keep the subscription order
+    auto anyIt = anyDevice.begin();
+    auto oneIt = oneDevice.begin();
+    while (anyIt != anyDevice.end() || oneIt != oneDevice.end())
+    {
+        const auto position = oneIt == oneDevice.end() || (anyIt != anyDevice.end() && *anyIt < *oneIt) ? *anyIt++ : *oneIt++;
+        if (const auto & [observer, subscription] = entries_[position]; IsMatching(subscription, device))
+        {
+            function(*observer);
+        }
+    }
+}
+}
@@ -0,0 +1,208 @@
+#include "stdafx.h"
+
+#include "RecordingAudioBackend.h"
+
+
+namespace
+{
+    DeviceFlowEnum ToRecordedFlow(EDataFlow flow)
+    {
+        switch (flow)
+        {
+        case eRender:
+            return DeviceFlowEnum::Render;
+        case eCapture:
+            return DeviceFlowEnum::Capture;
+        default:
+            return DeviceFlowEnum::RenderAndCapture;
+        }
+    }
+}
+
+ed::audio::RecordingAudioBackend::~RecordingAudioBackend()
+{
+    Stop();
+}
+
+ed::audio::RecordingAudioBackend::RecordingAudioBackend(std::unique_ptr<AudioBackendInterface> backend, const std::wstring & traceFilePath)
+    : backend_(std::move(backend))
+    , writer_(traceFilePath)
+    , recordingClient_(*this)
+{
+}
+
+void ed::audio::RecordingAudioBackend::Start(MultipleNotificationClient & client, TraceFunctionT traceFunction,
+                                             TraceOnFunctionT isTraceOn)
+{
+    client_ = &client;
+    backend_->Start(recordingClient_, std::move(traceFunction), std::move(isTraceOn));
+}
+
+void ed::audio::RecordingAudioBackend::Stop()
+{
+    backend_->Stop();
+    client_ = nullptr;
+}
+
+bool ed::audio::RecordingAudioBackend::TryEnumerateActiveEndpoints(bool bothHeadsetAndMicro, std::vector<std::wstring> & endpointIds)
+{
+    const auto succeeded = backend_->TryEnumerateActiveEndpoints(bothHeadsetAndMicro, endpointIds);
+
+    TraceRecord record;
+    record.Kind = TraceRecordKind::Enumerated;
+    record.Succeeded = succeeded;
+    if (succeeded)
+    {
+        record.EndpointIds = endpointIds;
+    }
+    writer_.Write(std::move(record));
+    return succeeded;
+}
+
+bool ed::audio::RecordingAudioBackend::TryProbeEndpoint(const std::wstring & endpointId, Device & device, TVolumeNotificationToken * volumeToken)
+{
+    const auto succeeded = backend_->TryProbeEndpoint(endpointId, device, volumeToken);
+
+    TraceRecord record;
+    record.Kind = TraceRecordKind::Probed;
+    record.Succeeded = succeeded;
+    record.EndpointId = endpointId;
+    if (succeeded)
+    {
+        record.Facts = device;
+    }
+    writer_.Write(std::move(record));
+    return succeeded;
+}
+
+bool ed::audio::RecordingAudioBackend::TryGetDefaultEndpoint(DeviceFlowEnum flow, DeviceRole role, std::wstring & endpointId)
+{
+    const auto succeeded = backend_->TryGetDefaultEndpoint(flow, role, endpointId);
+
+    TraceRecord record;
+    record.Kind = TraceRecordKind::DefaultQueried;
+    record.Succeeded = succeeded;
+    record.Flow = flow;
+    record.Role = role;
+    if (succeeded)
+    {
+        record.EndpointId = endpointId;
+    }
+    writer_.Write(std::move(record));
+    return succeeded;
+}
+
+bool ed::audio::RecordingAudioBackend::TryReadEndpointProperty(const std::wstring & endpointId, EndpointProperty property, Device & device)
+{
+    const auto succeeded = backend_->TryReadEndpointProperty(endpointId, property, device);
+
+    TraceRecord record;
+    record.Kind = TraceRecordKind::PropertyRead;
+    record.Succeeded = succeeded;
+    record.EndpointId = endpointId;
+    record.Property = property;
+    if (succeeded)
+    {
+        record.Facts = device;
+    }
+    writer_.Write(std::move(record));
+    return succeeded;
+}
+
+void ed::audio::RecordingAudioBackend::RegisterVolumeNotification(const std::wstring & endpointId, TVolumeNotificationToken volumeToken)
+{
+    backend_->RegisterVolumeNotification(endpointId, std::move(volumeToken));
+}
+
+void ed::audio::RecordingAudioBackend::UnregisterVolumeNotification(const std::wstring & endpointId)
+{
+    backend_->UnregisterVolumeNotification(endpointId);
+}
+
+void ed::audio::RecordingAudioBackend::UnregisterAllVolumeNotifications()
+{
+    backend_->UnregisterAllVolumeNotifications();
+}
+
+size_t ed::audio::RecordingAudioBackend::GetVolumeNotificationCount() const
+{
+    return backend_->GetVolumeNotificationCount();
+}
+
+ed::audio::RecordingAudioBackend::RecordingClient::RecordingClient(RecordingAudioBackend & owner)
+    : owner_(owner)
+{
+}
+
+HRESULT ed::audio::RecordingAudioBackend::RecordingClient::OnDeviceStateChanged(LPCWSTR deviceId, DWORD dwNewState)
+{
+    TraceRecord record;
+    record.Kind = TraceRecordKind::DeviceStateChanged;
+    record.EndpointId = deviceId;
+    record.State = dwNewState;
+    owner_.writer_.Write(std::move(record));
+    return owner_.client_->OnDeviceStateChanged(deviceId, dwNewState);
+}
+
+HRESULT ed::audio::RecordingAudioBackend::RecordingClient::OnDeviceAdded(LPCWSTR deviceId)
+{
+    TraceRecord record;
+    record.Kind = TraceRecordKind::DeviceAdded;
+    record.EndpointId = deviceId;
+    owner_.writer_.Write(std::move(record));
+    return owner_.client_->OnDeviceAdded(deviceId);
+}
+
+HRESULT ed::audio::RecordingAudioBackend::RecordingClient::OnDeviceRemoved(LPCWSTR deviceId)
+{
+    TraceRecord record;
+    record.Kind = TraceRecordKind::DeviceRemoved;
+    record.EndpointId = deviceId;
+    owner_.writer_.Write(std::move(record));
+    return owner_.client_->OnDeviceRemoved(deviceId);
+}
+
+HRESULT ed::audio::RecordingAudioBackend::RecordingClient::OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR defaultDeviceId)
+{
+    TraceRecord record;
+    record.Kind = TraceRecordKind::DefaultDeviceChanged;
+    record.Flow = ToRecordedFlow(flow);
+    record.Role = static_cast<DeviceRole>(role);
+    if (defaultDeviceId != nullptr)
+    {
+        record.EndpointId = defaultDeviceId;
+    }
+    owner_.writer_.Write(std::move(record));
+    return owner_.client_->OnDefaultDeviceChanged(flow, role, defaultDeviceId);
+}
+
+HRESULT ed::audio::RecordingAudioBackend::RecordingClient::OnPropertyValueChanged(LPCWSTR deviceId, const PROPERTYKEY key)
+{
+    TraceRecord record;
+    record.Kind = TraceRecordKind::PropertyValueChanged;
+    record.EndpointId = deviceId;
+    record.Property = GetEndpointProperty(key);
+    owner_.writer_.Write(std::move(record));
+    return owner_.client_->OnPropertyValueChanged(deviceId, key);
+}
+
+HRESULT ed::audio::RecordingAudioBackend::RecordingClient::OnNotify(PAUDIO_VOLUME_NOTIFICATION_DATA pNotify)
+{
+    TraceRecord record;
+    record.Kind = TraceRecordKind::VolumeNotify;
+    record.Muted = pNotify->bMuted != FALSE;
+    record.MasterVolume = pNotify->fMasterVolume;
+    owner_.writer_.Write(std::move(record));
+    return owner_.client_->OnNotify(pNotify);
+}
+
+HRESULT ed::audio::RecordingAudioBackend::RecordingClient::OnEndpointVolumeNotify(LPCWSTR endpointId, PAUDIO_VOLUME_NOTIFICATION_DATA pNotify)
+{
+    TraceRecord record;
+    record.Kind = TraceRecordKind::VolumeNotify;
+    record.EndpointId = endpointId;
+    record.Muted = pNotify->bMuted != FALSE;
+    record.MasterVolume = pNotify->fMasterVolume;
+    owner_.writer_.Write(std::move(record));
+    return owner_.client_->OnEndpointVolumeNotify(endpointId, pNotify);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+
+#include "AudioBackendInterface.h"
+#include "NotificationTrace.h"
+
+
+namespace ed::audio {
+// Decorates another backend and writes every notification it delivers, and every enumeration and
+// probe answer, into a notification trace. ReplayAudioBackend plays such a trace back.
+class RecordingAudioBackend final : public AudioBackendInterface {
+public:
+    DISALLOW_COPY_MOVE(RecordingAudioBackend);
+    ~RecordingAudioBackend() override;
+
+public:
+    RecordingAudioBackend(std::unique_ptr<AudioBackendInterface> backend, const std::wstring & traceFilePath);
+
+    void Start(MultipleNotificationClient & client, TraceFunctionT traceFunction, TraceOnFunctionT isTraceOn) override;
+    void Stop() override;
+
+    bool TryEnumerateActiveEndpoints(bool bothHeadsetAndMicro, std::vector<std::wstring> & endpointIds) override;
+    bool TryProbeEndpoint(const std::wstring & endpointId, Device & device, TVolumeNotificationToken * volumeToken) override;
+    bool TryGetDefaultEndpoint(DeviceFlowEnum flow, DeviceRole role, std::wstring & endpointId) override;
+    bool TryReadEndpointProperty(const std::wstring & endpointId, EndpointProperty property, Device & device) override;
+
+    void RegisterVolumeNotification(const std::wstring & endpointId, TVolumeNotificationToken volumeToken) override;
+    void UnregisterVolumeNotification(const std::wstring & endpointId) override;
+    void UnregisterAllVolumeNotifications() override;
+    [[nodiscard]] size_t GetVolumeNotificationCount() const override;
+
+private:
+    // Sits between the decorated backend and the real client
+    class RecordingClient final : public MultipleNotificationClient {
+    public:
+        DISALLOW_COPY_MOVE(RecordingClient);
+        ~RecordingClient() override = default;
+
+    public:
+        explicit RecordingClient(RecordingAudioBackend & owner);
+
+        HRESULT STDMETHODCALLTYPE OnDeviceStateChanged(LPCWSTR deviceId, DWORD dwNewState) override;
+        HRESULT STDMETHODCALLTYPE OnDeviceAdded(LPCWSTR deviceId) override;
+        HRESULT STDMETHODCALLTYPE OnDeviceRemoved(LPCWSTR deviceId) override;
+        HRESULT STDMETHODCALLTYPE OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR defaultDeviceId) override;
+        HRESULT STDMETHODCALLTYPE OnPropertyValueChanged(LPCWSTR deviceId, const PROPERTYKEY key) override;
+        HRESULT STDMETHODCALLTYPE OnNotify(PAUDIO_VOLUME_NOTIFICATION_DATA pNotify) override;
+        HRESULT OnEndpointVolumeNotify(LPCWSTR endpointId, PAUDIO_VOLUME_NOTIFICATION_DATA pNotify) override;
+
+    private:
+        RecordingAudioBackend & owner_;
+    };
+
+private:
+    std::unique_ptr<AudioBackendInterface> backend_;
+    NotificationTraceWriter writer_;
+    RecordingClient recordingClient_;
+    MultipleNotificationClient * client_ = nullptr;
+};
+}
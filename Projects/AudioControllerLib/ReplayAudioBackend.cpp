@@ -0,0 +1,224 @@
+#include "stdafx.h"
+
+#include "ReplayAudioBackend.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <thread>
+
+
+ed::audio::ReplayAudioBackend::ReplayAudioBackend(const std::wstring & traceFilePath)
+{
+    if (!NotificationTraceReader::TryLoad(traceFilePath, records_))
+    {
+        throw std::runtime_error("Can not load the notification trace.");
+    }
+    firstNotification_ = static_cast<size_t>(
+        std::ranges::find_if(records_, [](const TraceRecord & record) { return record.IsNotification(); }) - records_.begin());
+    ApplyAnswers(0, firstNotification_);
+}
+
+void ed::audio::ReplayAudioBackend::Start(MultipleNotificationClient & client, TraceFunctionT, TraceOnFunctionT)
+{
+    std::lock_guard lock(mutex_);
+    client_ = &client;
+}
+
+void ed::audio::ReplayAudioBackend::Stop()
+{
+    std::lock_guard lock(mutex_);
+    client_ = nullptr;
+}
+
+bool ed::audio::ReplayAudioBackend::TryEnumerateActiveEndpoints(bool, std::vector<std::wstring> & endpointIds)
+{
+    std::lock_guard lock(mutex_);
+    if (!enumeration_.has_value())
+    {
+        return false;
+    }
+    endpointIds = *enumeration_;
+    return true;
+}
+
+bool ed::audio::ReplayAudioBackend::TryProbeEndpoint(const std::wstring & endpointId, Device & device, TVolumeNotificationToken *)
+{
+    std::lock_guard lock(mutex_);
+    const auto foundPair = probes_.find(endpointId);
+    if (foundPair == probes_.end() || !foundPair->second.has_value())
+    {
+        return false;
+    }
+    device = *foundPair->second;
+    return true;
+}
+
+bool ed::audio::ReplayAudioBackend::TryGetDefaultEndpoint(DeviceFlowEnum flow, DeviceRole role, std::wstring & endpointId)
+{
+    const auto bit = Device::GetDefaultRoleBit(flow, role);
+    std::lock_guard lock(mutex_);
+    if (bit == 0 || !defaults_[std::countr_zero(bit)].has_value())
+    {
+        return false;
+    }
+    endpointId = *defaults_[std::countr_zero(bit)];
+    return true;
+}
+
+bool ed::audio::ReplayAudioBackend::TryReadEndpointProperty(const std::wstring & endpointId, EndpointProperty property, Device & device)
+{
+    std::lock_guard lock(mutex_);
+    const auto foundPair = propertyReads_.find(endpointId);
+    if (foundPair == propertyReads_.end() || !foundPair->second.has_value())
+    {
+        return false;
+    }
+    switch (property)
+    {
+    case EndpointProperty::FriendlyName:
+        device.SetName(foundPair->second->GetName());
+        return true;
+    case EndpointProperty::FormFactor:
+        device.SetFormFactor(foundPair->second->GetFormFactor());
+        return true;
+    case EndpointProperty::None:
+    default: // NOLINT(clang-diagnostic-covered-switch-default)
+        return false;
+    }
+}
+
+// Every recorded volume notification is delivered, it was registered at recording time
+void ed::audio::ReplayAudioBackend::RegisterVolumeNotification(const std::wstring &, TVolumeNotificationToken)
+{
+}
+
+void ed::audio::ReplayAudioBackend::UnregisterVolumeNotification(const std::wstring &)
+{
+}
+
+void ed::audio::ReplayAudioBackend::UnregisterAllVolumeNotifications()
+{
+}
+
+size_t ed::audio::ReplayAudioBackend::GetVolumeNotificationCount() const
+{
+    return 0;
+}
+
+size_t ed::audio::ReplayAudioBackend::Replay(double speedFactor)
+{
+    if (firstNotification_ >= records_.size())
+    {
+        return 0;
+    }
+    const auto startedAt = std::chrono::steady_clock::now();
+    const auto firstTimestamp = records_[firstNotification_].Timestamp;
+
+    size_t delivered = 0;
+    for (auto i = firstNotification_; i < records_.size();)
+    {
+        auto next = i + 1;
+        while (next < records_.size() && !records_[next].IsNotification())
+        {
+            ++next;
+        }
+        if (speedFactor > 0.0)
+        {
+            const auto offset = std::chrono::nanoseconds(static_cast<int64_t>(
+                static_cast<double>(records_[i].Timestamp - firstTimestamp) / speedFactor));
+            std::this_thread::sleep_until(startedAt + offset);
+        }
+        ApplyAnswers(i + 1, next);
+        Deliver(records_[i]);
+        ++delivered;
+        i = next;
+    }
+    return delivered;
+}
+
+size_t ed::audio::ReplayAudioBackend::GetNotificationCount() const
+{
+    return static_cast<size_t>(std::ranges::count_if(records_, [](const TraceRecord & record) { return record.IsNotification(); }));
+}
+
+void ed::audio::ReplayAudioBackend::ApplyAnswers(size_t from, size_t to)
+{
+    std::lock_guard lock(mutex_);
+    for (auto i = from; i < to; ++i)
+    {
+        const auto & record = records_[i];
+        if (record.Kind == TraceRecordKind::Enumerated)
+        {
+            enumeration_ = record.Succeeded ? std::optional(record.EndpointIds) : std::nullopt;
+        }
+        else if (record.Kind == TraceRecordKind::Probed)
+        {
+            probes_[record.EndpointId] = record.Succeeded ? std::optional(record.Facts) : std::nullopt;
+        }
+        else if (record.Kind == TraceRecordKind::PropertyRead)
+        {
+            propertyReads_[record.EndpointId] = record.Succeeded ? std::optional(record.Facts) : std::nullopt;
+        }
+        else if (record.Kind == TraceRecordKind::DefaultQueried)
+        {
+            if (const auto bit = Device::GetDefaultRoleBit(record.Flow, record.Role); bit != 0)
+            {
+                defaults_[std::countr_zero(bit)] = record.Succeeded ? std::optional(record.EndpointId) : std::nullopt;
+            }
+        }
+    }
+}
+
+void ed::audio::ReplayAudioBackend::Deliver(const TraceRecord & record) const
+{
+    MultipleNotificationClient * client;
+    {
+        std::lock_guard lock(mutex_);
+        client = client_;
+    }
+    if (client == nullptr)
+    {
+        return;
+    }
+    switch (record.Kind)
+    {
+    case TraceRecordKind::DeviceAdded:
+        // ReSharper disable once CppFunctionResultShouldBeUsed
+        client->OnDeviceAdded(record.EndpointId.c_str());
+        break;
+    case TraceRecordKind::DeviceRemoved:
+        // ReSharper disable once CppFunctionResultShouldBeUsed
+        client->OnDeviceRemoved(record.EndpointId.c_str());
+        break;
+    case TraceRecordKind::DeviceStateChanged:
+        // ReSharper disable once CppFunctionResultShouldBeUsed
+        client->OnDeviceStateChanged(record.EndpointId.c_str(), record.State);
+        break;
+    case TraceRecordKind::VolumeNotify:
+    {
+        AUDIO_VOLUME_NOTIFICATION_DATA data{};
+        data.bMuted = record.Muted ? TRUE : FALSE;
+        data.fMasterVolume = record.MasterVolume;
+        data.nChannels = 1;
+        data.afChannelVolumes[0] = record.MasterVolume;
+        // ReSharper disable once CppFunctionResultShouldBeUsed
+        record.EndpointId.empty() ? client->OnNotify(&data) : client->OnEndpointVolumeNotify(record.EndpointId.c_str(), &data);
+        break;
+    }
+    case TraceRecordKind::DefaultDeviceChanged:
+    {
+        const auto flow = record.Flow == DeviceFlowEnum::Render ? eRender : record.Flow == DeviceFlowEnum::Capture ? eCapture : eAll;
+        // ReSharper disable once CppFunctionResultShouldBeUsed
+        client->OnDefaultDeviceChanged(flow, static_cast<ERole>(record.Role),
+                                       record.EndpointId.empty() ? nullptr : record.EndpointId.c_str());
+        break;
+    }
+    case TraceRecordKind::PropertyValueChanged:
+        // ReSharper disable once CppFunctionResultShouldBeUsed
+        client->OnPropertyValueChanged(record.EndpointId.c_str(), GetPropertyKey(record.Property));
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <map>
+#include <mutex>
+#include <optional>
+
+#include "AudioBackendInterface.h"
+#include "NotificationTrace.h"
+
+
+namespace ed::audio {
+// Plays a notification trace back into the started client. The enumeration and probe answers
+// recorded after a notification are served while that notification is handled, so the client
+// sees the same facts as during the recording.
+class ReplayAudioBackend final : public AudioBackendInterface {
+public:
+    DISALLOW_COPY_MOVE(ReplayAudioBackend);
+    ~ReplayAudioBackend() override = default;
+
+public:
+    // Throws if the trace can not be loaded. Answers recorded before the first notification are served at once.
+    explicit ReplayAudioBackend(const std::wstring & traceFilePath);
+
+    void Start(MultipleNotificationClient & client, TraceFunctionT traceFunction, TraceOnFunctionT isTraceOn) override;
+    void Stop() override;
+
+    // Returns the recorded enumeration; the flow filter of the recording applies.
+    bool TryEnumerateActiveEndpoints(bool bothHeadsetAndMicro, std::vector<std::wstring> & endpointIds) override;
+    bool TryProbeEndpoint(const std::wstring & endpointId, Device & device, TVolumeNotificationToken * volumeToken) override;
+    // Return the recorded answers
+    bool TryGetDefaultEndpoint(DeviceFlowEnum flow, DeviceRole role, std::wstring & endpointId) override;
+    bool TryReadEndpointProperty(const std::wstring & endpointId, EndpointProperty property, Device & device) override;
+
+    void RegisterVolumeNotification(const std::wstring & endpointId, TVolumeNotificationToken volumeToken) override;
+    void UnregisterVolumeNotification(const std::wstring & endpointId) override;
+    void UnregisterAllVolumeNotifications() override;
+    [[nodiscard]] size_t GetVolumeNotificationCount() const override;
+
+    // Delivers all recorded notifications on the calling thread. speedFactor 1 keeps the recorded
+    // pace, N plays N times faster, 0 plays flat-out. Returns the number of delivered notifications.
+    size_t Replay(double speedFactor);
+    [[nodiscard]] size_t GetNotificationCount() const;
+
+private:
+    void ApplyAnswers(size_t from, size_t to);
+    void Deliver(const TraceRecord & record) const;
+
+private:
+    std::vector<TraceRecord> records_;
+    size_t firstNotification_ = 0;
+
+    mutable std::mutex mutex_;
+    std::optional<std::vector<std::wstring>> enumeration_;
+    std::map<std::wstring, std::optional<Device>> probes_;
+    // The facts after the last property read of an endpoint
+    std::map<std::wstring, std::optional<Device>> propertyReads_;
+    // By flow and role, as Device::GetDefaultRoleBit() orders them
+    std::array<std::optional<std::wstring>, 2 * DeviceRoleCount> defaults_;
+    MultipleNotificationClient * client_ = nullptr;
+};
+}
@@ -0,0 +1,403 @@
+#include "stdafx.h"
+
+#include "SimulatedAudioBackend.h"
+
+#include <bit>
+#include <cwchar>
+#include <thread>
+
+
+namespace {
+// Stands for the endpoint volume a probe has activated; registering it costs the registration only
+class SimulatedVolumeToken final : public ed::audio::VolumeNotificationToken {
+public:
+    DISALLOW_COPY_MOVE(SimulatedVolumeToken);
+    SimulatedVolumeToken() = default;
+    ~SimulatedVolumeToken() override = default;
+};
+}
+
+
+void ed::audio::SimulatedAudioBackend::Start(MultipleNotificationClient & client, TraceFunctionT traceFunction, TraceOnFunctionT)
+{
+    std::lock_guard lock(mutex_);
+    client_ = &client;
+    traceFunction_ = std::move(traceFunction);
+}
+
+void ed::audio::SimulatedAudioBackend::Stop()
+{
+    std::lock_guard lock(mutex_);
+    volumeNotifications_.clear();
+    client_ = nullptr;
+}
+
+bool ed::audio::SimulatedAudioBackend::TryEnumerateActiveEndpoints(bool bothHeadsetAndMicro, std::vector<std::wstring> & endpointIds)
+{
+    if (!SimulateCall(SimulatedCall::Enumerate))
+    {
+        return false;
+    }
+    std::lock_guard lock(mutex_);
+    endpointIds.clear();
+    endpointIds.reserve(endpoints_.size());
+    for (const auto & [endpointId, endpoint] : endpoints_)
+    {
+        if (endpoint.State == DEVICE_STATE_ACTIVE && (bothHeadsetAndMicro || endpoint.Flow == DeviceFlowEnum::Render))
+        {
+            endpointIds.push_back(endpointId);
+        }
+    }
+    return true;
+}
+
+bool ed::audio::SimulatedAudioBackend::TryProbeEndpoint(const std::wstring & endpointId, Device & device, TVolumeNotificationToken * volumeToken)
+{
+    if (!SimulateCall(SimulatedCall::Probe))
+    {
+        return false;
+    }
+    std::lock_guard lock(mutex_);
+    const auto foundPair = endpoints_.find(endpointId);
+    if (foundPair == endpoints_.end())
+    {
+        return false;
+    }
+    const auto & endpoint = foundPair->second;
+    const uint16_t volume = endpoint.Mute ? 0 : endpoint.Volume;
+    device = Device(
+        endpoint.ContainerId,
+        endpoint.Name,
+        endpoint.Flow,
+        endpoint.Flow == DeviceFlowEnum::Render ? volume : uint16_t{0},
+        endpoint.Flow == DeviceFlowEnum::Capture ? volume : uint16_t{0},
+        endpoint.FormFactor,
+        endpoint.JackConnection
+    );
+    if (volumeToken != nullptr)
+    {
+        *volumeToken = std::make_unique<SimulatedVolumeToken>();
+    }
+    return true;
+}
+
+bool ed::audio::SimulatedAudioBackend::TryGetDefaultEndpoint(DeviceFlowEnum flow, DeviceRole role, std::wstring & endpointId)
+{
+    SpendCall(SimulatedCall::GetDefault);
+    const auto bit = Device::GetDefaultRoleBit(flow, role);
+    std::lock_guard lock(mutex_);
+    if (bit == 0 || defaultEndpoints_[std::countr_zero(bit)].empty())
+    {
+        return false;
+    }
+    endpointId = defaultEndpoints_[std::countr_zero(bit)];
+    return true;
+}
+
+bool ed::audio::SimulatedAudioBackend::TryReadEndpointProperty(const std::wstring & endpointId, EndpointProperty property, Device & device)
+{
+    if (!SimulateCall(SimulatedCall::ReadProperty))
+    {
+        return false;
+    }
+    std::lock_guard lock(mutex_);
+    const auto foundPair = endpoints_.find(endpointId);
+    if (foundPair == endpoints_.end())
+    {
+        return false;
+    }
+    switch (property)
+    {
+    case EndpointProperty::FriendlyName:
+        device.SetName(foundPair->second.Name);
+        return true;
+    case EndpointProperty::FormFactor:
+        device.SetFormFactor(foundPair->second.FormFactor);
+        return true;
+    case EndpointProperty::None:
+    default: // NOLINT(clang-diagnostic-covered-switch-default)
+        return false;
+    }
+}
+
+void ed::audio::SimulatedAudioBackend::RegisterVolumeNotification(const std::wstring & endpointId, TVolumeNotificationToken)
+{
+    if (!SimulateCall(SimulatedCall::RegisterVolume))
+    {
+        return;
+    }
+    std::lock_guard lock(mutex_);
+    if (client_ != nullptr && endpoints_.contains(endpointId))
+    {
+        volumeNotifications_.insert(endpointId);
+    }
+}
+
+void ed::audio::SimulatedAudioBackend::UnregisterVolumeNotification(const std::wstring & endpointId)
+{
+    std::lock_guard lock(mutex_);
+    volumeNotifications_.erase(endpointId);
+}
+
+void ed::audio::SimulatedAudioBackend::UnregisterAllVolumeNotifications()
+{
+    std::lock_guard lock(mutex_);
+    volumeNotifications_.clear();
+}
+
+size_t ed::audio::SimulatedAudioBackend::GetVolumeNotificationCount() const
+{
+    std::lock_guard lock(mutex_);
+    return volumeNotifications_.size();
+}
+
+/*static*/
+ed::audio::SimulatedEndpoint ed::audio::SimulatedAudioBackend::MakeEndpoint(size_t containerNumber, DeviceFlowEnum flow)
+{
+    const auto number = static_cast<unsigned long long>(containerNumber);
+    const auto isCapture = flow == DeviceFlowEnum::Capture;
+
+    wchar_t containerId[40];
+    swprintf_s(containerId, L"{5133A4D1-0000-0000-0000-%012llu}", number);
+    wchar_t endpointId[64];
+    swprintf_s(endpointId, L"{0.0.%d.00000000}.{5133A4D1-0001-0000-0000-%012llu}", isCapture ? 1 : 0, number);
+    wchar_t name[64];
+    swprintf_s(name, L"%ls (Simulated Device %llu)", isCapture ? L"Microphone" : L"Speakers", number);
+
+    SimulatedEndpoint endpoint;
+    endpoint.EndpointId = endpointId;
+    endpoint.ContainerId = containerId;
+    endpoint.Name = name;
+    endpoint.Flow = flow;
+    endpoint.FormFactor = isCapture ? DeviceFormFactor::Microphone : DeviceFormFactor::Speakers;
+    return endpoint;
+}
+
+void ed::audio::SimulatedAudioBackend::Populate(size_t containerCount, bool renderAndCapture)
+{
+    std::lock_guard lock(mutex_);
+    for (size_t i = 0; i < containerCount; ++i)
+    {
+        auto render = MakeEndpoint(i, DeviceFlowEnum::Render);
+        endpoints_[render.EndpointId] = std::move(render);
+        if (renderAndCapture)
+        {
+            auto capture = MakeEndpoint(i, DeviceFlowEnum::Capture);
+            endpoints_[capture.EndpointId] = std::move(capture);
+        }
+    }
+}
+
+void ed::audio::SimulatedAudioBackend::AddEndpoint(const SimulatedEndpoint & endpoint)
+{
+    bool isKnown;
+    {
+        std::lock_guard lock(mutex_);
+        isKnown = endpoints_.contains(endpoint.EndpointId);
+        endpoints_[endpoint.EndpointId] = endpoint;
+    }
+    if (auto * client = GetClient(); client != nullptr)
+    {
+        const bool isRedundant = redundantNotifications_;
+        if (isKnown || isRedundant)
+        {
+            // ReSharper disable once CppFunctionResultShouldBeUsed
+            client->OnDeviceStateChanged(endpoint.EndpointId.c_str(), endpoint.State);
+        }
+        if (!isKnown || isRedundant)
+        {
+            // ReSharper disable once CppFunctionResultShouldBeUsed
+            client->OnDeviceAdded(endpoint.EndpointId.c_str());
+        }
+    }
+}
+
+void ed::audio::SimulatedAudioBackend::RemoveEndpoint(const std::wstring & endpointId)
+{
+    {
+        std::lock_guard lock(mutex_);
+        if (!endpoints_.contains(endpointId))
+        {
+            return;
+        }
+    }
+    SetEndpointState(endpointId, DEVICE_STATE_NOTPRESENT);
+    if (auto * client = GetClient(); client != nullptr && redundantNotifications_)
+    {
+        // ReSharper disable once CppFunctionResultShouldBeUsed
+        client->OnDeviceRemoved(endpointId.c_str());
+    }
+}
+
+void ed::audio::SimulatedAudioBackend::SetRedundantNotifications(bool isOn)
+{
+    redundantNotifications_ = isOn;
+}
+
+void ed::audio::SimulatedAudioBackend::SetEndpointState(const std::wstring & endpointId, DWORD state)
+{
+    {
+        std::lock_guard lock(mutex_);
+        const auto foundPair = endpoints_.find(endpointId);
+        if (foundPair == endpoints_.end())
+        {
+            return;
+        }
+        foundPair->second.State = state;
+    }
+    if (auto * client = GetClient(); client != nullptr)
+    {
+        // ReSharper disable once CppFunctionResultShouldBeUsed
+        client->OnDeviceStateChanged(endpointId.c_str(), state);
+    }
+}
+
+void ed::audio::SimulatedAudioBackend::SetVolume(const std::wstring & endpointId, uint16_t volume, bool mute)
+{
+    MultipleNotificationClient * client;
+    {
+        std::lock_guard lock(mutex_);
+        const auto foundPair = endpoints_.find(endpointId);
+        if (foundPair == endpoints_.end())
+        {
+            return;
+        }
+        foundPair->second.Volume = volume;
+        foundPair->second.Mute = mute;
+        client = volumeNotifications_.contains(endpointId) ? client_ : nullptr;
+    }
+    if (client != nullptr)
+    {
+        AUDIO_VOLUME_NOTIFICATION_DATA data{};
+        data.bMuted = mute ? TRUE : FALSE;
+        data.fMasterVolume = static_cast<float>(volume) / 1000.0f;
+        data.nChannels = 1;
+        data.afChannelVolumes[0] = data.fMasterVolume;
+        // ReSharper disable once CppFunctionResultShouldBeUsed
+        client->OnEndpointVolumeNotify(endpointId.c_str(), &data);
+    }
+}
+
+void ed::audio::SimulatedAudioBackend::SetDefaultEndpoint(DeviceFlowEnum flow, DeviceRole role, const std::wstring & endpointId)
+{
+    const auto bit = Device::GetDefaultRoleBit(flow, role);
+    if (bit == 0)
+    {
+        return;
+    }
+    {
+        std::lock_guard lock(mutex_);
+        defaultEndpoints_[std::countr_zero(bit)] = endpointId;
+    }
+    if (auto * client = GetClient(); client != nullptr)
+    {
+        // ReSharper disable once CppFunctionResultShouldBeUsed
+        client->OnDefaultDeviceChanged(flow == DeviceFlowEnum::Capture ? eCapture : eRender, static_cast<ERole>(role),
+                                       endpointId.empty() ? nullptr : endpointId.c_str());
+    }
+}
+
+void ed::audio::SimulatedAudioBackend::SetEndpointName(const std::wstring & endpointId, const std::wstring & name)
+{
+    ChangeProperty(endpointId, EndpointProperty::FriendlyName, [&name](SimulatedEndpoint & endpoint) { endpoint.Name = name; });
+}
+
+void ed::audio::SimulatedAudioBackend::SetEndpointFormFactor(const std::wstring & endpointId, DeviceFormFactor formFactor)
+{
+    ChangeProperty(endpointId, EndpointProperty::FormFactor, [formFactor](SimulatedEndpoint & endpoint) { endpoint.FormFactor = formFactor; });
+}
+
+template <typename TFunction>
+void ed::audio::SimulatedAudioBackend::ChangeProperty(const std::wstring & endpointId, EndpointProperty property, TFunction && change)
+{
+    {
+        std::lock_guard lock(mutex_);
+        const auto foundPair = endpoints_.find(endpointId);
+        if (foundPair == endpoints_.end())
+        {
+            return;
+        }
+        change(foundPair->second);
+    }
+    if (auto * client = GetClient(); client != nullptr)
+    {
+        // ReSharper disable once CppFunctionResultShouldBeUsed
+        client->OnPropertyValueChanged(endpointId.c_str(), GetPropertyKey(property));
+    }
+}
+
+size_t ed::audio::SimulatedAudioBackend::GetEndpointCount() const
+{
+    std::lock_guard lock(mutex_);
+    return endpoints_.size();
+}
+
+void ed::audio::SimulatedAudioBackend::SetLatency(std::chrono::nanoseconds latency)
+{
+    latency_ = latency.count();
+}
+
+void ed::audio::SimulatedAudioBackend::InjectFailures(SimulatedCall call, unsigned count)
+{
+    pendingFailures_[static_cast<size_t>(call)] = count;
+}
+
+void ed::audio::SimulatedAudioBackend::SetFailureProbability(double probability, unsigned seed)
+{
+    std::lock_guard lock(mutex_);
+    failureProbability_ = probability;
+    random_.seed(seed);
+}
+
+uint64_t ed::audio::SimulatedAudioBackend::GetCallCount(SimulatedCall call) const
+{
+    return callCounts_[static_cast<size_t>(call)];
+}
+
+bool ed::audio::SimulatedAudioBackend::SimulateCall(SimulatedCall call)
+{
+    SpendCall(call);
+
+    const auto index = static_cast<size_t>(call);
+    for (auto pending = pendingFailures_[index].load(); pending > 0;)
+    {
+        if (pendingFailures_[index].compare_exchange_weak(pending, pending - 1))
+        {
+            TraceIt(L"Simulated failure injected.");
+            return false;
+        }
+    }
+
+    std::lock_guard lock(mutex_);
+    return failureProbability_ <= 0.0
+        || std::uniform_real_distribution(0.0, 1.0)(random_) >= failureProbability_;
+}
+
+void ed::audio::SimulatedAudioBackend::SpendCall(SimulatedCall call)
+{
+    ++callCounts_[static_cast<size_t>(call)];
+
+    // Spin instead of sleeping: sleep granularity is far coarser than the latencies of interest
+    if (const auto latency = std::chrono::nanoseconds(latency_.load()); latency.count() > 0)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + latency;
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+ed::audio::MultipleNotificationClient * ed::audio::SimulatedAudioBackend::GetClient() const
+{
+    std::lock_guard lock(mutex_);
+    return client_;
+}
+
+void ed::audio::SimulatedAudioBackend::TraceIt(const std::wstring & line) const
+{
+    if (traceFunction_)
+    {
+        traceFunction_(line);
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+
+#include "AudioBackendInterface.h"
+
+
+namespace ed::audio {
+struct SimulatedEndpoint {
+    std::wstring EndpointId;
+    std::wstring ContainerId;
+    std::wstring Name;
+    DeviceFlowEnum Flow = DeviceFlowEnum::Render;
+    DWORD State = DEVICE_STATE_ACTIVE;
+    bool Mute = false;
+    uint16_t Volume = 500;
+    DeviceFormFactor FormFactor = DeviceFormFactor::Unknown;
+    DeviceJackConnection JackConnection = DeviceJackConnection::Unknown;
+};
+
+enum class SimulatedCall : uint8_t {
+    Enumerate = 0,
+    Probe,
+    RegisterVolume,
+    ReadProperty,
+    // Counted and delayed, but never failed, so the failure scripts of the other calls stay as they are
+    GetDefault
+};
+
+// In-memory, scriptable model of audio endpoints. Needs neither COM nor audio hardware, so merge,
+// filter, diff and notification logic can be tested and measured with thousands of devices.
+// Every backend call costs the configured latency and may fail on purpose. Scripting methods
+// notify the started client like the Windows audio service does; they are thread-safe but must
+// not overlap the destruction of the client.
+class SimulatedAudioBackend final : public AudioBackendInterface {
+public:
+    DISALLOW_COPY_MOVE(SimulatedAudioBackend);
+    ~SimulatedAudioBackend() override = default;
+
+public:
+    SimulatedAudioBackend() = default;
+
+    void Start(MultipleNotificationClient & client, TraceFunctionT traceFunction, TraceOnFunctionT isTraceOn) override;
+    void Stop() override;
+
+    bool TryEnumerateActiveEndpoints(bool bothHeadsetAndMicro, std::vector<std::wstring> & endpointIds) override;
+    bool TryProbeEndpoint(const std::wstring & endpointId, Device & device, TVolumeNotificationToken * volumeToken) override;
+    bool TryGetDefaultEndpoint(DeviceFlowEnum flow, DeviceRole role, std::wstring & endpointId) override;
+    bool TryReadEndpointProperty(const std::wstring & endpointId, EndpointProperty property, Device & device) override;
+
+    void RegisterVolumeNotification(const std::wstring & endpointId, TVolumeNotificationToken volumeToken) override;
+    void UnregisterVolumeNotification(const std::wstring & endpointId) override;
+    void UnregisterAllVolumeNotifications() override;
+    [[nodiscard]] size_t GetVolumeNotificationCount() const override;
+
+public:
+    // Deterministic endpoint of the container with the given number, e.g. for bulk population.
+    static SimulatedEndpoint MakeEndpoint(size_t containerNumber, DeviceFlowEnum flow);
+    // Adds active render (and capture, if requested) endpoints of containerCount containers, without notifications.
+    void Populate(size_t containerCount, bool renderAndCapture);
+
+    // Plugs an endpoint in: OnDeviceAdded for an unknown endpoint, OnDeviceStateChanged otherwise.
+    void AddEndpoint(const SimulatedEndpoint & endpoint);
+    // Unplugs an endpoint; it stays probe-able, as in Windows.
+    void RemoveEndpoint(const std::wstring & endpointId);
+    // As Windows often does: AddEndpoint() calls both OnDeviceStateChanged and OnDeviceAdded,
+    // RemoveEndpoint() both OnDeviceStateChanged and OnDeviceRemoved.
+    void SetRedundantNotifications(bool isOn);
+    void SetEndpointState(const std::wstring & endpointId, DWORD state);
+    // Calls OnEndpointVolumeNotify if the volume notification of the endpoint is registered.
+    void SetVolume(const std::wstring & endpointId, uint16_t volume, bool mute = false);
+    // Calls OnDefaultDeviceChanged; an empty endpoint id for none. Unplugging the default endpoint keeps it the default.
+    void SetDefaultEndpoint(DeviceFlowEnum flow, DeviceRole role, const std::wstring & endpointId);
+    // Call OnPropertyValueChanged, as renaming an endpoint in the Sound control panel or a driver update does.
+    void SetEndpointName(const std::wstring & endpointId, const std::wstring & name);
+    void SetEndpointFormFactor(const std::wstring & endpointId, DeviceFormFactor formFactor);
+    [[nodiscard]] size_t GetEndpointCount() const;
+
+    void SetLatency(std::chrono::nanoseconds latency);
+    // The next count calls of the given kind fail.
+    void InjectFailures(SimulatedCall call, unsigned count);
+    // Every call fails with the given probability, reproducible by the seed.
+    void SetFailureProbability(double probability, unsigned seed);
+    [[nodiscard]] uint64_t GetCallCount(SimulatedCall call) const;
+
+private:
+    bool SimulateCall(SimulatedCall call);
+    void SpendCall(SimulatedCall call);
+    // Changes the property of the endpoint, if known, and notifies the client
+    template <typename TFunction>
+    void ChangeProperty(const std::wstring & endpointId, EndpointProperty property, TFunction && change);
+    [[nodiscard]] MultipleNotificationClient * GetClient() const;
+    void TraceIt(const std::wstring & line) const;
+
+private:
+    static constexpr size_t CallKindCount = 5;
+
+    mutable std::mutex mutex_;
+    std::map<std::wstring, SimulatedEndpoint> endpoints_;
+    std::set<std::wstring> volumeNotifications_;
+    // By flow and role, as Device::GetDefaultRoleBit() orders them
+    std::array<std::wstring, 2 * DeviceRoleCount> defaultEndpoints_;
+    MultipleNotificationClient * client_ = nullptr;
+    TraceFunctionT traceFunction_;
+
+    std::atomic<std::chrono::nanoseconds::rep> latency_ = 0;
+    std::atomic_bool redundantNotifications_ = false;
+    std::array<std::atomic<unsigned>, CallKindCount> pendingFailures_{};
+    std::array<std::atomic<uint64_t>, CallKindCount> callCounts_{};
+    double failureProbability_ = 0.0;
+    std::mt19937 random_;
+};
+}
@@ -0,0 +1,109 @@
+#include "stdafx.h"
+
+#include "SnapshotPublisher.h"
+
+#include <atomic>
+#include <stdexcept>
+
+
+ed::audio::SnapshotPublisher::~SnapshotPublisher()
+{
+    collection_.Unsubscribe(*this);
+    if (region_ != nullptr)
+    {
+        UnmapViewOfFile(region_);
+    }
+    if (mapping_ != nullptr)
+    {
+        CloseHandle(mapping_);
+    }
+}
+
+ed::audio::SnapshotPublisher::SnapshotPublisher(DeviceCollectionInterface & collection, const std::wstring & regionName)
+    : collection_(collection)
+{
+    mapping_ = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(AcSnapshotRegion),
+                                  regionName.c_str());
+    if (mapping_ == nullptr)
+    {
+        std::ostringstream os; os << "Couldn't create snapshot file mapping, error code " << GetLastError() << ".";
+        throw std::runtime_error(os.str());
+    }
+    region_ = static_cast<AcSnapshotRegion*>(MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, sizeof(AcSnapshotRegion)));
+    if (region_ == nullptr)
+    {
+        std::ostringstream os; os << "Couldn't map snapshot view, error code " << GetLastError() << ".";
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+        throw std::runtime_error(os.str());
+    }
+
+    region_->HeaderSize = offsetof(AcSnapshotRegion, Devices);
+    region_->DeviceRecordSize = sizeof(AcSnapshotDevice);
+    region_->Capacity = AC_SNAPSHOT_MAX_DEVICES;
+    region_->Version = AC_SNAPSHOT_VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    region_->Magic = AC_SNAPSHOT_MAGIC;
+
+    collection_.Subscribe(*this);
+}
+
+void ed::audio::SnapshotPublisher::Publish()
+{
+    std::lock_guard lock(publishMutex_);
+
+    // Copied at once, so the collection may change meanwhile; writing the region below cannot throw, so the sequence
+    // never stays odd
+    const auto devices = collection_.FindDevices({});
+
+    std::atomic_ref sequence(region_->Sequence);
+    const auto seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    UINT32 count = 0;
+    for (const auto & device : devices)
+    {
+        if (count == AC_SNAPSHOT_MAX_DEVICES)
+        {
+            break;
+        }
+        auto & record = region_->Devices[count++];
+        record = {};
+        wcsncpy_s(record.Guid, _countof(record.Guid), device->GetPnpId().c_str(), _TRUNCATE);
+        wcsncpy_s(record.Name, _countof(record.Name), device->GetName().c_str(), _TRUNCATE);
+        record.Flow = static_cast<UINT8>(device->GetFlow());
+        record.RenderVolume = device->GetCurrentRenderVolume();
+        record.CaptureVolume = device->GetCurrentCaptureVolume();
+        record.FormFactor = static_cast<UINT8>(device->GetFormFactor());
+        record.JackConnection = static_cast<UINT8>(device->GetJackConnection());
+    }
+    region_->Count = count;
+
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    ULARGE_INTEGER ticks;
+    ticks.LowPart = now.dwLowDateTime;
+    ticks.HighPart = now.dwHighDateTime;
+    region_->PublishedAt = static_cast<INT64>(ticks.QuadPart);
+
+    sequence.store(seq + 2, std::memory_order_release);
+}
+
+void ed::audio::SnapshotPublisher::OnCollectionChanged(DeviceCollectionEvent, const std::wstring &)
+{
+    Publish();
+}
+
+void ed::audio::SnapshotPublisher::OnCollectionChangedBatch(std::span<const DeviceCollectionChange>)
+{
+    Publish();
+}
+
+void ed::audio::SnapshotPublisher::OnTrace(const std::wstring &)
+{
+}
+
+void ed::audio::SnapshotPublisher::OnTraceDebug(const std::wstring &)
+{
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+
+#include "../AudioController/AudioControlInterface.h"
+#include "../AudioController/AudioSnapshotLayout.h"
+
+
+namespace ed::audio {
+// Mirrors a device collection into a named shared-memory region (see AudioSnapshotLayout.h).
+// Republishes on every collection event (once per batch); call Publish() after ResetContent().
+class SnapshotPublisher final : public SnapshotPublisherInterface, protected DeviceCollectionObserverInterface {
+public:
+    DISALLOW_COPY_MOVE(SnapshotPublisher);
+    ~SnapshotPublisher() override;
+
+public:
+    SnapshotPublisher(DeviceCollectionInterface & collection, const std::wstring & regionName);
+
+    void Publish() override;
+
+protected:
+    void OnCollectionChanged(DeviceCollectionEvent event, const std::wstring & devicePnpId) override;
+    void OnCollectionChangedBatch(std::span<const DeviceCollectionChange> changes) override;
+    void OnTrace(const std::wstring & line) override;
+    void OnTraceDebug(const std::wstring & line) override;
+
+private:
+    DeviceCollectionInterface & collection_;
+    HANDLE mapping_ = nullptr;
+    AcSnapshotRegion * region_ = nullptr;
+    std::mutex publishMutex_;
+};
+}
@@ -0,0 +1,21 @@
+#include "stdafx.h"
+
+#include "TimedDeviceCollection.h"
+
+
+ed::audio::TimedDeviceCollection::TimedDeviceCollection(std::wstring nameFilter, bool bothHeadsetAndMicro, std::unique_ptr<AudioBackendInterface> backend)
+{
+    auto timingBackend = std::make_unique<TimingAudioBackend>(std::move(backend));
+    backend_ = timingBackend.get();
+    collection_ = std::make_unique<DeviceCollection>(std::move(nameFilter), bothHeadsetAndMicro, std::move(timingBackend));
+}
+
+DeviceCollectionInterface & ed::audio::TimedDeviceCollection::GetCollection()
+{
+    return *collection_;
+}
+
+PlatformCallTimes ed::audio::TimedDeviceCollection::GetPlatformCallTimes() const
+{
+    return backend_->GetCallTimes();
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../AudioController/AudioControlInterface.h"
+
+#include "DeviceCollection.h"
+#include "TimingAudioBackend.h"
+
+
+namespace ed::audio {
+class TimedDeviceCollection final : public TimedDeviceCollectionInterface {
+public:
+    DISALLOW_COPY_MOVE(TimedDeviceCollection);
+    ~TimedDeviceCollection() override = default;
+
+public:
+    TimedDeviceCollection(std::wstring nameFilter, bool bothHeadsetAndMicro, std::unique_ptr<AudioBackendInterface> backend);
+
+    DeviceCollectionInterface & GetCollection() override;
+    [[nodiscard]] PlatformCallTimes GetPlatformCallTimes() const override;
+
+private:
+    TimingAudioBackend * backend_;
+    std::unique_ptr<DeviceCollection> collection_;
+};
+}
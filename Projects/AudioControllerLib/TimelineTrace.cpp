@@ -0,0 +1,94 @@
+#include "stdafx.h"
+
+#include "TimelineTrace.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+
+
+/*static*/
+void ed::audio::TimelineTrace::Start(size_t capacity)
+{
+    recording_ = false;
+    slots_ = std::make_unique<Slot[]>(capacity);
+    capacity_ = capacity;
+    next_ = 0;
+    startedAt_ = std::chrono::steady_clock::now();
+    recording_ = true;
+}
+
+/*static*/
+void ed::audio::TimelineTrace::Stop()
+{
+    recording_ = false;
+}
+
+/*static*/
+void ed::audio::TimelineTrace::Record(const char * name, std::chrono::steady_clock::time_point startedAt,
+                                      std::chrono::steady_clock::time_point endedAt) noexcept
+{
+    const auto index = next_.fetch_add(1, std::memory_order_relaxed);
+    if (index >= capacity_)
+    {
+        return;
+    }
+    auto & slot = slots_[index];
+    slot.Name = name;
+    slot.ThreadId = GetCurrentThreadId();
+    slot.StartedAt = startedAt;
+    slot.EndedAt = endedAt;
+    slot.Committed.store(true, std::memory_order_release);
+}
+
+/*static*/
+size_t ed::audio::TimelineTrace::GetRecordedCount()
+{
+    return (std::min)(next_.load(), capacity_);
+}
+
+/*static*/
+size_t ed::audio::TimelineTrace::GetDroppedCount()
+{
+    const auto claimed = next_.load();
+    return claimed > capacity_ ? claimed - capacity_ : 0;
+}
+
+/*static*/
+bool ed::audio::TimelineTrace::TryWriteChromeJson(const std::wstring & filePath)
+{
+    std::ofstream stream(std::filesystem::path(filePath), std::ios::trunc);
+    if (!stream)
+    {
+        return false;
+    }
+
+    const auto toMicroseconds = [](std::chrono::steady_clock::duration duration)
+    {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    };
+    const auto processId = GetCurrentProcessId();
+    const auto recordedCount = GetRecordedCount();
+
+    stream << "{\n  \"displayTimeUnit\": \"ns\",\n  \"otherData\": {\"droppedZones\": " << GetDroppedCount() << "},\n"
+        << "  \"traceEvents\": [" << std::fixed << std::setprecision(3);
+    bool isFirst = true;
+    for (size_t i = 0; i < recordedCount; ++i)
+    {
+        // A zone still being written when the trace stopped is left out
+        const auto & slot = slots_[i];
+        if (!slot.Committed.load(std::memory_order_acquire))
+        {
+            continue;
+        }
+        stream << (isFirst ? "\n" : ",\n")
+            << "    {\"name\": \"" << slot.Name << "\", \"cat\": \"audio\", \"ph\": \"X\""
+            << ", \"ts\": " << toMicroseconds(slot.StartedAt - startedAt_)
+            << ", \"dur\": " << toMicroseconds(slot.EndedAt - slot.StartedAt)
+            << ", \"pid\": " << processId << ", \"tid\": " << slot.ThreadId << "}";
+        isFirst = false;
+    }
+    stream << "\n  ]\n}\n";
+    return static_cast<bool>(stream);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "../AudioController/ClassDefHelper.h"
+
+
+// Define AC_TIMELINE_TRACE as 0 to compile the zones out entirely. Compiled in, a zone costs
+// a relaxed load while no trace is recording, and two clock reads and a slot write while it is.
+#ifndef AC_TIMELINE_TRACE
+#define AC_TIMELINE_TRACE 1
+#endif
+
+#define AC_TIMELINE_CONCAT_INNER(a, b) a##b
+#define AC_TIMELINE_CONCAT(a, b) AC_TIMELINE_CONCAT_INNER(a, b)
+
+#if AC_TIMELINE_TRACE
+// Times the rest of the enclosing scope; name must be a string literal.
+#define AC_TIMELINE_ZONE(name) const ed::audio::TimelineZone AC_TIMELINE_CONCAT(timelineZone, __LINE__)(name)
+#else
+#define AC_TIMELINE_ZONE(name) static_cast<void>(0)
+#endif
+
+
+namespace ed::audio {
+// Process-wide, lock-free buffer of completed zones, written out as a Chrome trace / Perfetto JSON timeline
+// (chrome://tracing, ui.perfetto.dev). Start() must not overlap running zones, so call it before the
+// first collection is created; Stop() and TryWriteChromeJson() may.
+class TimelineTrace final {
+public:
+    DISALLOW_COPY_MOVE(TimelineTrace);
+    TimelineTrace() = delete;
+    ~TimelineTrace() = delete;
+
+public:
+    // Discards the recorded zones and records up to capacity new ones; further zones are dropped.
+    static void Start(size_t capacity);
+    static void Stop();
+    [[nodiscard]] static bool IsRecording() noexcept
+    {
+        return recording_.load(std::memory_order_relaxed);
+    }
+    static void Record(const char * name, std::chrono::steady_clock::time_point startedAt,
+                       std::chrono::steady_clock::time_point endedAt) noexcept;
+
+    [[nodiscard]] static size_t GetRecordedCount();
+    [[nodiscard]] static size_t GetDroppedCount();
+    // Complete ("X") events in microseconds, one track per thread
+    static bool TryWriteChromeJson(const std::wstring & filePath);
+
+private:
+    struct Slot {
+        const char * Name = nullptr;
+        unsigned long ThreadId = 0;
+        std::chrono::steady_clock::time_point StartedAt;
+        std::chrono::steady_clock::time_point EndedAt;
+        std::atomic_bool Committed = false;
+    };
+
+    inline static std::atomic_bool recording_ = false;
+    inline static std::unique_ptr<Slot[]> slots_;
+    inline static size_t capacity_ = 0;
+    inline static std::atomic<size_t> next_ = 0;
+    inline static std::chrono::steady_clock::time_point startedAt_;
+};
+
+// A timeline zone, see AC_TIMELINE_ZONE
+class TimelineZone final {
+public:
+    DISALLOW_COPY_MOVE(TimelineZone);
+    explicit TimelineZone(const char * name) noexcept
+        : name_(TimelineTrace::IsRecording() ? name : nullptr)
+    {
+        if (name_ != nullptr)
+        {
+            startedAt_ = std::chrono::steady_clock::now();
+        }
+    }
+    ~TimelineZone()
+    {
+        if (name_ != nullptr)
+        {
+            TimelineTrace::Record(name_, startedAt_, std::chrono::steady_clock::now());
+        }
+    }
+
+private:
+    const char * const name_;
+    std::chrono::steady_clock::time_point startedAt_;
+};
+}
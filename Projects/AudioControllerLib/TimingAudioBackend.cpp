@@ -0,0 +1,91 @@
+#include "stdafx.h"
+
+#include "TimingAudioBackend.h"
+
+
+ed::audio::TimingAudioBackend::TimingAudioBackend(std::unique_ptr<AudioBackendInterface> backend)
+    : backend_(std::move(backend))
+{
+}
+
+void ed::audio::TimingAudioBackend::Start(MultipleNotificationClient & client, TraceFunctionT traceFunction,
+                                          TraceOnFunctionT isTraceOn)
+{
+    backend_->Start(client, std::move(traceFunction), std::move(isTraceOn));
+}
+
+void ed::audio::TimingAudioBackend::Stop()
+{
+    backend_->Stop();
+}
+
+bool ed::audio::TimingAudioBackend::TryEnumerateActiveEndpoints(bool bothHeadsetAndMicro, std::vector<std::wstring> & endpointIds)
+{
+    ScopedTimer timer(enumerationNs_);
+    return backend_->TryEnumerateActiveEndpoints(bothHeadsetAndMicro, endpointIds);
+}
+
+bool ed::audio::TimingAudioBackend::TryProbeEndpoint(const std::wstring & endpointId, Device & device, TVolumeNotificationToken * volumeToken)
+{
+    ++probeCount_;
+    ScopedTimer timer(probingNs_);
+    return backend_->TryProbeEndpoint(endpointId, device, volumeToken);
+}
+
+bool ed::audio::TimingAudioBackend::TryGetDefaultEndpoint(DeviceFlowEnum flow, DeviceRole role, std::wstring & endpointId)
+{
+    // Asked along with every enumeration
+    ScopedTimer timer(enumerationNs_);
+    return backend_->TryGetDefaultEndpoint(flow, role, endpointId);
+}
+
+bool ed::audio::TimingAudioBackend::TryReadEndpointProperty(const std::wstring & endpointId, EndpointProperty property, Device & device)
+{
+    // Part of a probe, not counted as one
+    ScopedTimer timer(probingNs_);
+    return backend_->TryReadEndpointProperty(endpointId, property, device);
+}
+
+void ed::audio::TimingAudioBackend::RegisterVolumeNotification(const std::wstring & endpointId, TVolumeNotificationToken volumeToken)
+{
+    ScopedTimer timer(volumeRegistrationNs_);
+    backend_->RegisterVolumeNotification(endpointId, std::move(volumeToken));
+}
+
+void ed::audio::TimingAudioBackend::UnregisterVolumeNotification(const std::wstring & endpointId)
+{
+    ScopedTimer timer(volumeRegistrationNs_);
+    backend_->UnregisterVolumeNotification(endpointId);
+}
+
+void ed::audio::TimingAudioBackend::UnregisterAllVolumeNotifications()
+{
+    ScopedTimer timer(volumeRegistrationNs_);
+    backend_->UnregisterAllVolumeNotifications();
+}
+
+size_t ed::audio::TimingAudioBackend::GetVolumeNotificationCount() const
+{
+    return backend_->GetVolumeNotificationCount();
+}
+
+PlatformCallTimes ed::audio::TimingAudioBackend::GetCallTimes() const
+{
+    PlatformCallTimes times;
+    times.Enumeration = std::chrono::nanoseconds(enumerationNs_.load());
+    times.Probing = std::chrono::nanoseconds(probingNs_.load());
+    times.ProbeCount = probeCount_.load();
+    times.VolumeRegistration = std::chrono::nanoseconds(volumeRegistrationNs_.load());
+    return times;
+}
+
+ed::audio::TimingAudioBackend::ScopedTimer::ScopedTimer(std::atomic<int64_t> & nanoseconds)
+    : nanoseconds_(nanoseconds)
+    , startedAt_(std::chrono::steady_clock::now())
+{
+}
+
+ed::audio::TimingAudioBackend::ScopedTimer::~ScopedTimer()
+{
+    nanoseconds_ += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startedAt_).count();
+}
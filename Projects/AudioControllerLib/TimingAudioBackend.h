@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "../AudioController/AudioControlInterface.h"
+
+#include "AudioBackendInterface.h"
+
+
+namespace ed::audio {
+// Decorates another backend and accumulates the time spent in its calls, so the cost of the
+// platform (COM) can be told apart from the overhead of the library. Notifications pass untimed.
+class TimingAudioBackend final : public AudioBackendInterface {
+public:
+    DISALLOW_COPY_MOVE(TimingAudioBackend);
+    ~TimingAudioBackend() override = default;
+
+public:
+    explicit TimingAudioBackend(std::unique_ptr<AudioBackendInterface> backend);
+
+    void Start(MultipleNotificationClient & client, TraceFunctionT traceFunction, TraceOnFunctionT isTraceOn) override;
+    void Stop() override;
+
+    bool TryEnumerateActiveEndpoints(bool bothHeadsetAndMicro, std::vector<std::wstring> & endpointIds) override;
+    bool TryProbeEndpoint(const std::wstring & endpointId, Device & device, TVolumeNotificationToken * volumeToken) override;
+    bool TryGetDefaultEndpoint(DeviceFlowEnum flow, DeviceRole role, std::wstring & endpointId) override;
+    bool TryReadEndpointProperty(const std::wstring & endpointId, EndpointProperty property, Device & device) override;
+
+    void RegisterVolumeNotification(const std::wstring & endpointId, TVolumeNotificationToken volumeToken) override;
+    void UnregisterVolumeNotification(const std::wstring & endpointId) override;
+    void UnregisterAllVolumeNotifications() override;
+    [[nodiscard]] size_t GetVolumeNotificationCount() const override;
+
+    // Accumulated since construction; thread-safe.
+    [[nodiscard]] PlatformCallTimes GetCallTimes() const;
+
+private:
+    // Adds the time elapsed since its construction to the given counter
+    class ScopedTimer final {
+    public:
+        DISALLOW_COPY_MOVE(ScopedTimer);
+        explicit ScopedTimer(std::atomic<int64_t> & nanoseconds);
+        ~ScopedTimer();
+
+    private:
+        std::atomic<int64_t> & nanoseconds_;
+        const std::chrono::steady_clock::time_point startedAt_;
+    };
+
+private:
+    std::unique_ptr<AudioBackendInterface> backend_;
+    std::atomic<int64_t> enumerationNs_ = 0;
+    std::atomic<int64_t> probingNs_ = 0;
+    std::atomic<uint64_t> probeCount_ = 0;
+    std::atomic<int64_t> volumeRegistrationNs_ = 0;
+};
+}
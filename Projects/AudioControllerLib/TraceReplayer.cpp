@@ -0,0 +1,26 @@
+#include "stdafx.h"
+
+#include "TraceReplayer.h"
+
+
+ed::audio::TraceReplayer::TraceReplayer(const std::wstring & traceFilePath, std::wstring nameFilter, bool bothHeadsetAndMicro)
+{
+    auto backend = std::make_unique<ReplayAudioBackend>(traceFilePath);
+    backend_ = backend.get();
+    collection_ = std::make_unique<DeviceCollection>(std::move(nameFilter), bothHeadsetAndMicro, std::move(backend));
+}
+
+DeviceCollectionInterface & ed::audio::TraceReplayer::GetCollection()
+{
+    return *collection_;
+}
+
+size_t ed::audio::TraceReplayer::Replay(double speedFactor)
+{
+    return backend_->Replay(speedFactor);
+}
+
+size_t ed::audio::TraceReplayer::GetNotificationCount() const
+{
+    return backend_->GetNotificationCount();
+}
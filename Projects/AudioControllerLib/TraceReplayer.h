@@ -0,0 +1,26 @@
+#pragma once
+
+#include "../AudioController/AudioControlInterface.h"
+
+#include "DeviceCollection.h"
+#include "ReplayAudioBackend.h"
+
+
+namespace ed::audio {
+class TraceReplayer final : public TraceReplayerInterface {
+public:
+    DISALLOW_COPY_MOVE(TraceReplayer);
+    ~TraceReplayer() override = default;
+
+public:
+    TraceReplayer(const std::wstring & traceFilePath, std::wstring nameFilter, bool bothHeadsetAndMicro);
+
+    DeviceCollectionInterface & GetCollection() override;
+    size_t Replay(double speedFactor) override;
+    [[nodiscard]] size_t GetNotificationCount() const override;
+
+private:
+    ReplayAudioBackend * backend_;
+    std::unique_ptr<DeviceCollection> collection_;
+};
+}
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <memory_resource>
 #include <mmdeviceapi.h>
 #include <set>
 #include <sstream>
+#include <string_view>
 
 #ifdef NDEBUG
 #undef NDEBUG
@@ -30,7 +32,27 @@ inline std::set<std::wstring> Split(const std::wstring & s, const wchar_t delimi
     return result;
 }
 
-inline std::wstring Merge(const std::set<std::wstring> & st, const wchar_t delimiter)
+// As above, with the parts and the set allocated from the given resource, e.g. a notification arena
+inline std::pmr::set<std::pmr::wstring> Split(std::wstring_view s, const wchar_t delimiter, std::pmr::memory_resource * resource)
+{
+    std::pmr::set<std::pmr::wstring> result(resource);
+    size_t begin = 0;
+    while (begin < s.size())
+    {
+        auto end = s.find(delimiter, begin);
+        if (end == std::wstring_view::npos)
+        {
+            end = s.size();
+        }
+        result.emplace(s.substr(begin, end - begin));
+        begin = end + 1;
+    }
+
+    return result;
+}
+
+template <class TStringSet>
+std::wstring Merge(const TStringSet & st, const wchar_t delimiter)
 {
     size_t i = 0;
     std::wstring result;
@@ -23,6 +23,7 @@
 #include <string>
 
 #include "Utilities.h"
+#include "NotificationArena.h"
 
 #include <TimeUtils.h>
 #include <PrefixStream.h>
@@ -41,10 +42,13 @@
 #define PUT_TO_STREAM_LOG(oss, inp)
 #endif //_NO_LOG_
 
-#define LOG_INFO(inp) { std::wostringstream oss; \
+// The line is only formatted if somebody listens to it, within a notification-handling pass in its arena
+#define LOG_INFO(inp) { if (IsTraceOn()) { \
+                ed::audio::ArenaWideStringStream oss(std::ios_base::out, ed::audio::NotificationArena::GetCurrentResource()); \
                 PUT_TO_STREAM_LOG(oss, inp); \
-                TraceIt(oss.str().c_str()); }
+                TraceIt(std::wstring(oss.view())); } }
 
-#define LOG_INFO_COLL(inp, coll) { std::wostringstream oss; \
+#define LOG_INFO_COLL(inp, coll) { if ((coll)->IsTraceOn()) { \
+                ed::audio::ArenaWideStringStream oss(std::ios_base::out, ed::audio::NotificationArena::GetCurrentResource()); \
                 PUT_TO_STREAM_LOG(oss, inp); \
-                (coll)->TraceIt(oss.str().c_str()); }
+                (coll)->TraceIt(std::wstring(oss.view())); } }
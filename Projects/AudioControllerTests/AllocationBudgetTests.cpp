@@ -0,0 +1,135 @@
+#include "stdafx.h"
+
+#include <functional>
+
+#include <CppUnitTest.h>
+
+#include "../AudioController/AudioControlInterface.h"
+#include "AllocationCounter.h"
+#include "DeviceCollection.h"
+#include "NotificationArena.h"
+#include "RecordingObserver.h"
+#include "SimulatedAudioBackend.h"
+#include "Utilities.h"
+
+
+using namespace std::literals::string_literals;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace ed::audio {
+// Allocation budgets per operation. Budgets independent of the device count are checked by comparing
+// a small and a large collection, so they hold for any standard library; an operation is run once
+// before it is counted, so that one-off allocations (e.g. of the observer's event list) are not.
+TEST_CLASS(AllocationBudgetTests) {
+    using TOperation = std::function<void(SimulatedAudioBackend &, DeviceCollectionInterface &)>;
+
+    // Allocations of the operation, run on a populated collection of containerCount render devices
+    static uint64_t CountAllocations(size_t containerCount, bool isObserved, const TOperation & operation)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(containerCount, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+        RecordingObserver observer;
+        if (isObserved)
+        {
+            collection.Subscribe(observer);
+        }
+
+        operation(simulation, collection);
+        uint64_t allocationCount;
+        {
+            const AllocationCounter counter;
+            operation(simulation, collection);
+            allocationCount = counter.GetCount();
+        }
+
+        if (isObserved)
+        {
+            collection.Unsubscribe(observer);
+        }
+        return allocationCount;
+    }
+
+    static void SetVolume(SimulatedAudioBackend & simulation, DeviceCollectionInterface &)
+    {
+        static uint16_t volume = 100;
+        volume = volume == 100 ? 200 : 100;
+        simulation.SetVolume(SimulatedAudioBackend::MakeEndpoint(0, DeviceFlowEnum::Render).EndpointId, volume);
+    }
+
+    TEST_METHOD(VolumeNotificationOfKnownDeviceAllocatesNothingTest)
+    {
+        const auto endpointId = SimulatedAudioBackend::MakeEndpoint(0, DeviceFlowEnum::Render).EndpointId;
+        const auto allocationCount = CountAllocations(10, false,
+            [&endpointId](SimulatedAudioBackend & simulation, DeviceCollectionInterface &)
+            {
+                simulation.SetVolume(endpointId, 300);
+                simulation.SetVolume(endpointId, 400);
+            });
+
+        Assert::AreEqual(uint64_t{0}, allocationCount);
+    }
+
+    TEST_METHOD(ObservedVolumeNotificationBudgetIsIndependentOfDeviceCountTest)
+    {
+        const auto fewDevices = CountAllocations(10, true, &SetVolume);
+        const auto manyDevices = CountAllocations(1000, true, &SetVolume);
+
+        Assert::AreEqual(fewDevices, manyDevices);
+        // The event's plug-and-play id and device, matched by the subscriptions, and the observer's record of the event
+        Assert::IsTrue(fewDevices <= 16);
+    }
+
+    TEST_METHOD(AddRemoveBudgetIsIndependentOfDeviceCountTest)
+    {
+        const auto addRemove = [](SimulatedAudioBackend & simulation, DeviceCollectionInterface &)
+        {
+            const auto endpointId = SimulatedAudioBackend::MakeEndpoint(0, DeviceFlowEnum::Render).EndpointId;
+            simulation.SetEndpointState(endpointId, DEVICE_STATE_DISABLED);
+            simulation.SetEndpointState(endpointId, DEVICE_STATE_ACTIVE);
+        };
+
+        const auto fewDevices = CountAllocations(10, true, addRemove);
+        const auto manyDevices = CountAllocations(1000, true, addRemove);
+
+        Assert::AreEqual(fewDevices, manyDevices);
+    }
+
+    TEST_METHOD(CreateItemBudgetIsIndependentOfDeviceCountTest)
+    {
+        const auto createItem = [](SimulatedAudioBackend &, DeviceCollectionInterface & collection)
+        {
+            // ReSharper disable once CppNoDiscardExpression
+            collection.CreateItem(collection.GetSize() - 1);
+        };
+
+        const auto fewDevices = CountAllocations(10, false, createItem);
+        const auto manyDevices = CountAllocations(1000, false, createItem);
+
+        Assert::AreEqual(fewDevices, manyDevices);
+        // The device and its name and plug-and-play id
+        Assert::IsTrue(fewDevices <= 3);
+    }
+
+    TEST_METHOD(SplitInNotificationArenaAllocatesNothingTest)
+    {
+        const auto mergedName = L"Microphone (Simulated Device 0)/Speakers (Simulated Device 0)"s;
+        const auto expected = Split(mergedName, L'/');
+        uint64_t allocationCount;
+        bool isEqual;
+        {
+            const NotificationArena arena;
+            const AllocationCounter counter;
+            const auto parts = Split(mergedName, L'/', NotificationArena::GetCurrentResource());
+            allocationCount = counter.GetCount();
+            isEqual = Merge(parts, L'/') == Merge(expected, L'/');
+        }
+
+        Assert::AreEqual(uint64_t{0}, allocationCount);
+        Assert::IsTrue(isEqual);
+    }
+};
+}
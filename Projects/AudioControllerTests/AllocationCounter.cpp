@@ -0,0 +1,106 @@
+#include "stdafx.h"
+
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+namespace
+{
+thread_local uint64_t allocationCount = 0;
+std::atomic<int64_t> liveBlockCount = 0;
+
+void * Allocate(size_t size) noexcept
+{
+    ++allocationCount;
+    void * memory = malloc(size == 0 ? 1 : size);
+    if (memory != nullptr)
+    {
+        liveBlockCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    return memory;
+}
+
+void Free(void * memory) noexcept
+{
+    if (memory != nullptr)
+    {
+        liveBlockCount.fetch_sub(1, std::memory_order_relaxed);
+        free(memory);
+    }
+}
+}
+
+ed::audio::AllocationCounter::AllocationCounter()
+    : startedAt_(allocationCount)
+{
+}
+
+uint64_t ed::audio::AllocationCounter::GetCount() const
+{
+    return allocationCount - startedAt_;
+}
+
+/*static*/
+int64_t ed::audio::AllocationCounter::GetLiveBlockCount()
+{
+    return liveBlockCount.load(std::memory_order_relaxed);
+}
+
+// Replaceable global allocation functions; the aligned overloads are not used by the library
+
+void * operator new(size_t size)
+{
+    if (void * memory = Allocate(size); memory != nullptr)
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void * operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void * operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return Allocate(size);
+}
+
+void * operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return Allocate(size);
+}
+
+void operator delete(void * memory) noexcept
+{
+    Free(memory);
+}
+
+void operator delete[](void * memory) noexcept
+{
+    Free(memory);
+}
+
+void operator delete(void * memory, size_t) noexcept
+{
+    Free(memory);
+}
+
+void operator delete[](void * memory, size_t) noexcept
+{
+    Free(memory);
+}
+
+void operator delete(void * memory, const std::nothrow_t &) noexcept
+{
+    Free(memory);
+}
+
+void operator delete[](void * memory, const std::nothrow_t &) noexcept
+{
+    Free(memory);
+}
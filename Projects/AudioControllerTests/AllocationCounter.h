@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../AudioController/ClassDefHelper.h"
+
+
+namespace ed::audio {
+// Counts the heap allocations made by the current thread while in scope. The test module replaces
+// the global operator new (AllocationCounter.cpp), so every new, make_unique and container growth counts;
+// the simulated backend notifies synchronously, so an operation and its callbacks run on one thread.
+// GetLiveBlockCount() counts the blocks not yet freed, process-wide, e.g. to tell a leak from churn.
+class AllocationCounter final {
+public:
+    DISALLOW_COPY_MOVE(AllocationCounter);
+    AllocationCounter();
+    ~AllocationCounter() = default;
+
+    [[nodiscard]] uint64_t GetCount() const;
+    [[nodiscard]] static int64_t GetLiveBlockCount();
+
+private:
+    const uint64_t startedAt_;
+};
+}
@@ -8,6 +8,7 @@
 #include "Device.h"
 #include "../AudioControllerLib/generate-uuid.h"
 #include "CaseInsensitiveSubstr.h"
+#include "DeviceTableCache.h"
 
 
 
@@ -47,5 +48,40 @@ TEST_CLASS(AudioControllerLibTests) {
 
         Assert::IsFalse(FindSubstrCaseInsensitive(string01, substr02 + L"2"));
     }
+
+    TEST_METHOD(DeviceTableCacheRoundTripTest)
+    {
+        wchar_t tempDir[MAX_PATH];
+        GetTempPathW(MAX_PATH, tempDir);
+        const auto cacheFile = std::wstring(tempDir) + L"DeviceTableCacheTest-" + generate_w_uuid() + L".cache";
+        const DeviceTableCache cache(cacheFile);
+
+        std::vector<Device> loaded;
+        Assert::IsFalse(cache.Load(loaded));
+
+        const std::vector saved{
+            Device(generate_w_uuid(), L"Headset"s, DeviceFlowEnum::RenderAndCapture, 100, 200),
+            Device(generate_w_uuid(), L"Speakers"s, DeviceFlowEnum::Render, 300, 0)
+        };
+        Assert::IsTrue(cache.Save(saved));
+        Assert::IsTrue(cache.Load(loaded));
+        Assert::AreEqual(saved.size(), loaded.size());
+        Assert::AreEqual(saved[1].GetPnpId(), loaded[1].GetPnpId());
+        Assert::AreEqual(saved[1].GetName(), loaded[1].GetName());
+        Assert::AreEqual(saved[0].GetCurrentCaptureVolume(), loaded[0].GetCurrentCaptureVolume());
+
+        // A flipped byte in a record must invalidate the checksum
+        {
+            const HANDLE file = CreateFileW(cacheFile.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+            Assert::IsTrue(file != INVALID_HANDLE_VALUE);
+            SetFilePointer(file, 64, nullptr, FILE_BEGIN);
+            constexpr BYTE garbage = 0x5A;
+            DWORD written = 0;
+            WriteFile(file, &garbage, 1, &written, nullptr);
+            CloseHandle(file);
+        }
+        Assert::IsFalse(cache.Load(loaded));
+        DeleteFileW(cacheFile.c_str());
+    }
 };
 }
@@ -0,0 +1,141 @@
+#include "stdafx.h"
+
+#include <chrono>
+#include <thread>
+
+#include <CppUnitTest.h>
+
+#include "../AudioController/AudioControlInterface.h"
+#include "DeviceCollection.h"
+#include "RecordingObserver.h"
+#include "SimulatedAudioBackend.h"
+
+
+using namespace std::literals::string_literals;
+using namespace std::literals::chrono_literals;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace ed::audio {
+TEST_CLASS(BurstTests) {
+    TEST_METHOD(StormIsDeliveredAsOneBatchOfNetChangesTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(3, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+        RecordingObserver observer;
+        collection.Subscribe(observer);
+        // Long enough not to elapse during the test
+        collection.SetBurstWindow(1h);
+
+        const auto plugged = SimulatedAudioBackend::MakeEndpoint(10, DeviceFlowEnum::Render);
+        const auto flapping = SimulatedAudioBackend::MakeEndpoint(11, DeviceFlowEnum::Render);
+        const auto disabled = SimulatedAudioBackend::MakeEndpoint(0, DeviceFlowEnum::Render);
+        simulation.AddEndpoint(plugged);
+        for (int i = 0; i < 5; ++i)
+        {
+            simulation.AddEndpoint(flapping);
+            simulation.RemoveEndpoint(flapping.EndpointId);
+        }
+        simulation.SetEndpointState(disabled.EndpointId, DEVICE_STATE_DISABLED);
+
+        // Queued, not applied yet
+        Assert::AreEqual(size_t{3}, collection.GetSize());
+        Assert::AreEqual(size_t{0}, observer.GetEvents().size());
+
+        collection.FlushBurst();
+        collection.SetBurstWindow(0ms);
+        collection.Unsubscribe(observer);
+
+        const auto events = observer.GetEvents();
+        Assert::AreEqual(size_t{1}, observer.GetBatchCount());
+        Assert::AreEqual(size_t{2}, events.size());
+        Assert::IsTrue(events[0].first == DeviceCollectionEvent::Detached);
+        Assert::AreEqual(disabled.ContainerId, events[0].second);
+        Assert::IsTrue(events[1].first == DeviceCollectionEvent::Discovered);
+        Assert::AreEqual(plugged.ContainerId, events[1].second);
+        Assert::AreEqual(size_t{3}, collection.GetSize());
+        Assert::AreEqual(uint64_t{0}, collection.GetOperationalCounters().PendingNotifications);
+    }
+
+    TEST_METHOD(BurstIsAppliedAfterQuietWindowTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(3, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+        RecordingObserver observer;
+        collection.Subscribe(observer);
+        collection.SetBurstWindow(5ms);
+
+        for (size_t i = 10; i < 14; ++i)
+        {
+            simulation.AddEndpoint(SimulatedAudioBackend::MakeEndpoint(i, DeviceFlowEnum::Render));
+        }
+        const auto deadline = std::chrono::steady_clock::now() + 10s;
+        while (observer.GetEvents().size() < 4 && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+        collection.Unsubscribe(observer);
+
+        Assert::AreEqual(size_t{4}, observer.GetEvents().size());
+        // Usually one; a slow machine may split the burst
+        Assert::IsTrue(observer.GetBatchCount() >= 1);
+        Assert::AreEqual(size_t{7}, collection.GetSize());
+    }
+
+    TEST_METHOD(BurstProbesWithoutHoldingTheCollectionTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(3, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+        collection.SetBurstWindow(1h);
+        for (size_t i = 10; i < 14; ++i)
+        {
+            simulation.AddEndpoint(SimulatedAudioBackend::MakeEndpoint(i, DeviceFlowEnum::Render));
+        }
+        simulation.SetLatency(20ms);
+        const auto probes = simulation.GetCallCount(SimulatedCall::Probe);
+
+        std::thread flush([&collection] { collection.FlushBurst(); });
+        while (simulation.GetCallCount(SimulatedCall::Probe) == probes)
+        {
+            std::this_thread::yield();
+        }
+        // Readable, and unchanged, while the burst probes; its net changes appear at once afterwards
+        const auto sizeWhileProbing = collection.GetSize();
+        flush.join();
+        collection.SetBurstWindow(0ms);
+
+        Assert::AreEqual(size_t{3}, sizeWhileProbing);
+        Assert::AreEqual(size_t{7}, collection.GetSize());
+        Assert::AreEqual(uint64_t{7}, collection.GetOperationalCounters().VolumeCallbacks);
+    }
+
+    TEST_METHOD(VolumeChangesAreNeverQueuedTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(3, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+        RecordingObserver observer;
+        collection.Subscribe(observer);
+        collection.SetBurstWindow(1h);
+
+        simulation.SetVolume(SimulatedAudioBackend::MakeEndpoint(1, DeviceFlowEnum::Render).EndpointId, 123);
+        const auto events = observer.GetEvents();
+        collection.Unsubscribe(observer);
+
+        Assert::AreEqual(size_t{1}, events.size());
+        Assert::IsTrue(events[0].first == DeviceCollectionEvent::VolumeChanged);
+        Assert::AreEqual(size_t{0}, observer.GetBatchCount());
+    }
+};
+}
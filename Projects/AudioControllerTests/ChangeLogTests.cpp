@@ -0,0 +1,74 @@
+#include "stdafx.h"
+
+#include <CppUnitTest.h>
+
+#include "../AudioController/AudioControlInterface.h"
+#include "DeviceCollection.h"
+#include "SimulatedAudioBackend.h"
+
+
+using namespace std::literals::string_literals;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace ed::audio {
+TEST_CLASS(ChangeLogTests) {
+    TEST_METHOD(ChangesAreLoggedWithoutObserversTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(3, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+        // ResetContent() logs its differences, too
+        const auto sequence = collection.GetSequence();
+        Assert::AreEqual(uint64_t{3}, sequence);
+
+        const auto plugged = SimulatedAudioBackend::MakeEndpoint(10, DeviceFlowEnum::Render);
+        const auto unplugged = SimulatedAudioBackend::MakeEndpoint(1, DeviceFlowEnum::Render);
+        simulation.AddEndpoint(plugged);
+        simulation.SetVolume(plugged.EndpointId, 250);
+        // Unchanged: not logged
+        simulation.SetVolume(plugged.EndpointId, 250);
+        simulation.RemoveEndpoint(unplugged.EndpointId);
+
+        const auto changesSince = collection.GetChangesSince(sequence);
+        Assert::IsTrue(changesSince.IsComplete);
+        Assert::AreEqual(sequence + 3, changesSince.Sequence);
+        Assert::AreEqual(size_t{3}, changesSince.Changes.size());
+        Assert::IsTrue(changesSince.Changes[0].Event == DeviceCollectionEvent::Discovered);
+        Assert::AreEqual(plugged.ContainerId, changesSince.Changes[0].PnpId);
+        Assert::IsTrue(changesSince.Changes[1].Event == DeviceCollectionEvent::VolumeChanged);
+        Assert::AreEqual(plugged.ContainerId, changesSince.Changes[1].PnpId);
+        Assert::IsTrue(changesSince.Changes[2].Event == DeviceCollectionEvent::Detached);
+        Assert::AreEqual(unplugged.ContainerId, changesSince.Changes[2].PnpId);
+
+        const auto nothingSince = collection.GetChangesSince(changesSince.Sequence);
+        Assert::IsTrue(nothingSince.IsComplete);
+        Assert::AreEqual(size_t{0}, nothingSince.Changes.size());
+    }
+
+    TEST_METHOD(OverwrittenChangesAskForSnapshotTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(3, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+
+        const auto endpointId = SimulatedAudioBackend::MakeEndpoint(0, DeviceFlowEnum::Render).EndpointId;
+        for (uint16_t volume = 1; volume <= 1000; ++volume)
+        {
+            simulation.SetVolume(endpointId, volume);
+        }
+        const auto sequence = collection.GetSequence();
+
+        Assert::IsFalse(collection.GetChangesSince(0).IsComplete);
+        Assert::IsFalse(collection.GetChangesSince(sequence + 1).IsComplete);
+        const auto lastChanges = collection.GetChangesSince(sequence - 200);
+        Assert::IsTrue(lastChanges.IsComplete);
+        Assert::AreEqual(size_t{200}, lastChanges.Changes.size());
+        Assert::IsTrue(lastChanges.Changes.back().Event == DeviceCollectionEvent::VolumeChanged);
+    }
+};
+}
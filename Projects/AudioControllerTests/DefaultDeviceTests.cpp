@@ -0,0 +1,127 @@
+#include "stdafx.h"
+
+#include <chrono>
+#include <thread>
+
+#include <CppUnitTest.h>
+
+#include "../AudioController/AudioControlInterface.h"
+#include "DeviceCollection.h"
+#include "RecordingObserver.h"
+#include "SimulatedAudioBackend.h"
+
+
+using namespace std::literals::chrono_literals;
+using namespace std::literals::string_literals;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace ed::audio {
+TEST_CLASS(DefaultDeviceTests) {
+    TEST_METHOD(DefaultChangesAreTrackedWithoutProbingTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(10, true);
+        const auto speakers3 = SimulatedAudioBackend::MakeEndpoint(3, DeviceFlowEnum::Render);
+        const auto speakers5 = SimulatedAudioBackend::MakeEndpoint(5, DeviceFlowEnum::Render);
+        simulation.SetDefaultEndpoint(DeviceFlowEnum::Render, DeviceRole::Console, speakers3.EndpointId);
+        DeviceCollection collection(L""s, true, std::move(backend));
+        collection.ResetContent();
+
+        // Asked by ResetContent()
+        const auto console = collection.GetDefaultDevice(DeviceFlowEnum::Render, DeviceRole::Console);
+        Assert::IsTrue(console != nullptr);
+        Assert::AreEqual(speakers3.ContainerId, console->GetPnpId());
+        Assert::IsTrue(console->IsDefault(DeviceFlowEnum::Render, DeviceRole::Console));
+        Assert::IsFalse(console->IsDefault(DeviceFlowEnum::Render, DeviceRole::Communications));
+        Assert::IsTrue(collection.GetDefaultDevice(DeviceFlowEnum::Capture, DeviceRole::Console) == nullptr);
+
+        RecordingObserver observer;
+        collection.Subscribe(observer, {.Events = DeviceCollectionEventMask::DefaultChanged});
+        const auto probes = simulation.GetCallCount(SimulatedCall::Probe);
+        simulation.SetDefaultEndpoint(DeviceFlowEnum::Render, DeviceRole::Console, speakers5.EndpointId);
+        simulation.SetVolume(speakers5.EndpointId, 100);
+
+        const RecordingObserver::TEventList moved{
+            {DeviceCollectionEvent::DefaultChanged, speakers3.ContainerId}, {DeviceCollectionEvent::DefaultChanged, speakers5.ContainerId}
+        };
+        Assert::IsTrue(moved == observer.GetEvents());
+        Assert::AreEqual(probes, simulation.GetCallCount(SimulatedCall::Probe));
+        Assert::AreEqual(speakers5.ContainerId, collection.GetDefaultDevice(DeviceFlowEnum::Render, DeviceRole::Console)->GetPnpId());
+        Assert::IsFalse(collection.FindDevices({.NamePrefix = L"Speakers (Simulated Device 3)"})[0]->IsDefault(DeviceFlowEnum::Render, DeviceRole::Console));
+
+        // Unchanged, then none
+        simulation.SetDefaultEndpoint(DeviceFlowEnum::Render, DeviceRole::Console, speakers5.EndpointId);
+        simulation.SetDefaultEndpoint(DeviceFlowEnum::Render, DeviceRole::Console, L""s);
+        Assert::AreEqual(size_t{3}, observer.GetEvents().size());
+        Assert::IsTrue(collection.GetDefaultDevice(DeviceFlowEnum::Render, DeviceRole::Console) == nullptr);
+        Assert::AreEqual(uint64_t{3}, collection.GetOperationalCounters().DefaultDeviceChangedNotifications);
+        collection.Unsubscribe(observer);
+    }
+
+    TEST_METHOD(DefaultNotifiedDuringResetIsKeptTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(5, false);
+        const auto speakers1 = SimulatedAudioBackend::MakeEndpoint(1, DeviceFlowEnum::Render);
+        const auto speakers3 = SimulatedAudioBackend::MakeEndpoint(3, DeviceFlowEnum::Render);
+        simulation.SetDefaultEndpoint(DeviceFlowEnum::Render, DeviceRole::Console, speakers3.EndpointId);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+        simulation.SetLatency(20ms);
+        const auto queries = simulation.GetCallCount(SimulatedCall::GetDefault);
+
+        // Once the reset has been answered the console default, before it takes the answers
+        std::thread reset([&collection] { collection.ResetContent(); });
+        while (simulation.GetCallCount(SimulatedCall::GetDefault) < queries + 2)
+        {
+            std::this_thread::yield();
+        }
+        simulation.SetDefaultEndpoint(DeviceFlowEnum::Render, DeviceRole::Console, speakers1.EndpointId);
+        reset.join();
+        simulation.SetLatency(0ms);
+
+        // Not reverted to the answer of the reset
+        Assert::AreEqual(speakers1.ContainerId, collection.GetDefaultDevice(DeviceFlowEnum::Render, DeviceRole::Console)->GetPnpId());
+        Assert::IsTrue(collection.FindDevices({.NamePrefix = L"Speakers (Simulated Device 1)"})[0]->IsDefault(DeviceFlowEnum::Render, DeviceRole::Console));
+    }
+
+    TEST_METHOD(DefaultFollowsMergesRemovalsAndFiltersTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(10, true);
+        DeviceCollection collection(L""s, true, std::move(backend));
+        collection.ResetContent();
+        const auto speakers4 = SimulatedAudioBackend::MakeEndpoint(4, DeviceFlowEnum::Render);
+        const auto microphone4 = SimulatedAudioBackend::MakeEndpoint(4, DeviceFlowEnum::Capture);
+        simulation.SetDefaultEndpoint(DeviceFlowEnum::Capture, DeviceRole::Communications, microphone4.EndpointId);
+        const auto isDefault = [&collection]
+        {
+            const auto device = collection.GetDefaultDevice(DeviceFlowEnum::Capture, DeviceRole::Communications);
+            return device != nullptr && device->IsDefault(DeviceFlowEnum::Capture, DeviceRole::Communications);
+        };
+        Assert::IsTrue(isDefault());
+
+        // The device unmerged from its other endpoint stays the default
+        simulation.RemoveEndpoint(speakers4.EndpointId);
+        Assert::IsTrue(isDefault());
+        Assert::IsTrue(DeviceFlowEnum::Capture == collection.GetDefaultDevice(DeviceFlowEnum::Capture, DeviceRole::Communications)->GetFlow());
+
+        // Gone with its endpoint, and back with it
+        simulation.RemoveEndpoint(microphone4.EndpointId);
+        Assert::IsTrue(collection.GetDefaultDevice(DeviceFlowEnum::Capture, DeviceRole::Communications) == nullptr);
+        simulation.AddEndpoint(microphone4);
+        Assert::IsTrue(isDefault());
+
+        // Filtered out, and in again
+        collection.SetFilter(L"(Simulated Device 7)"s);
+        Assert::IsTrue(collection.GetDefaultDevice(DeviceFlowEnum::Capture, DeviceRole::Communications) == nullptr);
+        collection.SetFilter(L""s);
+        Assert::IsTrue(isDefault());
+        Assert::AreEqual(microphone4.ContainerId, collection.GetDefaultDevice(DeviceFlowEnum::Capture, DeviceRole::Communications)->GetPnpId());
+    }
+};
+}
@@ -0,0 +1,133 @@
+#include "stdafx.h"
+
+#include <CppUnitTest.h>
+
+#include "../AudioController/DeviceCollectionCoroutines.h"
+#include "DeviceCollection.h"
+#include "FakeDeviceCollection.h"
+#include "SimulatedAudioBackend.h"
+
+
+using namespace std::literals::string_literals;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace ed::audio {
+namespace {
+    // Minimal eager coroutine type, enough to drive the awaitables in a test
+    struct Detached {
+        struct promise_type {
+            Detached get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    Detached ConsumeBatches(coro::EventStream & stream, std::vector<std::vector<coro::CollectionEvent>> & batches)
+    {
+        for (auto batch = co_await stream.NextBatch(); !batch.empty(); batch = co_await stream.NextBatch())
+        {
+            batches.push_back(std::move(batch));
+        }
+    }
+
+    Detached ResetAndMark(DeviceCollectionInterface & collection, bool & completed)
+    {
+        co_await coro::ResetContentAsync(collection);
+        completed = true;
+    }
+
+    Detached ResetTwiceAndDestroy(std::unique_ptr<DeviceCollection> & collection, size_t & size, std::promise<void> & done)
+    {
+        co_await coro::ResetContentAsync(*collection);
+        co_await coro::ResetContentAsync(*collection);
+        size = collection->GetSize();
+        collection.reset();
+        done.set_value();
+    }
+
+    Detached ResetAndCatch(DeviceCollectionInterface & collection, std::promise<void> & done)
+    {
+        try
+        {
+            co_await coro::ResetContentAsync(collection);
+            done.set_value();
+        }
+        catch (...)
+        {
+            done.set_exception(std::current_exception());
+        }
+    }
+}
+
+TEST_CLASS(DeviceCollectionCoroutinesTests) {
+    TEST_METHOD(EventsAreBatchedAndResumedInlineTest)
+    {
+        FakeDeviceCollection collection;
+        const auto stream = coro::Events(collection);
+
+        // Events available before the first await arrive as one batch
+        collection.Notify(DeviceCollectionEvent::Discovered, L"pnp1"s);
+        collection.Notify(DeviceCollectionEvent::VolumeChanged, L"pnp1"s);
+
+        std::vector<std::vector<coro::CollectionEvent>> batches;
+        ConsumeBatches(*stream, batches);
+        Assert::AreEqual(size_t{1}, batches.size());
+        Assert::AreEqual(size_t{2}, batches[0].size());
+        Assert::IsTrue(batches[0][1].Event == DeviceCollectionEvent::VolumeChanged);
+
+        // The suspended consumer is resumed directly by the delivering thread
+        collection.Notify(DeviceCollectionEvent::Detached, L"pnp1"s);
+        Assert::AreEqual(size_t{2}, batches.size());
+        Assert::AreEqual(L"pnp1"s, batches[1][0].PnpId);
+
+        stream->Close();
+        collection.Notify(DeviceCollectionEvent::Discovered, L"pnp2"s);
+        Assert::AreEqual(size_t{2}, batches.size());
+    }
+
+    TEST_METHOD(ResetContentAsyncResumesOnCompletionTest)
+    {
+        FakeDeviceCollection collection;
+        bool completed = false;
+        ResetAndMark(collection, completed);
+        Assert::IsTrue(completed);
+    }
+
+    TEST_METHOD(ResetMayBeAwaitedAgainAndTheCollectionDestroyedTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        backend->Populate(10, false);
+        auto collection = std::make_unique<DeviceCollection>(L""s, false, std::move(backend));
+        size_t size = 0;
+        std::promise<void> done;
+        ResetTwiceAndDestroy(collection, size, done);
+
+        done.get_future().get();
+        Assert::AreEqual(size_t{10}, size);
+        Assert::IsTrue(collection == nullptr);
+    }
+
+    TEST_METHOD(FailedResetThrowsFromTheAwaitTest)
+    {
+        class ThrowingObserver final : public DeviceCollectionObserverInterface {
+        public:
+            void OnCollectionChanged(DeviceCollectionEvent, const std::wstring &) override { throw std::runtime_error("Observer failed"); }
+            void OnTrace(const std::wstring &) override {}
+            void OnTraceDebug(const std::wstring &) override {}
+        };
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        backend->Populate(10, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        ThrowingObserver observer;
+        collection.Subscribe(observer);
+        std::promise<void> done;
+        ResetAndCatch(collection, done);
+
+        Assert::ExpectException<std::runtime_error>([&done] { done.get_future().get(); });
+        collection.Unsubscribe(observer);
+    }
+};
+}
@@ -0,0 +1,127 @@
+#include "stdafx.h"
+
+#include <CppUnitTest.h>
+
+#include "../AudioController/AudioControlInterface.h"
+#include "DeviceCollection.h"
+#include "SimulatedAudioBackend.h"
+
+
+using namespace std::literals::string_literals;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace ed::audio {
+TEST_CLASS(DeviceQueryTests) {
+    static std::vector<std::wstring> GetPnpIds(const std::vector<std::unique_ptr<DeviceInterface>> & devices)
+    {
+        std::vector<std::wstring> pnpIds;
+        for (const auto & device : devices)
+        {
+            pnpIds.push_back(device->GetPnpId());
+        }
+        return pnpIds;
+    }
+
+    TEST_METHOD(QueryFollowsAddsRemovesAndVolumeChangesTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(20, true);
+        DeviceCollection collection(L""s, true, std::move(backend));
+        collection.ResetContent();
+        const auto microphone1 = SimulatedAudioBackend::MakeEndpoint(1, DeviceFlowEnum::Capture);
+        const auto microphone100 = SimulatedAudioBackend::MakeEndpoint(100, DeviceFlowEnum::Capture);
+        simulation.AddEndpoint(microphone100);
+        // Devices 1, 10 to 19 and 100
+        const DeviceQuery mutedMicrophones{.Flow = DeviceFlowEnum::Capture, .NamePrefix = L"microphone (SIMULATED device 1", .MaxVolume = 0};
+
+        Assert::AreEqual(size_t{0}, collection.FindDevices(mutedMicrophones).size());
+
+        simulation.SetVolume(microphone1.EndpointId, 0, true);
+        simulation.SetVolume(microphone100.EndpointId, 0, true);
+        const std::vector bothMuted{microphone1.ContainerId, microphone100.ContainerId};
+        Assert::IsTrue(bothMuted == GetPnpIds(collection.FindDevices(mutedMicrophones)));
+
+        simulation.RemoveEndpoint(microphone100.EndpointId);
+        simulation.SetVolume(SimulatedAudioBackend::MakeEndpoint(1, DeviceFlowEnum::Render).EndpointId, 0, true);
+        const std::vector oneMuted{microphone1.ContainerId};
+        Assert::IsTrue(oneMuted == GetPnpIds(collection.FindDevices(mutedMicrophones)));
+        // A plug-and-play id is looked up, and checked against the other criteria
+        Assert::IsTrue(oneMuted == GetPnpIds(collection.FindDevices({.PnpId = microphone1.ContainerId, .Flow = DeviceFlowEnum::Capture, .MaxVolume = 0})));
+        Assert::AreEqual(size_t{0}, collection.FindDevices({.PnpId = microphone1.ContainerId, .Flow = DeviceFlowEnum::Capture, .MinVolume = 1}).size());
+        Assert::AreEqual(size_t{0}, collection.FindDevices({.PnpId = microphone100.ContainerId}).size());
+
+        simulation.SetVolume(microphone1.EndpointId, 300);
+        Assert::AreEqual(size_t{0}, collection.FindDevices(mutedMicrophones).size());
+    }
+
+    TEST_METHOD(FlowAndVolumeRangeQueriesMatchAScanTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(50, false);
+        DeviceCollection collection(L""s, true, std::move(backend));
+        collection.ResetContent();
+        for (size_t i = 0; i < 50; ++i)
+        {
+            simulation.SetVolume(SimulatedAudioBackend::MakeEndpoint(i, DeviceFlowEnum::Render).EndpointId, static_cast<uint16_t>(i * 10));
+        }
+        for (size_t i = 50; i < 60; ++i)
+        {
+            simulation.AddEndpoint(SimulatedAudioBackend::MakeEndpoint(i, DeviceFlowEnum::Capture));
+        }
+        const DeviceQuery query{.Flow = DeviceFlowEnum::Render, .MinVolume = 100, .MaxVolume = 200};
+
+        std::vector<std::wstring> scanned;
+        for (size_t i = 0; i < collection.GetSize(); ++i)
+        {
+            const auto device = collection.CreateItem(i);
+            if (device->GetFlow() == DeviceFlowEnum::Render
+                && device->GetCurrentRenderVolume() >= query.MinVolume && device->GetCurrentRenderVolume() <= query.MaxVolume)
+            {
+                scanned.push_back(device->GetPnpId());
+            }
+        }
+
+        Assert::AreEqual(size_t{11}, scanned.size());
+        Assert::IsTrue(scanned == GetPnpIds(collection.FindDevices(query)));
+        Assert::AreEqual(size_t{10}, collection.FindDevices({.Flow = DeviceFlowEnum::Capture}).size());
+        Assert::AreEqual(size_t{60}, collection.FindDevices({}).size());
+    }
+
+    TEST_METHOD(FormFactorIsProbedMergedAndQueriedTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(20, false);
+        DeviceCollection collection(L""s, true, std::move(backend));
+        collection.ResetContent();
+        // A localized name a name filter for "Headset" misses
+        auto headsetRender = SimulatedAudioBackend::MakeEndpoint(30, DeviceFlowEnum::Render);
+        auto headsetCapture = SimulatedAudioBackend::MakeEndpoint(30, DeviceFlowEnum::Capture);
+        for (auto * endpoint : {&headsetRender, &headsetCapture})
+        {
+            endpoint->Name = L"Kopfh\u00f6rer (USB)";
+            endpoint->FormFactor = DeviceFormFactor::Headset;
+            endpoint->JackConnection = DeviceJackConnection::OtherDigital;
+            simulation.AddEndpoint(*endpoint);
+        }
+
+        const auto headsets = collection.FindDevices({.FormFactor = DeviceFormFactor::Headset});
+        Assert::AreEqual(size_t{1}, headsets.size());
+        Assert::AreEqual(headsetRender.ContainerId, headsets[0]->GetPnpId());
+        Assert::IsTrue(DeviceFlowEnum::RenderAndCapture == headsets[0]->GetFlow());
+        Assert::IsTrue(DeviceJackConnection::OtherDigital == headsets[0]->GetJackConnection());
+        Assert::AreEqual(size_t{20}, collection.FindDevices({.FormFactor = DeviceFormFactor::Speakers}).size());
+        Assert::AreEqual(size_t{1}, collection.FindDevices({.Flow = DeviceFlowEnum::Capture, .JackConnection = DeviceJackConnection::OtherDigital}).size());
+
+        // The device keeps its form factor while one of its endpoints is left
+        simulation.RemoveEndpoint(headsetRender.EndpointId);
+        const auto microphones = collection.FindDevices({.Flow = DeviceFlowEnum::Capture, .FormFactor = DeviceFormFactor::Headset});
+        Assert::AreEqual(size_t{1}, microphones.size());
+        simulation.RemoveEndpoint(headsetCapture.EndpointId);
+        Assert::AreEqual(size_t{0}, collection.FindDevices({.FormFactor = DeviceFormFactor::Headset}).size());
+    }
+};
+}
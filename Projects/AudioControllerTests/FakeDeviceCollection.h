@@ -0,0 +1,67 @@
+#pragma once
+
+#include <future>
+#include <vector>
+
+#include "../AudioController/AudioControlInterface.h"
+#include "Device.h"
+
+
+namespace ed::audio {
+// In-memory stand-in for tests of components that only need DeviceCollectionInterface.
+class FakeDeviceCollection final : public DeviceCollectionInterface {
+public:
+    DISALLOW_COPY_MOVE(FakeDeviceCollection);
+    FakeDeviceCollection() = default;
+    ~FakeDeviceCollection() override = default;
+
+    [[nodiscard]] size_t GetSize() const override { return devices_.size(); }
+    [[nodiscard]] std::unique_ptr<DeviceInterface> CreateItem(size_t deviceNumber) const override
+    {
+        return std::make_unique<Device>(devices_.at(deviceNumber));
+    }
+    [[nodiscard]] std::vector<std::unique_ptr<DeviceInterface>> FindDevices(const DeviceQuery &) const override { return {}; }
+    [[nodiscard]] std::unique_ptr<DeviceInterface> GetDefaultDevice(DeviceFlowEnum, DeviceRole) const override { return nullptr; }
+    void Subscribe(DeviceCollectionObserverInterface & observer) override { observer_ = &observer; }
+    void Subscribe(DeviceCollectionObserverInterface & observer, const DeviceCollectionSubscription &) override { observer_ = &observer; }
+    void Unsubscribe(DeviceCollectionObserverInterface & observer) override { observer_ = nullptr; }
+    void ResetContent() override {}
+    std::future<void> ResetContentAsync(std::function<void()> onCompleted) override
+    {
+        if (onCompleted)
+        {
+            onCompleted();
+        }
+        std::promise<void> promise;
+        promise.set_value();
+        return promise.get_future();
+    }
+    bool LoadWarmStartCache(const std::wstring &) override { return false; }
+    [[nodiscard]] bool IsStale() const override { return false; }
+    [[nodiscard]] LatencyStatistics GetLatencyStatistics() const override { return {}; }
+    [[nodiscard]] OperationalCounters GetOperationalCounters() const override { return {}; }
+    void SetBurstWindow(std::chrono::milliseconds) override {}
+    [[nodiscard]] uint64_t GetSequence() const override { return 0; }
+    [[nodiscard]] DeviceCollectionChangesSince GetChangesSince(uint64_t) const override { return {}; }
+    void SetFilter(const std::wstring &) override {}
+    void SetFlowMode(bool) override {}
+
+    void Add(const Device & device)
+    {
+        devices_.push_back(device);
+        Notify(DeviceCollectionEvent::Discovered, device.GetPnpId());
+    }
+
+    void Notify(DeviceCollectionEvent event, const std::wstring & pnpId) const
+    {
+        if (observer_ != nullptr)
+        {
+            observer_->OnCollectionChanged(event, pnpId);
+        }
+    }
+
+private:
+    std::vector<Device> devices_;
+    DeviceCollectionObserverInterface * observer_ = nullptr;
+};
+}
@@ -0,0 +1,77 @@
+#include "stdafx.h"
+
+#include <CppUnitTest.h>
+
+#include "../AudioController/AudioControlInterface.h"
+#include "DeviceCollection.h"
+#include "LatencyHistogram.h"
+#include "SimulatedAudioBackend.h"
+
+
+using namespace std::literals::string_literals;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace ed::audio {
+TEST_CLASS(LatencyHistogramTests) {
+    TEST_METHOD(BucketsCoverValuesWithinThreePercentTest)
+    {
+        for (uint64_t value = 0; value < (uint64_t{1} << 40); value = value * 3 / 2 + 1)
+        {
+            const auto index = LatencyHistogram::GetBucketIndex(value);
+            const auto upperBound = LatencyHistogram::GetBucketUpperBound(index);
+            Assert::IsTrue(value <= upperBound);
+            Assert::IsTrue(static_cast<double>(upperBound - value) <= static_cast<double>(value) / 32.0);
+            if (index > 0)
+            {
+                Assert::IsTrue(LatencyHistogram::GetBucketUpperBound(index - 1) < value);
+            }
+        }
+    }
+
+    TEST_METHOD(PercentilesOfUniformLatenciesTest)
+    {
+        LatencyHistogram histogram;
+        for (int64_t microseconds = 1; microseconds <= 1000; ++microseconds)
+        {
+            histogram.Record(std::chrono::microseconds(microseconds));
+        }
+
+        const auto summary = histogram.GetSummary();
+        Assert::AreEqual(uint64_t{1000}, summary.Count);
+        Assert::IsTrue(summary.Max == std::chrono::microseconds(1000));
+        Assert::IsTrue(summary.P50 >= std::chrono::microseconds(500) && summary.P50 <= std::chrono::microseconds(516));
+        Assert::IsTrue(summary.P99 >= std::chrono::microseconds(990) && summary.P99 <= summary.Max);
+        Assert::IsTrue(summary.Mean >= std::chrono::nanoseconds(500'500) && summary.Mean <= std::chrono::nanoseconds(500'501));
+    }
+
+    TEST_METHOD(CollectionRecordsEveryNotificationKindTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(10, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+
+        const auto endpoint = SimulatedAudioBackend::MakeEndpoint(10, DeviceFlowEnum::Render);
+        simulation.AddEndpoint(endpoint);
+        simulation.SetVolume(endpoint.EndpointId, 250);
+        simulation.SetDefaultEndpoint(DeviceFlowEnum::Render, DeviceRole::Console, endpoint.EndpointId);
+        simulation.SetEndpointName(endpoint.EndpointId, L"Studio Monitors"s);
+        simulation.RemoveEndpoint(endpoint.EndpointId);
+
+        const auto statistics = collection.GetLatencyStatistics();
+        const auto countOf = [&statistics](LatencyKind kind) { return statistics[static_cast<size_t>(kind)].Count; };
+        Assert::AreEqual(uint64_t{1}, countOf(LatencyKind::DeviceAdded));
+        Assert::AreEqual(uint64_t{1}, countOf(LatencyKind::VolumeChanged));
+        // Removal arrives as a state change, which must not be counted as a removal as well
+        Assert::AreEqual(uint64_t{1}, countOf(LatencyKind::DeviceStateChanged));
+        Assert::AreEqual(uint64_t{0}, countOf(LatencyKind::DeviceRemoved));
+        Assert::AreEqual(uint64_t{1}, countOf(LatencyKind::ResetContent));
+        Assert::AreEqual(uint64_t{1}, countOf(LatencyKind::ResetProbing));
+        Assert::AreEqual(uint64_t{1}, countOf(LatencyKind::DefaultDeviceChanged));
+        Assert::AreEqual(uint64_t{1}, countOf(LatencyKind::PropertyValueChanged));
+        Assert::IsTrue(statistics[static_cast<size_t>(LatencyKind::ResetContent)].Max > std::chrono::nanoseconds(0));
+    }
+};
+}
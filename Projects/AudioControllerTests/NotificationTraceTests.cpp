@@ -0,0 +1,87 @@
+#include "stdafx.h"
+
+#include <filesystem>
+
+#include <CppUnitTest.h>
+
+#include "../AudioController/AudioControlInterface.h"
+#include "DeviceCollection.h"
+#include "RecordingAudioBackend.h"
+#include "RecordingObserver.h"
+#include "SimulatedAudioBackend.h"
+#include "TraceReplayer.h"
+
+
+using namespace std::literals::string_literals;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace ed::audio {
+namespace {
+    std::wstring TemporaryTraceFile(const std::wstring & name)
+    {
+        return (std::filesystem::temp_directory_path() / (name + L".actrace")).wstring();
+    }
+}
+
+TEST_CLASS(NotificationTraceTests) {
+    TEST_METHOD(ReplayReproducesRecordedEventsTest)
+    {
+        const auto traceFile = TemporaryTraceFile(L"ReplayReproducesRecordedEventsTest");
+        RecordingObserver recorded;
+        size_t recordedSize;
+        {
+            auto simulated = std::make_unique<SimulatedAudioBackend>();
+            auto & simulation = *simulated;
+            simulation.Populate(20, true);
+            DeviceCollection collection(L""s, true, std::make_unique<RecordingAudioBackend>(std::move(simulated), traceFile));
+            collection.ResetContent();
+            collection.Subscribe(recorded);
+
+            simulation.AddEndpoint(SimulatedAudioBackend::MakeEndpoint(20, DeviceFlowEnum::Render));
+            simulation.SetVolume(SimulatedAudioBackend::MakeEndpoint(3, DeviceFlowEnum::Render).EndpointId, 100);
+            simulation.RemoveEndpoint(SimulatedAudioBackend::MakeEndpoint(5, DeviceFlowEnum::Capture).EndpointId);
+            simulation.SetEndpointState(SimulatedAudioBackend::MakeEndpoint(7, DeviceFlowEnum::Render).EndpointId, DEVICE_STATE_DISABLED);
+            simulation.SetDefaultEndpoint(DeviceFlowEnum::Render, DeviceRole::Console, SimulatedAudioBackend::MakeEndpoint(3, DeviceFlowEnum::Render).EndpointId);
+            simulation.SetEndpointName(SimulatedAudioBackend::MakeEndpoint(9, DeviceFlowEnum::Capture).EndpointId, L"Microphone (Renamed)"s);
+
+            collection.Unsubscribe(recorded);
+            recordedSize = collection.GetSize();
+        }
+
+        TraceReplayer replayer(traceFile, L""s, true);
+        replayer.GetCollection().ResetContent();
+        Assert::AreEqual(size_t{20}, replayer.GetCollection().GetSize());
+        RecordingObserver replayed;
+        replayer.GetCollection().Subscribe(replayed);
+
+        Assert::AreEqual(size_t{6}, replayer.GetNotificationCount());
+        Assert::AreEqual(size_t{6}, replayer.Replay(0.0));
+        replayer.GetCollection().Unsubscribe(replayed);
+
+        Assert::IsTrue(recorded.GetEvents() == replayed.GetEvents());
+        Assert::AreEqual(recordedSize, replayer.GetCollection().GetSize());
+        std::filesystem::remove(traceFile);
+    }
+
+    TEST_METHOD(TruncatedTraceIsRejectedTest)
+    {
+        const auto traceFile = TemporaryTraceFile(L"TruncatedTraceIsRejectedTest");
+        {
+            NotificationTraceWriter writer(traceFile);
+            TraceRecord record;
+            record.Kind = TraceRecordKind::DeviceAdded;
+            record.EndpointId = L"{0.0.0.00000000}.{endpoint}"s;
+            writer.Write(record);
+        }
+        std::vector<TraceRecord> records;
+        Assert::IsTrue(NotificationTraceReader::TryLoad(traceFile, records));
+        Assert::AreEqual(size_t{1}, records.size());
+        Assert::AreEqual(L"{0.0.0.00000000}.{endpoint}"s, records[0].EndpointId);
+
+        std::filesystem::resize_file(traceFile, std::filesystem::file_size(traceFile) - 1);
+        Assert::IsFalse(NotificationTraceReader::TryLoad(traceFile, records));
+        std::filesystem::remove(traceFile);
+    }
+};
+}
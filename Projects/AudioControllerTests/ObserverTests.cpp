@@ -0,0 +1,304 @@
+#include "stdafx.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <thread>
+#include <utility>
+
+#include <CppUnitTest.h>
+
+#include "../AudioController/AudioControlInterface.h"
+#include "DeviceCollection.h"
+#include "RecordingObserver.h"
+#include "SimulatedAudioBackend.h"
+
+
+using namespace std::literals::string_literals;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace ed::audio {
+TEST_CLASS(ObserverTests) {
+    // Runs an action on itself inside its first callback
+    class ReentrantObserver final : public DeviceCollectionObserverInterface {
+    public:
+        using TActionFunction = std::function<void(DeviceCollectionObserverInterface &)>;
+
+        explicit ReentrantObserver(TActionFunction action)
+            : action_(std::move(action))
+        {
+        }
+
+        void OnCollectionChanged(DeviceCollectionEvent, const std::wstring &) override
+        {
+            ++callCount_;
+            if (auto action = std::exchange(action_, nullptr))
+            {
+                action(*this);
+            }
+        }
+        void OnTrace(const std::wstring &) override {}
+        void OnTraceDebug(const std::wstring &) override {}
+
+        [[nodiscard]] size_t GetCallCount() const { return callCount_; }
+
+    private:
+        TActionFunction action_;
+        std::atomic<size_t> callCount_ = 0;
+    };
+
+    class TraceCountingObserver final : public DeviceCollectionObserverInterface {
+    public:
+        void OnCollectionChanged(DeviceCollectionEvent, const std::wstring &) override {}
+        void OnTrace(const std::wstring &) override { ++traceCount_; }
+        void OnTraceDebug(const std::wstring &) override {}
+
+        [[nodiscard]] size_t GetTraceCount() const { return traceCount_; }
+
+    private:
+        std::atomic<size_t> traceCount_ = 0;
+    };
+
+    // Reads the collection on every trace line, so it hangs if called back with the collection locked
+    class CollectionReadingObserver final : public DeviceCollectionObserverInterface {
+    public:
+        explicit CollectionReadingObserver(const DeviceCollectionInterface & collection)
+            : collection_(collection)
+        {
+        }
+
+        void OnCollectionChanged(DeviceCollectionEvent, const std::wstring &) override {}
+        void OnTrace(const std::wstring &) override
+        {
+            static_cast<void>(collection_.GetSize());
+            ++traceCount_;
+        }
+        void OnTraceDebug(const std::wstring &) override {}
+
+        [[nodiscard]] size_t GetTraceCount() const { return traceCount_; }
+
+    private:
+        const DeviceCollectionInterface & collection_;
+        std::atomic<size_t> traceCount_ = 0;
+    };
+
+    TEST_METHOD(ObserversMaySubscribeAndUnsubscribeInsideCallbacksTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(3, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+
+        RecordingObserver latecomer;
+        ReentrantObserver leaving([&collection](DeviceCollectionObserverInterface & self) { collection.Unsubscribe(self); });
+        ReentrantObserver inviting([&collection, &latecomer](DeviceCollectionObserverInterface &) { collection.Subscribe(latecomer); });
+        collection.Subscribe(leaving);
+        collection.Subscribe(inviting);
+
+        const auto endpointId = SimulatedAudioBackend::MakeEndpoint(0, DeviceFlowEnum::Render).EndpointId;
+        simulation.SetVolume(endpointId, 100);
+        simulation.SetVolume(endpointId, 200);
+        const auto counters = collection.GetOperationalCounters();
+        collection.Unsubscribe(inviting);
+        collection.Unsubscribe(latecomer);
+
+        // A change takes effect from the next dispatch on
+        Assert::AreEqual(size_t{1}, leaving.GetCallCount());
+        Assert::AreEqual(size_t{2}, inviting.GetCallCount());
+        Assert::AreEqual(size_t{1}, latecomer.GetEvents().size());
+        Assert::AreEqual(uint64_t{2}, counters.Observers);
+        Assert::AreEqual(uint64_t{2 + 2}, counters.EventsDelivered);
+    }
+
+    TEST_METHOD(SubscriptionChurnDuringDispatchTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(3, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+        RecordingObserver steady;
+        collection.Subscribe(steady);
+
+        std::atomic_bool isDone = false;
+        std::thread churn([&collection, &isDone]
+        {
+            RecordingObserver transient;
+            while (!isDone)
+            {
+                collection.Subscribe(transient);
+                collection.Unsubscribe(transient);
+            }
+        });
+        const auto endpointId = SimulatedAudioBackend::MakeEndpoint(0, DeviceFlowEnum::Render).EndpointId;
+        for (uint16_t volume = 1; volume <= 1000; ++volume)
+        {
+            simulation.SetVolume(endpointId, volume);
+        }
+        isDone = true;
+        churn.join();
+        collection.Unsubscribe(steady);
+
+        Assert::AreEqual(size_t{1000}, steady.GetEvents().size());
+        Assert::AreEqual(uint64_t{0}, collection.GetOperationalCounters().Observers);
+    }
+
+    TEST_METHOD(UnsubscribeWaitsForCallbacksInFlightTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(3, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+
+        std::promise<void> entered;
+        std::atomic_bool isFinished = false;
+        auto slow = std::make_unique<ReentrantObserver>([&entered, &isFinished](DeviceCollectionObserverInterface &)
+        {
+            entered.set_value();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            isFinished = true;
+        });
+        collection.Subscribe(*slow);
+        const auto endpointId = SimulatedAudioBackend::MakeEndpoint(0, DeviceFlowEnum::Render).EndpointId;
+        std::thread notification([&simulation, &endpointId] { simulation.SetVolume(endpointId, 100); });
+        entered.get_future().wait();
+
+        // The observer may be destroyed at once
+        collection.Unsubscribe(*slow);
+        Assert::IsTrue(isFinished);
+        slow.reset();
+        notification.join();
+        Assert::AreEqual(uint64_t{0}, collection.GetOperationalCounters().Observers);
+    }
+
+    TEST_METHOD(EventsAreRoutedToInterestedObserversOnlyTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(3, true);
+        DeviceCollection collection(L""s, true, std::move(backend));
+        collection.ResetContent();
+        const auto device1 = SimulatedAudioBackend::MakeEndpoint(1, DeviceFlowEnum::Render).ContainerId;
+        const auto device2 = SimulatedAudioBackend::MakeEndpoint(2, DeviceFlowEnum::Render).ContainerId;
+
+        RecordingObserver volumeOfOneDevice;
+        RecordingObserver attachDetach;
+        RecordingObserver captureByName;
+        collection.Subscribe(volumeOfOneDevice, {.Events = DeviceCollectionEventMask::VolumeChanged, .PnpId = device1});
+        collection.Subscribe(attachDetach, {.Events = DeviceCollectionEventMask::Discovered | DeviceCollectionEventMask::Detached});
+        collection.Subscribe(captureByName, {.Flow = DeviceFlowEnum::Capture, .NameFilter = L"simulated DEVICE 2"});
+
+        simulation.SetVolume(SimulatedAudioBackend::MakeEndpoint(0, DeviceFlowEnum::Render).EndpointId, 100);
+        simulation.SetVolume(SimulatedAudioBackend::MakeEndpoint(1, DeviceFlowEnum::Render).EndpointId, 100);
+        // Matched against the device as it was, a render-and-capture one
+        simulation.RemoveEndpoint(SimulatedAudioBackend::MakeEndpoint(2, DeviceFlowEnum::Capture).EndpointId);
+        const auto counters = collection.GetOperationalCounters();
+        collection.Unsubscribe(volumeOfOneDevice);
+        collection.Unsubscribe(attachDetach);
+        collection.Unsubscribe(captureByName);
+
+        const RecordingObserver::TEventList expectedVolume{{DeviceCollectionEvent::VolumeChanged, device1}};
+        const RecordingObserver::TEventList expectedDetached{{DeviceCollectionEvent::Detached, device2}};
+        Assert::IsTrue(expectedVolume == volumeOfOneDevice.GetEvents());
+        Assert::IsTrue(expectedDetached == attachDetach.GetEvents());
+        Assert::IsTrue(expectedDetached == captureByName.GetEvents());
+        Assert::AreEqual(uint64_t{3}, counters.EventsDelivered);
+    }
+
+    TEST_METHOD(FormFactorSubscriptionsMatchLocalizedNamesTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(2, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+        auto headset = SimulatedAudioBackend::MakeEndpoint(10, DeviceFlowEnum::Render);
+        headset.Name = L"Casque (USB)";
+        headset.FormFactor = DeviceFormFactor::Headset;
+
+        RecordingObserver headsets;
+        RecordingObserver byName;
+        collection.Subscribe(headsets, {.FormFactor = DeviceFormFactor::Headset});
+        collection.Subscribe(byName, {.NameFilter = L"Headset"});
+        simulation.AddEndpoint(SimulatedAudioBackend::MakeEndpoint(5, DeviceFlowEnum::Render));
+        simulation.AddEndpoint(headset);
+        collection.Unsubscribe(headsets);
+        collection.Unsubscribe(byName);
+
+        const RecordingObserver::TEventList expected{{DeviceCollectionEvent::Discovered, headset.ContainerId}};
+        Assert::IsTrue(expected == headsets.GetEvents());
+        Assert::AreEqual(size_t{0}, byName.GetEvents().size());
+    }
+
+    TEST_METHOD(BatchesContainTheMatchingChangesOnlyTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(2, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+        const auto headset = SimulatedAudioBackend::MakeEndpoint(10, DeviceFlowEnum::Render);
+
+        RecordingObserver oneDevice;
+        RecordingObserver volumeOnly;
+        collection.Subscribe(oneDevice, {.PnpId = headset.ContainerId});
+        collection.Subscribe(volumeOnly, {.Events = DeviceCollectionEventMask::VolumeChanged});
+        collection.SetBurstWindow(std::chrono::hours(1));
+        simulation.AddEndpoint(SimulatedAudioBackend::MakeEndpoint(11, DeviceFlowEnum::Render));
+        simulation.AddEndpoint(headset);
+        simulation.RemoveEndpoint(SimulatedAudioBackend::MakeEndpoint(0, DeviceFlowEnum::Render).EndpointId);
+        collection.FlushBurst();
+        collection.SetBurstWindow(std::chrono::milliseconds::zero());
+        collection.Unsubscribe(oneDevice);
+        collection.Unsubscribe(volumeOnly);
+
+        const RecordingObserver::TEventList expected{{DeviceCollectionEvent::Discovered, headset.ContainerId}};
+        Assert::IsTrue(expected == oneDevice.GetEvents());
+        Assert::AreEqual(size_t{1}, oneDevice.GetBatchCount());
+        Assert::AreEqual(size_t{0}, volumeOnly.GetBatchCount());
+    }
+
+    TEST_METHOD(TraceObserversMayReadTheCollectionTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(4, false);
+        DeviceCollection collection(L"Simulated Device 1"s, false, std::move(backend));
+        CollectionReadingObserver observer(collection);
+        collection.Subscribe(observer);
+
+        // The filter is traced for every endpoint while the tables are locked
+        collection.ResetContent();
+        const auto traceCount = observer.GetTraceCount();
+        collection.SetFilter(L""s);
+        simulation.RemoveEndpoint(SimulatedAudioBackend::MakeEndpoint(2, DeviceFlowEnum::Render).EndpointId);
+        collection.Unsubscribe(observer);
+
+        Assert::IsTrue(traceCount > 0);
+        Assert::IsTrue(observer.GetTraceCount() > traceCount);
+        Assert::AreEqual(size_t{3}, collection.GetSize());
+    }
+
+    TEST_METHOD(TraceLinesGoToObserversOfTheirLevelOnlyTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        backend->Populate(2, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        TraceCountingObserver silent;
+        TraceCountingObserver informed;
+        collection.Subscribe(silent, {.Trace = TraceLevel::None});
+        collection.Subscribe(informed, {.Trace = TraceLevel::Info});
+
+        collection.ResetContent();
+        collection.Unsubscribe(silent);
+        collection.Unsubscribe(informed);
+
+        Assert::AreEqual(size_t{0}, silent.GetTraceCount());
+        Assert::IsTrue(informed.GetTraceCount() > 0);
+    }
+};
+}
@@ -0,0 +1,91 @@
+#include "stdafx.h"
+
+#include <CppUnitTest.h>
+
+#include "../AudioController/AudioControlInterface.h"
+#include "DeviceCollection.h"
+#include "RecordingObserver.h"
+#include "SimulatedAudioBackend.h"
+
+
+using namespace std::literals::string_literals;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace ed::audio {
+TEST_CLASS(PropertyChangeTests) {
+    TEST_METHOD(RenameIsReadWithoutProbingOrEnumeratingTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(10, true);
+        DeviceCollection collection(L""s, true, std::move(backend));
+        collection.ResetContent();
+        const auto speakers3 = SimulatedAudioBackend::MakeEndpoint(3, DeviceFlowEnum::Render);
+        const auto microphone3 = SimulatedAudioBackend::MakeEndpoint(3, DeviceFlowEnum::Capture);
+        RecordingObserver observer;
+        collection.Subscribe(observer);
+        const auto probes = simulation.GetCallCount(SimulatedCall::Probe);
+        const auto enumerations = simulation.GetCallCount(SimulatedCall::Enumerate);
+
+        simulation.SetEndpointName(speakers3.EndpointId, L"Studio Monitors"s);
+
+        const RecordingObserver::TEventList renamed{{DeviceCollectionEvent::PropertyChanged, speakers3.ContainerId}};
+        Assert::IsTrue(renamed == observer.GetEvents());
+        Assert::AreEqual(probes, simulation.GetCallCount(SimulatedCall::Probe));
+        Assert::AreEqual(enumerations, simulation.GetCallCount(SimulatedCall::Enumerate));
+        Assert::AreEqual(uint64_t{1}, simulation.GetCallCount(SimulatedCall::ReadProperty));
+        // Still merged with its capture endpoint
+        const auto devices = collection.FindDevices({.NamePrefix = L"studio"});
+        Assert::AreEqual(size_t{1}, devices.size());
+        Assert::AreEqual(microphone3.Name + L"/Studio Monitors"s, devices[0]->GetName());
+        Assert::IsTrue(DeviceFlowEnum::RenderAndCapture == devices[0]->GetFlow());
+        Assert::AreEqual(size_t{0}, collection.FindDevices({.NamePrefix = speakers3.Name}).size());
+
+        // The same name raises nothing, nor does the form factor of the microphone: the device keeps the one of its
+        // render endpoint, discovered first
+        simulation.SetEndpointName(speakers3.EndpointId, L"Studio Monitors"s);
+        simulation.SetEndpointFormFactor(speakers3.EndpointId, DeviceFormFactor::Headset);
+        simulation.SetEndpointFormFactor(microphone3.EndpointId, DeviceFormFactor::Headset);
+        const RecordingObserver::TEventList reclassified{
+            {DeviceCollectionEvent::PropertyChanged, speakers3.ContainerId}, {DeviceCollectionEvent::PropertyChanged, speakers3.ContainerId}
+        };
+        Assert::IsTrue(reclassified == observer.GetEvents());
+        Assert::AreEqual(size_t{1}, collection.FindDevices({.FormFactor = DeviceFormFactor::Headset}).size());
+        Assert::AreEqual(uint64_t{4}, collection.GetOperationalCounters().PropertyValueChangedNotifications);
+        Assert::AreEqual(uint64_t{2}, collection.GetOperationalCounters().NotificationsSuppressed);
+        collection.Unsubscribe(observer);
+    }
+
+    TEST_METHOD(RenameMovesTheDeviceAcrossTheFilterTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(10, false);
+        DeviceCollection collection(L"Simulated Device 2"s, true, std::move(backend));
+        collection.ResetContent();
+        const auto speakers2 = SimulatedAudioBackend::MakeEndpoint(2, DeviceFlowEnum::Render);
+        const auto speakers7 = SimulatedAudioBackend::MakeEndpoint(7, DeviceFlowEnum::Render);
+        Assert::AreEqual(size_t{1}, collection.GetSize());
+        RecordingObserver observer;
+        collection.Subscribe(observer);
+
+        simulation.SetEndpointName(speakers7.EndpointId, L"Speakers (Simulated Device 2b)"s);
+        simulation.SetEndpointName(speakers2.EndpointId, L"Speakers (Renamed)"s);
+        // Out of the view, nothing to tell
+        simulation.SetEndpointName(SimulatedAudioBackend::MakeEndpoint(5, DeviceFlowEnum::Render).EndpointId, L"Speakers (Renamed, too)"s);
+
+        const RecordingObserver::TEventList moved{
+            {DeviceCollectionEvent::Discovered, speakers7.ContainerId}, {DeviceCollectionEvent::Detached, speakers2.ContainerId}
+        };
+        Assert::IsTrue(moved == observer.GetEvents());
+        Assert::AreEqual(size_t{1}, collection.GetSize());
+        Assert::AreEqual(speakers7.ContainerId, collection.CreateItem(0)->GetPnpId());
+
+        // A later filter sees the new names
+        collection.SetFilter(L"Renamed"s);
+        Assert::AreEqual(size_t{2}, collection.GetSize());
+        collection.Unsubscribe(observer);
+    }
+};
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../AudioController/AudioControlInterface.h"
+
+
+namespace ed::audio {
+// Records collection events in arrival order, from any thread; a batch is recorded as its events.
+class RecordingObserver final : public DeviceCollectionObserverInterface {
+public:
+    using TEventList = std::vector<std::pair<DeviceCollectionEvent, std::wstring>>;
+
+    void OnCollectionChanged(DeviceCollectionEvent event, const std::wstring & devicePnpId) override
+    {
+        std::lock_guard lock(mutex_);
+        if (!firstEventAt_.has_value())
+        {
+            firstEventAt_ = std::chrono::steady_clock::now();
+        }
+        events_.emplace_back(event, devicePnpId);
+    }
+
+    void OnCollectionChangedBatch(std::span<const DeviceCollectionChange> changes) override
+    {
+        {
+            std::lock_guard lock(mutex_);
+            ++batchCount_;
+        }
+        DeviceCollectionObserverInterface::OnCollectionChangedBatch(changes);
+    }
+
+    void OnTrace(const std::wstring &) override {}
+    void OnTraceDebug(const std::wstring &) override {}
+
+    TEventList GetEvents() const
+    {
+        std::lock_guard lock(mutex_);
+        return events_;
+    }
+
+    size_t GetBatchCount() const
+    {
+        std::lock_guard lock(mutex_);
+        return batchCount_;
+    }
+
+    std::optional<std::chrono::steady_clock::time_point> GetFirstEventAt() const
+    {
+        std::lock_guard lock(mutex_);
+        return firstEventAt_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    TEventList events_;
+    size_t batchCount_ = 0;
+    std::optional<std::chrono::steady_clock::time_point> firstEventAt_;
+};
+}
@@ -0,0 +1,320 @@
+#include "stdafx.h"
+
+#include <chrono>
+
+#include <CppUnitTest.h>
+
+#include "../AudioController/AudioControlInterface.h"
+#include "DeviceCollection.h"
+#include "RecordingObserver.h"
+#include "SimulatedAudioBackend.h"
+#include "TimedDeviceCollection.h"
+
+
+using namespace std::literals::string_literals;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace ed::audio {
+TEST_CLASS(SimulatedBackendTests) {
+    TEST_METHOD(RenderAndCaptureEndpointsAreMergedPerContainerTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        backend->Populate(2000, true);
+        DeviceCollection collection(L""s, true, std::move(backend));
+
+        collection.ResetContent();
+
+        Assert::AreEqual(size_t{2000}, collection.GetSize());
+        const auto device = collection.CreateItem(0);
+        Assert::IsTrue(device->GetFlow() == DeviceFlowEnum::RenderAndCapture);
+        Assert::AreEqual(L"Microphone (Simulated Device 0)/Speakers (Simulated Device 0)"s, device->GetName());
+    }
+
+    TEST_METHOD(ScriptedChangesAreNotifiedTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(10, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+        RecordingObserver observer;
+        collection.Subscribe(observer);
+
+        const auto endpoint = SimulatedAudioBackend::MakeEndpoint(10, DeviceFlowEnum::Render);
+        simulation.AddEndpoint(endpoint);
+        simulation.SetVolume(endpoint.EndpointId, 250);
+        simulation.RemoveEndpoint(endpoint.EndpointId);
+        collection.Unsubscribe(observer);
+
+        const auto events = observer.GetEvents();
+        Assert::AreEqual(size_t{3}, events.size());
+        Assert::IsTrue(events[0].first == DeviceCollectionEvent::Discovered);
+        Assert::IsTrue(events[1].first == DeviceCollectionEvent::VolumeChanged);
+        Assert::IsTrue(events[2].first == DeviceCollectionEvent::Detached);
+        Assert::AreEqual(endpoint.ContainerId, events[2].second);
+        Assert::AreEqual(size_t{10}, collection.GetSize());
+    }
+
+    TEST_METHOD(FailedProbesSkipEndpointsTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        backend->Populate(10, false);
+        backend->InjectFailures(SimulatedCall::Probe, 3);
+        DeviceCollection collection(L""s, false, std::move(backend));
+
+        collection.ResetContent();
+
+        Assert::AreEqual(size_t{7}, collection.GetSize());
+    }
+
+    TEST_METHOD(RemovalsUnmergeByTheKeptFactsTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(4, true);
+        DeviceCollection collection(L""s, true, std::move(backend));
+        collection.ResetContent();
+        RecordingObserver observer;
+        collection.Subscribe(observer);
+        const auto speakers2 = SimulatedAudioBackend::MakeEndpoint(2, DeviceFlowEnum::Render);
+        const auto microphone2 = SimulatedAudioBackend::MakeEndpoint(2, DeviceFlowEnum::Capture);
+        const auto probes = simulation.GetCallCount(SimulatedCall::Probe);
+
+        // A gone endpoint may fail to probe; it is not probed at all
+        simulation.InjectFailures(SimulatedCall::Probe, 2);
+        simulation.RemoveEndpoint(speakers2.EndpointId);
+        Assert::IsTrue(DeviceFlowEnum::Capture == collection.FindDevices({.NamePrefix = microphone2.Name})[0]->GetFlow());
+        simulation.RemoveEndpoint(microphone2.EndpointId);
+        collection.Unsubscribe(observer);
+
+        const RecordingObserver::TEventList expected{
+            {DeviceCollectionEvent::Detached, speakers2.ContainerId}, {DeviceCollectionEvent::Detached, speakers2.ContainerId}
+        };
+        Assert::IsTrue(expected == observer.GetEvents());
+        Assert::AreEqual(size_t{3}, collection.GetSize());
+        Assert::AreEqual(probes, simulation.GetCallCount(SimulatedCall::Probe));
+    }
+
+    TEST_METHOD(FirstDeviceIsPublishedBeforeEnumerationCompletesTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        backend->Populate(200, false);
+        backend->SetLatency(std::chrono::microseconds(200));
+        DeviceCollection collection(L""s, false, std::move(backend));
+        RecordingObserver observer;
+        collection.Subscribe(observer);
+
+        std::chrono::steady_clock::time_point completedAt;
+        collection.ResetContentAsync([&completedAt] { completedAt = std::chrono::steady_clock::now(); }).get();
+        collection.Unsubscribe(observer);
+
+        Assert::AreEqual(size_t{200}, collection.GetSize());
+        const auto firstEventAt = observer.GetFirstEventAt();
+        Assert::IsTrue(firstEventAt.has_value());
+        // 200 probes cost at least 40 ms; the first device must not wait for all of them
+        Assert::IsTrue(completedAt - *firstEventAt > std::chrono::milliseconds(20));
+    }
+
+    TEST_METHOD(ResetAsyncMayBeAskedAgainFromItsCompletionTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        backend->Populate(10, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+
+        std::future<void> second;
+        collection.ResetContentAsync([&collection, &second] { second = collection.ResetContentAsync(nullptr); }).get();
+        second.get();
+
+        Assert::AreEqual(size_t{10}, collection.GetSize());
+    }
+
+    TEST_METHOD(FailedResetAsyncCompletesTooTest)
+    {
+        class ThrowingObserver final : public DeviceCollectionObserverInterface {
+        public:
+            void OnCollectionChanged(DeviceCollectionEvent, const std::wstring &) override { throw std::runtime_error("Observer failed"); }
+            void OnTrace(const std::wstring &) override {}
+            void OnTraceDebug(const std::wstring &) override {}
+        };
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        backend->Populate(10, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        ThrowingObserver observer;
+        collection.Subscribe(observer);
+
+        bool isCompleted = false;
+        auto future = collection.ResetContentAsync([&isCompleted] { isCompleted = true; });
+        Assert::ExpectException<std::runtime_error>([&future] { future.get(); });
+        collection.Unsubscribe(observer);
+
+        Assert::IsTrue(isCompleted);
+    }
+
+    TEST_METHOD(PlatformCallTimesAreAccumulatedTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        backend->Populate(20, false);
+        backend->SetLatency(std::chrono::microseconds(100));
+        TimedDeviceCollection timed(L""s, false, std::move(backend));
+
+        timed.GetCollection().ResetContent();
+
+        const auto times = timed.GetPlatformCallTimes();
+        Assert::AreEqual(uint64_t{20}, times.ProbeCount);
+        Assert::IsTrue(times.Probing >= std::chrono::milliseconds(2));
+        Assert::IsTrue(times.Enumeration >= std::chrono::microseconds(100));
+        Assert::IsTrue(times.VolumeRegistration >= std::chrono::milliseconds(2));
+    }
+
+    TEST_METHOD(OperationalCountersTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(10, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+        RecordingObserver observer;
+        collection.Subscribe(observer);
+
+        const auto endpoint = SimulatedAudioBackend::MakeEndpoint(10, DeviceFlowEnum::Render);
+        simulation.AddEndpoint(endpoint);
+        simulation.SetVolume(endpoint.EndpointId, 250);
+        // Unchanged volume and a capture endpoint of a render-only collection: no events
+        simulation.SetVolume(endpoint.EndpointId, 250);
+        simulation.AddEndpoint(SimulatedAudioBackend::MakeEndpoint(0, DeviceFlowEnum::Capture));
+
+        const auto counters = collection.GetOperationalCounters();
+        collection.Unsubscribe(observer);
+        Assert::AreEqual(uint64_t{2}, counters.DeviceAddedNotifications);
+        Assert::AreEqual(uint64_t{2}, counters.VolumeNotifications);
+        Assert::AreEqual(uint64_t{2}, counters.EventsDelivered);
+        Assert::AreEqual(uint64_t{2}, counters.NotificationsSuppressed);
+        // Only ResetContent(): a volume notification updates its endpoint in place
+        Assert::AreEqual(uint64_t{1}, counters.Enumerations);
+        Assert::AreEqual(uint64_t{10 + 1 + 1}, counters.PropertyStoreOpens);
+        // Filtered out, the capture endpoint's volume is tracked as well, see SetFlowMode(); each registered with the
+        // endpoint volume its probe has activated
+        Assert::AreEqual(counters.PropertyStoreOpens, counters.EndpointActivations);
+        Assert::AreEqual(uint64_t{12}, counters.VolumeCallbacks);
+        Assert::AreEqual(uint64_t{1}, counters.Observers);
+        Assert::AreEqual(uint64_t{0}, counters.PendingNotifications);
+    }
+
+    TEST_METHOD(RedundantNotificationsAreDroppedBeforeProbingTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(10, false);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+        RecordingObserver observer;
+        collection.Subscribe(observer);
+        simulation.SetRedundantNotifications(true);
+
+        const auto plugged = SimulatedAudioBackend::MakeEndpoint(10, DeviceFlowEnum::Render);
+        const auto replugged = SimulatedAudioBackend::MakeEndpoint(0, DeviceFlowEnum::Render);
+        simulation.AddEndpoint(plugged);
+        simulation.RemoveEndpoint(plugged.EndpointId);
+        simulation.RemoveEndpoint(replugged.EndpointId);
+        simulation.AddEndpoint(replugged);
+        // Active since the enumeration
+        simulation.SetEndpointState(SimulatedAudioBackend::MakeEndpoint(1, DeviceFlowEnum::Render).EndpointId, DEVICE_STATE_ACTIVE);
+
+        const auto counters = collection.GetOperationalCounters();
+        collection.Unsubscribe(observer);
+        const auto events = observer.GetEvents();
+        Assert::AreEqual(size_t{4}, events.size());
+        Assert::IsTrue(events[0] == std::make_pair(DeviceCollectionEvent::Discovered, plugged.ContainerId));
+        Assert::IsTrue(events[1] == std::make_pair(DeviceCollectionEvent::Detached, plugged.ContainerId));
+        Assert::IsTrue(events[2] == std::make_pair(DeviceCollectionEvent::Detached, replugged.ContainerId));
+        Assert::IsTrue(events[3] == std::make_pair(DeviceCollectionEvent::Discovered, replugged.ContainerId));
+        Assert::AreEqual(uint64_t{5}, counters.NotificationsDeduplicated);
+        // One probe per addition, none per removal or redundant notification
+        Assert::AreEqual(uint64_t{10 + 2}, counters.PropertyStoreOpens);
+        Assert::AreEqual(size_t{10}, collection.GetSize());
+    }
+
+    TEST_METHOD(EndpointRemovedWhileResetProbesStaysRemovedTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(20, false);
+        simulation.SetLatency(std::chrono::milliseconds(2));
+        DeviceCollection collection(L""s, false, std::move(backend));
+        const auto removed = SimulatedAudioBackend::MakeEndpoint(19, DeviceFlowEnum::Render);
+
+        std::thread reset([&collection] { collection.ResetContent(); });
+        // Removed, probed and applied within the 40 ms the reset probes, which probes it as it stays probe-able
+        while (simulation.GetCallCount(SimulatedCall::Probe) == 0)
+        {
+            std::this_thread::yield();
+        }
+        simulation.RemoveEndpoint(removed.EndpointId);
+        reset.join();
+
+        Assert::AreEqual(size_t{19}, collection.GetSize());
+        Assert::AreEqual(size_t{0}, collection.FindDevices({.PnpId = removed.ContainerId}).size());
+        // Nor is it logged as discovered, nor its volume notification registered again by the reset
+        Assert::AreEqual(size_t{19}, collection.GetChangesSince(0).Changes.size());
+        Assert::AreEqual(uint64_t{19}, collection.GetOperationalCounters().VolumeCallbacks);
+    }
+
+    TEST_METHOD(FilterChangesNeitherEnumerateNorProbeTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(10, true);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+        RecordingObserver observer;
+        collection.Subscribe(observer);
+        const auto enumerations = simulation.GetCallCount(SimulatedCall::Enumerate);
+        const auto probes = simulation.GetCallCount(SimulatedCall::Probe);
+        const auto device1 = SimulatedAudioBackend::MakeEndpoint(1, DeviceFlowEnum::Render).ContainerId;
+
+        collection.SetFilter(L"device 1)"s);
+        Assert::AreEqual(size_t{1}, collection.GetSize());
+        Assert::AreEqual(size_t{9}, observer.GetEvents().size());
+        Assert::AreEqual(size_t{1}, observer.GetBatchCount());
+
+        collection.SetFlowMode(true);
+        const auto device = collection.CreateItem(0);
+        Assert::AreEqual(device1, device->GetPnpId());
+        Assert::IsTrue(DeviceFlowEnum::RenderAndCapture == device->GetFlow());
+        Assert::IsTrue(observer.GetEvents()[9] == std::make_pair(DeviceCollectionEvent::Discovered, device1));
+
+        collection.SetFilter(L""s);
+        collection.Unsubscribe(observer);
+        Assert::AreEqual(size_t{10}, collection.GetSize());
+        Assert::AreEqual(size_t{10}, collection.FindDevices({.Flow = DeviceFlowEnum::RenderAndCapture}).size());
+        Assert::AreEqual(size_t{3}, observer.GetBatchCount());
+        Assert::AreEqual(enumerations, simulation.GetCallCount(SimulatedCall::Enumerate));
+        Assert::AreEqual(probes, simulation.GetCallCount(SimulatedCall::Probe));
+    }
+
+    TEST_METHOD(FilteredOutEndpointsStayCurrentTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(5, true);
+        DeviceCollection collection(L""s, false, std::move(backend));
+        collection.ResetContent();
+        const auto microphone3 = SimulatedAudioBackend::MakeEndpoint(3, DeviceFlowEnum::Capture);
+        const auto microphone6 = SimulatedAudioBackend::MakeEndpoint(6, DeviceFlowEnum::Capture);
+
+        simulation.SetVolume(microphone3.EndpointId, 123);
+        simulation.RemoveEndpoint(SimulatedAudioBackend::MakeEndpoint(4, DeviceFlowEnum::Capture).EndpointId);
+        simulation.AddEndpoint(microphone6);
+        Assert::AreEqual(size_t{5}, collection.GetSize());
+        collection.SetFlowMode(true);
+
+        Assert::AreEqual(size_t{6}, collection.GetSize());
+        const auto microphones = collection.FindDevices({.Flow = DeviceFlowEnum::Capture, .MinVolume = 123, .MaxVolume = 123});
+        Assert::AreEqual(size_t{1}, microphones.size());
+        Assert::AreEqual(microphone3.ContainerId, microphones[0]->GetPnpId());
+        Assert::AreEqual(size_t{4}, collection.FindDevices({.Flow = DeviceFlowEnum::RenderAndCapture}).size());
+        Assert::AreEqual(size_t{1}, collection.FindDevices({.Flow = DeviceFlowEnum::Capture, .NamePrefix = L"Microphone (Simulated Device 6"}).size());
+    }
+};
+}
@@ -0,0 +1,62 @@
+#include "stdafx.h"
+
+#include <CppUnitTest.h>
+
+#include "../AudioController/AudioControlInterface.h"
+#include "../AudioController/AudioSnapshotReader.h"
+#include "../AudioControllerLib/generate-uuid.h"
+#include "Device.h"
+#include "FakeDeviceCollection.h"
+#include "SnapshotPublisher.h"
+
+
+using namespace std::literals::string_literals;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace ed::audio {
+TEST_CLASS(SnapshotTests) {
+    static std::wstring UniqueRegionName()
+    {
+        return L"Local\\PnPAudioCheckSnapshotTest-"s + generate_w_uuid();
+    }
+
+    TEST_METHOD(OpenWithoutPublisherFailsTest)
+    {
+        AudioSnapshotReader reader;
+        Assert::IsFalse(reader.Open(UniqueRegionName()));
+        Assert::IsFalse(reader.IsOpen());
+    }
+
+    TEST_METHOD(PublishAndReadTest)
+    {
+        const auto regionName = UniqueRegionName();
+        FakeDeviceCollection collection;
+        SnapshotPublisher publisher(collection, regionName);
+        publisher.Publish();
+
+        AudioSnapshotReader reader;
+        Assert::IsTrue(reader.Open(regionName));
+
+        std::vector<AcSnapshotDevice> devices;
+        INT64 sequence = 0;
+        INT64 publishedAt = 0;
+        Assert::IsTrue(reader.TryRead(devices, sequence, publishedAt));
+        Assert::IsTrue(devices.empty());
+        Assert::AreEqual(INT64{2}, sequence);
+
+        const auto pnpId = generate_w_uuid();
+        collection.Add(Device(pnpId, L"Headset 01"s, DeviceFlowEnum::RenderAndCapture, 300, 700));
+
+        Assert::IsTrue(reader.GetSequence() > sequence);
+        Assert::IsTrue(reader.TryRead(devices, sequence, publishedAt));
+        Assert::AreEqual(size_t{1}, devices.size());
+        Assert::AreEqual(pnpId, std::wstring(devices[0].Guid));
+        Assert::AreEqual(L"Headset 01"s, std::wstring(devices[0].Name));
+        Assert::AreEqual(static_cast<UINT8>(DeviceFlowEnum::RenderAndCapture), devices[0].Flow);
+        Assert::AreEqual(UINT16{300}, devices[0].RenderVolume);
+        Assert::AreEqual(UINT16{700}, devices[0].CaptureVolume);
+        Assert::IsTrue(publishedAt > 0);
+    }
+};
+}
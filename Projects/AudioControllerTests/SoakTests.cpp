@@ -0,0 +1,117 @@
+#include "stdafx.h"
+
+#include <atomic>
+#include <sstream>
+
+#include <CppUnitTest.h>
+#include <psapi.h>
+
+#include "../AudioController/AudioControlInterface.h"
+#include "AllocationCounter.h"
+#include "DeviceCollection.h"
+#include "SimulatedAudioBackend.h"
+
+
+using namespace std::literals::string_literals;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace ed::audio {
+// Long-run churn, as of a station plugging and unplugging headsets for a whole shift:
+// memory and live objects must stay flat once the first cycles have warmed the collection up.
+TEST_CLASS(SoakTests) {
+    static constexpr size_t CycleCount = 100000;
+    static constexpr size_t SampleInterval = 10000;
+    static constexpr size_t HeadsetCount = 16;
+    // Tolerated growth of the private bytes, for heap fragmentation
+    static constexpr size_t PrivateBytesTolerance = 1024 * 1024;
+
+    class CountingObserver final : public DeviceCollectionObserverInterface {
+    public:
+        void OnCollectionChanged(DeviceCollectionEvent, const std::wstring &) override { ++eventCount_; }
+        void OnTrace(const std::wstring &) override {}
+        void OnTraceDebug(const std::wstring &) override {}
+
+        [[nodiscard]] size_t GetEventCount() const { return eventCount_; }
+
+    private:
+        std::atomic<size_t> eventCount_ = 0;
+    };
+
+    struct Sample {
+        size_t Cycle = 0;
+        size_t PrivateBytes = 0;
+        int64_t LiveBlocks = 0;
+        size_t Devices = 0;
+        uint64_t VolumeCallbacks = 0;
+    };
+
+    static size_t GetPrivateBytes()
+    {
+        PROCESS_MEMORY_COUNTERS_EX memoryCounters{};
+        memoryCounters.cb = sizeof(memoryCounters);
+        if (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&memoryCounters), sizeof(memoryCounters)) == FALSE)
+        {
+            return 0;
+        }
+        return memoryCounters.PrivateUsage;
+    }
+
+    static Sample TakeSample(size_t cycle, const DeviceCollection & collection)
+    {
+        Sample sample{cycle, GetPrivateBytes(), AllocationCounter::GetLiveBlockCount(), collection.GetSize(),
+                      collection.GetOperationalCounters().VolumeCallbacks};
+        std::wostringstream line;
+        line << L"Cycle " << sample.Cycle << L": private bytes " << sample.PrivateBytes << L", live blocks "
+            << sample.LiveBlocks << L", devices " << sample.Devices << L", volume callbacks " << sample.VolumeCallbacks;
+        Logger::WriteMessage(line.str().c_str());
+        return sample;
+    }
+
+    TEST_METHOD(AddRemoveVolumeChurnKeepsMemoryFlatTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        auto & simulation = *backend;
+        simulation.Populate(10, true);
+        DeviceCollection collection(L""s, true, std::move(backend));
+        collection.ResetContent();
+        CountingObserver observer;
+        collection.Subscribe(observer);
+
+        std::vector<SimulatedEndpoint> headsets;
+        for (size_t i = 0; i < HeadsetCount; ++i)
+        {
+            headsets.push_back(SimulatedAudioBackend::MakeEndpoint(1000 + i, DeviceFlowEnum::Render));
+        }
+
+        std::vector<Sample> samples;
+        samples.reserve(CycleCount / SampleInterval);
+        for (size_t cycle = 0; cycle < CycleCount; ++cycle)
+        {
+            const auto & headset = headsets[cycle % HeadsetCount];
+            simulation.AddEndpoint(headset);
+            // A plugged-in headset has the volume 500
+            simulation.SetVolume(headset.EndpointId, static_cast<uint16_t>(250 + cycle % 250));
+            simulation.SetVolume(headset.EndpointId, 0, true);
+            simulation.RemoveEndpoint(headset.EndpointId);
+
+            if ((cycle + 1) % SampleInterval == 0)
+            {
+                samples.push_back(TakeSample(cycle + 1, collection));
+            }
+        }
+        collection.Unsubscribe(observer);
+
+        // Discovered, volume changed, muted and detached per cycle
+        Assert::AreEqual(CycleCount * 4, observer.GetEventCount());
+        const auto & warmedUp = samples.front();
+        for (const auto & sample : samples)
+        {
+            Assert::AreEqual(size_t{10}, sample.Devices);
+            Assert::AreEqual(uint64_t{20}, sample.VolumeCallbacks);
+            Assert::AreEqual(warmedUp.LiveBlocks, sample.LiveBlocks);
+            Assert::IsTrue(sample.PrivateBytes <= warmedUp.PrivateBytes + PrivateBytesTolerance);
+        }
+    }
+};
+}
@@ -0,0 +1,71 @@
+#include "stdafx.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <CppUnitTest.h>
+
+#include "../AudioController/AudioControlInterface.h"
+#include "DeviceCollection.h"
+#include "SimulatedAudioBackend.h"
+#include "TimelineTrace.h"
+
+
+using namespace std::literals::string_literals;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace ed::audio {
+TEST_CLASS(TimelineTraceTests) {
+    TEST_METHOD(ZonesAreRecordedOnlyWhileRecordingTest)
+    {
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        backend->Populate(3, false);
+        TimelineTrace::Start(1000);
+        DeviceCollection collection(L""s, false, std::move(backend));
+
+        collection.ResetContent();
+        TimelineTrace::Stop();
+        const auto recordedCount = TimelineTrace::GetRecordedCount();
+        collection.ResetContent();
+
+        // ResetContent, ProcessActiveDeviceList and a MergeDevice per endpoint
+        Assert::IsTrue(recordedCount >= 5);
+        Assert::AreEqual(recordedCount, TimelineTrace::GetRecordedCount());
+        Assert::AreEqual(size_t{0}, TimelineTrace::GetDroppedCount());
+    }
+
+    TEST_METHOD(ZonesBeyondCapacityAreDroppedTest)
+    {
+        TimelineTrace::Start(2);
+        for (int i = 0; i < 5; ++i)
+        {
+            AC_TIMELINE_ZONE("Zone");
+        }
+        TimelineTrace::Stop();
+
+        Assert::AreEqual(size_t{2}, TimelineTrace::GetRecordedCount());
+        Assert::AreEqual(size_t{3}, TimelineTrace::GetDroppedCount());
+    }
+
+    TEST_METHOD(ChromeJsonIsWrittenTest)
+    {
+        const auto jsonFile = (std::filesystem::temp_directory_path() / L"ChromeJsonIsWrittenTest.json").wstring();
+        TimelineTrace::Start(10);
+        {
+            AC_TIMELINE_ZONE("Outer");
+            AC_TIMELINE_ZONE("Inner");
+        }
+        TimelineTrace::Stop();
+
+        Assert::IsTrue(TimelineTrace::TryWriteChromeJson(jsonFile));
+        std::stringstream json;
+        json << std::ifstream(std::filesystem::path(jsonFile)).rdbuf();
+        std::filesystem::remove(jsonFile);
+        Assert::IsTrue(json.str().find("\"traceEvents\"") != std::string::npos);
+        Assert::IsTrue(json.str().find("{\"name\": \"Outer\", \"cat\": \"audio\", \"ph\": \"X\"") != std::string::npos);
+        Assert::IsTrue(json.str().find("{\"name\": \"Inner\"") != std::string::npos);
+    }
+};
+}